@@ -20,16 +20,16 @@ int usb_to_uart(uint8_t* data, int len)
 }
 
 //-------------------------------------------------------
-// Handler 2: UART → USB 方向的数据处理
+// Handler 2: UART → USB 方向的数据处理(v2 ABI:输入只读,写进单独的输出缓冲)
 //-------------------------------------------------------
-int uart_to_usb(uint8_t* data, int len)
+int uart_to_usb(const uint8_t* in, int len, uint8_t* out, int cap)
 {
-    printf("[filter] uart_to_usb called, len=%d\n", len);
+    printf("[filter] uart_to_usb called, len=%d cap=%d\n", len, cap);
 
-    // 示例：前面加一个 0xAA 标记
-    if (len + 1 > 2048) return len;
-    memmove(data + 1, data, len);
-    data[0] = 0xAA;
+    // 示例：前面加一个 0xAA 标记。放不下就告诉调用方要多少,会换大缓冲再调一次
+    if (len + 1 > cap) return len + 1;
+    out[0] = 0xAA;
+    memcpy(out + 1, in, len);
 
     return len + 1;
 }
@@ -44,5 +44,5 @@ void plugin_init()
     //plugin_register_handler("plugin_name", "func_name", func_by_name);
 
     plugin_register_handler("filter", "usb_to_uart", usb_to_uart);
-    plugin_register_handler("filter", "uart_to_usb", uart_to_usb);
+    plugin_register_handler_v2("filter", "uart_to_usb", uart_to_usb);
 }
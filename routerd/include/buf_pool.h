@@ -0,0 +1,95 @@
+#ifndef EZ_ROUTER_BUF_POOL_H
+#define EZ_ROUTER_BUF_POOL_H
+
+// buf_pool.h — 引用计数数据缓冲池(路由 fan-out 共享缓冲)
+//
+// 职责:
+//   - 启动时一次性预分配,按容量分档(size class):BUF_SIZE 一档 count 个(缺省
+//     BUF_POOL_DEFAULT_COUNT),配置了更长的消息(config "buffers".max_message)时再按
+//     ×4 递增加大档,最大一档正好放得下最长消息;每个大档按字节预算 class_bytes 定个数
+//   - buf_alloc 取放得下的最小一档,该档空了借更大的档 —— 小消息不占大缓冲
+//   - reactor 把一次 read() 的数据放进一个 buf_t,fan-out 的每条路由只
+//     buf_ref() 一次,不再逐路由 memcpy
+//   - 最后一个持有者(通常是 dispatch worker 发送完)buf_unref() 时归还池
+//
+// 不可变约定(隐性契约):
+//   refcnt > 1 的缓冲是共享的,任何人不得改写其内容。需要改写(plugin
+//   handler)时先 buf_alloc 一份私有副本(copy-on-write)。只有 refcnt == 1
+//   的持有者可以就地写。
+//
+// 并发:
+//   - buf_unref 任意线程可调(dispatch worker),归还走无锁 push
+//   - buf_alloc 只由 reactor 线程调用;同一档的分配者之间用该档的锁串行化
+//     (单 reactor 下无竞争),保证 pop 侧不出现 ABA
+//
+// 测试:tests/unit/test_buf_pool.c
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "event.h"
+
+#define BUF_POOL_DEFAULT_COUNT 1024
+#define BUF_SIZE               MAX_DATA            // 最小一档
+#define BUF_CLASS_MAX          4                   // BUF_SIZE ×4 递增,MAX_MESSAGE + 1 正好是第 4 档上限
+#define BUF_CLASS_DEFAULT_BYTES (2 * 1024 * 1024)  // 每个大档的缺省字节预算
+#define BUF_CLASS_MIN_COUNT    8                   // 大档至少这么多个
+
+typedef struct buf {
+    atomic_int   refcnt;
+    int          cap;           // data[] 容量(字节),>= BUF_SIZE
+    int          cls;           // 所属档
+    struct buf*  next_free;     // 仅在池内空闲链上有效
+    uint8_t      data[];
+} buf_t;
+
+// 只建 BUF_SIZE 一档,count 个(count <= 0 取缺省)。重复调用先释放旧池。
+// 返回 0 成功,-1 内存不足。调用时不能有任何缓冲在外。
+int buf_pool_init(int count);
+
+// 分档建池:BUF_SIZE 档 count 个;max_size > BUF_SIZE 时加大档直到能放下 max_size 字节
+// (最大一档容量 = max_size 向上取 64 字节对齐,上限 MAX_MESSAGE + 1),
+// 每个大档 class_bytes / 容量 个(<= 0 取 BUF_CLASS_DEFAULT_BYTES,至少 BUF_CLASS_MIN_COUNT)。
+int buf_pool_init_sized(int count, int max_size, int class_bytes);
+
+// 最大一档的容量(池没建时为 BUF_SIZE):一条消息最多 buf_max_size() - 1 字节
+int buf_max_size(void);
+
+// 释放池内存(进程退出 / 单测用)。
+void buf_pool_destroy(void);
+
+// 取一个至少 size 字节的缓冲,refcnt = 1。优先放得下的最小一档,该档空了取更大的档;
+// 都空或 size 超过最大一档返回 NULL。
+buf_t* buf_alloc(int size);
+
+// 加一个引用(fan-out 共享)。b 为 NULL 时无操作。
+void buf_ref(buf_t* b);
+
+// 减一个引用,归零时归还池。b 为 NULL 时无操作。
+void buf_unref(buf_t* b);
+
+// 当前引用数(调试 / COW 判定用)。
+int buf_refcnt(const buf_t* b);
+
+typedef struct {
+    int           cap;
+    int           total;
+    int           in_use;
+    int           peak_in_use;
+} buf_class_stats_t;
+
+typedef struct {
+    int           total;        // 以下三项是各档之和
+    int           in_use;
+    int           peak_in_use;
+    unsigned long alloc_fail;
+    unsigned long upsized;      // 合适的档空了,借更大一档的次数
+    int           classes;
+    buf_class_stats_t cls[BUF_CLASS_MAX];
+} buf_pool_stats_t;
+
+void buf_pool_get_stats(buf_pool_stats_t* out);
+
+// 以 LOG_DEBUG 打印池计数(主线程周期调用)。
+void buf_pool_log_stats(void);
+
+#endif // EZ_ROUTER_BUF_POOL_H
@@ -0,0 +1,42 @@
+#ifndef EZ_ROUTER_BYTE_SCAN_H
+#define EZ_ROUTER_BYTE_SCAN_H
+
+// byte_scan.h — 向量化字节查找(分帧 / 协议重同步的热路径)
+//
+// 职责:
+//   - 分隔符分帧、SLIP / COBS 找边界、字节流里找 PROTO_MAGIC 重同步,都是对每个
+//     收到的字节做比较;这里一次比 16 / 32 字节,命中后再精确定位
+//   - 实现按编译目标选:aarch64 NEON;x86-64 SSE2(基线),CPU 支持时长输入走 AVX2
+//     (函数级 target 属性 + 运行期 __builtin_cpu_supports,不要求 -mavx2 编译);
+//     其他架构逐字节
+//   - 语义与逐字节循环完全相同(返回第一个命中),不读 [p, p + n) 以外的字节
+//
+// 并发:纯函数,无状态。
+//
+// 测试:tests/unit/test_byte_scan.c(与逐字节参考实现逐位置比对)
+// 基准:tests/bench/bench_byte_scan.c(GB/s / 核,对比逐字节循环)
+
+#include <stddef.h>
+#include <stdint.h>
+
+// scan_set 一次最多找几种字节
+#define SCAN_SET_MAX  8
+
+// 第一个等于 b 的字节(同 memchr),没有返回 NULL
+const uint8_t* scan_byte(const uint8_t* p, size_t n, uint8_t b);
+
+// 第一个 p[i] == b0 且 p[i+1] == b1 的位置(两字节魔数,如 PROTO_MAGIC 的 7C EB)。
+// 只有最后一个字节等于 b0 不算命中:另一半还没收到,调用方自己保留这一个字节
+const uint8_t* scan_pair(const uint8_t* p, size_t n, uint8_t b0, uint8_t b1);
+
+// 第一个属于 set[0, k) 的字节(如 SLIP 的 END / ESC、CR / LF),k 取 1..SCAN_SET_MAX
+const uint8_t* scan_set(const uint8_t* p, size_t n, const uint8_t* set, int k);
+
+// 第一次出现 needle[0, m) 的位置(同 memmem):m == 1 走 scan_byte,
+// 否则 scan_pair 找前两字节再比较其余
+const uint8_t* scan_seq(const uint8_t* p, size_t n, const uint8_t* needle, size_t m);
+
+// 当前用的实现:"avx2" / "sse2" / "neon" / "scalar"(长输入时的路径)
+const char* scan_impl(void);
+
+#endif // EZ_ROUTER_BYTE_SCAN_H
@@ -2,12 +2,16 @@
 #define CONFIG_STORE_H
 
 #include <stdint.h>
+#include <stdatomic.h>
 #include "cJSON.h"
 
 #define MAX_PORTS    32
 #define MAX_PLUGINS  32
 #define MAX_ROUTES   64
 
+// reactor(epoll)线程数上限,"reactor": {"threads": N} 夹到 [1, REACTOR_MAX_THREADS]
+#define REACTOR_MAX_THREADS 8
+
 typedef enum {
     PORT_TTY,
     PORT_TCP_SERVER,
@@ -30,13 +34,149 @@ typedef enum {
     FLOW_XONXOFF = 2
 } flow_t;
 
+// 输出合并(作为目的端口时),ports[].coalesce:{"max_bytes": N, "max_delay_us": N}
+// max_delay_us == 0 = 不合并(控制口缺省走零延迟路径)。只对被路由当作 dst 的端口生效
+// (合并发生在该端口目的队列的 worker 里),别的端口配了无效果
+typedef struct {
+    int max_bytes;      // 攒够这么多字节立即发
+    int max_delay_us;   // 第一条消息最多等这么久
+} port_coalesce_t;
+
+#define COALESCE_DEFAULT_MAX_BYTES  1400      // 约一个以太网 MSS
+#define COALESCE_MAX_DELAY_US       1000000   // 上限 1s,防止配错把链路"冻住"
+
+// 慢 client 处理(tcp_server / ipc 作为目的端口时),ports[].slow_client:
+//   {"policy": "block" | "disconnect" | "latest" | "drop_oldest",
+//    "budget_bytes": N, "grace_ms": T}
+// 某个 accept 出的 client 输出积压超过 budget_bytes 持续 grace_ms 后按 policy 处理。
+// 除 block 外,慢 client 不会拖住 server 的其他 client。
+typedef enum {
+    SLOW_CLIENT_BLOCK = 0,      // "block"(缺省):最慢的 client 积压过高水位即暂停整个 server
+    SLOW_CLIENT_DISCONNECT,     // "disconnect":断开该 client
+    SLOW_CLIENT_LATEST,         // "latest":该 client 降级为只保留最新一条,追上后恢复
+    SLOW_CLIENT_DROP_OLDEST,    // "drop_oldest":丢最旧的整条消息,把积压压回 budget 以内
+} slow_client_policy_t;
+
+typedef struct {
+    slow_client_policy_t policy;
+    int budget_bytes;
+    int grace_ms;
+} port_slow_client_t;
+
+#define SLOW_CLIENT_DEFAULT_BUDGET    (64 * 1024)
+#define SLOW_CLIENT_DEFAULT_GRACE_MS  1000
+
+// socket 选项(tcp_server / tcp_client / udp),ports[].socket:
+//   {"nodelay": bool, "quickack": bool, "sndbuf": N, "rcvbuf": N, "busy_poll_us": N,
+//    "user_timeout_ms": N, "keepalive": {"idle_s": N, "interval_s": N, "count": N},
+//    "dscp": N | "tos": N}
+// 打开端口时设置(port_apply_sockopts);tcp_server 设在 listener 上,每个 accept 出的
+// client 再设一遍。不写 / 0 = 内核缺省。nodelay / quickack / user_timeout / keepalive
+// 只对 TCP 有效,udp 上忽略。
+// 控制回路:nodelay + quickack + 小缓冲;大块上传:大 sndbuf / rcvbuf。
+typedef struct {
+    int nodelay;           // TCP_NODELAY:关 Nagle
+    int quickack;          // TCP_QUICKACK:内核会自己退出,reactor 每次收到数据重设
+    int sndbuf;            // SO_SNDBUF(内核按 2 倍记账)
+    int rcvbuf;            // SO_RCVBUF
+    int busy_poll_us;      // SO_BUSY_POLL;超过 net.core.busy_read 需要 CAP_NET_ADMIN
+    int user_timeout_ms;   // TCP_USER_TIMEOUT:已发数据这么久没被确认就断开
+    int keepalive;         // SO_KEEPALIVE;写了 keepalive 块即开
+    int keepidle_s;        // TCP_KEEPIDLE
+    int keepintvl_s;       // TCP_KEEPINTVL
+    int keepcnt;           // TCP_KEEPCNT
+    int tos;               // IP_TOS;"dscp": N 存为 N << 2。0 = 不设
+} port_sockopt_t;
+
+// 收方向分帧(字节流端口作为源时,frame.h),ports[].frame:
+//   {"mode": "delimiter", "delimiter": "\r\n" | N, "keep_delimiter": bool}
+//   {"mode": "length", "offset": N, "width": 1|2|4, "endian": "big"|"little", "adjust": N}
+//   {"mode": "slip"} | {"mode": "cobs"}
+//   {"mode": "idle", "idle_us": N}
+//   {"mode": "modbus_rtu", "gap_chars": 3.5, "idle_us": N}
+//   公共:"max_len": N,不写 / 超过 "buffers".max_message 取 max_message
+// 写了 frame 块即分帧("use_frame": false 可临时关掉);tcp_server 的配置用于其 client。
+// delimiter 写数字表示单个字节(如 0 / 0x7E)。length 的帧长 = offset + width + 字段值
+// + adjust,字段值就是整帧长度时 adjust = -(offset + width)。
+// modbus_rtu 是按线路参数定静默的 idle:tty 端口由 baudrate / databits / parity / stopbits
+// 算字符时间,静默 gap_chars(缺省 3.5)个字符即帧结束;不写 gap_chars 时按 Modbus 规范
+// 波特率 > 19200 固定 1750us。写了 idle_us 则直接用它(非 tty 端口缺省 1750us)。
+typedef enum {
+    FRAME_NONE = 0,
+    FRAME_DELIMITER,
+    FRAME_LENGTH,
+    FRAME_SLIP,
+    FRAME_COBS,
+    FRAME_IDLE,
+    FRAME_MODBUS,
+} frame_mode_t;
+
+#define FRAME_DELIM_MAX      8
+#define FRAME_DEFAULT_IDLE_US 5000
+#define FRAME_MODBUS_CHARS    3.5
+#define FRAME_MODBUS_FAST_US  1750   // 规范:> 19200 baud 时 t3.5 固定值
+#define FRAME_MODBUS_FAST_T15 750    //                    t1.5 固定值
+
+typedef struct {
+    frame_mode_t mode;
+    uint8_t delim[FRAME_DELIM_MAX];
+    int     delim_len;
+    int     keep_delim;    // delimiter:帧里保留分隔符
+    int     len_offset;    // length:长度字段在帧内的偏移
+    int     len_width;     // length:1 / 2 / 4 字节
+    int     len_big;       // length:1 = 大端(网络序)
+    int     len_adjust;    // length:帧长修正
+    int     idle_us;       // idle / modbus_rtu:配置的静默(us),modbus_rtu 0 = 按线路算
+    double  gap_chars;     // modbus_rtu:静默多少个字符时间,0 = 规范缺省
+    int     max_len;       // 最长帧,0 = MAX_DATA-1(config 加载时已夹到 max_message)
+    // 以下由 config 加载时算出(不保存):
+    int     gap_us;        // 生效的帧间静默;0 = 用 idle_us
+    int     short_us;      // modbus_rtu:帧内字节间隔超过它(t1.5)算短间隙;0 = 不统计
+} port_frame_t;
+
+struct frame_rx;
+
+// 端口句柄(port_manager.h):g_port_table 下标 + generation,0 = 未注册
+typedef uint32_t port_handle_t;
+
+// 连接状态(base.link):只有配置里的 tcp_client 会离开 UP(断线重连见 reactor.h)。
+// reactor 线程写,dispatch worker 读(port_link_up)。
+typedef enum {
+    PORT_LINK_UP = 0,       // 连着;其他类型端口恒为此值
+    PORT_LINK_CONNECTING,   // 非阻塞 connect 进行中
+    PORT_LINK_DOWN,         // 断开 / 连接失败,等退避到期重连
+} port_link_t;
+
 typedef struct {
     char name[32];
     port_type_t type;
     int fd;
-    int use_frame;
+    int use_frame;  // "use_frame":写了 frame 块时缺省 true
+    port_frame_t frame;   // "frame": {...};accept 出的 client 按 base.id 用 server 的
+    int id;         // g_config.ports 下标(parse 时赋值);accept 出的 client 继承 server 的 id
+    port_handle_t handle;   // 运行期句柄,reactor 注册时分配,断开时失效
+    port_coalesce_t coalesce;
+    port_slow_client_t slow_client;   // 仅 server 端口有意义,client 按 base.id 查 server 的
+    int zerocopy_min;   // "zerocopy_min": N,TCP 一次发送不小于 N 字节时用 MSG_ZEROCOPY;0 = 不用
+    port_sockopt_t sock;   // "socket": {...};accept 出的 client 按 base.id 用 server 的
+    int reactor;    // 归属的 reactor 线程;配置 "reactor": N,缺省 -1 = 按端口序号轮转
+    int rx_segs;    // 运行期:下一次 readv 用几个池缓冲(reactor 自适应,0 = 从 1 起)
+    int rx_cap;     // 运行期:字节流每段池缓冲的容量(reactor 自适应,0 = BUF_SIZE)
+    int rx_armed;   // 运行期:io_uring 后端下是否有在途的读 / accept 请求
+    struct frame_rx* frame_rx;   // 运行期:分帧状态(frame.h),reactor 首次读时分配
+    atomic_int  link;         // 运行期:port_link_t
+    atomic_uint link_epoch;   // 运行期:tcp_client 每连上一次 +1,发送引擎据此换到新 fd
 } port_base_t;
 
+// reactor 取数据的方式;io_uring 不可用时启动期自动回退 epoll
+typedef enum {
+    REACTOR_BACKEND_EPOLL = 0,
+    REACTOR_BACKEND_URING,
+} reactor_backend_t;
+
+// tty:{"path", "baudrate", "databits", "stopbits", "parity", "flow", "low_latency"}
+// baudrate 任意正整数(termios2 BOTHER,tty_baud.h),打开时读回驱动实际速率并报告偏差;
+// 不写 / 0 = 115200。low_latency:置 ASYNC_LOW_LATENCY,驱动不支持只告警。
 typedef struct {
     char path[128];
     int baudrate;
@@ -44,24 +184,54 @@ typedef struct {
     int stopbits;
     parity_t parity;
     flow_t flow;
+    int low_latency;
 } port_tty_conf_t;
 
+#define TTY_DEFAULT_BAUD  115200
+
 typedef struct {
     char bind_addr[64];
     int  port;
     int  backlog;
 } port_tcp_server_conf_t;
 
+// tcp_client:{"addr", "port", "reconnect_min_ms", "reconnect_max_ms",
+//              "connect_timeout_ms", "buffer_bytes"}
+// 连接失败 / 断开后第 n 次重连前等 [d/2, d] 内的随机值,d = min(reconnect_min_ms << n,
+// reconnect_max_ms)(port_reconnect_delay_ms)。
 typedef struct {
     char addr[64];
     int  port;
+    int  reconnect_min_ms;
+    int  reconnect_max_ms;
+    int  connect_timeout_ms;   // connect 这么久没完成算失败
+    int  buffer_bytes;         // 断线期间缓存的待发字节上限(port_tx.h);0 = 断线期间的消息丢弃
 } port_tcp_client_conf_t;
 
+#define TCP_CLIENT_RECONNECT_MIN_MS    100
+#define TCP_CLIENT_RECONNECT_MAX_MS    10000
+#define TCP_CLIENT_CONNECT_TIMEOUT_MS  3000
+
+// udp:{"bind", "port", "peer", "peer_port", "learn_peer",
+//       "multicast": {"group", "interface", "ttl", "loop"}}
+// 每条消息一个数据报,发往当前对端:配置的 peer,learn_peer 时换成最近一次收到的
+// 数据报的发送方(没配 peer 时缺省开);都没有则不发。peer 可以是组播地址。
+// multicast.group 非空时加入该组收数据(bind 通常为 0.0.0.0,端口同组播端口)。
 typedef struct {
     char bind_addr[64];
-    int port;
+    int  port;
+    char peer_addr[64];      // 空 = 不配,等学习
+    int  peer_port;
+    int  learn_peer;
+    char mcast_group[64];    // 加入的组播组,空 = 不加入
+    char mcast_if[64];       // 组播收发用的本机地址,空 = 内核选
+    int  mcast_ttl;          // 发组播的 TTL(IP_MULTICAST_TTL)
+    int  mcast_loop;         // 本机是否收到自己发的组播(IP_MULTICAST_LOOP)
+    atomic_ullong peer;      // 运行期:当前对端(port_udp_peer_pack 编码),0 = 没有
 } port_udp_conf_t;
 
+#define UDP_MCAST_DEFAULT_TTL  1
+
 typedef struct {
     char path[128];
 } port_usb_conf_t;
@@ -92,11 +262,21 @@ typedef struct {
     char path[256];
 } plugin_def_t;
 
+// 目的队列满时的处理策略,routes[].policy
+typedef enum {
+    ROUTE_POLICY_BLOCK = 0,      // "block"(缺省):最多等 QUEUE_PUSH_TIMEOUT_MS 再丢
+    ROUTE_POLICY_DROP,           // "drop":立即丢,reactor 不等
+    ROUTE_POLICY_BACKPRESSURE,   // "backpressure":目的队列过高水位即停读源端口,
+                                 //   低水位恢复,由内核缓冲 / RTS-CTS 节流发送方
+} route_policy_t;
+
 typedef struct {
     char src[32];
     char dst[32];
     char plugin[32];
     char handler[64];
+    route_policy_t policy;
+    int splice;     // "splice": false 关掉 splice 直通(route_table.h),配置缺省开
 } route_def_t;
 
 typedef struct {
@@ -108,6 +288,25 @@ typedef struct {
 
     route_def_t   routes[MAX_ROUTES];
     int           route_count;
+
+    // "dispatcher": {"workers": N};0 = 缺省(见 dispatch_pool.h)
+    int           dispatch_workers;
+
+    // "reactor": {"threads": N, "edge_triggered": bool, "backend": "epoll"|"io_uring"};
+    // threads parse 后已夹到 [1, REACTOR_MAX_THREADS],edge_triggered 缺省 true,
+    // backend 缺省 epoll
+    int           reactor_threads;
+    int           reactor_edge;
+    reactor_backend_t reactor_backend;
+
+    // "buffers": {"max_message": N, "count": N, "class_bytes": N}(buf_pool.h 分档):
+    // max_message 缺省 MAX_DATA-1,parse 后已夹到 [MAX_DATA-1, MAX_MESSAGE];
+    // count = BUF_SIZE 档个数,class_bytes = 每个大档的字节预算,0 = 缺省
+    // io_uring 后端的读缓冲固定 BUF_SIZE 档:不分帧的字节流源一次最多 MAX_DATA-1 字节,
+    // 长记录要配 frame 或用 epoll 后端(reactor.h)
+    int           max_message;
+    int           buf_count;
+    int           buf_class_bytes;
 } config_t;
 
 extern config_t g_config;
@@ -120,6 +319,10 @@ int save_config(const char* filename);
 port_def_t* config_find_port(const char* name);
 int config_find_plugin(const char* name);
 void config_print();
+const char* route_policy_name(route_policy_t p);
+const char* reactor_backend_name(reactor_backend_t b);
+const char* slow_client_policy_name(slow_client_policy_t p);
+const char* frame_mode_name(frame_mode_t m);
 
 // find routes
 int config_find_routes_by_src(
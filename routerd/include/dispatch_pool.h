@@ -0,0 +1,114 @@
+#ifndef EZ_ROUTER_DISPATCH_POOL_H
+#define EZ_ROUTER_DISPATCH_POOL_H
+
+// dispatch_pool.h — 按目的端口分队列的 dispatcher worker 池
+//
+// 职责:
+//   - 每个被路由引用为 dst 的端口每个 reactor 一条 lane(event_queue,SPSC:
+//     生产者是该 reactor 线程,消费者是 dst 的归属 worker)。单 reactor 时即一条队列
+//   - N 个 worker 线程,每条队列固定归属一个 worker(dst 序号 % N),
+//     因此同一目的端口的消息严格按入队顺序发送
+//   - 每目的端口独立的深度 / 已发送 / drop 计数
+//
+// 为什么按目的端口拆:单队列 + 单 dispatcher 时,9600 波特 UART 或拥塞 TCP
+//   host 上的一次慢 port_send 会让所有其他目的端口排队(队头阻塞)。
+//   拆开后慢端口只堵自己的队列;与它同 worker 的其他队列仍受影响,
+//   所以关键链路应把 workers 配到 >= 目的端口数。
+//
+// 配置:config.json 顶层 "dispatcher": {"workers": N},缺省 DISPATCH_DEFAULT_WORKERS,
+//   夹到 [1, DISPATCH_MAX_WORKERS] 且不超过目的端口数。
+//
+// 输出合并:目的端口配了 ports[].coalesce 时,worker 把该端口的消息攒在手里,
+//   攒够 max_bytes(或 DISPATCH_COALESCE_MAX_MSGS 条)立即发,否则第一条消息
+//   入手 max_delay_us 后由 worker 的 timerfd 触发发送 —— 更大的写、更少的包,
+//   延迟上限有保证。没配的端口(控制口)照旧零延迟。
+//
+// 多 reactor:lane 数 = g_config.reactor_threads。源端口固定在一个 reactor 上,
+//   所以同一源 → 同一目的端口的消息仍然保序;不同 reactor 的 lane 由 worker 轮流取,
+//   跨源之间本就没有顺序保证。
+//
+// 非阻塞发送:worker 经发送挂钩(dispatch_tx_hooks_t)把写不完的字节交给每端口
+//   输出环,可写时在 worker 自己的循环里冲刷;输出环过高水位的目的端口暂停取队列。
+//
+// 测试:tests/unit/test_dispatch_pool.c
+
+#include "event.h"
+#include "event_queue.h"
+
+#define DISPATCH_MAX_WORKERS     8
+#define DISPATCH_DEFAULT_WORKERS 2
+
+// 每轮每条队列最多连续处理的消息数,也是一次 queue_pop_batch 的上限。
+// 防止一条持续满载的队列饿死同 worker 的其他队列。
+#define DISPATCH_QUANTUM 16
+
+// 一次批量取的字节上限(第一条不受限)。发送环过高水位(port_tx.h PORT_TX_HWM)前还能
+// 收一批:大消息("buffers".max_message)时一批不超过它,整批放得进发送环不被丢
+#define DISPATCH_QUANTUM_BYTES (64 * 1024)
+
+// 输出合并(ports[].coalesce)时每目的端口最多攒的消息数,到了立即发
+#define DISPATCH_COALESCE_MAX_MSGS 64
+
+// 批量消息处理回调。生产路径 = router_core_handle_batch;单测注入桩函数。
+// 回调在 worker 线程内执行,msgs[0..n) 是本轮从一条队列取出的消息(保序),
+// 返回后 worker 统一 buf_unref。
+typedef void (*dispatch_fn_t)(event_msg_t* msgs, int n);
+
+// 发送侧挂钩(可选,dispatch_pool_start 之前设置;生产路径见 router_core_tx_hooks)。
+// 全部在 worker 线程内调用:
+//   thread_init : worker 启动时,建本线程的发送引擎,返回要一起等待的 fd(-1 = 无)
+//   poll        : 每轮取队列前,冲刷已可写的排队端口(不阻塞);返回空闲时最多睡多少 ms
+//                 (-1 = 不限,有待到期的慢 client 时为正)
+//   blocked     : 目的端口(g_config.ports 下标)输出积压过高水位 → 本轮不取它的队列,
+//                 积压留在路由队列里由路由策略处理;回落后 poll 之后自然恢复
+//   round_begin / round_end : 每轮(poll + 取队列 + 发送)前后,睡眠不在其间。生产路径标
+//                 port_manager 的读侧区间:区间内解析出的端口不会被 reactor 回收(port_retire)
+//   thread_exit : worker 退出前
+typedef struct {
+    int  (*thread_init)(void);
+    int  (*poll)(void);
+    int  (*blocked)(int port_id);
+    void (*round_begin)(void);
+    void (*round_end)(void);
+    void (*thread_exit)(void);
+} dispatch_tx_hooks_t;
+
+void dispatch_pool_set_tx_hooks(const dispatch_tx_hooks_t* hooks);
+
+// 按 g_config.routes 的 dst 建队列并分配 worker。必须在 load_config 之后、
+// reactor 线程启动之前调用。返回目的队列数(>=0),-1 = 内存 / eventfd 失败。
+int dispatch_pool_init(int workers, dispatch_fn_t fn);
+
+// 启动 worker 线程。返回实际启动的 worker 数。
+int dispatch_pool_start(void);
+
+// 停止并 join 所有 worker,释放队列(进程退出前调用)。
+void dispatch_pool_stop(void);
+
+// 按目的端口名取 reactor 0 的 lane。未被任何路由引用的端口返回 NULL。
+event_queue_t* dispatch_queue_by_name(const char* dst);
+
+// route_table 用:目的端口在指定 reactor 上的 lane。reactor 越界 / dst 无队列返回 NULL。
+event_queue_t* dispatch_lane(const char* dst, int reactor);
+
+// lane 数(= reactor 线程数,init 时由 g_config.reactor_threads 定)
+int dispatch_pool_lanes(void);
+
+typedef struct {
+    char          name[32];
+    int           worker;
+    unsigned      depth;       // 以下三项为各 lane 之和
+    unsigned long sent;
+    unsigned long drops;
+    unsigned long batches;     // 回调次数;sent / batches = 平均批大小
+    unsigned      batch_max;   // 单批最大条数
+    unsigned long timer_flushes;   // 合并端口:因 max_delay_us 到期而发的批数
+} dispatch_dst_stats_t;
+
+// 复制每目的端口计数到 out,返回条数。
+int dispatch_pool_get_stats(dispatch_dst_stats_t* out, int max);
+
+// 以 LOG_DEBUG 打印每目的端口计数(主线程周期调用)。
+void dispatch_pool_log_stats(void);
+
+#endif // EZ_ROUTER_DISPATCH_POOL_H
@@ -5,6 +5,10 @@
 
 #define MAX_DATA 1024
 
+// 一条消息最长可配到多少字节(config "buffers".max_message,缺省 MAX_DATA-1)。
+// 受发送环(port_tx.h PORT_TX_RING_BYTES)约束:整条消息必须能一次入环
+#define MAX_MESSAGE (64 * 1024 - 1)
+
 typedef enum {
     EVT_USB_IN = 1,
     EVT_UART_IN,
@@ -12,12 +16,18 @@ typedef enum {
     EVT_GENERIC_IN      // 可选：通用“来自任意端口”
 } event_type_t;
 
+struct buf;   // buf_pool.h
+
+// 队列里只放消息头,数据在引用计数缓冲里(buf_pool.h)。
+// 槽位持有 buf 的一个引用,消费方处理完后 buf_unref。
+// buf 为 NULL 时 data 指向外部内存(单测 / bench),消费方不释放。
 typedef struct {
     // int src_port;        // ★ 新增：表示数据来自哪个物理端口（USB/UART/NET/SPI）
-    char dst[32];           // known where to send
+    uint32_t dst;           // 目的端口句柄(port_manager.h,port_handle_t)
     //event_type_t type;   // 保留：事件类型
     int len;
-    uint8_t data[MAX_DATA];
+    struct buf* buf;
+    uint8_t*    data;       // = buf->data
 } event_msg_t;
 
 #endif
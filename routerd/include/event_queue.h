@@ -1,6 +1,7 @@
 #ifndef EVENT_QUEUE_H
 #define EVENT_QUEUE_H
 
+#include <stdatomic.h>
 #include "event.h"
 
 // queue_push 超时阈值。
@@ -8,16 +9,115 @@
 // 100ms 比 watchdog 44s 兜底窗口短两个数量级,慢消费者下及时降级,避免 reactor 卡死。
 #define QUEUE_PUSH_TIMEOUT_MS 100
 
-void queue_init(void);
+// 每个队列的槽位数,必须是 2 的幂;有效容量 QSIZE-1。
+#define QSIZE 128
+
+#define EQ_CACHELINE 64
+
+// backpressure 路由的水位(条数 / 字节)。深度或排队字节任一 >= 高水位时 reactor 停读
+// 源端口,两者都消费到 <= 低水位时经 resume eventfd 通知 reactor 恢复。两者拉开避免抖动。
+// 字节水位只对大消息("buffers".max_message)起作用:1 KiB 的消息先到条数水位;
+// 几十 KB 的记录按字节停读,队列里压着的大缓冲不会把池里的大档用光。
+#define QUEUE_HIGH_WATERMARK (QSIZE * 3 / 4)
+#define QUEUE_LOW_WATERMARK  (QSIZE / 4)
+#define QUEUE_HIGH_WATERMARK_BYTES (512 * 1024)
+#define QUEUE_LOW_WATERMARK_BYTES  (128 * 1024)
+
+// 消费者睡眠点。一个 dispatcher worker 消费多个队列,共享一个 waiter:
+//   worker 先 queue_waiter_prepare,再重检自己所有队列,都空才 queue_waiter_sleep;
+//   任一队列 commit 时若看到 waiting 就 write eventfd 唤醒它。
+typedef struct {
+    _Alignas(EQ_CACHELINE) atomic_uint waiting;
+    int efd;
+} queue_waiter_t;
+
+int  queue_waiter_init(queue_waiter_t* w);
+void queue_waiter_destroy(queue_waiter_t* w);
+void queue_waiter_prepare(queue_waiter_t* w);
+void queue_waiter_cancel(queue_waiter_t* w);
+// 返回 1 = 被唤醒,0 = 超时。timeout_ms < 0 表示无限等。
+int  queue_waiter_sleep(queue_waiter_t* w, int timeout_ms);
+// 同 queue_waiter_sleep,但同时等 extra_fd 可读(如 worker 的 timerfd)。
+// extra_fd 只 poll 不 read,由 caller 处理。返回 1 = 被唤醒或 extra_fd 可读,0 = 超时。
+int  queue_waiter_sleep_fd(queue_waiter_t* w, int extra_fd, int timeout_ms);
+// 同上,等多个 extra fd(最多 QUEUE_WAITER_MAX_FDS 个,<0 的跳过)。
+#define QUEUE_WAITER_MAX_FDS 4
+int  queue_waiter_sleep_fds(queue_waiter_t* w, const int* extra, int n, int timeout_ms);
+// 无条件唤醒(停机用,不依赖 waiting 标志)。
+void queue_waiter_wake(queue_waiter_t* w);
+
+// SPSC 无锁环(见 event_queue.c 文件头):
+//   push/reserve/commit 只能由 reactor 线程调用,pop/peek/release 只能由
+//   该队列所属的一个 dispatcher worker 调用。
+// 字段仅 event_queue.c 访问,放在头文件是为了 cache line 布局一目了然。
+typedef struct {
+    _Alignas(EQ_CACHELINE) atomic_uint head;     // 下一个要读的位置,仅消费者推进
+    atomic_ulong    head_bytes;                  // 累计出队字节(slot.len 之和),仅消费者写
+    _Alignas(EQ_CACHELINE) atomic_uint tail;     // 下一个要写的位置,仅生产者推进
+    atomic_ulong    tail_bytes;                  // 累计入队字节,仅生产者写
+    _Alignas(EQ_CACHELINE) atomic_uint prod_waiting;
+    atomic_uint     throttled;                   // 生产者过高水位时置位,消费者到低水位时清
+    int             resume_efd;                  // throttled 清除时 write,-1 = 未启用
+    int             efd_not_full;
+    queue_waiter_t* consumer;
+    atomic_ulong    drop_count;
+    atomic_ulong    pop_count;
+    char            name[32];
+    queue_waiter_t  own_waiter;                  // consumer==NULL 创建时使用
+    event_msg_t     slots[QSIZE];
+} event_queue_t;
+
+// consumer 为 NULL 时队列自带 waiter(单队列消费者,如单测 / bench)。
+event_queue_t* queue_create(const char* name, queue_waiter_t* consumer);
+void queue_destroy(event_queue_t* q);
 
 // 入队;返回 0 = 成功,-1 = timeout drop(队列持续满 QUEUE_PUSH_TIMEOUT_MS)。
 // caller 当前可忽略返回值;计数器由 queue_get_drop_count() 暴露,
 // 阶段 1 STATS 帧落地时(open-questions U3)会用到。
-int  queue_push(event_msg_t* msg);
+int  queue_push(event_queue_t* q, event_msg_t* msg);
+
+void queue_pop(event_queue_t* q, event_msg_t* msg);
+
+// ---- 零拷贝接口(槽位就地读写) ----
+//
+// 生产者:queue_reserve 返回 tail 槽位指针,caller 直接往里 read()/跑 plugin,
+//   填好 dst/len 后 queue_commit 发布。满时等待规则同 queue_push,超时返回 NULL
+//   并计入 drop_count。reserve 之后不 commit 即放弃该槽位,下次 reserve 拿到同一个。
+//   同一队列同一时刻最多一个未提交的 reservation。
+event_msg_t* queue_reserve(event_queue_t* q);
+void queue_commit(event_queue_t* q);
+
+// 不等待版本:满即返回 NULL 并计入 drop_count("drop" / "backpressure" 策略用)。
+event_msg_t* queue_try_reserve(event_queue_t* q);
+
+// ---- 水位 / 背压(生产者侧) ----
+//
+// queue_set_resume_fd:登记 reactor 的 resume eventfd(启动时调用一次)。
+// queue_over_high_watermark:深度 >= QUEUE_HIGH_WATERMARK 或排队字节 >=
+//   QUEUE_HIGH_WATERMARK_BYTES 时置 throttled 并返回 1,调用方据此停读源端口;之后消费者
+//   把两者都降到低水位时清 throttled 并 write resume_efd。置位后重检深度(与 queue_release 的 Dekker 握手),
+//   已被消费到低水位以下则返回 0,不会出现"停了读却没人通知恢复"。
+void queue_set_resume_fd(event_queue_t* q, int efd);
+int  queue_over_high_watermark(event_queue_t* q);
+
+// 消费者:queue_peek 阻塞直到有数据,返回 head 槽位指针;queue_try_peek 空时返回 NULL。
+//   指针在 queue_release 之前一直有效且独占(生产者不会覆盖);不要改槽位的 len
+//   (出队字节按它算)。
+event_msg_t* queue_peek(event_queue_t* q);
+event_msg_t* queue_try_peek(event_queue_t* q);
+void queue_release(event_queue_t* q);
+
+// 批量出队:一次取走最多 max 条已提交消息,消息头按值拷到 out(数据仍在 buf 里,
+//   buf 引用随之转给 caller),只推进一次 head。空时返回 0,不阻塞。
+int queue_pop_batch(event_queue_t* q, event_msg_t* out, int max);
 
-void queue_pop(event_msg_t* msg);
+// 同上,另外取出的 len 之和不超过 max_bytes(第一条总是取,不管多长)。
+int queue_pop_batch_bytes(event_queue_t* q, event_msg_t* out, int max, unsigned long max_bytes);
 
-// 累计 timeout drop 计数,monotonically 增长。
-unsigned long queue_get_drop_count(void);
+// 计数器,任意线程可读(近似值,只用于统计)。
+unsigned      queue_depth(event_queue_t* q);
+unsigned long queue_bytes(event_queue_t* q);            // 排队中的消息字节
+unsigned long queue_get_drop_count(event_queue_t* q);   // 累计 drop(timeout / 满即丢),单调增长
+unsigned long queue_get_pop_count(event_queue_t* q);    // 累计消费条数
 
 #endif
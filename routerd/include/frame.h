@@ -0,0 +1,87 @@
+#ifndef EZ_ROUTER_FRAME_H
+#define EZ_ROUTER_FRAME_H
+
+// frame.h — 收方向增量分帧(字节流端口作为源时)
+//
+// 职责:
+//   - 把一次次 read 到的任意片段切成设备的完整帧,每帧路由一次;半帧留在
+//     frame_rx_t 里跨读累积,plugin 拿到的总是整帧
+//   - 模式(config_store.h 的 port_frame_t):
+//       delimiter  以 1..FRAME_DELIM_MAX 字节的分隔符结尾,可选保留分隔符
+//       length     固定位置的长度字段(offset / width 1|2|4 / 大小端),
+//                  帧长 = offset + width + 字段值 + adjust
+//       slip       RFC 1055,END 0xC0 分帧、ESC 0xDB 转义,输出解码后的内容
+//       cobs       0x00 分帧,输出解码后的内容
+//       idle       字节间静默 idle_us 即一帧结束(到期判定在 reactor,见 frame_idle_due)
+//       modbus_rtu 同 idle,静默按 tty 线路参数取 3.5 个字符时间(config_store.h);另外统计
+//                  帧内超过 1.5 字符的短间隙(规范上该帧无效,这里只计数)
+//   - 超过 max_len 的帧 / 编码错误的帧丢弃计数(drops),之后在下一个帧边界重新同步:
+//     delimiter / slip / cobs / idle 丢到下一个分隔符 / 静默;length 跳过声明的长度,
+//     长度字段本身不合理(比头还短)时滑过一个字节重新找头
+//
+// 零拷贝:当前没有半帧、整帧落在本次输入里的 delimiter / length 帧直接返回指向输入的
+// 指针(reactor 据此把读缓冲原样交给路由);其余帧在 frame_rx_t.buf 里拼好 / 解码。
+// buf 按 max_len 首次用到时分配(最长 MAX_MESSAGE,见 config "buffers"),frame_rx_free 释放;
+// 全零的 frame_rx_t 即可直接用。
+//
+// 并发:frame_rx_t 属于一个连接,只由该端口所在的 reactor 线程访问。
+//
+// 测试:tests/unit/test_frame.c
+
+#include <stdint.h>
+#include "config_store.h"
+#include "event.h"
+
+// 拼帧缓冲:最长帧 ml(再留一个位置给 '\0'),外加不保留的分隔符 /
+// cobs 编码后每 254 字节多出的码字节
+#define FRAME_BUF_BYTES(ml)  ((ml) + 1 + FRAME_DELIM_MAX + ((ml) + 1) / 254 + 2)
+
+typedef struct frame_rx {
+    uint8_t*      buf;
+    int           cap;        // buf 的容量,按当前配置不够时增长
+    int           n;          // buf 里已有的字节
+    int           discard;    // 丢弃中:到下一个边界为止(length:在滑字节找头)
+    int           skip;       // length:超长帧还要跳过的字节
+    int           esc;        // slip:上一个字节是 ESC
+    uint64_t      last_ns;    // idle:最近一次收到字节的时刻
+    uint64_t      split_ns;   // idle:上一帧静默出帧时最后一个字节的时刻,0 = 已核对
+    unsigned long frames;     // 切出的帧
+    unsigned long drops;      // 超长 / 编码错误丢弃的帧
+    // idle 帧边界的调参计数(读到字节的时刻含驱动 / 调度延迟,只作统计):
+    unsigned long short_gaps;   // modbus_rtu:帧内字节间隔超过 t1.5(还没到 t3.5)
+    unsigned long early_splits; // 出帧后不到一个静默间隔又来了字节:这一帧多半被拆开了
+} frame_rx_t;
+
+// 端口(accept 出的 client 看 server 的配置)生效的分帧配置;不分帧返回 NULL。
+// 只对字节流端口生效:udp 一个数据报就是一条消息。
+const port_frame_t* frame_conf_of(const port_def_t* port);
+
+void frame_rx_reset(frame_rx_t* fr);
+
+// 释放拼帧缓冲(连接断开时);之后 fr 回到全零状态
+void frame_rx_free(frame_rx_t* fr);
+
+// 从 *in / *in_len 消耗输入,切出下一帧:返回帧长(> 0),*out 指向帧数据
+// (指向输入或 fr->buf,下次调用前有效);输入用完还没有完整帧返回 0,半帧留在 fr 里。
+// idle 模式不在这里出帧,输入全部累积,由 frame_take 在静默到期时取走。
+int frame_next(frame_rx_t* fr, const port_frame_t* c,
+               const uint8_t** in, int* in_len, const uint8_t** out);
+
+// idle / modbus_rtu:now_ns 时刻读到的 in[0, len) 累积进当前帧,并更新短间隙 /
+// 提前拆帧计数。reactor 用它代替 frame_next(frame_next 不看时间)
+void frame_idle_feed(frame_rx_t* fr, const port_frame_t* c,
+                     const uint8_t* in, int len, uint64_t now_ns);
+
+// 帧间静默(ns);不是按静默分帧的模式返回 0
+uint64_t frame_gap_ns(const port_frame_t* c);
+
+// 输入丢了一段(读到了但池耗尽没存下):当前半帧作废,在下一个帧边界重新同步
+void frame_rx_gap(frame_rx_t* fr, const port_frame_t* c);
+
+// idle:取走累积的帧(静默到期 / 对端关闭时);没有返回 0
+int frame_take(frame_rx_t* fr, const port_frame_t* c, const uint8_t** out);
+
+// idle:累积中的帧到期时刻(ns,同 CLOCK_MONOTONIC);没有累积返回 0
+uint64_t frame_idle_due(const frame_rx_t* fr, const port_frame_t* c);
+
+#endif // EZ_ROUTER_FRAME_H
@@ -2,17 +2,34 @@
 #define PLUGIN_LOADER_H
 
 #include <stdint.h>
+#include "buf_pool.h"
 
-// 插件 handler 契约(见 PROJECT_CONTEXT.MD 条目 5):
+// 插件 handler 有两种 ABI,登记在同一张表里,路由配置写法不变("插件名.函数名"):
+//
+// v1 契约(见 PROJECT_CONTEXT.MD 条目 5):
 // - 就地修改 data,返回新长度
-// - 新长度必须在 [0, MAX_DATA] 区间(MAX_DATA=1024,见 event.h)
+// - 新长度必须在 [0, max(len, MAX_DATA)] 区间(MAX_DATA=1024,见 event.h);
+//   配了大消息("buffers".max_message)时 len 可以超过 MAX_DATA,缓冲至少放得下 len
 // - 调用方(reactor)会 clamp 越界返回值,但 plugin 仍应自律,
 //   越界即代表 plugin 实现错误,会被截断并打 WARN
 typedef int (*plugin_handler_t)(uint8_t* data, int len);
 
+// v2 契约:输入只读,输出直接写进下一级(目的队列)要用的池缓冲,不用在原地 memmove
+// - in / in_len  : 收到的消息,handler 不能改
+// - out / out_cap: 输出缓冲,out_cap >= min(max(in_len, MAX_DATA), 消息上限);
+//                  消息上限 = max("buffers".max_message, MAX_DATA)
+// - 返回 0..out_cap → 输出长度
+//   返回 > out_cap  → "需要这么多字节":调用方换一个至少这么大的缓冲再调一次
+//                     (只重试一次;超过消息上限 / 池里没有这么大的缓冲则丢弃本路由)
+//   返回 < 0        → 丢弃本路由
+// - 同一条消息可能被调两次(先问大小再写),handler 不能有依赖调用次数的副作用
+typedef int (*plugin_handler_v2_t)(const uint8_t* in, int in_len,
+                                   uint8_t* out, int out_cap);
+
 typedef struct{
     char full_name[128];
-    plugin_handler_t func;
+    plugin_handler_t func;        // v1;v2 登记的表项为 NULL
+    plugin_handler_v2_t func2;    // v2;v1 登记的表项为 NULL
 }handler_entry_t;
 
 #define MAX_HANDLERS 256
@@ -21,7 +38,20 @@ void plugin_register_handler(const char* plugin_name,
                              const char* handler_name,
                              plugin_handler_t func);
 
+void plugin_register_handler_v2(const char* plugin_name,
+                                const char* handler_name,
+                                plugin_handler_v2_t func);
+
+// 按全名查。名字登记的是另一种 ABI 时返回 NULL
 plugin_handler_t plugin_get_handler(const char* flullname);
+plugin_handler_v2_t plugin_get_handler_v2(const char* fullname);
+
+// 按 v2 契约调一次 handler:分配输出缓冲(至少 max(in_len, MAX_DATA),不超过 max_len)、
+// 调用、需要更多时按要求换缓冲重调一次。
+// 成功返回输出缓冲(调用方持有一个引用),*out_len 为输出长度;
+// 丢弃(handler 返回 < 0、要的超过 max_len、池耗尽)返回 NULL 并打 WARN,name 只用于日志
+buf_t* plugin_call_v2(plugin_handler_v2_t func, const char* name,
+                      const uint8_t* in, int in_len, int max_len, int* out_len);
 
 void plugin_list_handlers();
 int plugin_load(const char*);
@@ -1,6 +1,7 @@
 #ifndef PORT_MANAGER_H
 #define PORT_MANAGER_H
 
+#include <stdatomic.h>
 #include "config_store.h"   // 需要 g_config 和 port_def_t
 // #include "reactor.h"        // 需要 reactor_add_fd()
 
@@ -25,15 +26,110 @@ int port_get_fd_by_name(const char* name);
 
 int port_send(port_def_t* p, const uint8_t* data, int len);
 
+// 为 tcp_server 再开一个同地址 listener(多 reactor 时 SO_REUSEPORT 分组,
+// 每个 reactor 一个,内核分摊 accept)。返回 fd,失败 -1。
+int port_open_tcp_listener(port_def_t* p);
+
+// 按 p->base.sock 设 socket 选项(config_store.h 的 port_sockopt_t),返回设置失败的项数
+// (每项失败告警,不影响其他项)。打开 tcp / udp 端口时调;accept 出的 client 用 server 的
+// 配置再调一遍。
+int port_apply_sockopts(const port_def_t* p, int fd);
+
+// tcp_client:建非阻塞 socket 并发起 connect,不等完成(reactor 等 EPOLLOUT 判定)。
+// 返回 fd,socket 建不了返回 -1。启动时经 port_open_single 调,断线重连时 reactor 调。
+int port_open_tcp_client(port_def_t* p);
+
+// 第 attempt 次(从 0 起)重连前等多少 ms:reconnect_min_ms 每次翻倍、封顶
+// reconnect_max_ms,再在 [d/2, d] 内按 rnd 抖动。rnd 由调用方给(单测可复现)。
+int port_reconnect_delay_ms(const port_tcp_client_conf_t* c, int attempt, unsigned rnd);
+
+// tcp_client 当前连着(其他类型端口恒为真)。任意线程可调。
+static inline int port_link_up(const port_def_t* p)
+{
+    return atomic_load_explicit(&p->base.link, memory_order_acquire) == PORT_LINK_UP;
+}
+
+// udp 当前对端(配置的 peer 或学到的发送方),写入 *out 返回 1;没有返回 0。任意线程可调。
+struct sockaddr_in;
+int port_udp_peer(const port_def_t* p, struct sockaddr_in* out);
+
+// reactor 收到数据报后调:learn_peer 开着时把对端换成 from(没变不写)。
+void port_udp_learn(port_def_t* p, const struct sockaddr_in* from);
+
+// 批量发送 cnt 段(每段一条消息),一次 writev;各类型语义同 port_send。
+struct iovec;
+int port_send_batch(port_def_t* p, const struct iovec* iov, int cnt);
+
+// 同上,bufs[i] 是第 i 段所在的池缓冲(buf_pool.h,可为 NULL)。写不完要排队时
+// 输出环引用缓冲而不拷贝;广播给多个 client 时共享同一个缓冲。
+struct buf;
+int port_send_batch_bufs(port_def_t* p, const struct iovec* iov, struct buf* const* bufs, int cnt);
+
+// tcp_server / ipc_server 当前 accept 出的 client(广播目标)的句柄快照,最多 max 个,
+// 返回个数。无锁扫 g_port_table;client 随时可能断开,每次发送前用 port_from_handle 再解析。
+int port_server_clients(const port_def_t* server, port_handle_t* out, int max);
+
 
 // #define MAX_PORTS 128
 typedef struct{
 	int used;
 	int fd;
 	port_def_t* port;
+	atomic_uint gen;       // 槽位每次释放 +1,旧句柄随之失效
 }port_entry_t;
 
 extern port_entry_t g_port_table[MAX_PORTS];
 
+// ========================================================
+//  端口句柄:event_msg_t 里只带一个整数,取端口 = 数组下标 + generation 校验
+// ========================================================
+// 编码:低 16 位 = g_port_table 下标 + 1(所以 0 永远无效),高 16 位 = generation。
+// 端口(含 accept 出的 TCP/IPC client)注册时拿句柄,断开注销时槽位 gen+1:
+// 队列里仍指向旧连接的消息解析失败被丢弃,不会写到复用了同一 fd 的新连接上。
+// 同一槽位复用 65536 次后 generation 回绕,对本项目的连接数量级足够。
+#define PORT_HANDLE_INVALID 0u
+
+// 占一个 g_port_table 槽,句柄写入 p->base.handle 并返回。表满返回 PORT_HANDLE_INVALID。
+// 在 reactor 线程(及启动阶段)调用;多 reactor 并发注册由内部锁串行化。
+port_handle_t port_register(port_def_t* p);
+
+// 释放句柄对应的槽位(generation 前进)。在 reactor 线程调用,内部加锁。
+void port_unregister(port_handle_t h);
+
+// 句柄 → 端口。槽位空 / generation 不符返回 NULL。任意线程可调,O(1)。
+port_def_t* port_from_handle(port_handle_t h);
+
+// 句柄的槽位下标 [0, MAX_PORTS),无效句柄 -1。不校验 generation(调用方自己比句柄)。
+int port_handle_slot(port_handle_t h);
+
+// ========================================================
+//  断开端口的延迟回收:fd 和 accept 出的 client 不在 reactor 里立即 close / free
+// ========================================================
+// dispatch worker 从句柄解析出端口后就直接写它的 fd;reactor 同时可能在注销、关 fd、
+// 释放 client。立即回收的话 worker 会写已释放的 port_def_t,或写到内核已分给新连接的
+// 同号 fd。做法是 epoch:
+//   - 读侧(dispatch worker)每线程 port_reader_register 一次;每轮处理(冲刷 + 取队列 +
+//     发送)前 port_read_begin,处理完 port_read_end。区间内解析出的端口和它的 fd
+//     一直有效;区间外(睡眠时)不持有任何端口
+//   - reactor 断开端口时先 port_unregister,再 port_retire 代替 close(fd) / free(p):
+//     没有读侧停在更早的一轮里就立即回收,否则挂起,由最后离开那一轮的读侧回收
+// 没登记的线程(单测、工具)不受保护,自己保证不与断开并发。
+#define PORT_READERS_MAX 16
+
+// 登记本线程为读侧。返回 0,槽满返回 -1(该线程不受保护,打 ERROR)
+int  port_reader_register(void);
+// 注销本线程(线程退出前)
+void port_reader_unregister(void);
+// 进入 / 离开一轮。port_read_end 顺带回收已到期的挂起项。未登记的线程调用是空操作
+void port_read_begin(void);
+void port_read_end(void);
+
+// 回收一个已注销的端口:关 fd(>= 0 时),p 非 NULL 时 free(p)(只给 malloc 出来的
+// accept client)。可能推迟到读侧都离开当前一轮之后,在读侧线程里执行。
+void port_retire(port_def_t* p, int fd);
+
+// 挂起待回收的项数(单测 / 统计用)
+int  port_retired_pending(void);
+
 port_def_t* port_find(const char* name);
 #endif
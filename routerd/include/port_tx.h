@@ -0,0 +1,125 @@
+#ifndef EZ_ROUTER_PORT_TX_H
+#define EZ_ROUTER_PORT_TX_H
+
+// port_tx.h — 非阻塞发送引擎:每端口有界输出环 + EPOLLOUT 冲刷
+//
+// 职责:
+//   - 所有写都不阻塞:socket 用 MSG_DONTWAIT | MSG_NOSIGNAL,tty / usb 在 open 时已是
+//     O_NONBLOCK。写不完(短写 / EAGAIN)的部分进该端口的输出环,挂 EPOLLOUT,
+//     可写时由 port_tx_poll 接着写,保证同一端口字节不乱序、不截断
+//   - 输出环有界(PORT_TX_RING_BYTES):放不下的消息整条丢弃并计数(不撕裂消息)
+//   - 消息在池缓冲里(buf_pool.h)且不小于 PORT_TX_REF_MIN 时,排队只持有缓冲的引用,
+//     不拷贝;server 广播时所有 client 的环共享同一个缓冲,最后一个写完才归还
+//   - MSG_ZEROCOPY:端口配了 zerocopy_min(config_store.h)时,不小于阈值的直写带
+//     MSG_ZEROCOPY,缓冲引用持有到内核报告完成(只对 TCP;AF_UNIX 不支持,自动退回)
+//   - 高 / 低水位:环超过 PORT_TX_HWM 起 port_tx_blocked 为真,降到 PORT_TX_LWM
+//     以下才恢复。dispatch worker 据此暂停取该目的端口的队列,积压回到路由队列,
+//     由路由的 block / drop / backpressure 策略处理。server 端口按其 client 汇总
+//   - 慢 client:server 配了 slow_client(config_store.h)时,accept 出的 client 积压超
+//     budget 持续 grace_ms 后断开 / 降级为只留最新 / 丢最旧,不再拖住 server 和其他 client
+//   - tcp_client 断线重连(reactor.h):断线期间环不挂 epoll,消息在该端口
+//     buffer_bytes(config_store.h)以内入环缓存,超出整条丢弃;重连后按序发到新连接
+//   - 每端口计数:排队字节、短写次数、溢出丢弃、慢 client 处理(按 g_config.ports 下标,
+//     accept 出的 client 计入其 server);每个 client 的积压和落后时长见 port_tx_clients
+//
+// 并发:一个 port_tx_t 只由一个线程使用(每个 dispatch worker 一个,目的端口固定
+//   归属一个 worker,所以每个端口的环只有一个写者)。环按 g_port_table 槽位索引,
+//   记下端口句柄;句柄过期(连接断开 / 槽位复用)时残留字节计为丢弃。
+//   统计是原子量,任意线程可读。
+//
+// 测试:tests/unit/test_port_tx.c
+
+#include <stdint.h>
+#include <sys/uio.h>
+#include "config_store.h"
+
+#define PORT_TX_RING_BYTES  (128 * 1024)
+#define PORT_TX_HWM         (64 * 1024)
+#define PORT_TX_LWM         (16 * 1024)
+#define PORT_TX_SEGS        1024          // 每环最多排队的段数(约一段一条消息)
+#define PORT_TX_REF_MIN     256           // 不小于此长度的池缓冲消息引用排队,更小的拷贝
+#define PORT_TX_RELINK_MS   10            // 有 tcp_client 断线缓存时,worker 查重连的间隔
+
+typedef struct port_tx port_tx_t;
+
+// 建 / 销毁一个发送引擎(销毁时环里未发出的字节丢弃)。失败返回 NULL。
+port_tx_t* port_tx_create(void);
+void       port_tx_destroy(port_tx_t* tx);
+
+// 线程局部的当前引擎:port_send / port_send_batch 经它发送。
+// 未绑定的线程(单测等)退回同步 writev。
+void       port_tx_bind(port_tx_t* tx);
+port_tx_t* port_tx_current(void);
+
+// epoll fd:有排队端口可写时可读。调用方把它放进自己的等待集合,醒来调 port_tx_poll。
+int  port_tx_fd(const port_tx_t* tx);
+
+// 冲刷所有可写的排队端口(不阻塞)。返回本次从高水位降到低水位以下的端口数。
+int  port_tx_poll(port_tx_t* tx);
+
+// 最近一个慢 client 宽限期到期还有多少 ms(-1 = 没有);tcp_client 有断线缓存等重连、
+// 或有积压挂在可能已断开的旧连接上时不超过
+// PORT_TX_RELINK_MS。调用方睡眠不要超过它,醒来调 port_tx_poll 做到期处理
+// (对端完全不读 / 重连时没有别的事件能叫醒)。
+int  port_tx_timeout_ms(port_tx_t* tx);
+
+// 向单个字节流端口(tty / usb / tcp_client / ipc_client)发 cnt 段,每段一条消息。
+// 环空时先直接写,剩下的排队;环不空时直接排队(保序)。
+// bufs[i] 是第 i 段所在的池缓冲(可为 NULL,整个数组也可为 NULL):排队 / 零拷贝时
+// 引用它,调用方返回后照常 unref 即可。
+// 返回写出 + 排队的字节数,-1 = fd 出错(已计数,调用方记日志)。
+struct buf;
+int  port_tx_write(port_tx_t* tx, port_def_t* p, const struct iovec* iov,
+                   struct buf* const* bufs, int cnt);
+
+// 调用方已经写出前 skip 字节(如 io_uring 的短写),剩余部分排队,不再尝试直接写。
+int  port_tx_queue(port_tx_t* tx, port_def_t* p, const struct iovec* iov,
+                   struct buf* const* bufs, int cnt, size_t skip);
+
+// 端口当前没有排队字节,也没被当作慢 client 断开(可以绕过环直接写)
+int  port_tx_idle(port_tx_t* tx, const port_def_t* p);
+
+// 端口(g_config.ports 下标)有环在高水位以上(滞回,见文件头)。server 端口看它
+// accept 出的所有 client,任一积压即为真(和原来阻塞写时被最慢 client 拖住一致);
+// server 配了非 block 的 slow_client 策略时 client 不计入。
+// 已断开连接的残留顺带清掉,不计入。
+int  port_tx_blocked(port_tx_t* tx, int port_id);
+
+typedef struct {
+    unsigned long queued_bytes;     // 当前各环里排队的字节数
+    unsigned long queued_max;       // 排队字节峰值
+    unsigned long short_writes;     // 直接写没写完(含 EAGAIN)的次数
+    unsigned long flushes;          // EPOLLOUT 冲刷的写次数
+    unsigned long overflow_drops;   // 环满丢弃的消息数
+    unsigned long overflow_bytes;   // 丢弃的字节(环满 + 断开 / 出错时环里的残留)
+    unsigned long errors;           // 写出错(对端关闭等),环里残留一并丢弃
+    unsigned long lag_drops;        // 慢 client 策略丢的消息数(含断开后到注销前的写)
+    unsigned long lag_bytes;
+    unsigned long evictions;        // 因慢被断开的 client 数
+    unsigned long downgrades;       // 进入 latest / drop_oldest 的次数
+    unsigned long ref_msgs;         // 按缓冲引用(不拷贝)排队的消息数
+    unsigned long zc_sends;         // 带 MSG_ZEROCOPY 的 sendmsg 次数
+    unsigned long zc_copied;        // 其中内核报告实际做了拷贝的完成通知数(如 loopback)
+    unsigned long offline_msgs;     // tcp_client 断线期间缓存下来的消息数
+    unsigned long offline_drops;    // 断线期间丢弃的消息数(没配缓存 / 超出 buffer_bytes)
+} port_tx_stats_t;
+
+typedef struct {
+    int           fd;
+    unsigned long queued;           // 当前积压字节
+    unsigned long lag_ms;           // 已连续超 budget 多久,0 = 没超
+} port_tx_client_t;
+
+// 按 g_config.ports 下标取计数。越界返回 -1。
+int  port_tx_get_stats(int port_id, port_tx_stats_t* out);
+
+// 所有引擎当前持有的缓冲引用数(排队 + 零拷贝在途)。全局上限是缓冲池的一半。
+int  port_tx_refs_held(void);
+
+// server(g_config.ports 下标)当前各 client 的积压。返回个数。
+int  port_tx_clients(int server_id, port_tx_client_t* out, int max);
+
+// DEBUG 级别打印有发送活动的端口
+void port_tx_log_stats(void);
+
+#endif // EZ_ROUTER_PORT_TX_H
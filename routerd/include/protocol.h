@@ -93,4 +93,11 @@ int proto_decode(const uint8_t* in_buf, size_t in_len,
                  proto_frame_hdr_t* hdr_out,
                  const uint8_t** payload_out);
 
+// 重同步: decode 返回 BAD_MAGIC 后,找 in_buf 里下一个可能的帧头(magic 匹配,
+//   且已收到的 version 字节也匹配)。跳过 in_buf[0],即当前这个坏头。
+// 返回 caller 应丢弃的字节数:
+//   < in_len   下一个候选帧头的偏移,丢掉之前的字节后重新 decode
+//   = in_len   没有候选,全部丢弃;末字节恰是 magic 的前半时少丢这一个(返回 in_len - 1)
+size_t proto_resync(const uint8_t* in_buf, size_t in_len);
+
 #endif // EZ_ROUTER_PROTOCOL_H
@@ -7,8 +7,108 @@
 
 #define MAX_REACT_FDS 64
 
-// 初始化
-void reactor_init(void);
+// 每次 epoll_wait 最多取的事件数
+#define REACTOR_MAX_EVENTS 64
+
+// 读路径:数据端口缺省边沿触发("reactor": {"edge_triggered": false} 退回水平触发),
+//   一次就绪读到 EAGAIN / 短读为止。每次 readv 进最多 REACTOR_RX_SEGS_MAX 个池缓冲
+//   (各切成一条消息),段数按端口自适应。段缺省 MAX_DATA-1 字节;配了
+//   "buffers".max_message 时段容量也随读满增长到池的最大一档(buf_pool.h),
+//   不分帧的端口一次读就是一条最长 max_message 的消息。要保持记录边界用分帧 / udp。
+//   单端口一次就绪最多 REACTOR_READ_BUDGET 次 readv,仍满读就排到下一轮,不饿死同
+//   reactor 的其他端口。
+#define REACTOR_RX_SEGS_MAX  16
+#define REACTOR_READ_BUDGET  16
+
+// splice 直通(epoll 后端):路由表标了 splice 的源端口(route_table.h)不读进池缓冲,
+//   而是 splice() 经每端口一个管道直接搬到目的 fd,不经队列和 dispatch worker;
+//   目的写不动时停读源端口,可写后恢复。读 / 字节计数照常,另计 spliced / splice_drops。
+
+// 分帧(frame.h):配置了 frame 的字节流端口,读到的字节先切成完整帧(分隔符 / 长度字段 /
+//   SLIP / COBS / 字节间静默),半帧跨读累积,每帧一条消息(最长 max_len,
+//   可到 buffers.max_message,按长度取池里放得下的一档);不走 splice 直通。
+
+// udp:一次就绪用 recvmmsg 收一批数据报(批大小同 rx_segs 自适应),每个数据报一条
+//   消息(最长 buffers.max_message);发往 udp 目的时一条消息一个数据报,一批一次 sendmmsg(port_manager.h)。
+//   对端可配置,也可学习最近的发送方;可加入组播组(config_store.h 的 port_udp_conf_t)。
+
+// tcp_client:connect 非阻塞发起,由 reactor 等可写判定完成(epoll 挂 EPOLLOUT,
+//   io_uring 挂 POLL_ADD),不阻塞启动和其他端口。连接失败、connect_timeout_ms 超时、
+//   连上后 EOF / HUP / 读错误都关 fd 并按抖动指数退避重连(config_store.h 的
+//   reconnect_min_ms / reconnect_max_ms);端口句柄在重连间保持不变,断开期间发往它的
+//   消息由发送引擎按 buffer_bytes 缓存或丢弃(port_tx.h)。每端口计连接次数、重连次数、
+//   失败次数和 connect 耗时。
+
+// io_uring 后端("reactor": {"backend": "io_uring"}):listener 用 multishot accept,
+//   socket 端口用 multishot recv + provided buffer ring(内核直接读进池缓冲,一条
+//   CQE = 一条消息,provided buffer 固定 BUF_SIZE 档,长记录靠分帧拼回),tty / usb 用单次 read + buffer select;一次 io_uring_enter 同时
+//   提交重挂并收割完成。dispatch worker 的批量发送改为每 worker 一个环:同批写一次
+//   提交,同 fd 的写用 IOSQE_IO_LINK 串起来保序。内核 / 容器不支持时启动期回退 epoll,
+//   edge_triggered 只对 epoll 后端有意义。
+//   REACTOR_URING_BUFS 是每个 reactor 挂给内核的池缓冲数(2 的幂)。
+#define REACTOR_URING_BUFS     64
+#define REACTOR_URING_ENTRIES  256
+
+// 多 reactor:threads 个 epoll 线程,端口按 base.reactor 分片("reactor": N 显式指定,
+//   否则按端口序号轮转)。每个端口的读、accept、plugin handler 都只在它的 reactor 上跑;
+//   tcp_server 在每个 reactor 上各有一个 SO_REUSEPORT listener,accept 出的 client
+//   留在接受它的 reactor。不同 reactor 上的 handler 会并发执行,plugin 须可重入。
+//
+// 初始化:建 threads 个 epoll(夹到 [1, REACTOR_MAX_THREADS])并解析端口归属。
+// 须在 load_config 之后、reactor_add_port 之前调用。
+void reactor_init(int threads);
+
+// 启动全部 reactor 线程,返回启动数;reactor_join 等它们退出。
+int  reactor_start(void);
+void reactor_join(void);
+int  reactor_count(void);
+
+// 每 reactor 的循环统计,用来调分片
+typedef struct {
+    int           id;
+    int           ports;        // 当前挂在本 epoll 上的 fd 数(含 listener / client)
+    unsigned long wakeups;      // epoll_wait 返回 >0 的次数
+    unsigned long events;       // 累计事件数;events / wakeups = 每次唤醒的平均事件数
+    unsigned      max_events;   // 单次唤醒最多事件数
+    unsigned long busy_ns;      // 处理事件的累计时间(不含 epoll_wait 睡眠)
+} reactor_stats_t;
+
+int  reactor_get_stats(reactor_stats_t* out, int max);
+
+// 每端口读计数(按 g_config.ports 下标,accept 出的 client 计入其 server)
+typedef struct {
+    char          name[32];
+    unsigned long wakeups;      // 就绪次数;reads / wakeups = 每次就绪的读次数
+    unsigned long reads;        // 读系统调用次数;bytes / reads = 每次读的字节数
+    unsigned long bytes;
+    unsigned long msgs;
+    unsigned long spliced;      // splice 直通(route_table.h)写到目的的字节,不经队列
+    unsigned long splice_drops; // 直通时目的已断开 / 写出错丢弃的字节
+    unsigned long dgram_drops;  // udp:超长被截断而丢弃的数据报;msgs / reads = 每次 recvmmsg 的数据报数
+    unsigned long frame_drops;  // 分帧端口:超长 / 编码错误 / 池耗尽丢弃的帧;msgs = 帧数
+    // idle / modbus_rtu 分帧:静默到期出的帧、到期 → 出帧的延迟(帧边界延迟),
+    // 帧内超过 t1.5 的短间隙、出帧后不到一个静默又来字节(拆早了)的次数
+    unsigned long gap_frames;
+    unsigned long gap_late_us_last;
+    unsigned long gap_late_us_max;
+    unsigned long gap_late_us_avg;
+    unsigned long short_gaps;
+    unsigned long early_splits;
+    // tcp_client 连接(其他类型为 0)
+    unsigned long connects;        // 连上的次数
+    unsigned long reconnects;      // 其中断开 / 失败之后重新连上的次数
+    unsigned long connect_fails;   // connect 失败 / 超时次数
+    unsigned long connect_us_last; // 最近一次 connect 耗时(发起到可写)
+    unsigned long connect_us_max;
+    unsigned long connect_us_avg;
+} reactor_port_stats_t;
+
+// 只返回有读记录或连接记录的端口
+int  reactor_get_port_stats(reactor_port_stats_t* out, int max);
+
+// 以 LOG_DEBUG 打印每 reactor 计数(busy% 为距上次调用的占比)和每端口读计数
+// (主线程周期调用)
+void reactor_log_stats(void);
 
 // 向 epoll 添加 fd
 // void reactor_add_fd(int fd);
@@ -16,7 +116,7 @@ void reactor_init(void);
 // 根据 port 打开 fd 并添加到 epoll
 void reactor_add_fd_by_port(int port);
 
-// reactor 主线程
+// reactor 线程体,arg = reactor_start 传入的 reactor(NULL = reactor 0)
 void* reactor_thread(void* arg);
 
 // 清空所有 epoll 端口（重置路由使用）
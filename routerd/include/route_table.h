@@ -0,0 +1,61 @@
+#ifndef EZ_ROUTER_ROUTE_TABLE_H
+#define EZ_ROUTER_ROUTE_TABLE_H
+
+// route_table.h — 编译后的路由表(热路径零字符串比较)
+//
+// 职责:
+//   - 配置加载完成后把 g_config.routes 编译成"按源端口下标索引"的数组,
+//     每条表项预先解析好:目的端口下标、目的队列(每 reactor 一条 lane)、handler 函数指针
+//     (v1 / v2 两种 ABI 按登记时的类型分别填,见 plugin_loader.h)
+//   - reactor 每次 read 只做 route_table_for_src(port->base.id) 一次数组取址,
+//     不再 strcmp 扫 routes / 256 个 handler;入队时按 dst_id 取目的端口当前句柄,
+//     dispatcher 用句柄直接取端口(port_from_handle)
+//
+// splice 直通:没有 handler、源只有这一条路由、源和目的都是单连接字节流端口
+//   (tty / usb / tcp_client / ipc_client)、目的不被别的路由写、没配输出合并、
+//   策略不是 drop、配置没关("splice": false)的路由标 splice = 1。epoll 后端的
+//   reactor 对它用 splice() 经管道把字节从源 fd 直接搬到目的 fd,不进池缓冲、不进队列、
+//   不经 dispatch worker;目的写不动时停读源端口(效果同 backpressure)。
+//   drop 策略要求目的慢时丢数据,splice 只能节流,所以不走直通。
+//
+// 解析失败在编译期一次性 WARN,不在每条消息上重复:
+//   - dst 未配置 / 无目的队列 → 表项不建(消息本就无处可去)
+//   - handler 非空但未注册  → 表项保留,handler / handler_v2 = NULL(透传,与原行为一致)
+//
+// 生命周期:必须在 plugin_load 全部完成、dispatch_pool_init 之后,
+//   reactor 线程启动之前调用 route_table_build()。运行期只读,无锁。
+//   热更新不在范围内(非目标)。
+//
+// 测试:tests/unit/test_route_table.c
+// 基准:tests/bench/bench_route_lookup.c
+
+#include "config_store.h"
+#include "event_queue.h"
+#include "plugin_loader.h"
+
+// 单个源端口最多的路由数(与原 reactor 的 routes[16] 一致)
+#define ROUTE_MAX_PER_SRC 16
+
+typedef struct {
+    const route_def_t* def;       // 原始配置(仅日志用)
+    int                dst_id;    // 目的端口 g_config.ports 下标
+    event_queue_t*     q[REACTOR_MAX_THREADS];   // 目的端口在各 reactor 上的 lane,
+                                                  // reactor k 只用 q[k](dispatch_pool)
+    plugin_handler_t   handler;   // v1 handler
+    plugin_handler_v2_t handler_v2;   // v2 handler;两个都为 NULL = 透传
+    route_policy_t     policy;    // 目的队列满时的策略
+    int                splice;    // 1 = 可走 splice 直通(见文件头)
+} route_entry_t;
+
+typedef struct {
+    route_entry_t e[ROUTE_MAX_PER_SRC];
+    int           n;
+} route_src_t;
+
+// 编译路由表。返回编译出的表项总数。
+int route_table_build(void);
+
+// 源端口 id → 该源的全部路由。id 越界返回 NULL。
+const route_src_t* route_table_for_src(int port_id);
+
+#endif // EZ_ROUTER_ROUTE_TABLE_H
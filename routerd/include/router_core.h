@@ -2,7 +2,22 @@
 #define ROUTER_CORE_H
 
 #include "event.h"
+#include "dispatch_pool.h"
 
 void router_core_handle(event_msg_t* msg);
 
+// 单次 writev 最多合并的消息数
+#define ROUTER_IOV_MAX 64
+
+// io_uring 发送环大小:一次提交最多的 WRITEV 数 / 消息段数
+#define ROUTER_URING_OPS 64
+
+// 批量处理:连续同 dst 的消息合成一次 port_send_batch。dispatch worker 的生产回调。
+// io_uring 后端下整批一次提交(见 router_core.c)。
+void router_core_handle_batch(event_msg_t* msgs, int n);
+
+// dispatch worker 的非阻塞发送挂钩(每 worker 一个 port_tx 引擎,见 port_tx.h)。
+// dispatch_pool_start 之前 dispatch_pool_set_tx_hooks(router_core_tx_hooks())。
+const dispatch_tx_hooks_t* router_core_tx_hooks(void);
+
 #endif
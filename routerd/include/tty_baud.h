@@ -0,0 +1,37 @@
+#ifndef EZ_ROUTER_TTY_BAUD_H
+#define EZ_ROUTER_TTY_BAUD_H
+
+// tty_baud.h — 串口任意波特率(termios2 + BOTHER)与 ASYNC_LOW_LATENCY
+//
+// 职责:
+//   - 在已配好 raw / 数据位 / 校验 / 流控的 tty fd 上设波特率:整数直接交给驱动
+//     (BOTHER),不受 Bxxx 常量表限制,460800 / 921600 / 3M / 250000(DMX)都可以
+//   - 读回驱动实际采用的速率:分频器只能逼近时与请求值有偏差,由调用方报告
+//   - 切 ASYNC_LOW_LATENCY(TIOCSSERIAL):8250 类 UART 收到数据立即推给 tty 层,
+//     不等驱动的延迟处理;USB 串口 / pty 多数不支持,返回失败由调用方告警
+//
+// 不负责:其他 termios 标志(port_manager.c 的 port_open_tty 用 tcsetattr 设)。
+//
+// 为什么单独一个文件:<asm/termbits.h> 的 struct termios 与 glibc <termios.h> 冲突,
+//   termios2 只能在不包含 <termios.h> 的编译单元里用。
+//
+// 并发:无状态,调用方保证同一 fd 不被并发配置(打开端口时在启动线程调)。
+//
+// 测试:tests/unit/test_tty_baud.c
+
+// 设输入 / 输出波特率为 baud(> 0)。返回驱动实际采用的输出速率,失败 -1(errno 保留)。
+int tty_set_baud(int fd, int baud);
+
+// 当前输出波特率,失败 -1。
+int tty_get_baud(int fd);
+
+// 实际速率相对请求值的偏差,单位 ppm(千分之一 = 1000),带符号。
+int tty_baud_error_ppm(int requested, int actual);
+
+// on = 1 置 ASYNC_LOW_LATENCY,0 清掉。驱动不支持返回 -1(errno 保留)。
+int tty_set_low_latency(int fd, int on);
+
+// 超过这个偏差(2%)收发双方采样点会漂出一个位宽,按帧出错告警
+#define TTY_BAUD_WARN_PPM  20000
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef EZ_ROUTER_URING_H
+#define EZ_ROUTER_URING_H
+
+// uring.h — 最小 io_uring 封装(裸系统调用,不依赖 liburing)
+//
+// 职责:
+//   - io_uring_setup / mmap SQ、CQ 环 / io_uring_enter
+//   - 取 SQE、遍历 CQE
+//   - provided buffer ring(IORING_REGISTER_PBUF_RING):内核读数据时自己挑缓冲,
+//     CQE 里带 buffer id;用完由调用方补回
+//
+// 不负责:业务语义(reactor 后端在 reactor.c,批量发送在 router_core.c)。
+//
+// 并发:一个 uring_t 只由一个线程使用(SQ / CQ 都是单生产者单消费者)。
+//
+// 可用性:内核 < 5.19 没有 pbuf ring,seccomp / 容器可能禁掉 io_uring_setup。
+//   uring_probe() 启动时探测一次,失败则调用方回退 epoll。
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <linux/io_uring.h>
+
+// 旧内核头文件里没有的常量(值与 mainline uapi 一致)
+#ifndef IORING_CQE_F_BUFFER
+#define IORING_CQE_F_BUFFER   (1U << 0)
+#endif
+#ifndef IORING_CQE_F_MORE
+#define IORING_CQE_F_MORE     (1U << 1)
+#endif
+#ifndef IORING_CQE_BUFFER_SHIFT
+#define IORING_CQE_BUFFER_SHIFT 16
+#endif
+
+typedef struct {
+    int ring_fd;
+
+    // SQ
+    atomic_uint* sq_head;
+    atomic_uint* sq_tail;
+    unsigned*    sq_mask;
+    unsigned*    sq_array;
+    struct io_uring_sqe* sqes;
+    unsigned     sq_entries;
+    unsigned     sqe_tail;       // 本地已填的尾,uring_submit 时发布
+
+    // CQ
+    atomic_uint* cq_head;
+    atomic_uint* cq_tail;
+    unsigned*    cq_mask;
+    struct io_uring_cqe* cqes;
+
+    void*  sq_ptr;  size_t sq_len;
+    void*  cq_ptr;  size_t cq_len;
+    void*  sqe_ptr; size_t sqe_len;
+} uring_t;
+
+// 建环,entries 取 2 的幂。返回 0 成功,-errno 失败。
+int  uring_init(uring_t* u, unsigned entries);
+void uring_exit(uring_t* u);
+
+// 取一个清零的 SQE;SQ 满时先 submit 腾位置,仍满返回 NULL。
+struct io_uring_sqe* uring_get_sqe(uring_t* u);
+
+// 提交已填的 SQE,并至少等 wait_nr 个 CQE(0 = 不等)。返回提交数,-errno 失败;
+// 被信号打断返回 -EINTR,未交出的 SQE 留在环里,下次 submit 一并提交。
+int  uring_submit(uring_t* u, unsigned wait_nr);
+
+// 取下一个 CQE(不等待),没有返回 NULL。处理完调 uring_cqe_seen。
+struct io_uring_cqe* uring_peek_cqe(uring_t* u);
+void uring_cqe_seen(uring_t* u);
+
+// ---- provided buffer ring ----
+typedef struct {
+    struct io_uring_buf_ring* br;
+    size_t   len;
+    unsigned entries;            // 2 的幂
+    uint16_t bgid;
+    uint16_t tail;               // 本地尾,uring_pbuf_commit 时发布
+} uring_pbuf_t;
+
+// 注册 entries 个槽的 buffer ring(初始为空)。返回 0 成功,-errno 失败。
+int  uring_pbuf_init(uring_t* u, uring_pbuf_t* pb, unsigned entries, uint16_t bgid);
+void uring_pbuf_exit(uring_t* u, uring_pbuf_t* pb);
+
+// 把一块缓冲挂回环上(bid 由调用方管理),uring_pbuf_commit 后内核可见。
+void uring_pbuf_add(uring_pbuf_t* pb, void* addr, unsigned len, uint16_t bid);
+void uring_pbuf_commit(uring_pbuf_t* pb);
+
+// 探测本机是否能用 io_uring + pbuf ring(结果缓存)。1 = 可用。
+int  uring_probe(void);
+
+#endif // EZ_ROUTER_URING_H
@@ -0,0 +1,217 @@
+// buf_pool.c — 引用计数数据缓冲池
+//
+// 详见 buf_pool.h 文件头。
+//
+// 空闲链(每档一条):
+//   - 归还(buf_unref 归零):CAS push 到所属档的空闲链,任意线程
+//   - 分配(buf_alloc):持该档的 alloc_lock 做 CAS pop。分配者之间互斥后,
+//     并发方只有 push,被 pop 的头节点不可能被别人取走再放回,没有 ABA。
+//
+// 测试:tests/unit/test_buf_pool.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "buf_pool.h"
+#include "log.h"
+
+// 一档:容量相同的缓冲连续放在一块 arena 里(步长 = 头 + cap),各自一条空闲链
+typedef struct {
+    uint8_t*          arena;
+    size_t            stride;
+    int               cap;
+    int               total;
+    _Atomic(buf_t*)   free;
+    pthread_mutex_t   alloc_lock;
+    atomic_int        in_use;
+    atomic_int        peak_in_use;
+} buf_class_t;
+
+static buf_class_t       g_cls[BUF_CLASS_MAX] = {
+    [0 ... BUF_CLASS_MAX - 1] = {.alloc_lock = PTHREAD_MUTEX_INITIALIZER},
+};
+static int               g_ncls = 0;
+static int               g_total = 0;
+
+static atomic_int        g_in_use;
+static atomic_int        g_peak_in_use;
+static atomic_ulong      g_alloc_fail;
+static atomic_ulong      g_upsized;
+
+static void free_push(buf_class_t* c, buf_t* b)
+{
+    buf_t* head = atomic_load_explicit(&c->free, memory_order_relaxed);
+    do {
+        b->next_free = head;
+    } while (!atomic_compare_exchange_weak_explicit(&c->free, &head, b,
+                 memory_order_release, memory_order_relaxed));
+}
+
+static void peak_raise(atomic_int* peak, int n)
+{
+    int p = atomic_load_explicit(peak, memory_order_relaxed);
+    while (n > p && !atomic_compare_exchange_weak_explicit(peak, &p, n,
+                        memory_order_relaxed, memory_order_relaxed)) {}
+}
+
+static int class_init(buf_class_t* c, int cap, int count)
+{
+    c->stride = (sizeof(buf_t) + (size_t)cap + 63) & ~(size_t)63;
+    c->arena  = calloc((size_t)count, c->stride);
+    if (!c->arena) {
+        LOG_ERROR("[buf] pool alloc failed, %d x %d bytes\n", count, cap);
+        return -1;
+    }
+    c->cap   = cap;
+    c->total = count;
+    atomic_store(&c->free, NULL);
+    for (int i = count - 1; i >= 0; i--) {
+        buf_t* b = (buf_t*)(c->arena + (size_t)i * c->stride);
+        b->cap = cap;
+        b->cls = (int)(c - g_cls);
+        free_push(c, b);
+    }
+    atomic_store(&c->in_use, 0);
+    atomic_store(&c->peak_in_use, 0);
+    return 0;
+}
+
+int buf_pool_init(int count)
+{
+    return buf_pool_init_sized(count, BUF_SIZE, 0);
+}
+
+int buf_pool_init_sized(int count, int max_size, int class_bytes)
+{
+    buf_pool_destroy();
+    if (count <= 0) count = BUF_POOL_DEFAULT_COUNT;
+    if (class_bytes <= 0) class_bytes = BUF_CLASS_DEFAULT_BYTES;
+    if (max_size > MAX_MESSAGE + 1) max_size = MAX_MESSAGE + 1;
+
+    // 档容量:BUF_SIZE, ×4, ... 最后一档收到 max_size(64 字节对齐),不多留一整档
+    int cap = BUF_SIZE;
+    for (int k = 0; k < BUF_CLASS_MAX; k++) {
+        int n = k == 0 ? count : class_bytes / cap;
+        if (k > 0 && n < BUF_CLASS_MIN_COUNT) n = BUF_CLASS_MIN_COUNT;
+        if (class_init(&g_cls[k], cap, n) < 0) {
+            buf_pool_destroy();
+            return -1;
+        }
+        g_ncls = k + 1;
+        g_total += n;
+        if (cap >= max_size) break;
+        cap *= 4;
+        if (cap > max_size) cap = (max_size + 63) & ~63;
+    }
+    atomic_store(&g_in_use, 0);
+    atomic_store(&g_peak_in_use, 0);
+    atomic_store(&g_alloc_fail, 0);
+    atomic_store(&g_upsized, 0);
+
+    for (int k = 0; k < g_ncls; k++)
+        LOG_INFO("[buf] pool class %d ready: %d x %d bytes\n", k, g_cls[k].total, g_cls[k].cap);
+    return 0;
+}
+
+void buf_pool_destroy(void)
+{
+    for (int k = 0; k < g_ncls; k++) {
+        free(g_cls[k].arena);
+        g_cls[k].arena = NULL;
+        g_cls[k].total = 0;
+        atomic_store(&g_cls[k].free, NULL);
+    }
+    g_ncls  = 0;
+    g_total = 0;
+}
+
+int buf_max_size(void)
+{
+    return g_ncls > 0 ? g_cls[g_ncls - 1].cap : BUF_SIZE;
+}
+
+static buf_t* class_pop(buf_class_t* c)
+{
+    pthread_mutex_lock(&c->alloc_lock);
+    buf_t* head = atomic_load_explicit(&c->free, memory_order_acquire);
+    while (head && !atomic_compare_exchange_weak_explicit(&c->free, &head, head->next_free,
+                       memory_order_acquire, memory_order_acquire)) {}
+    pthread_mutex_unlock(&c->alloc_lock);
+    return head;
+}
+
+buf_t* buf_alloc(int size)
+{
+    int k = 0;
+    while (k < g_ncls && g_cls[k].cap < size) k++;
+
+    buf_t* head = NULL;
+    for (int j = k; j < g_ncls && !head; j++)
+        head = class_pop(&g_cls[j]);
+    if (!head) {
+        atomic_fetch_add_explicit(&g_alloc_fail, 1, memory_order_relaxed);
+        return NULL;
+    }
+    if (head->cls != k)
+        atomic_fetch_add_explicit(&g_upsized, 1, memory_order_relaxed);
+
+    atomic_store_explicit(&head->refcnt, 1, memory_order_relaxed);
+    head->next_free = NULL;
+
+    buf_class_t* c = &g_cls[head->cls];
+    peak_raise(&c->peak_in_use, atomic_fetch_add_explicit(&c->in_use, 1, memory_order_relaxed) + 1);
+    peak_raise(&g_peak_in_use, atomic_fetch_add_explicit(&g_in_use, 1, memory_order_relaxed) + 1);
+    return head;
+}
+
+void buf_ref(buf_t* b)
+{
+    if (!b) return;
+    atomic_fetch_add_explicit(&b->refcnt, 1, memory_order_relaxed);
+}
+
+void buf_unref(buf_t* b)
+{
+    if (!b) return;
+    // acq_rel:最后一个持有者要看到其他持有者对缓冲的全部读完成后才归还
+    if (atomic_fetch_sub_explicit(&b->refcnt, 1, memory_order_acq_rel) != 1)
+        return;
+    buf_class_t* c = &g_cls[b->cls];
+    atomic_fetch_sub_explicit(&c->in_use, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&g_in_use, 1, memory_order_relaxed);
+    free_push(c, b);
+}
+
+int buf_refcnt(const buf_t* b)
+{
+    return b ? atomic_load_explicit(&((buf_t*)b)->refcnt, memory_order_acquire) : 0;
+}
+
+void buf_pool_get_stats(buf_pool_stats_t* out)
+{
+    out->total       = g_total;
+    out->in_use      = atomic_load_explicit(&g_in_use, memory_order_relaxed);
+    out->peak_in_use = atomic_load_explicit(&g_peak_in_use, memory_order_relaxed);
+    out->alloc_fail  = atomic_load_explicit(&g_alloc_fail, memory_order_relaxed);
+    out->upsized     = atomic_load_explicit(&g_upsized, memory_order_relaxed);
+    out->classes     = g_ncls;
+    for (int k = 0; k < g_ncls; k++) {
+        buf_class_t* c = &g_cls[k];
+        out->cls[k].cap         = c->cap;
+        out->cls[k].total       = c->total;
+        out->cls[k].in_use      = atomic_load_explicit(&c->in_use, memory_order_relaxed);
+        out->cls[k].peak_in_use = atomic_load_explicit(&c->peak_in_use, memory_order_relaxed);
+    }
+}
+
+void buf_pool_log_stats(void)
+{
+    buf_pool_stats_t st;
+    buf_pool_get_stats(&st);
+    LOG_DEBUG("[buf] total=%d in_use=%d peak=%d alloc_fail=%lu upsized=%lu\n",
+              st.total, st.in_use, st.peak_in_use, st.alloc_fail, st.upsized);
+    for (int k = 0; st.classes > 1 && k < st.classes; k++)
+        LOG_DEBUG("[buf]   class %d cap=%d total=%d in_use=%d peak=%d\n", k, st.cls[k].cap,
+                  st.cls[k].total, st.cls[k].in_use, st.cls[k].peak_in_use);
+}
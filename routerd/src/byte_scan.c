@@ -0,0 +1,352 @@
+// byte_scan.c — 向量化字节查找
+//
+// 详见 byte_scan.h 文件头。
+//
+// 每种查找的结构相同:整块(16 / 32 字节)比较得到位掩码,非零就取最低位定位;
+// 不足一块的尾部用一次与前一块重叠的加载补齐(重叠部分已确认没有命中,所以
+// 块内第一个命中仍是全局第一个),整个输入不足一块才逐字节。
+//
+// 测试:tests/unit/test_byte_scan.c
+
+#include <string.h>
+#include "byte_scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_X86 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SCAN_NEON 1
+#endif
+
+// ============================================
+// 逐字节(短输入 / 无 SIMD 的架构)
+// ============================================
+static const uint8_t* byte_scalar(const uint8_t* p, size_t n, uint8_t b)
+{
+    for (size_t i = 0; i < n; i++)
+        if (p[i] == b) return p + i;
+    return NULL;
+}
+
+static const uint8_t* pair_scalar(const uint8_t* p, size_t n, uint8_t b0, uint8_t b1)
+{
+    for (size_t i = 0; i + 1 < n; i++)
+        if (p[i] == b0 && p[i + 1] == b1) return p + i;
+    return NULL;
+}
+
+static const uint8_t* set_scalar(const uint8_t* p, size_t n, const uint8_t* set, int k)
+{
+    for (size_t i = 0; i < n; i++)
+        for (int j = 0; j < k; j++)
+            if (p[i] == set[j]) return p + i;
+    return NULL;
+}
+
+#if SCAN_X86
+// ============================================
+// x86-64:SSE2 是基线;AVX2 函数单独按 target("avx2") 编译,运行期探测后才调用
+// ============================================
+#define SCAN_AVX2_MIN 64   // 短于这个走 SSE2,省掉探测和 256 位加载的启动开销
+
+// -DBYTE_SCAN_NO_AVX2:只用 SSE2(老 CPU 的行为;测试用它覆盖 SSE2 的长输入路径)
+static int has_avx2(void)
+{
+#ifdef BYTE_SCAN_NO_AVX2
+    return 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static const uint8_t* byte_sse2(const uint8_t* p, size_t n, uint8_t b)
+{
+    const __m128i v = _mm_set1_epi8((char)b);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {   // 4 块一组,合并后只判一次
+        __m128i e0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i)), v);
+        __m128i e1 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i + 16)), v);
+        __m128i e2 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i + 32)), v);
+        __m128i e3 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i + 48)), v);
+        __m128i any = _mm_or_si128(_mm_or_si128(e0, e1), _mm_or_si128(e2, e3));
+        if (_mm_movemask_epi8(any)) break;   // 下面逐块定位
+    }
+    for (; i + 16 <= n; i += 16) {
+        int m = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i)), v));
+        if (m) return p + i + __builtin_ctz((unsigned)m);
+    }
+    if (i < n) {
+        size_t j = n - 16;
+        int m = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + j)), v));
+        if (m) return p + j + __builtin_ctz((unsigned)m);
+    }
+    return NULL;
+}
+
+__attribute__((target("avx2")))
+static const uint8_t* byte_avx2(const uint8_t* p, size_t n, uint8_t b)
+{
+    const __m256i v = _mm256_set1_epi8((char)b);
+    size_t i = 0;
+    for (; i + 128 <= n; i += 128) {
+        __m256i e0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i)), v);
+        __m256i e1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i + 32)), v);
+        __m256i e2 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i + 64)), v);
+        __m256i e3 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i + 96)), v);
+        __m256i any = _mm256_or_si256(_mm256_or_si256(e0, e1), _mm256_or_si256(e2, e3));
+        if (!_mm256_testz_si256(any, any)) break;
+    }
+    for (; i + 32 <= n; i += 32) {
+        unsigned m = (unsigned)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i)), v));
+        if (m) return p + i + __builtin_ctz(m);
+    }
+    if (i < n) {
+        size_t j = n - 32;
+        unsigned m = (unsigned)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + j)), v));
+        if (m) return p + j + __builtin_ctz(m);
+    }
+    return NULL;
+}
+
+// 位置 i 命中 = p[i] == b0 且 p[i+1] == b1:两次错开一字节的加载按位与
+static const uint8_t* pair_sse2(const uint8_t* p, size_t n, uint8_t b0, uint8_t b1)
+{
+    const __m128i v0 = _mm_set1_epi8((char)b0), v1 = _mm_set1_epi8((char)b1);
+    size_t i = 0;
+    for (; i + 17 <= n; i += 16) {
+        __m128i x0 = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i x1 = _mm_loadu_si128((const __m128i*)(p + i + 1));
+        int m = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(x0, v0), _mm_cmpeq_epi8(x1, v1)));
+        if (m) return p + i + __builtin_ctz((unsigned)m);
+    }
+    if (i + 1 < n) {
+        size_t j = n - 17;
+        __m128i x0 = _mm_loadu_si128((const __m128i*)(p + j));
+        __m128i x1 = _mm_loadu_si128((const __m128i*)(p + j + 1));
+        int m = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(x0, v0), _mm_cmpeq_epi8(x1, v1)));
+        if (m) return p + j + __builtin_ctz((unsigned)m);
+    }
+    return NULL;
+}
+
+__attribute__((target("avx2")))
+static const uint8_t* pair_avx2(const uint8_t* p, size_t n, uint8_t b0, uint8_t b1)
+{
+    const __m256i v0 = _mm256_set1_epi8((char)b0), v1 = _mm256_set1_epi8((char)b1);
+    size_t i = 0;
+    for (; i + 33 <= n; i += 32) {
+        __m256i x0 = _mm256_loadu_si256((const __m256i*)(p + i));
+        __m256i x1 = _mm256_loadu_si256((const __m256i*)(p + i + 1));
+        unsigned m = (unsigned)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(x0, v0), _mm256_cmpeq_epi8(x1, v1)));
+        if (m) return p + i + __builtin_ctz(m);
+    }
+    if (i + 1 < n) {
+        size_t j = n - 33;
+        __m256i x0 = _mm256_loadu_si256((const __m256i*)(p + j));
+        __m256i x1 = _mm256_loadu_si256((const __m256i*)(p + j + 1));
+        unsigned m = (unsigned)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(x0, v0), _mm256_cmpeq_epi8(x1, v1)));
+        if (m) return p + j + __builtin_ctz(m);
+    }
+    return NULL;
+}
+
+// k <= 4(常见:END / ESC、CR / LF)时固定比 4 次,不足的用 set[0] 补:
+// 比较次数固定,四个比较向量留在寄存器里,不必每块循环读 v[]
+static const uint8_t* set_sse2(const uint8_t* p, size_t n, const uint8_t* set, int k)
+{
+    __m128i v[SCAN_SET_MAX];
+    int kk = k < 4 ? 4 : k;
+    for (int j = 0; j < kk; j++) v[j] = _mm_set1_epi8((char)set[j < k ? j : 0]);
+    size_t i = 0;
+    for (;;) {
+        if (i + 16 > n) {
+            if (i >= n) return NULL;
+            i = n - 16;   // 重叠的最后一块
+        }
+        __m128i x = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i e = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(x, v[0]), _mm_cmpeq_epi8(x, v[1])),
+                                 _mm_or_si128(_mm_cmpeq_epi8(x, v[2]), _mm_cmpeq_epi8(x, v[3])));
+        for (int j = 4; j < kk; j++) e = _mm_or_si128(e, _mm_cmpeq_epi8(x, v[j]));
+        int m = _mm_movemask_epi8(e);
+        if (m) return p + i + __builtin_ctz((unsigned)m);
+        if (i + 16 == n) return NULL;
+        i += 16;
+    }
+}
+
+__attribute__((target("avx2")))
+static const uint8_t* set_avx2(const uint8_t* p, size_t n, const uint8_t* set, int k)
+{
+    __m256i v[SCAN_SET_MAX];
+    int kk = k < 4 ? 4 : k;
+    for (int j = 0; j < kk; j++) v[j] = _mm256_set1_epi8((char)set[j < k ? j : 0]);
+    size_t i = 0;
+    for (;;) {
+        if (i + 32 > n) {
+            if (i >= n) return NULL;
+            i = n - 32;
+        }
+        __m256i x = _mm256_loadu_si256((const __m256i*)(p + i));
+        __m256i e = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(x, v[0]), _mm256_cmpeq_epi8(x, v[1])),
+            _mm256_or_si256(_mm256_cmpeq_epi8(x, v[2]), _mm256_cmpeq_epi8(x, v[3])));
+        for (int j = 4; j < kk; j++) e = _mm256_or_si256(e, _mm256_cmpeq_epi8(x, v[j]));
+        unsigned m = (unsigned)_mm256_movemask_epi8(e);
+        if (m) return p + i + __builtin_ctz(m);
+        if (i + 32 == n) return NULL;
+        i += 32;
+    }
+}
+
+const uint8_t* scan_byte(const uint8_t* p, size_t n, uint8_t b)
+{
+    if (n < 16) return byte_scalar(p, n, b);
+    if (n >= SCAN_AVX2_MIN && has_avx2()) return byte_avx2(p, n, b);
+    return byte_sse2(p, n, b);
+}
+
+const uint8_t* scan_pair(const uint8_t* p, size_t n, uint8_t b0, uint8_t b1)
+{
+    if (n < 17) return pair_scalar(p, n, b0, b1);
+    if (n >= SCAN_AVX2_MIN && has_avx2()) return pair_avx2(p, n, b0, b1);
+    return pair_sse2(p, n, b0, b1);
+}
+
+const uint8_t* scan_set(const uint8_t* p, size_t n, const uint8_t* set, int k)
+{
+    if (k < 1 || k > SCAN_SET_MAX) return NULL;
+    if (n < 16) return set_scalar(p, n, set, k);
+    if (n >= SCAN_AVX2_MIN && has_avx2()) return set_avx2(p, n, set, k);
+    return set_sse2(p, n, set, k);
+}
+
+const char* scan_impl(void)
+{
+    return has_avx2() ? "avx2" : "sse2";
+}
+
+#elif SCAN_NEON
+// ============================================
+// aarch64 NEON:比较结果没有 movemask,用"每字节右移 4 位窄化"把 16 字节的
+// 0x00 / 0xFF 压成 64 位,每个字节对应 4 位,ctz / 4 即位置
+// ============================================
+static inline uint64_t neon_mask(uint8x16_t eq)
+{
+    uint8x8_t nib = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nib), 0);
+}
+
+const uint8_t* scan_byte(const uint8_t* p, size_t n, uint8_t b)
+{
+    if (n < 16) return byte_scalar(p, n, b);
+    const uint8x16_t v = vdupq_n_u8(b);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {   // 4 块一组,合并后只判一次
+        uint8x16_t e0 = vceqq_u8(vld1q_u8(p + i), v);
+        uint8x16_t e1 = vceqq_u8(vld1q_u8(p + i + 16), v);
+        uint8x16_t e2 = vceqq_u8(vld1q_u8(p + i + 32), v);
+        uint8x16_t e3 = vceqq_u8(vld1q_u8(p + i + 48), v);
+        if (vmaxvq_u8(vorrq_u8(vorrq_u8(e0, e1), vorrq_u8(e2, e3)))) break;
+    }
+    for (; i + 16 <= n; i += 16) {
+        uint64_t m = neon_mask(vceqq_u8(vld1q_u8(p + i), v));
+        if (m) return p + i + (__builtin_ctzll(m) >> 2);
+    }
+    if (i < n) {
+        size_t j = n - 16;
+        uint64_t m = neon_mask(vceqq_u8(vld1q_u8(p + j), v));
+        if (m) return p + j + (__builtin_ctzll(m) >> 2);
+    }
+    return NULL;
+}
+
+const uint8_t* scan_pair(const uint8_t* p, size_t n, uint8_t b0, uint8_t b1)
+{
+    if (n < 17) return pair_scalar(p, n, b0, b1);
+    const uint8x16_t v0 = vdupq_n_u8(b0), v1 = vdupq_n_u8(b1);
+    size_t i = 0;
+    for (; i + 17 <= n; i += 16) {
+        uint8x16_t e = vandq_u8(vceqq_u8(vld1q_u8(p + i), v0), vceqq_u8(vld1q_u8(p + i + 1), v1));
+        uint64_t m = neon_mask(e);
+        if (m) return p + i + (__builtin_ctzll(m) >> 2);
+    }
+    if (i + 1 < n) {
+        size_t j = n - 17;
+        uint8x16_t e = vandq_u8(vceqq_u8(vld1q_u8(p + j), v0), vceqq_u8(vld1q_u8(p + j + 1), v1));
+        uint64_t m = neon_mask(e);
+        if (m) return p + j + (__builtin_ctzll(m) >> 2);
+    }
+    return NULL;
+}
+
+const uint8_t* scan_set(const uint8_t* p, size_t n, const uint8_t* set, int k)
+{
+    if (k < 1 || k > SCAN_SET_MAX) return NULL;
+    if (n < 16) return set_scalar(p, n, set, k);
+    uint8x16_t v[SCAN_SET_MAX];
+    for (int j = 0; j < k; j++) v[j] = vdupq_n_u8(set[j]);
+    size_t i = 0;
+    for (;;) {
+        if (i + 16 > n) {
+            if (i >= n) return NULL;
+            i = n - 16;
+        }
+        uint8x16_t x = vld1q_u8(p + i);
+        uint8x16_t e = vceqq_u8(x, v[0]);
+        for (int j = 1; j < k; j++) e = vorrq_u8(e, vceqq_u8(x, v[j]));
+        uint64_t m = neon_mask(e);
+        if (m) return p + i + (__builtin_ctzll(m) >> 2);
+        if (i + 16 == n) return NULL;
+        i += 16;
+    }
+}
+
+const char* scan_impl(void)
+{
+    return "neon";
+}
+
+#else
+// ============================================
+// 其他架构:逐字节
+// ============================================
+const uint8_t* scan_byte(const uint8_t* p, size_t n, uint8_t b)
+{
+    return byte_scalar(p, n, b);
+}
+
+const uint8_t* scan_pair(const uint8_t* p, size_t n, uint8_t b0, uint8_t b1)
+{
+    return pair_scalar(p, n, b0, b1);
+}
+
+const uint8_t* scan_set(const uint8_t* p, size_t n, const uint8_t* set, int k)
+{
+    if (k < 1 || k > SCAN_SET_MAX) return NULL;
+    return set_scalar(p, n, set, k);
+}
+
+const char* scan_impl(void)
+{
+    return "scalar";
+}
+#endif
+
+const uint8_t* scan_seq(const uint8_t* p, size_t n, const uint8_t* needle, size_t m)
+{
+    if (m == 0) return p;
+    if (m == 1) return scan_byte(p, n, needle[0]);
+    while (n >= m) {
+        const uint8_t* c = scan_pair(p, n - m + 2, needle[0], needle[1]);
+        if (!c) return NULL;
+        if (m == 2 || memcmp(c + 2, needle + 2, m - 2) == 0) return c;
+        n -= (size_t)(c + 1 - p);
+        p = c + 1;
+    }
+    return NULL;
+}
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "config_store.h"
+#include "event.h"
 #include "cJSON.h"
 #include "log.h"
 
@@ -33,6 +34,43 @@ static void clear_config()
     memset(&g_config, 0, sizeof(g_config));
 }
 
+const char* route_policy_name(route_policy_t p)
+{
+    switch (p) {
+    case ROUTE_POLICY_DROP:         return "drop";
+    case ROUTE_POLICY_BACKPRESSURE: return "backpressure";
+    default:                        return "block";
+    }
+}
+
+const char* slow_client_policy_name(slow_client_policy_t p)
+{
+    switch (p) {
+    case SLOW_CLIENT_DISCONNECT:  return "disconnect";
+    case SLOW_CLIENT_LATEST:      return "latest";
+    case SLOW_CLIENT_DROP_OLDEST: return "drop_oldest";
+    default:                      return "block";
+    }
+}
+
+const char* frame_mode_name(frame_mode_t m)
+{
+    switch (m) {
+    case FRAME_DELIMITER: return "delimiter";
+    case FRAME_LENGTH:    return "length";
+    case FRAME_SLIP:      return "slip";
+    case FRAME_COBS:      return "cobs";
+    case FRAME_IDLE:      return "idle";
+    case FRAME_MODBUS:    return "modbus_rtu";
+    default:              return "none";
+    }
+}
+
+const char* reactor_backend_name(reactor_backend_t b)
+{
+    return b == REACTOR_BACKEND_URING ? "io_uring" : "epoll";
+}
+
 port_def_t* config_find_port(const char* name)
 {
     if (!name || name[0] == '\0') {
@@ -74,6 +112,116 @@ int config_find_plugin(const char* name)
 }
 
 // ============ JSON → config_t ============
+
+// "frame" 块 → port_frame_t;配置不成立时告警并保持 FRAME_NONE(原样转发)
+static void parse_frame(cJSON* jf, port_def_t* p)
+{
+    port_frame_t* f = &p->base.frame;
+    memset(f, 0, sizeof(*f));
+    if (!cJSON_IsObject(jf)) return;
+
+    char mode[16] = {0};
+    GET_STR(jf, "mode", mode);
+    GET_INT(jf, "max_len", f->max_len);
+    if (f->max_len <= 0 || f->max_len > g_config.max_message) f->max_len = g_config.max_message;
+
+    if (strcmp(mode, "delimiter") == 0) {
+        // 字符串 / 单字节数字 / 字节数组
+        cJSON* jd = cJSON_GetObjectItem(jf, "delimiter");
+        if (cJSON_IsString(jd)) {
+            size_t n = strlen(jd->valuestring);
+            if (n > 0 && n <= FRAME_DELIM_MAX) {
+                memcpy(f->delim, jd->valuestring, n);
+                f->delim_len = (int)n;
+            }
+        } else if (cJSON_IsNumber(jd) && jd->valueint >= 0 && jd->valueint < 256) {
+            f->delim[0] = (uint8_t)jd->valueint;
+            f->delim_len = 1;
+        } else if (cJSON_IsArray(jd) && cJSON_GetArraySize(jd) <= FRAME_DELIM_MAX) {
+            cJSON* b;
+            cJSON_ArrayForEach(b, jd) {
+                if (!cJSON_IsNumber(b) || b->valueint < 0 || b->valueint > 255) {
+                    f->delim_len = 0;
+                    break;
+                }
+                f->delim[f->delim_len++] = (uint8_t)b->valueint;
+            }
+        }
+        f->keep_delim = cJSON_IsTrue(cJSON_GetObjectItem(jf, "keep_delimiter"));
+        if (f->delim_len == 0) {
+            LOG_WARN("[config] %s: frame.delimiter missing or longer than %d bytes, not framed\n",
+                     p->base.name, FRAME_DELIM_MAX);
+            return;
+        }
+        f->mode = FRAME_DELIMITER;
+    } else if (strcmp(mode, "length") == 0) {
+        char endian[16] = {0};
+        GET_INT(jf, "offset", f->len_offset);
+        GET_INT(jf, "width", f->len_width);
+        GET_INT(jf, "adjust", f->len_adjust);
+        GET_STR(jf, "endian", endian);
+        f->len_big = strcmp(endian, "little") != 0;   // 缺省网络序
+        if (f->len_width != 1 && f->len_width != 2 && f->len_width != 4) {
+            LOG_WARN("[config] %s: frame.width must be 1, 2 or 4, not framed\n", p->base.name);
+            return;
+        }
+        if (f->len_offset < 0 || f->len_offset + f->len_width > f->max_len) {
+            LOG_WARN("[config] %s: frame.offset %d out of range, not framed\n",
+                     p->base.name, f->len_offset);
+            return;
+        }
+        f->mode = FRAME_LENGTH;
+    } else if (strcmp(mode, "slip") == 0) {
+        f->mode = FRAME_SLIP;
+    } else if (strcmp(mode, "cobs") == 0) {
+        f->mode = FRAME_COBS;
+    } else if (strcmp(mode, "idle") == 0) {
+        GET_INT(jf, "idle_us", f->idle_us);
+        if (f->idle_us <= 0) f->idle_us = FRAME_DEFAULT_IDLE_US;
+        f->mode = FRAME_IDLE;
+    } else if (strcmp(mode, "modbus_rtu") == 0) {
+        GET_INT(jf, "idle_us", f->idle_us);
+        cJSON* jg = cJSON_GetObjectItem(jf, "gap_chars");
+        if (cJSON_IsNumber(jg)) f->gap_chars = jg->valuedouble;
+        if (f->idle_us < 0) f->idle_us = 0;
+        if (f->gap_chars < 0 || (jg && f->gap_chars == 0)) {
+            LOG_WARN("[config] %s: frame.gap_chars must be > 0, using %.1f\n",
+                     p->base.name, FRAME_MODBUS_CHARS);
+            f->gap_chars = 0;
+        }
+        f->mode = FRAME_MODBUS;
+    } else {
+        LOG_WARN("[config] %s: unknown frame.mode '%s', not framed\n", p->base.name, mode);
+    }
+}
+
+// modbus_rtu:按端口线路参数算帧间静默(t3.5)和短间隙门限(t1.5),要在 tty 块解析之后
+static void frame_line_gap(port_def_t* p)
+{
+    port_frame_t* f = &p->base.frame;
+    if (f->mode != FRAME_MODBUS) return;
+    double chars = f->gap_chars > 0 ? f->gap_chars : FRAME_MODBUS_CHARS;
+    if (p->base.type != PORT_TTY) {
+        f->gap_us   = f->idle_us > 0 ? f->idle_us : FRAME_MODBUS_FAST_US;
+        f->short_us = (int)(f->gap_us * 1.5 / chars);
+        return;
+    }
+    const port_tty_conf_t* t = &p->cfg.tty;
+    int baud = t->baudrate > 0 ? t->baudrate : TTY_DEFAULT_BAUD;
+    // 起始位 + 数据位 + 校验位 + 停止位,与 port_open_tty 的取值一致
+    int bits = 1 + (t->databits == 7 ? 7 : 8) + (t->parity != PARITY_NONE) + (t->stopbits == 2 ? 2 : 1);
+    double char_us = bits * 1e6 / baud;
+    if (f->gap_chars <= 0 && baud > 19200) {
+        f->gap_us   = FRAME_MODBUS_FAST_US;
+        f->short_us = FRAME_MODBUS_FAST_T15;
+    } else {
+        f->gap_us   = (int)(chars * char_us + 0.5);
+        f->short_us = (int)(1.5 * char_us + 0.5);
+    }
+    if (f->idle_us > 0) f->gap_us = f->idle_us;   // 显式静默优先
+    if (f->short_us >= f->gap_us) f->short_us = 0;
+}
+
 static void parse_ports(cJSON* arr)
 {
     if (!arr || !cJSON_IsArray(arr)) {
@@ -89,18 +237,116 @@ static void parse_ports(cJSON* arr)
         if (g_config.port_count >= MAX_PORTS)
             break;
 
-        port_def_t* p = &g_config.ports[g_config.port_count++];
+        port_def_t* p = &g_config.ports[g_config.port_count];
+        p->base.id = g_config.port_count++;
 
         // ---- 基础字段 ----
         GET_STR(item, "name", p->base.name);
 
-        //----
+        // ---- 收方向分帧(可选) ----
         {
+            parse_frame(cJSON_GetObjectItem(item, "frame"), p);
             cJSON* jf = cJSON_GetObjectItem(item, "use_frame");
             if (cJSON_IsBool(jf))
                 p->base.use_frame = cJSON_IsTrue(jf);
             else
-                p->base.use_frame = 0;   // 默认 false
+                p->base.use_frame = p->base.frame.mode != FRAME_NONE;   // 写了 frame 块即开
+            if (p->base.use_frame && p->base.frame.mode == FRAME_NONE)
+                LOG_WARN("[config] %s: use_frame without a frame block, forwarded as read\n",
+                         p->base.name);
+        }
+
+        // ---- 归属 reactor(可选,缺省轮转) ----
+        {
+            cJSON* jr = cJSON_GetObjectItem(item, "reactor");
+            p->base.reactor = cJSON_IsNumber(jr) ? jr->valueint : -1;
+        }
+
+        // ---- 输出合并(可选) ----
+        {
+            cJSON* jc = cJSON_GetObjectItem(item, "coalesce");
+            port_coalesce_t* c = &p->base.coalesce;
+            if (cJSON_IsObject(jc)) {
+                GET_INT(jc, "max_bytes", c->max_bytes);
+                GET_INT(jc, "max_delay_us", c->max_delay_us);
+                if (c->max_bytes <= 0) c->max_bytes = COALESCE_DEFAULT_MAX_BYTES;
+                if (c->max_delay_us < 0) c->max_delay_us = 0;
+                if (c->max_delay_us > COALESCE_MAX_DELAY_US) {
+                    LOG_WARN("[config] %s: coalesce.max_delay_us %d clamped to %d\n",
+                             p->base.name, c->max_delay_us, COALESCE_MAX_DELAY_US);
+                    c->max_delay_us = COALESCE_MAX_DELAY_US;
+                }
+            }
+        }
+
+        // ---- 零拷贝发送阈值(可选,tcp 端口;server 对其 client 生效) ----
+        {
+            cJSON* jz = cJSON_GetObjectItem(item, "zerocopy_min");
+            p->base.zerocopy_min = (cJSON_IsNumber(jz) && jz->valueint > 0) ? jz->valueint : 0;
+        }
+
+        // ---- socket 选项(可选,tcp / udp 端口) ----
+        {
+            cJSON* jo = cJSON_GetObjectItem(item, "socket");
+            port_sockopt_t* so = &p->base.sock;
+            memset(so, 0, sizeof(*so));
+            if (cJSON_IsObject(jo)) {
+                so->nodelay  = cJSON_IsTrue(cJSON_GetObjectItem(jo, "nodelay"));
+                so->quickack = cJSON_IsTrue(cJSON_GetObjectItem(jo, "quickack"));
+                GET_INT(jo, "sndbuf", so->sndbuf);
+                GET_INT(jo, "rcvbuf", so->rcvbuf);
+                GET_INT(jo, "busy_poll_us", so->busy_poll_us);
+                GET_INT(jo, "user_timeout_ms", so->user_timeout_ms);
+                cJSON* jk = cJSON_GetObjectItem(jo, "keepalive");
+                if (cJSON_IsObject(jk)) {
+                    so->keepalive = 1;
+                    GET_INT(jk, "idle_s", so->keepidle_s);
+                    GET_INT(jk, "interval_s", so->keepintvl_s);
+                    GET_INT(jk, "count", so->keepcnt);
+                } else {
+                    so->keepalive = cJSON_IsTrue(jk);
+                }
+                cJSON* jd = cJSON_GetObjectItem(jo, "dscp");
+                cJSON* jt = cJSON_GetObjectItem(jo, "tos");
+                if (cJSON_IsNumber(jd) && jd->valueint >= 0 && jd->valueint < 64)
+                    so->tos = jd->valueint << 2;
+                else if (cJSON_IsNumber(jt) && jt->valueint >= 0 && jt->valueint < 256)
+                    so->tos = jt->valueint;
+                else if (jd || jt)
+                    LOG_WARN("[config] %s: socket.dscp / tos out of range, ignored\n",
+                             p->base.name);
+                if (so->sndbuf < 0) so->sndbuf = 0;
+                if (so->rcvbuf < 0) so->rcvbuf = 0;
+                if (so->busy_poll_us < 0) so->busy_poll_us = 0;
+                if (so->user_timeout_ms < 0) so->user_timeout_ms = 0;
+            }
+        }
+
+        // ---- 慢 client 处理(可选,server 端口) ----
+        {
+            cJSON* js = cJSON_GetObjectItem(item, "slow_client");
+            port_slow_client_t* sc = &p->base.slow_client;
+            sc->policy       = SLOW_CLIENT_BLOCK;
+            sc->budget_bytes = SLOW_CLIENT_DEFAULT_BUDGET;
+            sc->grace_ms     = SLOW_CLIENT_DEFAULT_GRACE_MS;
+            if (cJSON_IsObject(js)) {
+                char policy[32] = {0};
+                GET_STR(js, "policy", policy);
+                GET_INT(js, "budget_bytes", sc->budget_bytes);
+                cJSON* jg = cJSON_GetObjectItem(js, "grace_ms");   // 0 是合法值,缺省不能靠 GET_INT
+                if (cJSON_IsNumber(jg)) sc->grace_ms = jg->valueint;
+                if (strcmp(policy, "disconnect") == 0)
+                    sc->policy = SLOW_CLIENT_DISCONNECT;
+                else if (strcmp(policy, "latest") == 0)
+                    sc->policy = SLOW_CLIENT_LATEST;
+                else if (strcmp(policy, "drop_oldest") == 0)
+                    sc->policy = SLOW_CLIENT_DROP_OLDEST;
+                else if (policy[0] != '\0' && strcmp(policy, "block") != 0)
+                    LOG_WARN("[config] %s: unknown slow_client.policy '%s', use block\n",
+                             p->base.name, policy);
+                if (sc->budget_bytes <= 0) sc->budget_bytes = SLOW_CLIENT_DEFAULT_BUDGET;
+                if (sc->grace_ms < 0) sc->grace_ms = 0;
+            }
         }
 
 
@@ -125,6 +371,12 @@ static void parse_ports(cJSON* arr)
             GET_INT(tty, "stopbits", p->cfg.tty.stopbits);
             GET_INT(tty, "parity",   p->cfg.tty.parity);
             GET_INT(tty, "flow",     p->cfg.tty.flow);
+            p->cfg.tty.low_latency = cJSON_IsTrue(cJSON_GetObjectItem(tty, "low_latency"));
+            if (p->cfg.tty.baudrate < 0) {
+                LOG_WARN("[config] %s: baudrate %d invalid, using %d\n",
+                         p->base.name, p->cfg.tty.baudrate, TTY_DEFAULT_BAUD);
+                p->cfg.tty.baudrate = TTY_DEFAULT_BAUD;
+            }
         }
         else if (strcmp(type_str, "tcp_server") == 0) {
             p->base.type = PORT_TCP_SERVER;
@@ -140,16 +392,49 @@ static void parse_ports(cJSON* arr)
 
             cJSON* tc = cJSON_GetObjectItem(item, "tcp_client");
 
-            GET_STR(tc, "addr", p->cfg.tcp_client.addr);
-            GET_INT(tc, "port", p->cfg.tcp_client.port);
+            port_tcp_client_conf_t* c = &p->cfg.tcp_client;
+            GET_STR(tc, "addr", c->addr);
+            GET_INT(tc, "port", c->port);
+            GET_INT(tc, "reconnect_min_ms", c->reconnect_min_ms);
+            GET_INT(tc, "reconnect_max_ms", c->reconnect_max_ms);
+            GET_INT(tc, "connect_timeout_ms", c->connect_timeout_ms);
+            GET_INT(tc, "buffer_bytes", c->buffer_bytes);
+            if (c->reconnect_min_ms <= 0) c->reconnect_min_ms = TCP_CLIENT_RECONNECT_MIN_MS;
+            if (c->reconnect_max_ms <= 0) c->reconnect_max_ms = TCP_CLIENT_RECONNECT_MAX_MS;
+            if (c->reconnect_max_ms < c->reconnect_min_ms) c->reconnect_max_ms = c->reconnect_min_ms;
+            if (c->connect_timeout_ms <= 0) c->connect_timeout_ms = TCP_CLIENT_CONNECT_TIMEOUT_MS;
+            if (c->buffer_bytes < 0) c->buffer_bytes = 0;
         }
         else if (strcmp(type_str, "udp") == 0) {
             p->base.type = PORT_UDP;
 
             cJSON* u = cJSON_GetObjectItem(item, "udp");
 
-            GET_STR(u, "bind", p->cfg.udp.bind_addr);
-            GET_INT(u, "port", p->cfg.udp.port);
+            port_udp_conf_t* c = &p->cfg.udp;
+            GET_STR(u, "bind", c->bind_addr);
+            GET_INT(u, "port", c->port);
+            GET_STR(u, "peer", c->peer_addr);
+            GET_INT(u, "peer_port", c->peer_port);
+            cJSON* jl = cJSON_GetObjectItem(u, "learn_peer");
+            c->learn_peer = cJSON_IsBool(jl) ? cJSON_IsTrue(jl) : c->peer_addr[0] == '\0';
+
+            cJSON* jm = cJSON_GetObjectItem(u, "multicast");
+            c->mcast_ttl  = UDP_MCAST_DEFAULT_TTL;
+            c->mcast_loop = 0;
+            if (cJSON_IsObject(jm)) {
+                GET_STR(jm, "group", c->mcast_group);
+                GET_STR(jm, "interface", c->mcast_if);
+                cJSON* jt = cJSON_GetObjectItem(jm, "ttl");
+                if (cJSON_IsNumber(jt) && jt->valueint >= 0 && jt->valueint <= 255)
+                    c->mcast_ttl = jt->valueint;
+                cJSON* jo = cJSON_GetObjectItem(jm, "loop");
+                if (cJSON_IsBool(jo)) c->mcast_loop = cJSON_IsTrue(jo);
+            }
+            if (c->peer_addr[0] && (c->peer_port <= 0 || c->peer_port > 65535)) {
+                LOG_WARN("[config] %s: udp.peer_port %d invalid, peer ignored\n",
+                         p->base.name, c->peer_port);
+                c->peer_addr[0] = '\0';
+            }
         }
         else if (strcmp(type_str, "usb") == 0) {
             p->base.type = PORT_USB;
@@ -168,6 +453,7 @@ static void parse_ports(cJSON* arr)
             LOG_INFO("[config] ERROR: unknown port type: %s\n", type_str);
         }
 
+        frame_line_gap(p);
         p->base.fd = -1; // runtime use
     }
 }
@@ -222,6 +508,77 @@ static void parse_routes(cJSON* arr)
         GET_STR(item, "dst",     r->dst);
         GET_STR(item, "plugin",  r->plugin);
         GET_STR(item, "handler", r->handler);
+        r->splice = !cJSON_IsFalse(cJSON_GetObjectItem(item, "splice"));
+
+        char policy[32] = {0};
+        GET_STR(item, "policy", policy);
+        if (policy[0] == '\0' || strcmp(policy, "block") == 0) {
+            r->policy = ROUTE_POLICY_BLOCK;
+        } else if (strcmp(policy, "drop") == 0) {
+            r->policy = ROUTE_POLICY_DROP;
+        } else if (strcmp(policy, "backpressure") == 0) {
+            r->policy = ROUTE_POLICY_BACKPRESSURE;
+        } else {
+            LOG_WARN("[config] route %s -> %s: unknown policy '%s', use block\n",
+                     r->src, r->dst, policy);
+            r->policy = ROUTE_POLICY_BLOCK;
+        }
+    }
+}
+
+
+static void parse_dispatcher(cJSON* obj)
+{
+    if (!obj || !cJSON_IsObject(obj)) {
+        g_config.dispatch_workers = 0;   // 缺省
+        return;
+    }
+    GET_INT(obj, "workers", g_config.dispatch_workers);
+}
+
+// "buffers" 先于 ports 解析:分帧 max_len 按 max_message 夹
+static void parse_buffers(cJSON* obj)
+{
+    if (cJSON_IsObject(obj)) {
+        GET_INT(obj, "max_message", g_config.max_message);
+        GET_INT(obj, "count", g_config.buf_count);
+        GET_INT(obj, "class_bytes", g_config.buf_class_bytes);
+    }
+    if (g_config.max_message < MAX_DATA - 1)   // 缺键 GET_INT 给 0
+        g_config.max_message = MAX_DATA - 1;
+    if (g_config.max_message > MAX_MESSAGE) {
+        LOG_WARN("[config] buffers.max_message %d clamped to %d\n",
+                 g_config.max_message, MAX_MESSAGE);
+        g_config.max_message = MAX_MESSAGE;
+    }
+    if (g_config.buf_count < 0) g_config.buf_count = 0;
+    if (g_config.buf_class_bytes < 0) g_config.buf_class_bytes = 0;
+}
+
+static void parse_reactor(cJSON* obj)
+{
+    g_config.reactor_threads = 1;   // 缺省单 reactor
+    g_config.reactor_edge = 1;      // 缺省边沿触发,一次就绪读到空
+    g_config.reactor_backend = REACTOR_BACKEND_EPOLL;
+    if (obj && cJSON_IsObject(obj)) {
+        GET_INT(obj, "threads", g_config.reactor_threads);
+        cJSON* je = cJSON_GetObjectItem(obj, "edge_triggered");
+        if (cJSON_IsBool(je))
+            g_config.reactor_edge = cJSON_IsTrue(je);
+        cJSON* jb = cJSON_GetObjectItem(obj, "backend");
+        if (cJSON_IsString(jb)) {
+            if (strcmp(jb->valuestring, "io_uring") == 0)
+                g_config.reactor_backend = REACTOR_BACKEND_URING;
+            else if (strcmp(jb->valuestring, "epoll") != 0)
+                LOG_WARN("[config] unknown reactor.backend '%s', using epoll\n", jb->valuestring);
+        }
+    }
+    if (g_config.reactor_threads < 1)   // 缺键 GET_INT 给 0
+        g_config.reactor_threads = 1;
+    if (g_config.reactor_threads > REACTOR_MAX_THREADS) {
+        LOG_WARN("[config] reactor.threads %d clamped to %d\n",
+                 g_config.reactor_threads, REACTOR_MAX_THREADS);
+        g_config.reactor_threads = REACTOR_MAX_THREADS;
     }
 }
 
@@ -255,9 +612,12 @@ int load_config(const char* filename)
     }
 
     LOG_INFO("[config] before parse!\n");
+    parse_buffers(cJSON_GetObjectItem(root, "buffers"));
     parse_ports(cJSON_GetObjectItem(root, "ports"));
     parse_plugins(cJSON_GetObjectItem(root, "plugins"));
     parse_routes(cJSON_GetObjectItem(root, "routes"));
+    parse_dispatcher(cJSON_GetObjectItem(root, "dispatcher"));
+    parse_reactor(cJSON_GetObjectItem(root, "reactor"));
 
     cJSON_Delete(root);
 
@@ -269,6 +629,73 @@ int load_config(const char* filename)
     return 0;
 }
 
+// "socket" 块:只写设置过的项,全缺省时不写
+static void save_sockopt(cJSON* o, const port_sockopt_t* so)
+{
+    if (!(so->nodelay || so->quickack || so->sndbuf || so->rcvbuf || so->busy_poll_us ||
+          so->user_timeout_ms || so->keepalive || so->tos))
+        return;
+    cJSON* js = cJSON_AddObjectToObject(o, "socket");
+    if (so->nodelay) cJSON_AddBoolToObject(js, "nodelay", 1);
+    if (so->quickack) cJSON_AddBoolToObject(js, "quickack", 1);
+    if (so->sndbuf) cJSON_AddNumberToObject(js, "sndbuf", so->sndbuf);
+    if (so->rcvbuf) cJSON_AddNumberToObject(js, "rcvbuf", so->rcvbuf);
+    if (so->busy_poll_us) cJSON_AddNumberToObject(js, "busy_poll_us", so->busy_poll_us);
+    if (so->user_timeout_ms) cJSON_AddNumberToObject(js, "user_timeout_ms", so->user_timeout_ms);
+    if (so->keepalive) {
+        cJSON* jk = cJSON_AddObjectToObject(js, "keepalive");
+        if (so->keepidle_s) cJSON_AddNumberToObject(jk, "idle_s", so->keepidle_s);
+        if (so->keepintvl_s) cJSON_AddNumberToObject(jk, "interval_s", so->keepintvl_s);
+        if (so->keepcnt) cJSON_AddNumberToObject(jk, "count", so->keepcnt);
+    }
+    if (so->tos) cJSON_AddNumberToObject(js, "tos", so->tos);
+}
+
+// "frame" 块:只写当前模式用到的项
+static void save_frame(cJSON* o, const port_base_t* b)
+{
+    const port_frame_t* f = &b->frame;
+    if (f->mode == FRAME_NONE) {
+        if (b->use_frame) cJSON_AddBoolToObject(o, "use_frame", 1);
+        return;
+    }
+    if (!b->use_frame) cJSON_AddBoolToObject(o, "use_frame", 0);
+    cJSON* jf = cJSON_AddObjectToObject(o, "frame");
+    cJSON_AddStringToObject(jf, "mode", frame_mode_name(f->mode));
+    if (f->max_len != g_config.max_message) cJSON_AddNumberToObject(jf, "max_len", f->max_len);
+    switch (f->mode) {
+    case FRAME_DELIMITER: {
+        // 带 NUL 的分隔符写不成 C 字符串,写字节数组
+        if (memchr(f->delim, 0, (size_t)f->delim_len)) {
+            cJSON* ja = cJSON_AddArrayToObject(jf, "delimiter");
+            for (int k = 0; k < f->delim_len; k++)
+                cJSON_AddItemToArray(ja, cJSON_CreateNumber(f->delim[k]));
+        } else {
+            char d[FRAME_DELIM_MAX + 1] = {0};
+            memcpy(d, f->delim, (size_t)f->delim_len);
+            cJSON_AddStringToObject(jf, "delimiter", d);
+        }
+        if (f->keep_delim) cJSON_AddBoolToObject(jf, "keep_delimiter", 1);
+        break;
+    }
+    case FRAME_LENGTH:
+        cJSON_AddNumberToObject(jf, "offset", f->len_offset);
+        cJSON_AddNumberToObject(jf, "width", f->len_width);
+        cJSON_AddStringToObject(jf, "endian", f->len_big ? "big" : "little");
+        if (f->len_adjust) cJSON_AddNumberToObject(jf, "adjust", f->len_adjust);
+        break;
+    case FRAME_IDLE:
+        cJSON_AddNumberToObject(jf, "idle_us", f->idle_us);
+        break;
+    case FRAME_MODBUS:
+        if (f->idle_us > 0) cJSON_AddNumberToObject(jf, "idle_us", f->idle_us);
+        if (f->gap_chars > 0) cJSON_AddNumberToObject(jf, "gap_chars", f->gap_chars);
+        break;
+    default:
+        break;
+    }
+}
+
 // ============ save_config() ============
 int save_config(const char* filename)
 {
@@ -284,6 +711,23 @@ int save_config(const char* filename)
 
         // 基础字段
         cJSON_AddStringToObject(o, "name", p->base.name);
+        if (p->base.reactor >= 0)
+            cJSON_AddNumberToObject(o, "reactor", p->base.reactor);
+        if (p->base.coalesce.max_delay_us > 0) {
+            cJSON* jc = cJSON_AddObjectToObject(o, "coalesce");
+            cJSON_AddNumberToObject(jc, "max_bytes", p->base.coalesce.max_bytes);
+            cJSON_AddNumberToObject(jc, "max_delay_us", p->base.coalesce.max_delay_us);
+        }
+        if (p->base.slow_client.policy != SLOW_CLIENT_BLOCK) {
+            cJSON* js = cJSON_AddObjectToObject(o, "slow_client");
+            cJSON_AddStringToObject(js, "policy", slow_client_policy_name(p->base.slow_client.policy));
+            cJSON_AddNumberToObject(js, "budget_bytes", p->base.slow_client.budget_bytes);
+            cJSON_AddNumberToObject(js, "grace_ms", p->base.slow_client.grace_ms);
+        }
+        if (p->base.zerocopy_min > 0)
+            cJSON_AddNumberToObject(o, "zerocopy_min", p->base.zerocopy_min);
+        save_sockopt(o, &p->base.sock);
+        save_frame(o, &p->base);
 
         // 根据类型写入 type + 子对象
         switch (p->base.type)
@@ -300,6 +744,8 @@ int save_config(const char* filename)
             cJSON_AddNumberToObject(tty, "stopbits", p->cfg.tty.stopbits);
             cJSON_AddNumberToObject(tty, "parity",   p->cfg.tty.parity);
             cJSON_AddNumberToObject(tty, "flow",     p->cfg.tty.flow);
+            if (p->cfg.tty.low_latency)
+                cJSON_AddBoolToObject(tty, "low_latency", 1);
             break;
         }
 
@@ -323,6 +769,11 @@ case PORT_TCP_CLIENT: {
 
     cJSON_AddStringToObject(tc, "addr", p->cfg.tcp_client.addr);
     cJSON_AddNumberToObject(tc, "port", p->cfg.tcp_client.port);
+    cJSON_AddNumberToObject(tc, "reconnect_min_ms", p->cfg.tcp_client.reconnect_min_ms);
+    cJSON_AddNumberToObject(tc, "reconnect_max_ms", p->cfg.tcp_client.reconnect_max_ms);
+    cJSON_AddNumberToObject(tc, "connect_timeout_ms", p->cfg.tcp_client.connect_timeout_ms);
+    if (p->cfg.tcp_client.buffer_bytes > 0)
+        cJSON_AddNumberToObject(tc, "buffer_bytes", p->cfg.tcp_client.buffer_bytes);
     break;
 }
 
@@ -332,8 +783,21 @@ case PORT_UDP: {
     cJSON* u = cJSON_CreateObject();
     cJSON_AddItemToObject(o, "udp", u);
 
-    cJSON_AddStringToObject(u, "bind", p->cfg.udp.bind_addr);
-    cJSON_AddNumberToObject(u, "port", p->cfg.udp.port);
+    const port_udp_conf_t* c = &p->cfg.udp;
+    cJSON_AddStringToObject(u, "bind", c->bind_addr);
+    cJSON_AddNumberToObject(u, "port", c->port);
+    if (c->peer_addr[0]) {
+        cJSON_AddStringToObject(u, "peer", c->peer_addr);
+        cJSON_AddNumberToObject(u, "peer_port", c->peer_port);
+    }
+    cJSON_AddBoolToObject(u, "learn_peer", c->learn_peer);
+    if (c->mcast_group[0]) {
+        cJSON* jm = cJSON_AddObjectToObject(u, "multicast");
+        cJSON_AddStringToObject(jm, "group", c->mcast_group);
+        if (c->mcast_if[0]) cJSON_AddStringToObject(jm, "interface", c->mcast_if);
+        cJSON_AddNumberToObject(jm, "ttl", c->mcast_ttl);
+        cJSON_AddBoolToObject(jm, "loop", c->mcast_loop);
+    }
     break;
 }
 
@@ -373,8 +837,24 @@ for (int i = 0; i < g_config.route_count; i++) {
     cJSON_AddStringToObject(o, "dst",     r->dst);
     cJSON_AddStringToObject(o, "plugin",  r->plugin);
     cJSON_AddStringToObject(o, "handler", r->handler);
+    cJSON_AddStringToObject(o, "policy",  route_policy_name(r->policy));
+    if (!r->splice) cJSON_AddFalseToObject(o, "splice");
 }
 
+    // dispatcher
+cJSON* disp = cJSON_AddObjectToObject(root, "dispatcher");
+cJSON_AddNumberToObject(disp, "workers", g_config.dispatch_workers);
+
+cJSON* react = cJSON_AddObjectToObject(root, "reactor");
+cJSON_AddNumberToObject(react, "threads", g_config.reactor_threads);
+cJSON_AddBoolToObject(react, "edge_triggered", g_config.reactor_edge);
+cJSON_AddStringToObject(react, "backend", reactor_backend_name(g_config.reactor_backend));
+
+cJSON* bufs = cJSON_AddObjectToObject(root, "buffers");
+cJSON_AddNumberToObject(bufs, "max_message", g_config.max_message);
+if (g_config.buf_count) cJSON_AddNumberToObject(bufs, "count", g_config.buf_count);
+if (g_config.buf_class_bytes) cJSON_AddNumberToObject(bufs, "class_bytes", g_config.buf_class_bytes);
+
 char* out = cJSON_Print(root);
 
 FILE* fp = fopen(filename, "wb");
@@ -432,6 +912,31 @@ void config_print()
         LOG_INFO("  [%d]\n", i);
         LOG_INFO("    name : %s\n", p->base.name);
         LOG_INFO("    use_frame: %d\n",p->base.use_frame);
+        if (p->base.frame.mode != FRAME_NONE)
+            LOG_INFO("    frame: mode=%s max_len=%d delim_len=%d len=%d@%d/%s%+d idle_us=%d gap_us=%d t1.5=%d\n",
+                     frame_mode_name(p->base.frame.mode), p->base.frame.max_len,
+                     p->base.frame.delim_len, p->base.frame.len_width, p->base.frame.len_offset,
+                     p->base.frame.len_big ? "be" : "le", p->base.frame.len_adjust,
+                     p->base.frame.idle_us, p->base.frame.gap_us, p->base.frame.short_us);
+        if (p->base.reactor >= 0)
+            LOG_INFO("    reactor  : %d\n", p->base.reactor);
+        if (p->base.coalesce.max_delay_us > 0)
+            LOG_INFO("    coalesce: max_bytes=%d max_delay_us=%d\n",
+                     p->base.coalesce.max_bytes, p->base.coalesce.max_delay_us);
+        if (p->base.slow_client.policy != SLOW_CLIENT_BLOCK)
+            LOG_INFO("    slow_client: policy=%s budget_bytes=%d grace_ms=%d\n",
+                     slow_client_policy_name(p->base.slow_client.policy),
+                     p->base.slow_client.budget_bytes, p->base.slow_client.grace_ms);
+        if (p->base.zerocopy_min > 0)
+            LOG_INFO("    zerocopy_min: %d\n", p->base.zerocopy_min);
+        const port_sockopt_t* so = &p->base.sock;
+        if (so->nodelay || so->quickack || so->sndbuf || so->rcvbuf || so->busy_poll_us ||
+            so->user_timeout_ms || so->keepalive || so->tos)
+            LOG_INFO("    socket: nodelay=%d quickack=%d sndbuf=%d rcvbuf=%d busy_poll_us=%d "
+                     "user_timeout_ms=%d keepalive=%d(%d/%d/%d) tos=0x%02x\n",
+                     so->nodelay, so->quickack, so->sndbuf, so->rcvbuf, so->busy_poll_us,
+                     so->user_timeout_ms, so->keepalive, so->keepidle_s, so->keepintvl_s,
+                     so->keepcnt, so->tos);
         LOG_INFO("    type : ");
 
         switch (p->base.type)
@@ -444,6 +949,8 @@ void config_print()
                 LOG_INFO("      stopbits  : %d\n", p->cfg.tty.stopbits);
                 LOG_INFO("      parity    : %d\n", p->cfg.tty.parity);
                 LOG_INFO("      flow      : %d\n", p->cfg.tty.flow);
+                if (p->cfg.tty.low_latency)
+                    LOG_INFO("      low_latency: yes\n");
                 break;
 
             case PORT_TCP_SERVER:
@@ -457,12 +964,27 @@ void config_print()
                 LOG_INFO("tcp_client\n");
                 LOG_INFO("      addr      : %s\n", p->cfg.tcp_client.addr);
                 LOG_INFO("      port      : %d\n", p->cfg.tcp_client.port);
+                LOG_INFO("      reconnect : %d..%d ms, connect timeout %d ms\n",
+                         p->cfg.tcp_client.reconnect_min_ms, p->cfg.tcp_client.reconnect_max_ms,
+                         p->cfg.tcp_client.connect_timeout_ms);
+                if (p->cfg.tcp_client.buffer_bytes > 0)
+                    LOG_INFO("      buffer    : %d bytes while disconnected\n",
+                             p->cfg.tcp_client.buffer_bytes);
                 break;
 
             case PORT_UDP:
                 LOG_INFO("udp\n");
                 LOG_INFO("      bind      : %s\n", p->cfg.udp.bind_addr);
                 LOG_INFO("      port      : %d\n", p->cfg.udp.port);
+                if (p->cfg.udp.peer_addr[0])
+                    LOG_INFO("      peer      : %s:%d\n",
+                             p->cfg.udp.peer_addr, p->cfg.udp.peer_port);
+                LOG_INFO("      learn peer: %s\n", p->cfg.udp.learn_peer ? "yes" : "no");
+                if (p->cfg.udp.mcast_group[0])
+                    LOG_INFO("      multicast : %s if=%s ttl=%d loop=%d\n",
+                             p->cfg.udp.mcast_group,
+                             p->cfg.udp.mcast_if[0] ? p->cfg.udp.mcast_if : "any",
+                             p->cfg.udp.mcast_ttl, p->cfg.udp.mcast_loop);
                 break;
 
             case PORT_USB:
@@ -500,7 +1022,17 @@ void config_print()
         LOG_INFO("    dst     : %s\n", r->dst);
         LOG_INFO("    plugin  : %s\n", r->plugin);
         LOG_INFO("    handler : %s\n", r->handler);
+        LOG_INFO("    policy  : %s\n", route_policy_name(r->policy));
+        if (!r->splice) LOG_INFO("    splice  : off\n");
     }
 
+    /* ----------- DISPATCHER ----------- */
+    LOG_INFO("\n[DISPATCHER] workers = %d\n", g_config.dispatch_workers);
+    LOG_INFO("[REACTOR] threads = %d, edge_triggered = %d, backend = %s\n",
+             g_config.reactor_threads, g_config.reactor_edge,
+             reactor_backend_name(g_config.reactor_backend));
+    LOG_INFO("[BUFFERS] max_message = %d, count = %d, class_bytes = %d\n",
+             g_config.max_message, g_config.buf_count, g_config.buf_class_bytes);
+
     LOG_INFO("\n=============================================\n\n");
 }
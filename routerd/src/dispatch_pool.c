@@ -0,0 +1,405 @@
+// dispatch_pool.c — 按目的端口分队列的 dispatcher worker 池
+//
+// 详见 dispatch_pool.h 文件头。
+//
+// 并发:
+//   - g_dsts[] / g_workers[] 在 init 时建好,worker 启动后只读(无锁)
+//   - 每条队列只有一个 worker 消费,SPSC 契约由"固定归属"保证;
+//     生产侧每个 reactor 独占一条 lane,同样是单生产者
+//   - worker 空闲时睡在自己的 queue_waiter_t 上,任一归属队列 commit 即唤醒;
+//     有合并端口的 worker 同时等自己的 timerfd(最早的合并截止时间)
+//   - 合并中的消息(pend)已出队,只属于 worker,不再占队列槽位
+//
+// 测试:tests/unit/test_dispatch_pool.c
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "dispatch_pool.h"
+#include "config_store.h"
+#include "buf_pool.h"
+#include "run_state.h"
+#include "log.h"
+
+typedef struct {
+    char           name[32];
+    event_queue_t* q[REACTOR_MAX_THREADS];   // 每 reactor 一条 lane
+    int            worker;
+    int            port_id;     // g_config.ports 下标(发送挂钩的 blocked 用)
+    atomic_ulong   batches;     // 只由归属 worker 写,stats 任意线程读
+    atomic_uint    batch_max;
+    atomic_ulong   timer_flushes;
+
+    // 输出合并(max_delay_us == 0 = 不合并),以下只由归属 worker 访问
+    int            max_bytes;
+    int            max_delay_us;
+    event_msg_t    pend[DISPATCH_COALESCE_MAX_MSGS];
+    int            pend_n;
+    int            pend_bytes;
+    uint64_t       deadline_ns;   // 第一条 pend 入手时间 + max_delay_us
+} dispatch_dst_t;
+
+typedef struct {
+    int            id;
+    pthread_t      th;
+    int            started;
+    queue_waiter_t waiter;
+    int            tfd;                  // 合并发送的截止时间,-1 = 本 worker 无合并端口
+    int            dst_idx[MAX_PORTS];   // 归属本 worker 的 g_dsts 下标
+    int            dst_count;
+} dispatch_worker_t;
+
+static dispatch_dst_t    g_dsts[MAX_PORTS];
+static int               g_dst_count = 0;
+static dispatch_worker_t g_workers[DISPATCH_MAX_WORKERS];
+static int               g_worker_count = 0;
+static int               g_lanes = 1;
+static dispatch_fn_t     g_fn = NULL;
+static dispatch_tx_hooks_t g_tx;   // 全空 = 同步发送,无输出环
+static atomic_int        g_stop;
+
+static int find_dst(const char* name)
+{
+    for (int i = 0; i < g_dst_count; i++) {
+        if (strcmp(g_dsts[i].name, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+void dispatch_pool_set_tx_hooks(const dispatch_tx_hooks_t* hooks)
+{
+    if (hooks)
+        g_tx = *hooks;
+    else
+        memset(&g_tx, 0, sizeof(g_tx));
+}
+
+int dispatch_pool_init(int workers, dispatch_fn_t fn)
+{
+    g_fn = fn;
+    g_dst_count = 0;
+    g_worker_count = 0;
+    atomic_store(&g_stop, 0);
+
+    g_lanes = g_config.reactor_threads;
+    if (g_lanes < 1) g_lanes = 1;
+    if (g_lanes > REACTOR_MAX_THREADS) g_lanes = REACTOR_MAX_THREADS;
+
+    // 收集被路由引用的目的端口(按首次出现顺序,去重)
+    for (int i = 0; i < g_config.route_count; i++) {
+        const char* dst = g_config.routes[i].dst;
+        if (dst[0] == '\0' || find_dst(dst) >= 0) continue;
+        if (!config_find_port(dst)) {
+            LOG_WARN("[dispatch] route %s -> %s: dst port not configured\n",
+                     g_config.routes[i].src, dst);
+            continue;
+        }
+        if (g_dst_count >= MAX_PORTS) break;
+        memset(&g_dsts[g_dst_count], 0, sizeof(g_dsts[0]));
+        strncpy(g_dsts[g_dst_count].name, dst, sizeof(g_dsts[0].name) - 1);
+        g_dsts[g_dst_count].port_id = (int)(config_find_port(dst) - g_config.ports);
+        const port_coalesce_t* c = &config_find_port(dst)->base.coalesce;
+        g_dsts[g_dst_count].max_bytes    = c->max_bytes;
+        g_dsts[g_dst_count].max_delay_us = c->max_delay_us;
+        g_dsts[g_dst_count].name[sizeof(g_dsts[0].name) - 1] = '\0';
+        g_dst_count++;
+    }
+
+    if (workers <= 0) workers = DISPATCH_DEFAULT_WORKERS;
+    if (workers > DISPATCH_MAX_WORKERS) workers = DISPATCH_MAX_WORKERS;
+    if (workers > g_dst_count) workers = g_dst_count;   // 空 worker 无意义
+
+    for (int w = 0; w < workers; w++) {
+        dispatch_worker_t* wk = &g_workers[w];
+        memset(wk, 0, sizeof(*wk));
+        wk->id = w;
+        wk->tfd = -1;
+        if (queue_waiter_init(&wk->waiter) < 0) return -1;
+        g_worker_count++;
+    }
+
+    for (int i = 0; i < g_dst_count; i++) {
+        dispatch_worker_t* wk = &g_workers[i % workers];
+        g_dsts[i].worker = wk->id;
+        for (int l = 0; l < g_lanes; l++) {
+            char qname[32];
+            if (g_lanes == 1)
+                snprintf(qname, sizeof(qname), "%.*s", (int)sizeof(qname) - 1, g_dsts[i].name);
+            else
+                snprintf(qname, sizeof(qname), "%.24s/r%d", g_dsts[i].name, l);
+            g_dsts[i].q[l] = queue_create(qname, &wk->waiter);
+            if (!g_dsts[i].q[l]) return -1;
+        }
+        wk->dst_idx[wk->dst_count++] = i;
+        LOG_INFO("[dispatch] dst %s -> worker %d, %d lane(s)\n", g_dsts[i].name, wk->id, g_lanes);
+
+        if (g_dsts[i].max_delay_us > 0) {
+            if (wk->tfd < 0)
+                wk->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+            if (wk->tfd < 0) {
+                LOG_WARN("[dispatch] %s: timerfd failed, coalesce disabled\n", g_dsts[i].name);
+                g_dsts[i].max_delay_us = 0;
+            } else {
+                LOG_INFO("[dispatch] dst %s coalesce max_bytes=%d max_delay_us=%d\n",
+                         g_dsts[i].name, g_dsts[i].max_bytes, g_dsts[i].max_delay_us);
+            }
+        }
+    }
+
+    LOG_INFO("[dispatch] %d dst queues, %d workers\n", g_dst_count, g_worker_count);
+    return g_dst_count;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void note_batch(dispatch_dst_t* d, int n)
+{
+    atomic_fetch_add_explicit(&d->batches, 1, memory_order_relaxed);
+    if ((unsigned)n > atomic_load_explicit(&d->batch_max, memory_order_relaxed))
+        atomic_store_explicit(&d->batch_max, (unsigned)n, memory_order_relaxed);
+}
+
+// 交给回调发送,然后归还消息持有的 buf 引用(最后一个目的端口发完即归还池)
+static void deliver(dispatch_dst_t* d, event_msg_t* msgs, int n)
+{
+    g_fn(msgs, n);
+    for (int i = 0; i < n; i++)
+        buf_unref(msgs[i].buf);
+    note_batch(d, n);
+}
+
+static void coalesce_flush(dispatch_dst_t* d)
+{
+    if (d->pend_n == 0) return;
+    deliver(d, d->pend, d->pend_n);
+    d->pend_n = 0;
+    d->pend_bytes = 0;
+}
+
+// 合并端口:从一条 lane 取到 pend 里,够 max_bytes / 条数上限立即发。返回取出条数。
+static int coalesce_pull(dispatch_dst_t* d, event_queue_t* q)
+{
+    int room = DISPATCH_COALESCE_MAX_MSGS - d->pend_n;
+    if (room > DISPATCH_QUANTUM) room = DISPATCH_QUANTUM;
+    int n = queue_pop_batch_bytes(q, &d->pend[d->pend_n], room, DISPATCH_QUANTUM_BYTES);
+    if (n == 0) return 0;
+
+    if (d->pend_n == 0)
+        d->deadline_ns = now_ns() + (uint64_t)d->max_delay_us * 1000ull;
+    for (int i = 0; i < n; i++)
+        d->pend_bytes += d->pend[d->pend_n + i].len;
+    d->pend_n += n;
+
+    if (d->pend_bytes >= d->max_bytes || d->pend_n >= DISPATCH_COALESCE_MAX_MSGS)
+        coalesce_flush(d);
+    return n;
+}
+
+// 发送所有已到期的合并批,再把 timerfd 设到最早的未到期截止时间(没有则停表)
+static void coalesce_timers(dispatch_worker_t* wk)
+{
+    if (wk->tfd < 0) return;
+
+    uint64_t now = now_ns();
+    uint64_t next = 0;
+    for (int k = 0; k < wk->dst_count; k++) {
+        dispatch_dst_t* d = &g_dsts[wk->dst_idx[k]];
+        if (d->pend_n == 0) continue;
+        if (d->deadline_ns <= now) {
+            coalesce_flush(d);
+            atomic_fetch_add_explicit(&d->timer_flushes, 1, memory_order_relaxed);
+        } else if (next == 0 || d->deadline_ns < next) {
+            next = d->deadline_ns;
+        }
+    }
+
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec  = (time_t)(next / 1000000000ull);
+    its.it_value.tv_nsec = (long)(next % 1000000000ull);
+    timerfd_settime(wk->tfd, TFD_TIMER_ABSTIME, &its, NULL);   // next == 0 → 停表
+}
+
+static int dst_blocked(const dispatch_dst_t* d)
+{
+    return g_tx.blocked && g_tx.blocked(d->port_id);
+}
+
+// 轮询本 worker 的所有队列(每目的端口的每条 lane),每条一次批量取最多
+// DISPATCH_QUANTUM 条 / DISPATCH_QUANTUM_BYTES 字节。输出积压过高水位的目的端口跳过。返回本轮处理条数。
+static int drain_once(dispatch_worker_t* wk)
+{
+    event_msg_t batch[DISPATCH_QUANTUM];
+    int done = 0;
+    for (int k = 0; k < wk->dst_count; k++) {
+        dispatch_dst_t* d = &g_dsts[wk->dst_idx[k]];
+        for (int l = 0; l < g_lanes; l++) {
+            // 每条 lane 前都查:上一条 lane 的一批可能刚把发送环推过高水位
+            if (dst_blocked(d)) break;
+            if (d->max_delay_us > 0) {
+                done += coalesce_pull(d, d->q[l]);
+                continue;
+            }
+            int n = queue_pop_batch_bytes(d->q[l], batch, DISPATCH_QUANTUM, DISPATCH_QUANTUM_BYTES);
+            if (n == 0) continue;
+            deliver(d, batch, n);
+            done += n;
+        }
+    }
+    return done;
+}
+
+static int any_pending(dispatch_worker_t* wk)
+{
+    for (int k = 0; k < wk->dst_count; k++) {
+        if (dst_blocked(&g_dsts[wk->dst_idx[k]])) continue;   // 等 EPOLLOUT 唤醒
+        for (int l = 0; l < g_lanes; l++) {
+            if (queue_try_peek(g_dsts[wk->dst_idx[k]].q[l]))
+                return 1;
+        }
+    }
+    return 0;
+}
+
+static void* worker_main(void* arg)
+{
+    dispatch_worker_t* wk = arg;
+    LOG_INFO("[dispatch] worker %d started, %d queues\n", wk->id, wk->dst_count);
+    int txfd = g_tx.thread_init ? g_tx.thread_init() : -1;
+
+    while (run_state_is_running() && !atomic_load(&g_stop)) {
+        if (g_tx.round_begin) g_tx.round_begin();
+        int tx_wait = g_tx.poll ? g_tx.poll() : -1;
+        int done = drain_once(wk);
+        coalesce_timers(wk);
+        if (g_tx.round_end) g_tx.round_end();
+        if (done > 0)
+            continue;
+
+        // 先置 waiting 再重检,与 queue_commit 的 exchange 配对,不丢唤醒
+        queue_waiter_prepare(&wk->waiter);
+        if (any_pending(wk) || atomic_load(&g_stop)) {
+            queue_waiter_cancel(&wk->waiter);
+            continue;
+        }
+        if (wk->tfd < 0 && txfd < 0) {
+            queue_waiter_sleep(&wk->waiter, tx_wait);
+        } else {
+            // 合并截止时间 / 排队端口可写 也能叫醒
+            int fds[2] = {wk->tfd, txfd};
+            queue_waiter_sleep_fds(&wk->waiter, fds, 2, tx_wait);
+            if (wk->tfd >= 0) {
+                uint64_t exp;
+                (void)!read(wk->tfd, &exp, sizeof(exp));   // 非阻塞,没到期 EAGAIN
+            }
+        }
+    }
+
+    // 退出前把攒着的发掉,buf 引用归还
+    if (g_tx.round_begin) g_tx.round_begin();
+    for (int k = 0; k < wk->dst_count; k++)
+        coalesce_flush(&g_dsts[wk->dst_idx[k]]);
+    if (g_tx.round_end) g_tx.round_end();
+    if (g_tx.thread_exit) g_tx.thread_exit();
+    return NULL;
+}
+
+int dispatch_pool_start(void)
+{
+    int started = 0;
+    for (int w = 0; w < g_worker_count; w++) {
+        if (pthread_create(&g_workers[w].th, NULL, worker_main, &g_workers[w]) != 0) {
+            LOG_ERROR("[dispatch] worker %d create failed\n", w);
+            continue;
+        }
+        g_workers[w].started = 1;
+        started++;
+    }
+    return started;
+}
+
+void dispatch_pool_stop(void)
+{
+    atomic_store(&g_stop, 1);
+    for (int w = 0; w < g_worker_count; w++) {
+        if (!g_workers[w].started) continue;
+        queue_waiter_wake(&g_workers[w].waiter);
+        pthread_join(g_workers[w].th, NULL);
+        g_workers[w].started = 0;
+    }
+    for (int i = 0; i < g_dst_count; i++) {
+        for (int l = 0; l < g_lanes; l++) {
+            queue_destroy(g_dsts[i].q[l]);
+            g_dsts[i].q[l] = NULL;
+        }
+    }
+    for (int w = 0; w < g_worker_count; w++) {
+        queue_waiter_destroy(&g_workers[w].waiter);
+        if (g_workers[w].tfd >= 0) close(g_workers[w].tfd);
+        g_workers[w].tfd = -1;
+    }
+    g_dst_count = 0;
+    g_worker_count = 0;
+}
+
+event_queue_t* dispatch_queue_by_name(const char* dst)
+{
+    return dispatch_lane(dst, 0);
+}
+
+event_queue_t* dispatch_lane(const char* dst, int reactor)
+{
+    if (!dst || reactor < 0 || reactor >= g_lanes) return NULL;
+    int i = find_dst(dst);
+    return (i >= 0) ? g_dsts[i].q[reactor] : NULL;
+}
+
+int dispatch_pool_lanes(void)
+{
+    return g_lanes;
+}
+
+int dispatch_pool_get_stats(dispatch_dst_stats_t* out, int max)
+{
+    int n = 0;
+    for (int i = 0; i < g_dst_count && n < max; i++, n++) {
+        memcpy(out[n].name, g_dsts[i].name, sizeof(out[n].name));
+        out[n].worker = g_dsts[i].worker;
+        out[n].depth  = 0;
+        out[n].sent   = 0;
+        out[n].drops  = 0;
+        for (int l = 0; l < g_lanes; l++) {
+            event_queue_t* q = g_dsts[i].q[l];
+            out[n].depth += queue_depth(q);
+            out[n].sent  += queue_get_pop_count(q);
+            out[n].drops += queue_get_drop_count(q);
+        }
+        out[n].batches   = atomic_load_explicit(&g_dsts[i].batches, memory_order_relaxed);
+        out[n].batch_max = atomic_load_explicit(&g_dsts[i].batch_max, memory_order_relaxed);
+        out[n].timer_flushes = atomic_load_explicit(&g_dsts[i].timer_flushes, memory_order_relaxed);
+    }
+    return n;
+}
+
+void dispatch_pool_log_stats(void)
+{
+    dispatch_dst_stats_t st[MAX_PORTS];
+    int n = dispatch_pool_get_stats(st, MAX_PORTS);
+    for (int i = 0; i < n; i++) {
+        LOG_DEBUG("[dispatch] dst=%s worker=%d depth=%u sent=%lu drops=%lu "
+                  "batches=%lu avg_batch=%.1f max_batch=%u timer_flushes=%lu\n",
+                  st[i].name, st[i].worker, st[i].depth, st[i].sent, st[i].drops,
+                  st[i].batches, st[i].batches ? (double)st[i].sent / st[i].batches : 0.0,
+                  st[i].batch_max, st[i].timer_flushes);
+    }
+}
@@ -1,87 +1,381 @@
+// event_queue.c — reactor → dispatcher worker 的单生产者/单消费者(SPSC)无锁环
+//
+// 线程模型(隐性契约,改动前先确认):
+//   - 每个队列的生产者只有 reactor 线程(queue_push / queue_reserve+queue_commit)
+//   - 每个队列的消费者只有一个 dispatcher worker(queue_pop / queue_peek+queue_release)
+//   一个 worker 可以消费多个队列,它们共享同一个 queue_waiter_t 睡眠。
+//   多生产者/多消费者场景下本实现不安全,需要换 MPMC 结构。
+//
+// 同步:
+//   - head(消费者写)/ tail(生产者写)各占独立 cache line,避免 false sharing
+//   - 数据路径只有 acquire/release 原子操作,无 mutex
+//   - 睡眠/唤醒走 eventfd,只在"对方确实在睡"时才 write(empty→non-empty /
+//     full→non-full 两个边沿),稳态突发下不进内核
+//   - waiting 标志与索引之间是 Dekker 式握手:双方都用 seq_cst 先写自己的
+//     标志再读对方的索引,保证至少一方看到对方,不会丢唤醒
+
 #include <string.h>
-#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 #include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
 #include "event_queue.h"
 #include "log.h"
 
-#define QSIZE 128
+_Static_assert((QSIZE & (QSIZE - 1)) == 0, "QSIZE must be a power of two");
+
+#define QMASK (QSIZE - 1)
+
+// 容量保持 QSIZE-1(与旧 mutex 版一致,test_queue_drop 依赖这个边界)
+static inline int ring_full(unsigned head, unsigned tail)
+{
+    return tail - head >= QSIZE - 1;   // 自由增长的 unsigned 索引,回绕后差值仍正确
+}
+
+static void efd_signal(int efd)
+{
+    uint64_t one = 1;
+    // eventfd 计数器不会满(2^64-2),write 只会因 EINTR 失败
+    while (write(efd, &one, sizeof(one)) < 0 && errno == EINTR) {}
+}
 
-static event_msg_t queue[QSIZE];
-static int head = 0, tail = 0;
-static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t  cond_not_empty = PTHREAD_COND_INITIALIZER;
-static pthread_cond_t  cond_not_full  = PTHREAD_COND_INITIALIZER;
+// 等待 eventfd 可读并清零计数。timeout_ms < 0 表示无限等。
+// 返回 1 = 被唤醒,0 = 超时。
+static int efd_wait(int efd, int timeout_ms)
+{
+    struct pollfd pfd = {.fd = efd, .events = POLLIN};
+    int rc = poll(&pfd, 1, timeout_ms);
+    if (rc <= 0) return 0;
+    uint64_t v;
+    (void)!read(efd, &v, sizeof(v));   // EFD_NONBLOCK:并发被别人读走也无妨
+    return 1;
+}
 
-static unsigned long g_drop_count = 0;  // 仅在 lock 下读写
+static long now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
 
-void queue_init(void)
+// ========================================================
+//  消费者睡眠点
+// ========================================================
+int queue_waiter_init(queue_waiter_t* w)
 {
-    head = tail = 0;
-    g_drop_count = 0;
+    atomic_store(&w->waiting, 0);
+    w->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (w->efd < 0) {
+        LOG_ERROR("[queue] eventfd create failed, errno=%d\n", errno);
+        return -1;
+    }
+    return 0;
 }
 
+void queue_waiter_destroy(queue_waiter_t* w)
+{
+    if (w->efd >= 0) close(w->efd);
+    w->efd = -1;
+}
+
+void queue_waiter_prepare(queue_waiter_t* w)
+{
+    atomic_store(&w->waiting, 1);
+}
+
+int queue_waiter_sleep(queue_waiter_t* w, int timeout_ms)
+{
+    int woken = efd_wait(w->efd, timeout_ms);
+    atomic_store_explicit(&w->waiting, 0, memory_order_relaxed);
+    return woken;
+}
+
+int queue_waiter_sleep_fd(queue_waiter_t* w, int extra_fd, int timeout_ms)
+{
+    return queue_waiter_sleep_fds(w, &extra_fd, 1, timeout_ms);
+}
+
+int queue_waiter_sleep_fds(queue_waiter_t* w, const int* extra, int n, int timeout_ms)
+{
+    struct pollfd pfd[1 + QUEUE_WAITER_MAX_FDS];
+    int cnt = 0;
+    pfd[cnt++] = (struct pollfd){.fd = w->efd, .events = POLLIN};
+    for (int i = 0; i < n && i < QUEUE_WAITER_MAX_FDS; i++) {
+        if (extra[i] >= 0) pfd[cnt++] = (struct pollfd){.fd = extra[i], .events = POLLIN};
+    }
+    int rc = poll(pfd, (nfds_t)cnt, timeout_ms);
+    if (rc > 0 && (pfd[0].revents & POLLIN)) {
+        uint64_t v;
+        (void)!read(w->efd, &v, sizeof(v));
+    }
+    atomic_store_explicit(&w->waiting, 0, memory_order_relaxed);
+    return rc > 0;
+}
+
+void queue_waiter_cancel(queue_waiter_t* w)
+{
+    atomic_store_explicit(&w->waiting, 0, memory_order_relaxed);
+}
+
+void queue_waiter_wake(queue_waiter_t* w)
+{
+    efd_signal(w->efd);
+}
+
+// ========================================================
+//  创建 / 销毁
+// ========================================================
+event_queue_t* queue_create(const char* name, queue_waiter_t* consumer)
+{
+    event_queue_t* q = aligned_alloc(EQ_CACHELINE, sizeof(*q));
+    if (!q) return NULL;
+    memset(q, 0, sizeof(*q));
+
+    strncpy(q->name, name ? name : "", sizeof(q->name) - 1);
+    q->efd_not_full = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    q->resume_efd = -1;
+    q->own_waiter.efd = -1;
+
+    if (consumer) {
+        q->consumer = consumer;
+    } else if (queue_waiter_init(&q->own_waiter) == 0) {
+        q->consumer = &q->own_waiter;
+    }
+
+    if (q->efd_not_full < 0 || !q->consumer) {
+        LOG_ERROR("[queue] %s: eventfd create failed, errno=%d\n", q->name, errno);
+        queue_destroy(q);
+        return NULL;
+    }
+    return q;
+}
+
+void queue_destroy(event_queue_t* q)
+{
+    if (!q) return;
+    if (q->efd_not_full >= 0) close(q->efd_not_full);
+    queue_waiter_destroy(&q->own_waiter);
+    free(q);
+}
+
+// ========================================================
+//  生产者
+// ========================================================
+
+// 等到 tail 槽位可写。返回 0 = 可写,-1 = 持续满 QUEUE_PUSH_TIMEOUT_MS(已计 drop)。
+//
 // R-1 解法(RPD 阶段 0.12):reactor 不可阻塞契约。
-// 队列满时最多 timed_wait QUEUE_PUSH_TIMEOUT_MS,超时则 drop+WARN。
+// 队列满时最多等待 QUEUE_PUSH_TIMEOUT_MS,超时则 drop,由 caller 打 WARN。
 // 慢消费者掉包合理,reactor 永不阻塞,hw watchdog 兜底前提保住。
-int queue_push(event_msg_t* msg)
-{
-    pthread_mutex_lock(&lock);
-
-    if (((tail + 1) % QSIZE) == head) {
-        // 队列满,等到不满或超时
-        struct timespec deadline;
-        clock_gettime(CLOCK_REALTIME, &deadline);
-        deadline.tv_sec  += QUEUE_PUSH_TIMEOUT_MS / 1000;
-        deadline.tv_nsec += (QUEUE_PUSH_TIMEOUT_MS % 1000) * 1000000L;
-        if (deadline.tv_nsec >= 1000000000L) {
-            deadline.tv_sec  += 1;
-            deadline.tv_nsec -= 1000000000L;
-        }
+static int wait_not_full(event_queue_t* q, unsigned tail, unsigned long* total_drops)
+{
+    unsigned head = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (!ring_full(head, tail)) return 0;
+
+    long deadline = now_ms() + QUEUE_PUSH_TIMEOUT_MS;
+    for (;;) {
+        atomic_store(&q->prod_waiting, 1);
+        head = atomic_load(&q->head);
+        if (!ring_full(head, tail)) break;
 
-        while (((tail + 1) % QSIZE) == head) {
-            int rc = pthread_cond_timedwait(&cond_not_full, &lock, &deadline);
-            if (rc == ETIMEDOUT) {
-                g_drop_count++;
-                unsigned long total = g_drop_count;
-                pthread_mutex_unlock(&lock);
-                LOG_WARN("[queue] push timeout %dms, drop dst=%s len=%d total_drops=%lu\n",
-                         QUEUE_PUSH_TIMEOUT_MS, msg->dst, msg->len, total);
-                return -1;
-            }
-            // rc==0 → 被 signal 唤醒;循环条件重检
+        long left = deadline - now_ms();
+        if (left <= 0 || !efd_wait(q->efd_not_full, (int)left)) {
+            head = atomic_load(&q->head);
+            if (!ring_full(head, tail)) break;   // 超时边沿恰好被消费
+            atomic_store(&q->prod_waiting, 0);
+            *total_drops = atomic_fetch_add(&q->drop_count, 1) + 1;
+            return -1;
         }
     }
+    atomic_store(&q->prod_waiting, 0);
+    return 0;
+}
+
+event_msg_t* queue_reserve(event_queue_t* q)
+{
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    unsigned long total;
+    if (wait_not_full(q, tail, &total) < 0) {
+        LOG_WARN("[queue] %s: reserve timeout %dms, drop total_drops=%lu\n",
+                 q->name, QUEUE_PUSH_TIMEOUT_MS, total);
+        return NULL;
+    }
+    return &q->slots[tail & QMASK];
+}
+
+event_msg_t* queue_try_reserve(event_queue_t* q)
+{
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (ring_full(head, tail)) {
+        unsigned long total = atomic_fetch_add(&q->drop_count, 1) + 1;
+        LOG_WARN("[queue] %s: full, drop total_drops=%lu\n", q->name, total);
+        return NULL;
+    }
+    return &q->slots[tail & QMASK];
+}
+
+void queue_set_resume_fd(event_queue_t* q, int efd)
+{
+    q->resume_efd = efd;
+}
+
+int queue_over_high_watermark(event_queue_t* q)
+{
+    if (queue_depth(q) < QUEUE_HIGH_WATERMARK && queue_bytes(q) < QUEUE_HIGH_WATERMARK_BYTES)
+        return 0;
+
+    // seq_cst:先置 throttled 再读 head,与 queue_release "先写 head 再读 throttled" 配对。
+    // head_bytes 在 head 之前写,读到 head 之后再读它不会比 head 旧
+    atomic_store(&q->throttled, 1);
+    unsigned depth = atomic_load_explicit(&q->tail, memory_order_relaxed) - atomic_load(&q->head);
+    unsigned long bytes = atomic_load_explicit(&q->tail_bytes, memory_order_relaxed) -
+                          atomic_load_explicit(&q->head_bytes, memory_order_acquire);
+    return depth > QUEUE_LOW_WATERMARK || bytes > QUEUE_LOW_WATERMARK_BYTES;
+}
 
-    queue[tail] = *msg;
-    tail = (tail + 1) % QSIZE;
+void queue_commit(event_queue_t* q)
+{
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    unsigned long tb = atomic_load_explicit(&q->tail_bytes, memory_order_relaxed);
+    atomic_store_explicit(&q->tail_bytes, tb + (unsigned)q->slots[tail & QMASK].len,
+                          memory_order_relaxed);
 
-    pthread_cond_signal(&cond_not_empty);
-    pthread_mutex_unlock(&lock);
+    // seq_cst store:与消费者"先置 waiting 再读 tail"配对
+    // exchange 清标志:一次睡眠只唤醒一次,对方醒来若仍需等会自己重新置位
+    atomic_store(&q->tail, tail + 1);
+    if (atomic_exchange(&q->consumer->waiting, 0))
+        efd_signal(q->consumer->efd);
+}
+
+int queue_push(event_queue_t* q, event_msg_t* msg)
+{
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    unsigned long total;
+    if (wait_not_full(q, tail, &total) < 0) {
+        LOG_WARN("[queue] %s: push timeout %dms, drop len=%d total_drops=%lu\n",
+                 q->name, QUEUE_PUSH_TIMEOUT_MS, msg->len, total);
+        return -1;
+    }
+    q->slots[tail & QMASK] = *msg;
+    queue_commit(q);
     return 0;
 }
 
-void queue_pop(event_msg_t* msg)
+// ========================================================
+//  消费者
+// ========================================================
+event_msg_t* queue_try_peek(event_queue_t* q)
+{
+    unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    unsigned tail = atomic_load(&q->tail);
+    if (head == tail) return NULL;
+    return &q->slots[head & QMASK];
+}
+
+event_msg_t* queue_peek(event_queue_t* q)
+{
+    event_msg_t* m;
+    while (!(m = queue_try_peek(q))) {
+        queue_waiter_prepare(q->consumer);
+        if ((m = queue_try_peek(q))) {
+            queue_waiter_cancel(q->consumer);
+            break;
+        }
+        queue_waiter_sleep(q->consumer, -1);
+    }
+    return m;
+}
+
+// 推进 head n 格并处理两个边沿(生产者在等不满 / 背压恢复)。批量出队只走一次。
+static void release_n(event_queue_t* q, unsigned n)
+{
+    unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    unsigned long hb = atomic_load_explicit(&q->head_bytes, memory_order_relaxed);
+    for (unsigned i = 0; i < n; i++)
+        hb += (unsigned)q->slots[(head + i) & QMASK].len;
+    head += n;
+
+    atomic_store_explicit(&q->head_bytes, hb, memory_order_relaxed);
+    atomic_store(&q->head, head);
+    atomic_fetch_add_explicit(&q->pop_count, n, memory_order_relaxed);
+    // 通知生产者队列不再满(仅当它确实在等)
+    if (atomic_exchange(&q->prod_waiting, 0))
+        efd_signal(q->efd_not_full);
+
+    // 背压恢复边沿:生产者因高水位停读了源端口,降到低水位时通知一次。
+    // seq_cst 读 throttled:与 queue_over_high_watermark 的"先置位再读 head"配对
+    if (atomic_load(&q->throttled)
+        && atomic_load(&q->tail) - head <= QUEUE_LOW_WATERMARK
+        && atomic_load_explicit(&q->tail_bytes, memory_order_relaxed) - hb <= QUEUE_LOW_WATERMARK_BYTES
+        && atomic_exchange(&q->throttled, 0) && q->resume_efd >= 0)
+        efd_signal(q->resume_efd);
+}
+
+void queue_release(event_queue_t* q)
+{
+    release_n(q, 1);
+}
+
+int queue_pop_batch(event_queue_t* q, event_msg_t* out, int max)
+{
+    return queue_pop_batch_bytes(q, out, max, ~0ul);
+}
+
+int queue_pop_batch_bytes(event_queue_t* q, event_msg_t* out, int max, unsigned long max_bytes)
 {
-    pthread_mutex_lock(&lock);
+    unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    unsigned n = tail - head;
+    if (n == 0 || max <= 0) return 0;
+    if (n > (unsigned)max) n = (unsigned)max;
 
-    while (head == tail)
-        pthread_cond_wait(&cond_not_empty, &lock);
+    unsigned long bytes = 0;
+    unsigned i = 0;
+    for (; i < n; i++) {
+        const event_msg_t* m = &q->slots[(head + i) & QMASK];
+        bytes += (unsigned)m->len;
+        if (i > 0 && bytes > max_bytes) break;
+        out[i] = *m;
+    }
+    release_n(q, i);
+    return (int)i;
+}
 
-    *msg = queue[head];
-    head = (head + 1) % QSIZE;
+void queue_pop(event_queue_t* q, event_msg_t* msg)
+{
+    *msg = *queue_peek(q);
+    queue_release(q);
+}
 
-    // 通知生产者队列不再满
-    pthread_cond_signal(&cond_not_full);
-    pthread_mutex_unlock(&lock);
+// ========================================================
+//  计数器(任意线程可读,近似值)
+// ========================================================
+unsigned queue_depth(event_queue_t* q)
+{
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    return tail - head;
+}
+
+unsigned long queue_bytes(event_queue_t* q)
+{
+    unsigned long hb = atomic_load_explicit(&q->head_bytes, memory_order_relaxed);
+    unsigned long tb = atomic_load_explicit(&q->tail_bytes, memory_order_relaxed);
+    return tb > hb ? tb - hb : 0;   // 别的线程读两个计数有先后,近似值
+
+}
+
+unsigned long queue_get_drop_count(event_queue_t* q)
+{
+    return atomic_load(&q->drop_count);
 }
 
-unsigned long queue_get_drop_count(void)
+unsigned long queue_get_pop_count(event_queue_t* q)
 {
-    unsigned long c;
-    pthread_mutex_lock(&lock);
-    c = g_drop_count;
-    pthread_mutex_unlock(&lock);
-    return c;
+    return atomic_load_explicit(&q->pop_count, memory_order_relaxed);
 }
@@ -0,0 +1,425 @@
+// frame.c — 收方向增量分帧
+//
+// 详见 frame.h 文件头。
+//
+// 并发:frame_rx_t 只由所属端口的 reactor 线程访问;配置只读。
+//
+// 测试:tests/unit/test_frame.c
+
+#include <stdlib.h>
+#include <string.h>
+#include "frame.h"
+#include "byte_scan.h"
+
+#define SLIP_END      0xC0
+#define SLIP_ESC      0xDB
+#define SLIP_ESC_END  0xDC
+#define SLIP_ESC_ESC  0xDD
+
+const port_frame_t* frame_conf_of(const port_def_t* port)
+{
+    int id = port->base.id;
+    if (id < 0 || id >= g_config.port_count || port->base.type == PORT_UDP) return NULL;
+    const port_def_t* cp = &g_config.ports[id];
+    if (!cp->base.use_frame || cp->base.frame.mode == FRAME_NONE) return NULL;
+    return &cp->base.frame;
+}
+
+void frame_rx_reset(frame_rx_t* fr)
+{
+    fr->n       = 0;
+    fr->discard = 0;
+    fr->skip    = 0;
+    fr->esc     = 0;
+}
+
+void frame_rx_gap(frame_rx_t* fr, const port_frame_t* c)
+{
+    fr->drops++;
+    frame_rx_reset(fr);
+    // length 没有分隔符可等:接下来的字节当帧头读,不合理的长度会滑字节找头
+    if (c->mode != FRAME_LENGTH) fr->discard = 1;
+}
+
+void frame_rx_free(frame_rx_t* fr)
+{
+    free(fr->buf);
+    memset(fr, 0, sizeof(*fr));
+}
+
+static int max_len(const port_frame_t* c)
+{
+    return (c->max_len > 0 && c->max_len <= MAX_MESSAGE) ? c->max_len : MAX_DATA - 1;
+}
+
+// 拼帧缓冲放得下本配置的最长帧;内存不足返回 -1(调用方把输入当缺口丢掉)
+static int reserve(frame_rx_t* fr, const port_frame_t* c)
+{
+    int need = FRAME_BUF_BYTES(max_len(c));
+    if (fr->cap >= need) return 0;
+    uint8_t* nb = realloc(fr->buf, (size_t)need);
+    if (!nb) return -1;
+    fr->buf = nb;
+    fr->cap = need;
+    return 0;
+}
+
+static void consume(const uint8_t** in, int* in_len, int k)
+{
+    *in += k;
+    *in_len -= k;
+}
+
+// 追加输入到 buf,最多 room 字节,返回追加数
+static int append(frame_rx_t* fr, const uint8_t** in, int* in_len, int room)
+{
+    int k = *in_len < room ? *in_len : room;
+    if (k <= 0) return 0;
+    memcpy(fr->buf + fr->n, *in, (size_t)k);
+    fr->n += k;
+    consume(in, in_len, k);
+    return k;
+}
+
+static int emit(frame_rx_t* fr, const uint8_t* p, int len, const uint8_t** out)
+{
+    fr->frames++;
+    *out = p;
+    return len;
+}
+
+// ---- delimiter ----
+// buf 里是帧的前半段(丢弃中只留最后 dlen-1 字节,用来认出跨读的分隔符)。
+// 分隔符可能跨两次读,所以每次从 buf 里新字节前 dlen-1 处开始找。
+static int next_delimiter(frame_rx_t* fr, const port_frame_t* c,
+                          const uint8_t** in, int* in_len, const uint8_t** out)
+{
+    const int dlen = c->delim_len;
+    const int body = max_len(c) - (c->keep_delim ? dlen : 0);   // 帧内容(不含分隔符)上限
+    const int tail = c->keep_delim ? dlen : 0;
+
+    while (*in_len > 0) {
+        // 快路径:没有半帧,分隔符就在本次输入里
+        if (fr->n == 0 && !fr->discard) {
+            const uint8_t* d = scan_seq(*in, (size_t)*in_len, c->delim, (size_t)dlen);
+            if (!d) {
+                append(fr, in, in_len, body + dlen);
+                if (fr->n == body + dlen) {   // 装满还没见分隔符
+                    fr->drops++;
+                    fr->discard = 1;
+                    memmove(fr->buf, fr->buf + fr->n - (dlen - 1), (size_t)(dlen - 1));
+                    fr->n = dlen - 1;
+                }
+                continue;
+            }
+            const uint8_t* start = *in;
+            int pos = (int)(d - start);
+            consume(in, in_len, pos + dlen);
+            if (pos == 0) continue;   // 空帧(连续分隔符)
+            if (pos > body) {
+                fr->drops++;
+                continue;
+            }
+            return emit(fr, start, pos + tail, out);
+        }
+
+        int from = fr->n > dlen - 1 ? fr->n - (dlen - 1) : 0;
+        int room = fr->discard ? fr->cap - fr->n : body + dlen - fr->n;
+        append(fr, in, in_len, room);
+        const uint8_t* d = scan_seq(fr->buf + from, (size_t)(fr->n - from), c->delim, (size_t)dlen);
+        if (d) {
+            int pos = (int)(d - fr->buf);
+            int extra = fr->n - (pos + dlen);   // 分隔符之后多追加的字节还给输入
+            *in -= extra;
+            *in_len += extra;
+            fr->n = 0;
+            if (fr->discard) {
+                fr->discard = 0;
+                continue;
+            }
+            if (pos == 0) continue;
+            return emit(fr, fr->buf, pos + tail, out);
+        }
+        if (fr->discard || fr->n == body + dlen) {
+            if (!fr->discard) fr->drops++;
+            fr->discard = 1;
+            int keep = dlen - 1 < fr->n ? dlen - 1 : fr->n;
+            memmove(fr->buf, fr->buf + fr->n - keep, (size_t)keep);
+            fr->n = keep;
+        }
+    }
+    return 0;
+}
+
+// ---- length ----
+static long long length_field(const port_frame_t* c, const uint8_t* p)
+{
+    const uint8_t* f = p + c->len_offset;
+    uint32_t v = 0;
+    for (int k = 0; k < c->len_width; k++) {
+        int idx = c->len_big ? k : c->len_width - 1 - k;
+        v = (v << 8) | f[idx];
+    }
+    return (long long)c->len_offset + c->len_width + v + c->len_adjust;
+}
+
+static int next_length(frame_rx_t* fr, const port_frame_t* c,
+                       const uint8_t** in, int* in_len, const uint8_t** out)
+{
+    const int hdr = c->len_offset + c->len_width;
+    const int cap = max_len(c);
+
+    while (*in_len > 0) {
+        if (fr->skip > 0) {   // 超长帧剩下的部分
+            int k = *in_len < fr->skip ? *in_len : fr->skip;
+            consume(in, in_len, k);
+            fr->skip -= k;
+            continue;
+        }
+
+        // 快路径:没有半帧,整帧在本次输入里
+        if (fr->n == 0 && *in_len >= hdr) {
+            long long total = length_field(c, *in);
+            if (total >= hdr && total <= cap && total <= *in_len) {
+                const uint8_t* start = *in;
+                consume(in, in_len, (int)total);
+                fr->discard = 0;
+                return emit(fr, start, (int)total, out);
+            }
+        }
+
+        if (fr->n < hdr) {
+            append(fr, in, in_len, hdr - fr->n);
+            if (fr->n < hdr) return 0;
+        }
+        long long total = length_field(c, fr->buf);
+        if (total < hdr) {
+            // 长度字段不合理:不是帧头,滑过一个字节再找。一段连续的滑动只计一次丢弃
+            if (!fr->discard) fr->drops++;
+            fr->discard = 1;
+            memmove(fr->buf, fr->buf + 1, (size_t)--fr->n);
+            continue;
+        }
+        fr->discard = 0;
+        if (total > cap) {
+            fr->drops++;
+            fr->skip = (int)(total - fr->n < 0x7fffffff ? total - fr->n : 0x7fffffff);
+            fr->n = 0;
+            continue;
+        }
+        append(fr, in, in_len, (int)total - fr->n);
+        if (fr->n == total) {
+            fr->n = 0;
+            return emit(fr, fr->buf, (int)total, out);
+        }
+    }
+    // 输入用完时 buf 里可能正好是一个帧头不合理的残段,下次接着滑
+    return 0;
+}
+
+// ---- slip(RFC 1055)----
+// 普通字节成段处理:scan_set 找下一个 END / ESC,之前的整段直接拷进 buf;
+// 丢弃中只需找下一个 END。只有 END / ESC 和转义后的那个字节逐字节走状态机。
+static const uint8_t k_slip_special[2] = { SLIP_END, SLIP_ESC };
+
+static int next_slip(frame_rx_t* fr, const port_frame_t* c,
+                     const uint8_t** in, int* in_len, const uint8_t** out)
+{
+    const int cap = max_len(c);
+    while (*in_len > 0) {
+        if (!fr->esc) {
+            const uint8_t* s = fr->discard
+                ? scan_byte(*in, (size_t)*in_len, SLIP_END)
+                : scan_set(*in, (size_t)*in_len, k_slip_special, 2);
+            int run = s ? (int)(s - *in) : *in_len;
+            if (fr->discard) {
+                consume(in, in_len, run);
+            } else if (run > 0) {
+                append(fr, in, in_len, run < cap - fr->n ? run : cap - fr->n);
+                if (fr->n == cap && *in_len > 0 && **in != SLIP_END) {
+                    // 帧内容到上限还没结束
+                    fr->drops++;
+                    fr->discard = 1;
+                    continue;
+                }
+            }
+            if (*in_len == 0) return 0;
+        }
+
+        uint8_t b = **in;
+        consume(in, in_len, 1);
+        if (b == SLIP_END) {
+            int n = fr->n;
+            int bad = fr->discard || fr->esc;
+            if (fr->esc && !fr->discard) fr->drops++;   // ESC 后直接 END
+            fr->n = 0;
+            fr->discard = 0;
+            fr->esc = 0;
+            if (bad || n == 0) continue;   // 丢弃段结束 / 空帧(帧间的 END)
+            return emit(fr, fr->buf, n, out);
+        }
+        if (fr->discard) continue;
+        if (fr->esc) {
+            fr->esc = 0;
+            if (b == SLIP_ESC_END) {
+                b = SLIP_END;
+            } else if (b == SLIP_ESC_ESC) {
+                b = SLIP_ESC;
+            } else {   // 非法转义:整帧不可信
+                fr->drops++;
+                fr->discard = 1;
+                continue;
+            }
+        } else if (b == SLIP_ESC) {
+            fr->esc = 1;
+            continue;
+        }
+        if (fr->n == cap) {
+            fr->drops++;
+            fr->discard = 1;
+            continue;
+        }
+        fr->buf[fr->n++] = b;
+    }
+    return 0;
+}
+
+// ---- cobs ----
+// 就地解码 buf[0, n):解码结果不会比编码长,写指针始终不超过读指针。返回解码长度,-1 = 编码错误
+static int cobs_decode(uint8_t* buf, int n)
+{
+    int r = 0, w = 0;
+    while (r < n) {
+        int code = buf[r++];
+        if (code == 0 || r + code - 1 > n) return -1;
+        memmove(buf + w, buf + r, (size_t)(code - 1));
+        w += code - 1;
+        r += code - 1;
+        if (code < 0xFF && r < n) buf[w++] = 0;
+    }
+    return w;
+}
+
+static int next_cobs(frame_rx_t* fr, const port_frame_t* c,
+                     const uint8_t** in, int* in_len, const uint8_t** out)
+{
+    const int cap = max_len(c);
+    const int enc_cap = cap + cap / 254 + 1;   // cap 字节解码内容的最长编码
+    while (*in_len > 0) {
+        const uint8_t* z = scan_byte(*in, (size_t)*in_len, 0);
+        int run = z ? (int)(z - *in) : *in_len;
+        if (fr->discard) {
+            consume(in, in_len, run);
+        } else {
+            int room = enc_cap - fr->n;
+            append(fr, in, in_len, run < room ? run : room);
+            if (fr->n == enc_cap && *in_len > 0 && **in != 0) {
+                fr->drops++;
+                fr->discard = 1;
+                fr->n = 0;
+                continue;
+            }
+        }
+        if (*in_len == 0) return 0;
+        consume(in, in_len, 1);   // 帧尾的 0x00
+        int n = fr->n;
+        int bad = fr->discard;
+        fr->n = 0;
+        fr->discard = 0;
+        if (bad || n == 0) continue;
+        int len = cobs_decode(fr->buf, n);
+        if (len < 0 || len > cap) {
+            fr->drops++;
+            continue;
+        }
+        if (len == 0) continue;
+        return emit(fr, fr->buf, len, out);
+    }
+    return 0;
+}
+
+// ---- idle ----
+static void feed_idle(frame_rx_t* fr, const port_frame_t* c, const uint8_t** in, int* in_len)
+{
+    const int cap = max_len(c);
+    if (!fr->discard && fr->n + *in_len > cap) {   // 静默前就超长:丢到下一段静默
+        fr->drops++;
+        fr->discard = 1;
+        fr->n = 0;
+    }
+    if (fr->discard)
+        consume(in, in_len, *in_len);
+    else
+        append(fr, in, in_len, *in_len);
+}
+
+int frame_next(frame_rx_t* fr, const port_frame_t* c,
+               const uint8_t** in, int* in_len, const uint8_t** out)
+{
+    if (c->mode != FRAME_NONE && reserve(fr, c) < 0) {
+        frame_rx_gap(fr, c);
+        consume(in, in_len, *in_len);
+        return 0;
+    }
+    switch (c->mode) {
+    case FRAME_DELIMITER: return next_delimiter(fr, c, in, in_len, out);
+    case FRAME_LENGTH:    return next_length(fr, c, in, in_len, out);
+    case FRAME_SLIP:      return next_slip(fr, c, in, in_len, out);
+    case FRAME_COBS:      return next_cobs(fr, c, in, in_len, out);
+    case FRAME_IDLE:
+    case FRAME_MODBUS:    feed_idle(fr, c, in, in_len); return 0;
+    default:
+        // 不分帧:整段输入就是一条
+        if (*in_len <= 0) return 0;
+        *out = *in;
+        int len = *in_len;
+        consume(in, in_len, len);
+        return len;
+    }
+}
+
+uint64_t frame_gap_ns(const port_frame_t* c)
+{
+    if (c->mode != FRAME_IDLE && c->mode != FRAME_MODBUS) return 0;
+    int us = c->gap_us > 0 ? c->gap_us : c->idle_us;
+    return (uint64_t)(us > 0 ? us : FRAME_DEFAULT_IDLE_US) * 1000ull;
+}
+
+void frame_idle_feed(frame_rx_t* fr, const port_frame_t* c,
+                     const uint8_t* in, int len, uint64_t now_ns)
+{
+    if (len <= 0) return;
+    if (reserve(fr, c) < 0) {
+        frame_rx_gap(fr, c);
+        fr->last_ns = now_ns;
+        return;
+    }
+    if (fr->n == 0 && !fr->discard) {
+        // 新帧的第一段:离上一帧的最后一个字节还不到一个静默,说明刚才的出帧早了
+        if (fr->split_ns && now_ns - fr->split_ns < frame_gap_ns(c)) fr->early_splits++;
+        fr->split_ns = 0;
+    } else if (c->short_us > 0 && now_ns - fr->last_ns > (uint64_t)c->short_us * 1000ull) {
+        fr->short_gaps++;
+    }
+    feed_idle(fr, c, &in, &len);
+    fr->last_ns = now_ns;
+}
+
+int frame_take(frame_rx_t* fr, const port_frame_t* c, const uint8_t** out)
+{
+    (void)c;
+    int n = fr->n;
+    int bad = fr->discard;
+    if (n > 0 || bad) fr->split_ns = fr->last_ns;
+    fr->n = 0;
+    fr->discard = 0;
+    if (bad || n == 0) return 0;
+    return emit(fr, fr->buf, n, out);
+}
+
+uint64_t frame_idle_due(const frame_rx_t* fr, const port_frame_t* c)
+{
+    uint64_t gap = frame_gap_ns(c);
+    if (gap == 0 || (fr->n == 0 && !fr->discard)) return 0;
+    return fr->last_ns + gap;
+}
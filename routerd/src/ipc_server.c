@@ -3,6 +3,7 @@
 // 数据流:
 //   accept() → 每连接独立 read buffer → 循环 proto_decode():
 //     INCOMPLETE → break inner loop, 继续 recv (契约 21)
+//     BAD_MAGIC  → proto_resync 丢到下一个候选帧头,继续 decode
 //     其他负值   → 断连(致命错误,流损坏)
 //     ok        → proto_dispatch()  → memmove 推进读指针
 //
@@ -85,6 +86,16 @@ static void handle_client(int client_fd)
                 // 契约 21: 不是错误,继续 recv
                 break;
             }
+            if (r == PROTO_ERR_BAD_MAGIC) {
+                // 流里混进了垃圾(或半帧):跳到下一个 magic 重同步,不断连
+                size_t skip = proto_resync(buf, buf_len);
+                LOG_WARN("[IPC] bad magic on fd=%d, resync skip %zu bytes\n",
+                         client_fd, skip);
+                if (skip < buf_len)
+                    memmove(buf, buf + skip, buf_len - skip);
+                buf_len -= skip;
+                continue;
+            }
             if (r < 0) {
                 LOG_WARN("[IPC] decode err=%d on fd=%d, drop conn\n",
                          r, client_fd);
@@ -2,37 +2,97 @@
 #include <stdio.h>
 #include <string.h>
 #include <dlfcn.h>
+#include "event.h"
 #include "log.h"
 
 
 static handler_entry_t g_handlers[MAX_HANDLERS];
 static int g_handler_count = 0;
 
-void plugin_register_handler(
-        const char* plugin_name,
-        const char* handler_name,
-        plugin_handler_t func)
+static void register_entry(const char* plugin_name, const char* handler_name,
+                           plugin_handler_t func, plugin_handler_v2_t func2)
 {
     if (g_handler_count >= MAX_HANDLERS)
         return;
 
-    snprintf(g_handlers[g_handler_count].full_name,
-             sizeof(g_handlers[g_handler_count].full_name),
-             "%s.%s", plugin_name, handler_name);
+    handler_entry_t* h = &g_handlers[g_handler_count];
+    snprintf(h->full_name, sizeof(h->full_name), "%s.%s", plugin_name, handler_name);
+    h->func  = func;
+    h->func2 = func2;
 
-    g_handlers[g_handler_count].func = func;
-
-    LOG_INFO("[plugin] register handler: %s -> %p\n",
-           g_handlers[g_handler_count].full_name, func);
+    LOG_INFO("[plugin] register handler: %s -> %p%s\n", h->full_name,
+             func ? (void*)func : (void*)func2, func2 ? " (v2)" : "");
 
     g_handler_count++;
 }
 
-plugin_handler_t plugin_get_handler(const char* fullname)
+void plugin_register_handler(
+        const char* plugin_name,
+        const char* handler_name,
+        plugin_handler_t func)
+{
+    register_entry(plugin_name, handler_name, func, NULL);
+}
+
+void plugin_register_handler_v2(
+        const char* plugin_name,
+        const char* handler_name,
+        plugin_handler_v2_t func)
+{
+    register_entry(plugin_name, handler_name, NULL, func);
+}
+
+static const handler_entry_t* find_entry(const char* fullname)
 {
     for (int i = 0; i < g_handler_count; ++i) {
         if (strcmp(g_handlers[i].full_name, fullname) == 0)
-            return g_handlers[i].func;
+            return &g_handlers[i];
+    }
+    return NULL;
+}
+
+plugin_handler_t plugin_get_handler(const char* fullname)
+{
+    const handler_entry_t* h = find_entry(fullname);
+    return h ? h->func : NULL;
+}
+
+plugin_handler_v2_t plugin_get_handler_v2(const char* fullname)
+{
+    const handler_entry_t* h = find_entry(fullname);
+    return h ? h->func2 : NULL;
+}
+
+buf_t* plugin_call_v2(plugin_handler_v2_t func, const char* name,
+                      const uint8_t* in, int in_len, int max_len, int* out_len)
+{
+    int want = in_len > MAX_DATA ? in_len : MAX_DATA;
+    if (want > max_len) want = max_len;
+
+    // 第一次按默认大小给;handler 说不够就按它要的换一次,第二次还不够不再追
+    for (int tries = 0; tries < 2; tries++) {
+        buf_t* out = buf_alloc(want);
+        if (!out) {
+            LOG_WARN("[plugin] %s: no %d-byte buffer in pool, drop\n", name, want);
+            return NULL;
+        }
+        int cap = out->cap < max_len ? out->cap : max_len;
+        int n = func(in, in_len, out->data, cap);
+        if (n >= 0 && n <= cap) {
+            *out_len = n;
+            return out;
+        }
+        buf_unref(out);
+        if (n < 0) {
+            LOG_WARN("[plugin] %s returned %d, drop\n", name, n);
+            return NULL;
+        }
+        if (n > max_len || tries > 0) {
+            LOG_WARN("[plugin] %s needs %d bytes (limit %d, had %d), drop\n",
+                     name, n, max_len, cap);
+            return NULL;
+        }
+        want = n;
     }
     return NULL;
 }
@@ -41,7 +101,9 @@ void plugin_list_handlers()
 {
     printf("=== Registered Handlers ===\n");
     for (int i = 0; i < g_handler_count; ++i) {
-        LOG_INFO("%s -> %p\n", g_handlers[i].full_name, g_handlers[i].func);
+        const handler_entry_t* h = &g_handlers[i];
+        LOG_INFO("%s -> %p%s\n", h->full_name,
+                 h->func ? (void*)h->func : (void*)h->func2, h->func2 ? " (v2)" : "");
     }
     LOG_INFO("===========================\n");
 }
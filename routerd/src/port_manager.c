@@ -1,3 +1,6 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE   // sendmmsg
+#endif
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
@@ -5,28 +8,75 @@
 #include <termios.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <sys/un.h>
+#include <sys/uio.h>
 #include <errno.h>
+#include <stdlib.h>
+#include <pthread.h>
 
 #include "port_manager.h"
+#include "port_tx.h"
+#include "tty_baud.h"
 #include "log.h"
 
 port_entry_t g_port_table[MAX_PORTS];//define ports
+
+// 多 reactor 时 register / unregister 来自多个线程(各自 accept / 断开),
+// 占槽与释放串行化;port_from_handle 仍无锁
+static pthread_mutex_t g_table_lock = PTHREAD_MUTEX_INITIALIZER;
 // ========================================================
 //  打开 TTY 端口 (/dev/ttyS0, /dev/ttyUSB0, /dev/ttyACM0, /dev/ttyGS0...)
 // ========================================================
+// 标准 Bxxx 常量;不在表里返回 0(由 termios2 设准确值,tty_baud.h)
 static speed_t baud_to_speed(int baud)
 {
     switch (baud) {
+    case 1200: return B1200;
+    case 2400: return B2400;
+    case 4800: return B4800;
     case 9600: return B9600;
     case 19200: return B19200;
     case 38400: return B38400;
     case 57600: return B57600;
     case 115200: return B115200;
     case 230400: return B230400;
-    default: return B115200; // 或者返回 0 表示不支持
+    case 460800: return B460800;
+    case 500000: return B500000;
+    case 576000: return B576000;
+    case 921600: return B921600;
+    case 1000000: return B1000000;
+    case 1152000: return B1152000;
+    case 1500000: return B1500000;
+    case 2000000: return B2000000;
+    case 2500000: return B2500000;
+    case 3000000: return B3000000;
+    case 3500000: return B3500000;
+    case 4000000: return B4000000;
+    default: return 0;
+    }
+}
+
+// termios2 把速率设成准确的整数并读回驱动实际采用的值,报告偏差。
+// 驱动不认 termios2 时:标准速率已由 tcsetattr 设好,非标准速率无法设置,返回 -1。
+static int tty_apply_baud(const port_def_t* p, int fd, int baud, speed_t std)
+{
+    int actual = tty_set_baud(fd, baud);
+    if (actual < 0) {
+        if (std) return 0;
+        LOG_ERROR("[port_tty] %s: baudrate %d needs termios2, errno=%d\n",
+                  p->base.name, baud, errno);
+        return -1;
     }
+    int ppm = tty_baud_error_ppm(baud, actual);
+    if (ppm > TTY_BAUD_WARN_PPM || ppm < -TTY_BAUD_WARN_PPM)
+        LOG_WARN("[port_tty] %s: baudrate %d, driver runs %d (%+.2f%%), expect framing errors\n",
+                 p->base.name, baud, actual, ppm / 10000.0);
+    else if (actual != baud)
+        LOG_INFO("[port_tty] %s: baudrate %d, driver runs %d (%+.2f%%)\n",
+                 p->base.name, baud, actual, ppm / 10000.0);
+    return 0;
 }
 
 static int port_open_tty(port_def_t* p)
@@ -52,8 +102,10 @@ static int port_open_tty(port_def_t* p)
     tio.c_iflag &= ~(IXON | IXOFF | IXANY | ICRNL | INLCR | IGNCR);
     tio.c_oflag &= ~(OPOST);        // 禁止 \n -> \r\n 等转换
 
-    // 3) 波特率（注意：用 Bxxxx 宏）
-    speed_t spd = baud_to_speed(p->cfg.tty.baudrate);
+    // 3) 波特率:标准值先用 Bxxxx 宏设上,非标准值先占位,tcsetattr 之后 termios2 再设准确值
+    int baud = p->cfg.tty.baudrate > 0 ? p->cfg.tty.baudrate : TTY_DEFAULT_BAUD;
+    speed_t std = baud_to_speed(baud);
+    speed_t spd = std ? std : B38400;
     if (cfsetispeed(&tio, spd) != 0 || cfsetospeed(&tio, spd) != 0) {
         perror("[port_tty] cfsetispeed/cfsetospeed");
         // USB CDC 这里失败也未必致命，但建议处理
@@ -92,6 +144,15 @@ static int port_open_tty(port_def_t* p)
         close(fd);
         return -1;
     }
+    if (tty_apply_baud(p, fd, baud, std) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    // 8) 低延迟:驱动收到数据立即交给 tty 层(不支持的驱动只告警)
+    if (p->cfg.tty.low_latency && tty_set_low_latency(fd, 1) < 0)
+        LOG_WARN("[port_tty] %s: ASYNC_LOW_LATENCY not supported by driver, errno=%d\n",
+                 p->base.name, errno);
 
     // 可选：清一下缓冲
     tcflush(fd, TCIOFLUSH);
@@ -100,6 +161,46 @@ static int port_open_tty(port_def_t* p)
 }
 
 
+// ========================================================
+//  socket 选项(config_store.h 的 port_sockopt_t)
+// ========================================================
+static int sockopt_set(const port_def_t* p, int fd, int level, int opt, int val, const char* what)
+{
+    if (setsockopt(fd, level, opt, &val, sizeof(val)) == 0) return 0;
+    LOG_WARN("[port] %s fd=%d: %s=%d failed, errno=%d\n", p->base.name, fd, what, val, errno);
+    return 1;
+}
+
+int port_apply_sockopts(const port_def_t* p, int fd)
+{
+    const port_sockopt_t* so = &p->base.sock;
+    int tcp = p->base.type == PORT_TCP_SERVER || p->base.type == PORT_TCP_CLIENT;
+    int failed = 0;
+
+    if (so->sndbuf)       failed += sockopt_set(p, fd, SOL_SOCKET, SO_SNDBUF, so->sndbuf, "SO_SNDBUF");
+    if (so->rcvbuf)       failed += sockopt_set(p, fd, SOL_SOCKET, SO_RCVBUF, so->rcvbuf, "SO_RCVBUF");
+    if (so->busy_poll_us) failed += sockopt_set(p, fd, SOL_SOCKET, SO_BUSY_POLL, so->busy_poll_us,
+                                                "SO_BUSY_POLL");
+    if (so->tos)          failed += sockopt_set(p, fd, IPPROTO_IP, IP_TOS, so->tos, "IP_TOS");
+    if (!tcp) return failed;
+
+    if (so->nodelay)  failed += sockopt_set(p, fd, IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+    if (so->quickack) failed += sockopt_set(p, fd, IPPROTO_TCP, TCP_QUICKACK, 1, "TCP_QUICKACK");
+    if (so->user_timeout_ms)
+        failed += sockopt_set(p, fd, IPPROTO_TCP, TCP_USER_TIMEOUT, so->user_timeout_ms,
+                              "TCP_USER_TIMEOUT");
+    if (so->keepalive) {
+        failed += sockopt_set(p, fd, SOL_SOCKET, SO_KEEPALIVE, 1, "SO_KEEPALIVE");
+        if (so->keepidle_s)
+            failed += sockopt_set(p, fd, IPPROTO_TCP, TCP_KEEPIDLE, so->keepidle_s, "TCP_KEEPIDLE");
+        if (so->keepintvl_s)
+            failed += sockopt_set(p, fd, IPPROTO_TCP, TCP_KEEPINTVL, so->keepintvl_s, "TCP_KEEPINTVL");
+        if (so->keepcnt)
+            failed += sockopt_set(p, fd, IPPROTO_TCP, TCP_KEEPCNT, so->keepcnt, "TCP_KEEPCNT");
+    }
+    return failed;
+}
+
 // ========================================================
 //  打开 TCP Server
 // ========================================================
@@ -113,6 +214,13 @@ static int port_open_tcp_server(port_def_t* p)
 
     int yes = 1;
     setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    // 多 reactor:每个 reactor 一个 listener 绑同一地址,内核按连接哈希分摊 accept。
+    // 组内所有 socket 都要在 bind 前置 SO_REUSEPORT,包括第一个。
+    if (g_config.reactor_threads > 1 &&
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes)) < 0)
+        LOG_WARN("[port_tcp_server] SO_REUSEPORT failed, errno=%d\n", errno);
+    // 缓冲大小要在 listen 前设:accept 出的连接继承,窗口缩放在握手时就定了
+    port_apply_sockopts(p, fd);
 
     struct sockaddr_in addr = {0};
     addr.sin_family = AF_INET;
@@ -134,12 +242,20 @@ static int port_open_tcp_server(port_def_t* p)
     return fd;
 }
 
+int port_open_tcp_listener(port_def_t* p)
+{
+    if (!p || p->base.type != PORT_TCP_SERVER) return -1;
+    return port_open_tcp_server(p);
+}
+
 // ========================================================
-//  打开 TCP Client
+//  打开 TCP Client(非阻塞 connect)
 // ========================================================
-static int port_open_tcp_client(port_def_t* p)
+// 只发起连接就返回:连接完成、超时和断线重连都由 reactor 处理(reactor.h)。
+// 立即失败(如本机端口没人听)也返回 fd,reactor 在 HUP 上按失败处理、退避重连。
+int port_open_tcp_client(port_def_t* p)
 {
-    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
     if (fd < 0) {
         perror("[port_tcp_client] socket");
         return -1;
@@ -150,29 +266,110 @@ static int port_open_tcp_client(port_def_t* p)
     addr.sin_addr.s_addr = inet_addr(p->cfg.tcp_client.addr);
     addr.sin_port = htons(p->cfg.tcp_client.port);
 
-    connect(fd, (struct sockaddr*)&addr, sizeof(addr));
+    port_apply_sockopts(p, fd);   // connect 前:缓冲大小影响握手时通告的窗口缩放
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS)
+        LOG_INFO("[port_tcp_client] %s: connect %s:%d failed, errno=%d\n",
+                 p->base.name, p->cfg.tcp_client.addr, p->cfg.tcp_client.port, errno);
 
     return fd;
 }
 
+int port_reconnect_delay_ms(const port_tcp_client_conf_t* c, int attempt, unsigned rnd)
+{
+    int lo = c->reconnect_min_ms > 0 ? c->reconnect_min_ms : TCP_CLIENT_RECONNECT_MIN_MS;
+    int hi = c->reconnect_max_ms >= lo ? c->reconnect_max_ms : lo;
+    long d = lo;
+    for (int k = 0; k < attempt && d < hi; k++) d *= 2;
+    if (d > hi) d = hi;
+    // 等 [d/2, d]:同一服务重启时,连着它的多个 client 不会齐步重连
+    long half = d / 2;
+    return (int)(d - half + (long)(rnd % (unsigned)(half + 1)));
+}
+
+// ========================================================
+//  UDP 对端:IPv4 地址 + 端口编进一个 64 位原子量,reactor 学习时写、worker 发送时读
+// ========================================================
+// 编码:bit48 = 有效位,bit16..47 = 地址(主机序),低 16 位 = 端口(主机序)
+static uint64_t udp_peer_pack(const struct sockaddr_in* a)
+{
+    return (1ull << 48) | ((uint64_t)ntohl(a->sin_addr.s_addr) << 16) | ntohs(a->sin_port);
+}
+
+int port_udp_peer(const port_def_t* p, struct sockaddr_in* out)
+{
+    uint64_t v = atomic_load_explicit(&p->cfg.udp.peer, memory_order_acquire);
+    if (!v) return 0;
+    memset(out, 0, sizeof(*out));
+    out->sin_family      = AF_INET;
+    out->sin_addr.s_addr = htonl((uint32_t)(v >> 16));
+    out->sin_port        = htons((uint16_t)v);
+    return 1;
+}
+
+void port_udp_learn(port_def_t* p, const struct sockaddr_in* from)
+{
+    port_udp_conf_t* c = &p->cfg.udp;
+    if (!c->learn_peer || from->sin_family != AF_INET) return;
+    uint64_t v = udp_peer_pack(from);
+    if (atomic_load_explicit(&c->peer, memory_order_relaxed) == v) return;   // 常见情形:不写
+    atomic_store_explicit(&c->peer, v, memory_order_release);
+    LOG_INFO("[port_udp] %s: peer is now %s:%d\n",
+             p->base.name, inet_ntoa(from->sin_addr), ntohs(from->sin_port));
+}
+
 // ========================================================
 //  打开 UDP
 // ========================================================
+// 非阻塞:读由 reactor recvmmsg 读空,写由 worker sendmmsg 带 MSG_DONTWAIT。
+// 组播:加入 multicast.group(失败只告警,单播照常);发组播用 interface / ttl / loop。
 static int port_open_udp(port_def_t* p)
 {
-    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    port_udp_conf_t* c = &p->cfg.udp;
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
     if (fd < 0) {
         perror("[port_udp] socket");
         return -1;
     }
 
+    int on = 1;
+    if (c->mcast_group[0])   // 同一组播端口本机可有多个接收方
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    port_apply_sockopts(p, fd);
+
     struct sockaddr_in addr = {0};
     addr.sin_family = AF_INET;
-    addr.sin_addr.s_addr = inet_addr(p->cfg.udp.bind_addr);
-    addr.sin_port = htons(p->cfg.udp.port);
-
-    bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    addr.sin_addr.s_addr = c->bind_addr[0] ? inet_addr(c->bind_addr) : htonl(INADDR_ANY);
+    addr.sin_port = htons(c->port);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        LOG_ERROR("[port_udp] %s: bind %s:%d failed, errno=%d\n",
+                  p->base.name, c->bind_addr, c->port, errno);
+        close(fd);
+        return -1;
+    }
 
+    struct in_addr ifa = {.s_addr = c->mcast_if[0] ? inet_addr(c->mcast_if) : htonl(INADDR_ANY)};
+    if (c->mcast_group[0]) {
+        struct ip_mreq mr = {.imr_interface = ifa};
+        mr.imr_multiaddr.s_addr = inet_addr(c->mcast_group);
+        if (!IN_MULTICAST(ntohl(mr.imr_multiaddr.s_addr)) ||
+            setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mr, sizeof(mr)) < 0)
+            LOG_WARN("[port_udp] %s: join multicast %s failed, errno=%d\n",
+                     p->base.name, c->mcast_group, errno);
+    }
+    if (c->mcast_if[0])
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &ifa, sizeof(ifa));
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &c->mcast_ttl, sizeof(c->mcast_ttl));
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &c->mcast_loop, sizeof(c->mcast_loop));
+
+    atomic_store_explicit(&c->peer, 0, memory_order_relaxed);
+    if (c->peer_addr[0]) {
+        struct sockaddr_in to = {.sin_family = AF_INET, .sin_port = htons(c->peer_port)};
+        if (inet_pton(AF_INET, c->peer_addr, &to.sin_addr) == 1)
+            atomic_store_explicit(&c->peer, udp_peer_pack(&to), memory_order_release);
+        else
+            LOG_WARN("[port_udp] %s: peer %s is not an IPv4 address\n",
+                     p->base.name, c->peer_addr);
+    }
     return fd;
 }
 
@@ -342,28 +539,57 @@ port_def_t* port_find_by_fd(int fd)
 
 
 
-// PORT_TCP_SERVER 的 send 语义:广播给所有同名 PORT_TCP_CLIENT。
+// 字节流端口(tty / usb / tcp_client / ipc_client)的一次写。
+// dispatch worker 线程绑定了发送引擎:非阻塞写,写不完的进该端口的输出环(见 port_tx.h)。
+// 没绑定的线程(单测、工具)退回同步 writev。
+// bufs[i] 是第 i 段所在的池缓冲(可为 NULL):排队时引用它而不是拷贝。
+static int port_send_stream(port_def_t* p, const struct iovec* iov, struct buf* const* bufs, int cnt)
+{
+    port_tx_t* tx = port_tx_current();
+    if (tx) return port_tx_write(tx, p, iov, bufs, cnt);
+    if (!port_link_up(p)) {
+        errno = ENOTCONN;
+        return -1;
+    }
+    return (int)writev(p->base.fd, iov, cnt);
+}
+
+// 槽位 i 当前的句柄,空槽 PORT_HANDLE_INVALID。只是快照,用前要 port_from_handle 校验
+static port_handle_t slot_handle(int i)
+{
+    port_entry_t* e = &g_port_table[i];
+    unsigned gen = atomic_load_explicit(&e->gen, memory_order_acquire) & 0xFFFFu;
+    if (!e->used) return PORT_HANDLE_INVALID;
+    return (gen << 16) | (unsigned)(i + 1);
+}
+
+// PORT_TCP_SERVER / PORT_IPC_SERVER 的 send 语义:广播给它 accept 出的所有 client。
 // 设计契约(RPD 阶段 0.3,固化于 design-intent.md §3):
-//   reactor.c 在 accept 时把每个 client 的 base.name 设为 server 的 base.name(reactor.c:88-94)。
+//   reactor.c 在 accept 时把每个 client 的 base.name / base.id 设为 server 的(reactor.c:88-94),
+//   这里按 id 匹配,不做字符串比较。
 //   因此 routes[].dst 配置成 tcp_server 端口名 = 通知所有连接到该 server 的 host。
 //   失败语义:任一 client 写失败 → 关闭它(让 reactor EPOLLIN==0 路径走 g_port_table 清理)
 //   + WARN 日志 + 继续给其他 client 发。至少一个成功返回 len,全部失败返回 -1,无 client 返回 0。
-//   非阻塞写后续:当前 fd 是阻塞 socket → 慢 client 会阻塞 reactor 一次写。
-//   PROJECT_CONTEXT v4 §14 不可阻塞契约的彻底解法(EAGAIN/旁路 dispatcher)放在阶段 1。
-static int port_send_tcp_server_broadcast(const port_def_t* server, const uint8_t* data, int len)
+//   iov 形式:单条 port_send 传 1 段,port_send_batch 一批消息一次 writev。
+//   非阻塞:经本线程的发送引擎(port_tx)写,每个 client 自己的输出环吸收短写 / EAGAIN。
+//   消息只编码一次:各 client 的输出环引用同一个池缓冲(bufs),最后一个写完才归还。
+//   慢 client 的处理见 server 的 slow_client 配置:缺省积压过高水位时暂停整个 server,
+//   配了 disconnect / latest / drop_oldest 时只处理该 client,其他 client 不受影响。
+static int port_send_server_broadcast(const port_def_t* server, const struct iovec* iov,
+                                      struct buf* const* bufs, int cnt, int len)
 {
+    port_handle_t clients[MAX_PORTS];
+    int nc = port_server_clients(server, clients, MAX_PORTS);
     int sent_to = 0;
     int failed  = 0;
-    for (int i = 0; i < MAX_PORTS; i++) {
-        if (!g_port_table[i].used) continue;
-        port_def_t* cli = g_port_table[i].port;
+    for (int i = 0; i < nc; i++) {
+        // 快照之后 client 可能已断开:每次发送前按句柄重新解析,过期的跳过
+        port_def_t* cli = port_from_handle(clients[i]);
         if (!cli) continue;
-        if (cli->base.type != PORT_TCP_CLIENT) continue;
-        if (strcmp(cli->base.name, server->base.name) != 0) continue;
 
-        int n = write(cli->base.fd, data, len);
+        int n = port_send_stream(cli, iov, bufs, cnt);
         if (n < 0) {
-            LOG_WARN("[port_send] tcp_server '%s' broadcast: client fd=%d write failed, errno=%d\n",
+            LOG_WARN("[port_send] server '%s' broadcast: client fd=%d write failed, errno=%d\n",
                      server->base.name, cli->base.fd, errno);
             failed++;
             // fd 真坏后续 reactor 会从 EPOLLIN read==0 走清理路径,这里不主动 close
@@ -372,54 +598,94 @@ static int port_send_tcp_server_broadcast(const port_def_t* server, const uint8_
         }
         sent_to++;
     }
-    LOG_INFO("[port_send] tcp_server '%s' broadcast: sent_to=%d failed=%d\n",
+    LOG_INFO("[port_send] server '%s' broadcast: sent_to=%d failed=%d\n",
              server->base.name, sent_to, failed);
     if (sent_to == 0 && failed == 0) return 0;       // 当前无 client 连接
     if (sent_to == 0)                  return -1;    // 全失败
     return len;
 }
 
+int port_server_clients(const port_def_t* server, port_handle_t* out, int max)
+{
+    port_type_t cli_type = (server->base.type == PORT_IPC_SERVER) ? PORT_IPC_CLIENT
+                                                                  : PORT_TCP_CLIENT;
+    int n = 0;
+    for (int i = 0; i < MAX_PORTS && n < max; i++) {
+        port_handle_t h = slot_handle(i);
+        const port_def_t* cli = port_from_handle(h);
+        if (!cli) continue;
+        if (cli->base.type != cli_type) continue;
+        if (cli->base.id != server->base.id) continue;
+        out[n++] = h;
+    }
+    return n;
+}
+
+// ========================================================
+//  UDP 发送:每段一个数据报,发往当前对端(port_udp_peer)
+// ========================================================
+// 一批消息一次 sendmmsg(每次最多 UDP_SENDMMSG_MAX 个)。MSG_DONTWAIT:发送缓冲满时
+// 剩下的数据报丢弃并告警,不阻塞 worker —— UDP 本来就不保证送达,也没有背压对象。
+// 还没有对端(没配 peer、也还没收到过数据报)返回 0,同 server 没有 client。
+#define UDP_SENDMMSG_MAX 64
+
+static int port_send_udp(port_def_t* p, const struct iovec* iov, int cnt)
+{
+    struct sockaddr_in to;
+    if (!port_udp_peer(p, &to)) return 0;
+
+    struct mmsghdr mm[UDP_SENDMMSG_MAX];
+    int sent  = 0;
+    int bytes = 0;
+    while (sent < cnt) {
+        int n = cnt - sent < UDP_SENDMMSG_MAX ? cnt - sent : UDP_SENDMMSG_MAX;
+        for (int k = 0; k < n; k++) {
+            memset(&mm[k], 0, sizeof(mm[k]));
+            mm[k].msg_hdr.msg_name    = &to;
+            mm[k].msg_hdr.msg_namelen = sizeof(to);
+            mm[k].msg_hdr.msg_iov     = (struct iovec*)&iov[sent + k];
+            mm[k].msg_hdr.msg_iovlen  = 1;
+        }
+        int r = sendmmsg(p->base.fd, mm, (unsigned)n, MSG_DONTWAIT);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            LOG_WARN("[port_udp] %s: send failed, errno=%d, drop %d datagrams\n",
+                     p->base.name, errno, cnt - sent);
+            return bytes > 0 ? bytes : -1;
+        }
+        for (int k = 0; k < r; k++) bytes += (int)mm[k].msg_len;
+        sent += r;   // 只发出一部分:下一轮拿到出错的那个数据报的 errno
+    }
+    return bytes;
+}
+
 int port_send(port_def_t* p, const uint8_t* data, int len)
 {
-    if (!p || p->base.fd < 0) return -1;
+    // 断线中的 tcp_client 也往下走:发送引擎按 buffer_bytes 缓存或丢弃
+    if (!p || (p->base.fd < 0 && port_link_up(p))) return -1;
 
-    int fd = p->base.fd;
     LOG_INFO("[port_send] send message to dest\n");
     int status=-1;
+    struct iovec one = {.iov_base = (void*)data, .iov_len = (size_t)len};
     switch (p->base.type)
     {
-    case PORT_TTY:{
-        status=write(fd,data,len);
-        break;
-    }
-case PORT_USB:{
-    status= write(fd, data, len);
-    break;
-}
-
-case PORT_TCP_CLIENT:{
-    status=write(fd, data, len);
-    break;
-}
+    case PORT_TTY:
+case PORT_USB:
+case PORT_TCP_CLIENT:
 case PORT_IPC_CLIENT:{
-    status=write(fd,data,len);
+    status = port_send_stream(p, &one, NULL, 1);
     break;
 }
 
-case PORT_TCP_SERVER:{
-    // 见 port_send_tcp_server_broadcast 顶部契约
-    status = port_send_tcp_server_broadcast(p, data, len);
-    break;
-}
+case PORT_TCP_SERVER:
 case PORT_IPC_SERVER:{
-    status=write(fd,data,len);
+    // 见 port_send_server_broadcast 顶部契约
+    status = port_send_server_broadcast(p, &one, NULL, 1, len);
+    break;
 }
 
 case PORT_UDP: {
-            // struct sockaddr_in* addr = &p->cfg.udp.peer_addr;
-            // return sendto(fd, data, len, 0,
-                    // (struct sockaddr*)addr, sizeof(*addr));
-    status=0;
+    status = port_send_udp(p, &one, 1);
     break;
 }
 
@@ -434,6 +700,42 @@ LOG_INFO("[port_send] send message finish\n");
 return status;
 }
 
+// ========================================================
+//  批量发送:同一目的端口的连续消息合成一次 writev
+// ========================================================
+// 每种端口类型的语义与 port_send 一致,只是 cnt 条消息一个系统调用:
+//   tty / usb / tcp_client / ipc_client:writev 到自身 fd(字节流,合并无语义变化)
+//   tcp_server / ipc_server:对每个 client 一次 writev(广播)
+//   udp:数据报边界不能合并,每段一个数据报,一次 sendmmsg(port_send_udp)
+// 返回写出的字节数(广播时为总长),-1 = 失败。
+int port_send_batch(port_def_t* p, const struct iovec* iov, int cnt)
+{
+    return port_send_batch_bufs(p, iov, NULL, cnt);
+}
+
+int port_send_batch_bufs(port_def_t* p, const struct iovec* iov, struct buf* const* bufs, int cnt)
+{
+    if (!p || (p->base.fd < 0 && port_link_up(p)) || cnt <= 0) return -1;
+
+    int len = 0;
+    for (int i = 0; i < cnt; i++) len += (int)iov[i].iov_len;
+
+    switch (p->base.type) {
+    case PORT_TTY:
+    case PORT_USB:
+    case PORT_TCP_CLIENT:
+    case PORT_IPC_CLIENT:
+        return port_send_stream(p, iov, bufs, cnt);
+    case PORT_TCP_SERVER:
+    case PORT_IPC_SERVER:
+        return port_send_server_broadcast(p, iov, bufs, cnt, len);
+    case PORT_UDP:
+        return port_send_udp(p, iov, cnt);
+    default:
+        return -1;
+    }
+}
+
 
 
 port_def_t* port_find(const char* name)
@@ -470,4 +772,212 @@ port_def_t* port_find(const char* name)
 //             return g_reactor_table[i].port;
 //     }
 //     return NULL;
-// }
\ No newline at end of file
+// }
+
+
+
+// ========================================================
+//  端口句柄(见 port_manager.h)
+// ========================================================
+#define HANDLE_IDX(h)  ((int)((h) & 0xFFFFu) - 1)
+#define HANDLE_GEN(h)  ((h) >> 16)
+
+port_handle_t port_register(port_def_t* p)
+{
+    if (!p) return PORT_HANDLE_INVALID;
+
+    pthread_mutex_lock(&g_table_lock);
+    for (int i = 0; i < MAX_PORTS; i++) {
+        port_entry_t* e = &g_port_table[i];
+        if (e->used) continue;
+        e->fd   = p->base.fd;
+        e->port = p;
+        e->used = 1;
+        unsigned gen = atomic_load_explicit(&e->gen, memory_order_relaxed) & 0xFFFFu;
+        p->base.handle = (gen << 16) | (unsigned)(i + 1);
+        pthread_mutex_unlock(&g_table_lock);
+        return p->base.handle;
+    }
+    pthread_mutex_unlock(&g_table_lock);
+    LOG_WARN("[port] table full, %s fd=%d not registered\n", p->base.name, p->base.fd);
+    p->base.handle = PORT_HANDLE_INVALID;
+    return PORT_HANDLE_INVALID;
+}
+
+void port_unregister(port_handle_t h)
+{
+    int i = HANDLE_IDX(h);
+    if (i < 0 || i >= MAX_PORTS) return;
+    port_entry_t* e = &g_port_table[i];
+
+    pthread_mutex_lock(&g_table_lock);
+    if (!e->used || (atomic_load(&e->gen) & 0xFFFFu) != HANDLE_GEN(h)) {
+        pthread_mutex_unlock(&g_table_lock);
+        return;
+    }
+
+    // 先让 generation 前进,再清槽:并发的 port_from_handle 要么看到旧 gen
+    // 且 port 仍有效,要么看到新 gen 直接失败
+    atomic_fetch_add_explicit(&e->gen, 1, memory_order_release);
+    e->used = 0;
+    e->fd   = -1;
+    e->port = NULL;
+    pthread_mutex_unlock(&g_table_lock);
+}
+
+int port_handle_slot(port_handle_t h)
+{
+    int i = HANDLE_IDX(h);
+    return (i >= 0 && i < MAX_PORTS) ? i : -1;
+}
+
+port_def_t* port_from_handle(port_handle_t h)
+{
+    int i = HANDLE_IDX(h);
+    if (i < 0 || i >= MAX_PORTS) return NULL;
+    port_entry_t* e = &g_port_table[i];
+
+    unsigned gen = atomic_load_explicit(&e->gen, memory_order_acquire) & 0xFFFFu;
+    if (gen != HANDLE_GEN(h)) return NULL;
+    port_def_t* p = e->port;
+    if (!p) return NULL;
+    atomic_thread_fence(memory_order_acquire);
+    if ((atomic_load_explicit(&e->gen, memory_order_relaxed) & 0xFFFFu) != gen)
+        return NULL;
+    return p;
+}
+
+// ========================================================
+//  断开端口的延迟回收(见 port_manager.h)
+// ========================================================
+// g_epoch 每挂起一项 +1。读侧进入一轮时把当时的 g_epoch 记进自己的槽(0 = 不在一轮里)。
+// 挂起项记下挂起前的 epoch E:读侧槽为 0 或 > E 的,进入这一轮时端口已经注销,
+// 解析不到它;所有读侧都满足时回收。
+typedef struct {
+    port_def_t*   port;
+    int           fd;
+    unsigned long epoch;
+} retired_t;
+
+static atomic_ulong    g_epoch = 1;
+static atomic_ulong    g_reader_epoch[PORT_READERS_MAX];
+static atomic_int      g_reader_used[PORT_READERS_MAX];
+static __thread int    t_reader = -1;
+
+static pthread_mutex_t g_retire_lock = PTHREAD_MUTEX_INITIALIZER;
+static retired_t*      g_retired;
+static int             g_retired_cap;
+static atomic_int      g_retired_n;
+
+static void port_reclaim_due(void);
+
+int port_reader_register(void)
+{
+    if (t_reader >= 0) return 0;
+    for (int i = 0; i < PORT_READERS_MAX; i++) {
+        int free_slot = 0;
+        if (atomic_compare_exchange_strong(&g_reader_used[i], &free_slot, 1)) {
+            atomic_store(&g_reader_epoch[i], 0);
+            t_reader = i;
+            return 0;
+        }
+    }
+    LOG_ERROR("[port] more than %d reader threads, this one is not protected\n", PORT_READERS_MAX);
+    return -1;
+}
+
+void port_reader_unregister(void)
+{
+    if (t_reader < 0) return;
+    atomic_store(&g_reader_epoch[t_reader], 0);
+    atomic_store(&g_reader_used[t_reader], 0);
+    t_reader = -1;
+    port_reclaim_due();
+}
+
+void port_read_begin(void)
+{
+    if (t_reader < 0) return;
+    atomic_store(&g_reader_epoch[t_reader], atomic_load(&g_epoch));
+    // 槽写出去之后才能解析句柄:与 port_retire 的 epoch 推进 + 扫槽成对
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+void port_read_end(void)
+{
+    if (t_reader < 0) return;
+    atomic_store_explicit(&g_reader_epoch[t_reader], 0, memory_order_release);
+    if (atomic_load_explicit(&g_retired_n, memory_order_relaxed) > 0)
+        port_reclaim_due();
+}
+
+// 还有读侧停在 epoch <= e 的一轮里
+static int reader_before(unsigned long e)
+{
+    for (int i = 0; i < PORT_READERS_MAX; i++) {
+        unsigned long r = atomic_load(&g_reader_epoch[i]);
+        if (r != 0 && r <= e) return 1;
+    }
+    return 0;
+}
+
+static void retired_free(const retired_t* r)
+{
+    if (r->fd >= 0) close(r->fd);
+    free(r->port);
+}
+
+// 从头回收到期的挂起项。多个 reactor 并发挂起时 epoch 不严格递增,
+// 排在没到期项后面的晚一点回收,不会提前
+static void port_reclaim_due(void)
+{
+    pthread_mutex_lock(&g_retire_lock);
+    int n = atomic_load(&g_retired_n);
+    int k = 0;
+    while (k < n && !reader_before(g_retired[k].epoch)) {
+        retired_free(&g_retired[k]);
+        k++;
+    }
+    if (k > 0) {
+        memmove(g_retired, g_retired + k, (size_t)(n - k) * sizeof(*g_retired));
+        atomic_store(&g_retired_n, n - k);
+    }
+    pthread_mutex_unlock(&g_retire_lock);
+}
+
+void port_retire(port_def_t* p, int fd)
+{
+    if (!p && fd < 0) return;
+    // 调用方已 port_unregister;推进 epoch 之后才进入一轮的读侧解析不到 p
+    retired_t r = {.port = p, .fd = fd, .epoch = atomic_fetch_add(&g_epoch, 1)};
+    atomic_thread_fence(memory_order_seq_cst);
+
+    pthread_mutex_lock(&g_retire_lock);
+    int n = atomic_load(&g_retired_n);
+    if (n == 0 && !reader_before(r.epoch)) {
+        pthread_mutex_unlock(&g_retire_lock);
+        retired_free(&r);
+        return;
+    }
+    if (n == g_retired_cap) {
+        int cap = g_retired_cap ? g_retired_cap * 2 : 16;
+        retired_t* a = realloc(g_retired, (size_t)cap * sizeof(*a));
+        if (!a) {
+            // 宁可泄漏也不提前释放
+            pthread_mutex_unlock(&g_retire_lock);
+            LOG_ERROR("[port] no memory to defer close of fd=%d, leaked\n", fd);
+            return;
+        }
+        g_retired = a;
+        g_retired_cap = cap;
+    }
+    g_retired[n] = r;
+    atomic_store(&g_retired_n, n + 1);
+    pthread_mutex_unlock(&g_retire_lock);
+    port_reclaim_due();
+}
+
+int port_retired_pending(void)
+{
+    return atomic_load(&g_retired_n);
+}
@@ -0,0 +1,1146 @@
+// port_tx.c — 非阻塞发送引擎
+//
+// 详见 port_tx.h 文件头。
+//
+// 输出环:每端口一个段队列(PORT_TX_SEGS 个段)+ 一块 PORT_TX_RING_BYTES 的字节
+//   arena,第一次需要排队时才分配(大多数端口从不排队,不占内存),之后随槽位复用。
+//   每段是一条消息(或它的一部分)的剩余字节:
+//     - 引用段:消息在 buf_pool 缓冲里且不小于 PORT_TX_REF_MIN,只 buf_ref 一次,
+//       不拷贝。广播时 N 个 client 的环引用同一个缓冲,最后一个写完的 unref 归还池
+//     - 拷贝段:小消息 / 没有缓冲的数据拷进 arena(arena 按段的顺序先进先出使用,
+//       回绕处一条消息拆成两段)
+//   段上记消息结束标志,丢弃(环满 / 慢 client)永远按整条、还没开始写的消息。
+//   全局最多持有缓冲池一半的缓冲(g_ref_cap),超了退回拷贝,不让积压饿死 reactor 的分配。
+//
+// EPOLLOUT:环从空变非空时挂上(水平触发),写空时摘掉。有零拷贝在途的 socket 即使
+//   写空也留在 epoll 里(事件掩码为 0),完成通知走 EPOLLERR(错误队列)。
+//   epoll data 放槽位下标,事件到来时用环里记的句柄校验端口是否还是那个连接。
+//
+// MSG_ZEROCOPY(端口配了 zerocopy_min,只对 TCP):环空时的直写,整次 sendmsg 不小于
+//   阈值且每段都在缓冲池里,就带 MSG_ZEROCOPY 发,每个缓冲多持一个引用直到内核
+//   报告完成(SO_EE_ORIGIN_ZEROCOPY,序号区间)。TCP 的完成按序到达。
+//
+// 慢 client(server accept 出的连接,server 配了 slow_client):积压超 budget 持续
+//   grace_ms 后按策略断开 / 只留最新 / 丢最旧;写了一半的那条留在队头接着写。
+//
+// tcp_client 断线(base.link 不是 UP,见 reactor.h):句柄不变,环"停泊"——不挂 epoll,
+//   新消息在 buffer_bytes 以内照常入环,超出整条丢弃。worker 按 PORT_TX_RELINK_MS 醒来
+//   查,连上后(link_epoch 变了)环改到新 fd 接着写。旧连接上写了一半的那条消息作废
+//   (新连接上的对端收不到前半条),旧连接的零拷贝在途缓冲随 fd 关闭不再等通知。
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#include "port_tx.h"
+#include "port_manager.h"
+#include "buf_pool.h"
+#include "log.h"
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY   60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY  0x4000000
+#endif
+
+typedef struct {
+    buf_t*   b;         // 引用段:持有一个引用;NULL = 拷贝段,字节在 arena 里
+    uint8_t* p;         // 下一个待写字节
+    uint32_t len;       // 剩余字节
+    uint32_t ao;        // 拷贝段:在 arena 里的起点
+    uint32_t alen;      // 拷贝段:占 arena 的字节数(整段写完才回收)
+    int      end;       // 消息的最后一段
+} tx_seg_t;
+
+typedef struct {
+    buf_t*   b;
+    uint32_t seq;       // 哪一次零拷贝 sendmsg
+} tx_zc_t;
+
+#define TX_ZC_MAX  256   // 每个 socket 最多这么多个在途零拷贝缓冲,满了走普通发送
+
+typedef struct {
+    port_handle_t h;        // 环属于哪个端口(句柄含 generation)
+    int           fd;
+    int           stream_sock;   // 1 = socket,用 sendmsg
+    int           id;            // 计数归属(g_config.ports 下标)
+    tx_seg_t*     seg;
+    int           seg_head;
+    int           seg_n;
+    uint8_t*      arena;
+    uint32_t      a_head;
+    uint32_t      a_len;
+    uint32_t      len;           // 排队字节数(两种段合计)
+    int           mid;           // 队头那条消息已写出一部分,不能丢
+    int           armed;         // 在 epoll 里
+    uint32_t      ep_events;     // 当前挂的事件(EPOLLOUT 或 0)
+    int           over;          // 高水位滞回状态
+    // 零拷贝
+    int           zc;            // 0 = 没试过,1 = SO_ZEROCOPY 已开,-1 = 不用
+    int           zc_min;
+    uint32_t      zc_next;       // 下一次零拷贝 sendmsg 的序号(内核按 socket 从 0 数)
+    tx_zc_t*      zc_q;
+    int           zc_head;
+    int           zc_n;
+    // 以下只对配置里的 tcp_client 有意义
+    unsigned      epoch;         // fd 属于第几次连接(base.link_epoch)
+    uint32_t      offline_cap;   // 断线期间最多缓存的字节,0 = 断线即丢
+    int           dialer;        // 配置里的 tcp_client(会断线重连,句柄不变)
+    int           parked;        // 断线中,不在 epoll 里,等重连
+    // 以下只对 server accept 出的 client 有意义
+    int           client;
+    const port_slow_client_t* sc;   // server 配了非 block 的慢 client 策略;否则 NULL
+    uint64_t      lag_since;     // 积压超 budget 的起始时刻(ns),0 = 没超
+    int           degraded;      // latest / drop_oldest 已生效,写空后恢复
+    int           evicted;       // 已断开,后续写直接丢
+} tx_ring_t;
+
+struct port_tx {
+    int        epfd;
+    int        armed_n;          // 在 epoll 里的环数;0 时 poll 不进内核
+    int        over_n;           // 在高水位以上的环数;0 时 blocked 不扫环
+    int        lag_n;            // 积压超 budget 的 client 环数;0 时 poll 不扫环
+    int        parked_n;         // 停泊(tcp_client 断线)的环数;0 时 poll 不扫环
+    int        dialer_n;         // dialer 环数;有且有环在 epoll 里时 poll 查断线
+    tx_ring_t* slot[MAX_PORTS];
+};
+
+typedef struct {
+    atomic_ulong queued_bytes;
+    atomic_ulong queued_max;
+    atomic_ulong short_writes;
+    atomic_ulong flushes;
+    atomic_ulong overflow_drops;
+    atomic_ulong overflow_bytes;
+    atomic_ulong errors;
+    atomic_ulong lag_drops;
+    atomic_ulong lag_bytes;
+    atomic_ulong evictions;
+    atomic_ulong downgrades;
+    atomic_ulong ref_msgs;
+    atomic_ulong zc_sends;
+    atomic_ulong zc_copied;
+    atomic_ulong offline_msgs;
+    atomic_ulong offline_drops;
+} tx_counter_t;
+
+// 每个 client 槽位的积压快照,给统计线程看
+typedef struct {
+    atomic_uint  h;             // client 的句柄;过期即视为空
+    atomic_int   id;            // 所属 server(g_config.ports 下标)
+    atomic_int   fd;
+    atomic_ulong queued;
+    atomic_ulong lag_since;
+} tx_client_t;
+
+static tx_counter_t g_tx[MAX_PORTS];
+static tx_client_t  g_client[MAX_PORTS];
+static atomic_int   g_refs_held;    // 所有引擎持有的缓冲引用数
+static int          g_ref_cap;      // 上限:缓冲池的一半(port_tx_create 时取)
+static __thread port_tx_t* t_current;
+
+static tx_counter_t* cnt_of(int id)
+{
+    return (id >= 0 && id < MAX_PORTS) ? &g_tx[id] : NULL;
+}
+
+#define CNT_ADD(id, field, v) do {                                          \
+        tx_counter_t* c_ = cnt_of(id);                                      \
+        if (c_) atomic_fetch_add_explicit(&c_->field, (unsigned long)(v),    \
+                                          memory_order_relaxed);             \
+    } while (0)
+
+static void queued_add(int id, long delta)
+{
+    tx_counter_t* c = cnt_of(id);
+    if (!c || delta == 0) return;
+    unsigned long now = atomic_fetch_add_explicit(&c->queued_bytes, (unsigned long)delta,
+                                                  memory_order_relaxed) + (unsigned long)delta;
+    if (delta > 0 && now > atomic_load_explicit(&c->queued_max, memory_order_relaxed))
+        atomic_store_explicit(&c->queued_max, now, memory_order_relaxed);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int is_stream_socket(const port_def_t* p)
+{
+    return p->base.type == PORT_TCP_CLIENT || p->base.type == PORT_IPC_CLIENT;
+}
+
+// 非阻塞 writev。socket 加 MSG_NOSIGNAL:对端已关时返回 EPIPE 而不是杀进程。
+static ssize_t tx_writev(int fd, int sock, const struct iovec* iov, int cnt, int flags)
+{
+    if (sock) {
+        struct msghdr mh;
+        memset(&mh, 0, sizeof(mh));
+        mh.msg_iov    = (struct iovec*)iov;
+        mh.msg_iovlen = (size_t)cnt;
+        return sendmsg(fd, &mh, MSG_DONTWAIT | MSG_NOSIGNAL | flags);
+    }
+    return writev(fd, iov, cnt);
+}
+
+static int would_block(int err)
+{
+    return err == EAGAIN || err == EWOULDBLOCK || err == EINTR;
+}
+
+// ---- 缓冲引用(全局有上限)----
+
+static int ref_take(buf_t* b)
+{
+    if (atomic_fetch_add_explicit(&g_refs_held, 1, memory_order_relaxed) >= g_ref_cap) {
+        atomic_fetch_sub_explicit(&g_refs_held, 1, memory_order_relaxed);
+        return 0;
+    }
+    buf_ref(b);
+    return 1;
+}
+
+static void ref_drop(buf_t* b)
+{
+    buf_unref(b);
+    atomic_fetch_sub_explicit(&g_refs_held, 1, memory_order_relaxed);
+}
+
+port_tx_t* port_tx_create(void)
+{
+    port_tx_t* tx = calloc(1, sizeof(*tx));
+    if (!tx) return NULL;
+    tx->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (tx->epfd < 0) {
+        free(tx);
+        return NULL;
+    }
+    buf_pool_stats_t st;
+    buf_pool_get_stats(&st);
+    g_ref_cap = st.total / 2;   // 缓冲池没建(单测)时为 0:一律拷贝
+    return tx;
+}
+
+static void client_publish(const tx_ring_t* r)
+{
+    int i = port_handle_slot(r->h);
+    if (!r->client || i < 0) return;
+    tx_client_t* c = &g_client[i];
+    atomic_store_explicit(&c->queued, r->len, memory_order_relaxed);
+    atomic_store_explicit(&c->lag_since, r->lag_since, memory_order_relaxed);
+}
+
+static void set_over(port_tx_t* tx, tx_ring_t* r, int over)
+{
+    if (r->over == over) return;
+    r->over = over;
+    tx->over_n += over ? 1 : -1;
+}
+
+static tx_seg_t* seg_at(tx_ring_t* r, int k)
+{
+    return &r->seg[(r->seg_head + k) % PORT_TX_SEGS];
+}
+
+// epoll 里的事件跟着环的状态走:有排队字节挂 EPOLLOUT;只剩零拷贝在途时挂 0
+// (EPOLLERR 总会报);都没有就摘掉
+static void ep_update(port_tx_t* tx, tx_ring_t* r)
+{
+    uint32_t want = r->len > 0 ? EPOLLOUT : 0;
+    if (r->len == 0 && r->zc_n == 0) {
+        if (r->armed) {
+            epoll_ctl(tx->epfd, EPOLL_CTL_DEL, r->fd, NULL);
+            tx->armed_n--;
+            r->armed = 0;
+        }
+        return;
+    }
+    if (r->armed && r->ep_events == want) return;
+
+    struct epoll_event ev = {.events = want, .data.u32 = (uint32_t)port_handle_slot(r->h)};
+    int rc = epoll_ctl(tx->epfd, r->armed ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, r->fd, &ev);
+    if (rc < 0 && !r->armed && errno == EEXIST)
+        rc = epoll_ctl(tx->epfd, EPOLL_CTL_MOD, r->fd, &ev);
+    if (rc < 0) {
+        LOG_WARN("[port_tx] fd=%d: epoll watch failed, errno=%d\n", r->fd, errno);
+        return;
+    }
+    if (!r->armed) {
+        r->armed = 1;
+        tx->armed_n++;
+    }
+    r->ep_events = want;
+}
+
+static void zc_release_all(tx_ring_t* r)
+{
+    for (int k = 0; k < r->zc_n; k++)
+        ref_drop(r->zc_q[(r->zc_head + k) % TX_ZC_MAX].b);
+    r->zc_head = 0;
+    r->zc_n    = 0;
+}
+
+// 丢弃环里残留(端口已断开 / 写出错 / 引擎销毁),引用的缓冲全部归还。
+// live = 端口还在(fd 没关):摘 epoll。端口已断开时 fd 已关,epoll 自动摘除,
+// 而且 fd 号可能已被新连接复用并挂在本 epoll 上,不能再按 fd 号 DEL。
+static void ring_reset(port_tx_t* tx, tx_ring_t* r, int live)
+{
+    if (r->armed) {
+        if (live) epoll_ctl(tx->epfd, EPOLL_CTL_DEL, r->fd, NULL);
+        tx->armed_n--;
+        r->armed = 0;
+    }
+    if (r->len > 0) {
+        CNT_ADD(r->id, overflow_bytes, r->len);
+        queued_add(r->id, -(long)r->len);
+    }
+    for (int k = 0; k < r->seg_n; k++) {
+        tx_seg_t* s = seg_at(r, k);
+        if (s->b) ref_drop(s->b);
+    }
+    zc_release_all(r);
+    r->seg_head = 0;
+    r->seg_n    = 0;
+    r->a_head   = 0;
+    r->a_len    = 0;
+    r->len      = 0;
+    r->mid      = 0;
+    set_over(tx, r, 0);
+    r->degraded = 0;
+    if (r->lag_since) {
+        r->lag_since = 0;
+        tx->lag_n--;
+    }
+    if (r->parked) {
+        r->parked = 0;
+        tx->parked_n--;
+    }
+    client_publish(r);
+}
+
+static void ring_free(tx_ring_t* r)
+{
+    if (!r) return;
+    free(r->seg);
+    free(r->arena);
+    free(r->zc_q);
+    free(r);
+}
+
+void port_tx_destroy(port_tx_t* tx)
+{
+    if (!tx) return;
+    for (int i = 0; i < MAX_PORTS; i++) {
+        tx_ring_t* r = tx->slot[i];
+        if (!r) continue;
+        ring_reset(tx, r, 0);   // epoll 随后整个关掉
+        ring_free(r);
+    }
+    close(tx->epfd);
+    if (t_current == tx) t_current = NULL;
+    free(tx);
+}
+
+void port_tx_bind(port_tx_t* tx)
+{
+    t_current = tx;
+}
+
+port_tx_t* port_tx_current(void)
+{
+    return t_current;
+}
+
+int port_tx_fd(const port_tx_t* tx)
+{
+    return tx ? tx->epfd : -1;
+}
+
+// 配置里的 tcp_client(reactor 断线重连的那种;accept 出的 client 不是)
+static int is_dialer(const port_def_t* p)
+{
+    int id = p->base.id;
+    return p->base.type == PORT_TCP_CLIENT && id >= 0 && id < g_config.port_count &&
+           p == &g_config.ports[id];
+}
+
+// 配置里的 tcp_client 断线期间可缓存的字节(buffer_bytes,夹到环容量);其他端口 0
+static uint32_t offline_cap(const port_def_t* p)
+{
+    if (!is_dialer(p)) return 0;
+    int cap = p->cfg.tcp_client.buffer_bytes;
+    return cap > PORT_TX_RING_BYTES ? PORT_TX_RING_BYTES : (uint32_t)cap;
+}
+
+// tcp_client 断线:环停泊,不再等旧 fd 的 EPOLLOUT。live 同 ring_reset
+static void ring_park(port_tx_t* tx, tx_ring_t* r, int live)
+{
+    if (r->armed) {
+        if (live) epoll_ctl(tx->epfd, EPOLL_CTL_DEL, r->fd, NULL);
+        tx->armed_n--;
+        r->armed = 0;
+    }
+    if (!r->parked) {
+        r->parked = 1;
+        tx->parked_n++;
+    }
+}
+
+static void seg_pop(tx_ring_t* r);
+
+// tcp_client 重连上了:环改到新 fd。旧 fd 已由 reactor 关掉(epoll 自动摘除,
+// 不能按 fd 号 DEL),写了一半的那条丢掉剩余部分,其余整条消息按序发到新连接
+static void ring_relink(port_tx_t* tx, tx_ring_t* r, const port_def_t* p)
+{
+    if (r->armed) {
+        tx->armed_n--;
+        r->armed = 0;
+    }
+    if (r->parked) {
+        r->parked = 0;
+        tx->parked_n--;
+    }
+    zc_release_all(r);
+    uint32_t before = r->len;
+    while (r->mid && r->seg_n > 0) {
+        tx_seg_t* s = seg_at(r, 0);
+        int end = s->end;
+        r->len -= s->len;
+        seg_pop(r);
+        if (end) r->mid = 0;
+    }
+    r->mid = 0;
+    if (before > r->len) {
+        CNT_ADD(r->id, overflow_bytes, before - r->len);
+        queued_add(r->id, -(long)(before - r->len));
+    }
+    r->fd      = p->base.fd;
+    r->epoch   = atomic_load_explicit(&p->base.link_epoch, memory_order_acquire);
+    r->zc      = 0;
+    r->zc_next = 0;
+    if (r->len > 0)
+        LOG_INFO("[port_tx] %s fd=%d: reconnected, %u buffered bytes to send\n",
+                 p->base.name, r->fd, r->len);
+    ep_update(tx, r);
+}
+
+// 端口对应的环;句柄变了(槽位换了连接)先清掉旧连接的残留。create=0 时不分配。
+static tx_ring_t* ring_of(port_tx_t* tx, const port_def_t* p, int create)
+{
+    int i = port_handle_slot(p->base.handle);
+    if (i < 0) return NULL;
+    tx_ring_t* r = tx->slot[i];
+    if (!r) {
+        if (!create) return NULL;
+        r = calloc(1, sizeof(*r));
+        if (r) {
+            r->seg   = malloc(PORT_TX_SEGS * sizeof(*r->seg));
+            r->arena = malloc(PORT_TX_RING_BYTES);
+            r->zc_q  = malloc(TX_ZC_MAX * sizeof(*r->zc_q));
+        }
+        if (!r || !r->seg || !r->arena || !r->zc_q) {
+            ring_free(r);
+            return NULL;
+        }
+        tx->slot[i] = r;
+        r->h = PORT_HANDLE_INVALID;
+    }
+    if (r->h != p->base.handle) {
+        ring_reset(tx, r, 0);   // 旧连接已断开(槽位才会换句柄)
+        r->h           = p->base.handle;
+        r->fd          = p->base.fd;
+        r->stream_sock = is_stream_socket(p);
+        r->id          = p->base.id;
+        r->evicted     = 0;
+        r->zc          = 0;
+        r->zc_next     = 0;
+
+        // accept 出的 client:base.id 指向 server,配置都看 server 的
+        const port_def_t* cfg = (r->id >= 0 && r->id < g_config.port_count)
+                              ? &g_config.ports[r->id] : NULL;
+        r->client = r->stream_sock && cfg && (cfg->base.type == PORT_TCP_SERVER ||
+                                              cfg->base.type == PORT_IPC_SERVER);
+        r->sc = (r->client && cfg->base.slow_client.policy != SLOW_CLIENT_BLOCK)
+              ? &cfg->base.slow_client : NULL;
+        r->zc_min = (r->stream_sock && cfg) ? cfg->base.zerocopy_min : 0;
+        r->epoch  = atomic_load_explicit(&p->base.link_epoch, memory_order_acquire);
+        r->offline_cap = offline_cap(p);
+        tx->dialer_n  -= r->dialer;
+        r->dialer      = is_dialer(p);
+        tx->dialer_n  += r->dialer;
+        if (r->client) {
+            atomic_store_explicit(&g_client[i].h, r->h, memory_order_relaxed);
+            atomic_store_explicit(&g_client[i].id, r->id, memory_order_relaxed);
+            atomic_store_explicit(&g_client[i].fd, r->fd, memory_order_relaxed);
+            client_publish(r);
+        }
+    }
+    if (r->epoch != atomic_load_explicit(&p->base.link_epoch, memory_order_acquire) &&
+        port_link_up(p))
+        ring_relink(tx, r, p);
+    return r;
+}
+
+// 入队一条消息的剩余 n 字节(src 在缓冲 b 里,b 可为 NULL)。放不下返回 0,不动环。
+static int ring_push(tx_ring_t* r, buf_t* b, const uint8_t* src, uint32_t n)
+{
+    if (r->len + n > PORT_TX_RING_BYTES || r->seg_n + 2 > PORT_TX_SEGS) return 0;
+
+    if (b && n >= PORT_TX_REF_MIN && ref_take(b)) {
+        tx_seg_t* s = seg_at(r, r->seg_n++);
+        *s = (tx_seg_t){.b = b, .p = (uint8_t*)src, .len = n, .end = 1};
+        r->len += n;
+        CNT_ADD(r->id, ref_msgs, 1);
+        return 1;
+    }
+
+    if (r->a_len + n > PORT_TX_RING_BYTES) return 0;
+    uint32_t tail  = (r->a_head + r->a_len) % PORT_TX_RING_BYTES;
+    uint32_t first = PORT_TX_RING_BYTES - tail;
+    if (first > n) first = n;
+    memcpy(r->arena + tail, src, first);
+    tx_seg_t* s = seg_at(r, r->seg_n++);
+    *s = (tx_seg_t){.p = r->arena + tail, .len = first, .ao = tail, .alen = first,
+                    .end = (first == n)};
+    if (first < n) {   // 回绕:后半段从 arena 开头起
+        memcpy(r->arena, src + first, n - first);
+        s = seg_at(r, r->seg_n++);
+        *s = (tx_seg_t){.p = r->arena, .len = n - first, .ao = 0, .alen = n - first, .end = 1};
+    }
+    r->a_len += n;
+    r->len   += n;
+    return 1;
+}
+
+// 弹出队头段:归还引用 / 回收 arena(连同它前面因丢弃留下的空洞)
+static void seg_pop(tx_ring_t* r)
+{
+    tx_seg_t* s = seg_at(r, 0);
+    if (s->b) {
+        ref_drop(s->b);
+    } else {
+        uint32_t dist = (s->ao + PORT_TX_RING_BYTES - r->a_head) % PORT_TX_RING_BYTES + s->alen;
+        r->a_head = (s->ao + s->alen) % PORT_TX_RING_BYTES;
+        r->a_len -= dist;
+    }
+    r->seg_head = (r->seg_head + 1) % PORT_TX_SEGS;
+    r->seg_n--;
+    if (r->seg_n == 0) {
+        r->seg_head = 0;
+        r->a_head   = 0;
+        r->a_len    = 0;
+    }
+}
+
+// 队头写出了 w 字节
+static void ring_consume(tx_ring_t* r, uint32_t w)
+{
+    while (w > 0 && r->seg_n > 0) {
+        tx_seg_t* s = seg_at(r, 0);
+        uint32_t take = w < s->len ? w : s->len;
+        s->p   += take;
+        s->len -= take;
+        r->len -= take;
+        w      -= take;
+        if (s->len > 0) {
+            r->mid = 1;
+            return;
+        }
+        r->mid = !s->end;
+        seg_pop(r);
+    }
+}
+
+static void ring_watermark(port_tx_t* tx, tx_ring_t* r)
+{
+    if (r->len >= PORT_TX_HWM)
+        set_over(tx, r, 1);
+    else if (r->len <= PORT_TX_LWM)
+        set_over(tx, r, 0);
+}
+
+// ---- 慢 client ----
+
+// 丢掉队头之后(写了一半的那条不动)最旧的 k 条消息:段队列原地压紧。
+// 丢掉的拷贝段在 arena 里留下空洞,等后面的拷贝段弹出时一起回收。
+static void ring_drop_msgs(tx_ring_t* r, int k)
+{
+    if (k <= 0) return;
+    int front = r->mid;     // 还在队头那条消息里
+    int msg = 0, wr = 0, copies = 0;
+    uint32_t dropped = 0;
+    for (int rd = 0; rd < r->seg_n; rd++) {
+        tx_seg_t s = *seg_at(r, rd);
+        int drop = !front && msg < k;
+        if (s.end) {
+            if (front) front = 0;
+            else       msg++;
+        }
+        if (drop) {
+            dropped += s.len;
+            if (s.b) ref_drop(s.b);
+            continue;
+        }
+        if (!s.b) copies++;
+        *seg_at(r, wr++) = s;
+    }
+    r->seg_n = wr;
+    r->len  -= dropped;
+    if (copies == 0) {   // arena 里已没有活的字节
+        r->a_head = 0;
+        r->a_len  = 0;
+    }
+    CNT_ADD(r->id, lag_drops, k);
+    CNT_ADD(r->id, lag_bytes, dropped);
+    queued_add(r->id, -(long)dropped);
+}
+
+// latest:只留最新一条;drop_oldest:丢最旧的直到积压回到 budget 以内。最新一条总保留。
+static void ring_degrade(tx_ring_t* r)
+{
+    int msgs = 0;
+    for (int k = 0; k < r->seg_n; k++) msgs += seg_at(r, k)->end;
+    if (r->mid) msgs--;   // 队头那条不算
+    if (msgs <= 1) return;
+    if (r->sc->policy == SLOW_CLIENT_LATEST) {
+        ring_drop_msgs(r, msgs - 1);
+        return;
+    }
+    uint32_t budget = (uint32_t)r->sc->budget_bytes;
+    uint32_t remain = r->len, size = 0;
+    int front = r->mid, k = 0;
+    for (int j = 0; j < r->seg_n && remain > budget && k < msgs - 1; j++) {
+        const tx_seg_t* s = seg_at(r, j);
+        if (front) {
+            front = !s->end;
+            continue;
+        }
+        size += s->len;
+        if (s->end) {
+            remain -= size;
+            size = 0;
+            k++;
+        }
+    }
+    ring_drop_msgs(r, k);
+}
+
+static void ring_evict(port_tx_t* tx, tx_ring_t* r)
+{
+    LOG_WARN("[port_tx] %s fd=%d: slow client evicted, %u bytes behind for %d ms\n",
+             g_config.ports[r->id].base.name, r->fd, r->len, r->sc->grace_ms);
+    CNT_ADD(r->id, evictions, 1);
+    // 只 shutdown,不 close:fd 的关闭和注销仍由 reactor 读到 EOF 后统一做
+    if (port_from_handle(r->h)) shutdown(r->fd, SHUT_RDWR);
+    ring_reset(tx, r, 1);
+    r->evicted = 1;
+}
+
+// 每次入环 / 冲刷后检查:积压超 budget 多久了,到期按策略处理;顺带发布积压快照
+static void slow_check(port_tx_t* tx, tx_ring_t* r)
+{
+    if (!r->client) return;
+    const port_slow_client_t* sc = r->sc;
+    if (sc && !r->evicted) {
+        if (r->degraded && r->len == 0) {
+            r->degraded = 0;
+            LOG_INFO("[port_tx] %s fd=%d: slow client caught up\n",
+                     g_config.ports[r->id].base.name, r->fd);
+        }
+        if (r->degraded) ring_degrade(r);
+
+        if (r->len <= (uint32_t)sc->budget_bytes) {
+            if (r->lag_since) {
+                r->lag_since = 0;
+                tx->lag_n--;
+            }
+        } else {
+            uint64_t now = now_ns();
+            if (!r->lag_since) {
+                r->lag_since = now;
+                tx->lag_n++;
+            }
+            if (now - r->lag_since >= (uint64_t)sc->grace_ms * 1000000ull) {
+                if (sc->policy == SLOW_CLIENT_DISCONNECT) {
+                    ring_evict(tx, r);
+                    return;
+                }
+                if (!r->degraded) {
+                    r->degraded = 1;
+                    CNT_ADD(r->id, downgrades, 1);
+                    LOG_WARN("[port_tx] %s fd=%d: slow client downgraded to %s, %u bytes behind\n",
+                             g_config.ports[r->id].base.name, r->fd,
+                             slow_client_policy_name(sc->policy), r->len);
+                }
+                ring_degrade(r);
+            }
+        }
+    }
+    client_publish(r);
+}
+
+// 前 skip 字节已写出,其余按消息入环(整条放得下才放),环非空时挂 EPOLLOUT
+static int ring_enqueue(port_tx_t* tx, port_def_t* p, const struct iovec* iov,
+                        struct buf* const* bufs, int cnt, size_t skip)
+{
+    tx_ring_t* r = ring_of(tx, p, 1);
+    size_t accepted = skip;
+    if (r && r->evicted) {   // 已断开,等 reactor 注销;当作发出去了
+        size_t total = 0;
+        for (int i = 0; i < cnt; i++) total += iov[i].iov_len;
+        CNT_ADD(p->base.id, lag_drops, cnt);
+        CNT_ADD(p->base.id, lag_bytes, total - skip);
+        return (int)total;
+    }
+    uint32_t before = r ? r->len : 0;
+
+    for (int i = 0; i < cnt; i++) {
+        size_t len = iov[i].iov_len;
+        if (skip >= len) {   // 已写出
+            skip -= len;
+            continue;
+        }
+        const uint8_t* src = (const uint8_t*)iov[i].iov_base + skip;
+        size_t rest = len - skip;
+        int was_empty = r && r->len == 0;
+        // 写了一半的消息(skip > 0)不能再丢,否则对端收到半条;环空时一定放得下
+        if (!r || rest > PORT_TX_RING_BYTES ||
+            !ring_push(r, bufs ? bufs[i] : NULL, src, (uint32_t)rest)) {
+            CNT_ADD(p->base.id, overflow_drops, 1);
+            CNT_ADD(p->base.id, overflow_bytes, rest);
+            if (skip > 0)
+                LOG_WARN("[port_tx] %s fd=%d: ring full, message torn after %zu bytes\n",
+                         p->base.name, p->base.fd, skip);
+            skip = 0;
+            continue;
+        }
+        if (was_empty) r->mid = (skip > 0);
+        accepted += rest;
+        skip = 0;
+    }
+    if (!r) return (int)accepted;
+
+    queued_add(r->id, (long)r->len - (long)before);
+    slow_check(tx, r);
+    if (r->evicted) return (int)accepted;
+    ring_watermark(tx, r);
+    if (!r->parked) ep_update(tx, r);
+    return (int)accepted;
+}
+
+int port_tx_queue(port_tx_t* tx, port_def_t* p, const struct iovec* iov,
+                  struct buf* const* bufs, int cnt, size_t skip)
+{
+    if (!tx || !p || p->base.fd < 0 || cnt <= 0) return -1;
+    CNT_ADD(p->base.id, short_writes, 1);
+    return ring_enqueue(tx, p, iov, bufs, cnt, skip);
+}
+
+// ---- MSG_ZEROCOPY ----
+
+static int zc_enable(tx_ring_t* r)
+{
+    if (r->zc == 0) {
+        int one = 1;
+        r->zc = setsockopt(r->fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0 ? 1 : -1;
+        if (r->zc < 0)
+            LOG_INFO("[port_tx] fd=%d: SO_ZEROCOPY unavailable (errno=%d), copying\n",
+                     r->fd, errno);
+    }
+    return r->zc > 0;
+}
+
+// 尝试零拷贝直写。返回写出字节数;-1 = 没用零拷贝(调用方走普通发送),errno 保留
+static ssize_t zc_send(port_tx_t* tx, tx_ring_t* r, const struct iovec* iov,
+                       struct buf* const* bufs, int cnt)
+{
+    if (r->zc_n + cnt > TX_ZC_MAX || !zc_enable(r)) return -1;
+    // 发出去的每个缓冲在完成通知前都不能回池:先拿引用,拿不到(上限)就不用零拷贝
+    int i;
+    for (i = 0; i < cnt; i++) {
+        if (!bufs[i] || !ref_take(bufs[i])) break;
+        r->zc_q[(r->zc_head + r->zc_n + i) % TX_ZC_MAX] = (tx_zc_t){.b = bufs[i], .seq = r->zc_next};
+    }
+    if (i < cnt) {
+        while (i-- > 0) ref_drop(r->zc_q[(r->zc_head + r->zc_n + i) % TX_ZC_MAX].b);
+        return -1;
+    }
+
+    ssize_t w = tx_writev(r->fd, 1, iov, cnt, MSG_ZEROCOPY);
+    if (w < 0) {   // 没发出去就不占序号,也不会有完成通知
+        int err = errno;
+        for (i = 0; i < cnt; i++) ref_drop(r->zc_q[(r->zc_head + r->zc_n + i) % TX_ZC_MAX].b);
+        errno = err;
+        return err == ENOBUFS ? -1 : -2;   // ENOBUFS = optmem 用完:这次普通发送
+    }
+    // 没写出的尾部也一并挂到这次完成上(排队时另外拿引用),简单且不影响正确性
+    r->zc_n += cnt;
+    r->zc_next++;
+    CNT_ADD(r->id, zc_sends, 1);
+    ep_update(tx, r);
+    return w;
+}
+
+// 读错误队列里的零拷贝完成通知,归还 [lo, hi] 区间对应的缓冲。返回读到的通知数
+static int zc_reap(tx_ring_t* r)
+{
+    int got = 0;
+    for (;;) {
+        char ctrl[128];
+        struct msghdr mh;
+        memset(&mh, 0, sizeof(mh));
+        mh.msg_control    = ctrl;
+        mh.msg_controllen = sizeof(ctrl);
+        if (recvmsg(r->fd, &mh, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) break;
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&mh); cm; cm = CMSG_NXTHDR(&mh, cm)) {
+            if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                  (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)))
+                continue;
+            struct sock_extended_err* ee = (struct sock_extended_err*)CMSG_DATA(cm);
+            if (ee->ee_origin != SO_EE_ORIGIN_ZEROCOPY || ee->ee_errno != 0) continue;
+            got++;
+            if (ee->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)   // 内核实际拷贝了(如 loopback)
+                CNT_ADD(r->id, zc_copied, 1);
+            uint32_t hi = ee->ee_data;
+            while (r->zc_n > 0) {
+                tx_zc_t* z = &r->zc_q[r->zc_head];
+                if ((int32_t)(hi - z->seq) < 0) break;
+                ref_drop(z->b);
+                r->zc_head = (r->zc_head + 1) % TX_ZC_MAX;
+                r->zc_n--;
+            }
+        }
+    }
+    return got;
+}
+
+// tcp_client 断线中:offline_cap 以内整条入环(停泊,重连后发),超出的整条丢弃。
+// 对调用方当作发出去了,不报错。live 同 ring_reset(写出错时 fd 还没被 reactor 关)
+static int offline_write(port_tx_t* tx, port_def_t* p, const struct iovec* iov,
+                         struct buf* const* bufs, int cnt, size_t total, int live)
+{
+    tx_ring_t* r = ring_of(tx, p, offline_cap(p) > 0);
+    uint32_t before = r ? r->len : 0;
+    int kept = 0;
+    for (int i = 0; i < cnt; i++) {
+        size_t len = iov[i].iov_len;
+        if (r && r->len + len <= r->offline_cap &&
+            ring_push(r, bufs ? bufs[i] : NULL, iov[i].iov_base, (uint32_t)len)) {
+            kept++;
+            continue;
+        }
+        CNT_ADD(p->base.id, offline_drops, 1);
+    }
+    if (!r) return (int)total;
+    CNT_ADD(r->id, offline_msgs, kept);
+    queued_add(r->id, (long)r->len - (long)before);
+    ring_watermark(tx, r);
+    if (r->len > 0 || r->armed) ring_park(tx, r, live);
+    return (int)total;
+}
+
+int port_tx_write(port_tx_t* tx, port_def_t* p, const struct iovec* iov,
+                  struct buf* const* bufs, int cnt)
+{
+    if (!tx || !p || cnt <= 0) return -1;
+
+    size_t total = 0;
+    for (int i = 0; i < cnt; i++) total += iov[i].iov_len;
+
+    tx_ring_t* r = ring_of(tx, p, 0);   // 重连后第一次写在这里换到新 fd
+    if (!port_link_up(p) || (r && r->parked))
+        return offline_write(tx, p, iov, bufs, cnt, total, 0);
+    if (p->base.fd < 0) return -1;
+    if (r && r->evicted) {   // 已断开,等 reactor 注销;当作发出去了
+        CNT_ADD(p->base.id, lag_drops, cnt);
+        CNT_ADD(p->base.id, lag_bytes, total);
+        return (int)total;
+    }
+    if (r && r->len > 0)
+        return ring_enqueue(tx, p, iov, bufs, cnt, 0);   // 前面还有没写完的,排在后面
+
+    ssize_t w = -1;
+    int zc_min = r ? r->zc_min
+                   : (is_stream_socket(p) && p->base.id >= 0 && p->base.id < g_config.port_count
+                          ? g_config.ports[p->base.id].base.zerocopy_min : 0);
+    if (bufs && zc_min > 0 && total >= (size_t)zc_min) {
+        if (!r) r = ring_of(tx, p, 1);   // 在途的零拷贝缓冲挂在环上
+        if (r) {
+            w = zc_send(tx, r, iov, bufs, cnt);
+            if (w == -2) {
+                w = -1;
+                goto failed;
+            }
+        }
+    }
+    if (w < 0)
+        w = tx_writev(p->base.fd, is_stream_socket(p), iov, cnt, 0);
+    if (w < 0) {
+failed:
+        if (!would_block(errno)) {
+            CNT_ADD(p->base.id, errors, 1);
+            // 连接刚断、reactor 还没发现:配了断线缓存的 tcp_client 这批留到重连后发
+            if (offline_cap(p) > 0) return offline_write(tx, p, iov, bufs, cnt, total, 1);
+            return -1;
+        }
+        w = 0;
+    }
+    if ((size_t)w == total) return (int)total;
+
+    return port_tx_queue(tx, p, iov, bufs, cnt, (size_t)w);
+}
+
+int port_tx_idle(port_tx_t* tx, const port_def_t* p)
+{
+    if (!port_link_up(p)) return 0;   // 断线中:经 port_tx_write 缓存或丢弃
+    int i = port_handle_slot(p->base.handle);
+    if (i < 0 || !tx->slot[i]) return 1;
+    const tx_ring_t* r = tx->slot[i];
+    return r->h != p->base.handle || (r->len == 0 && !r->evicted);
+}
+
+int port_tx_blocked(port_tx_t* tx, int port_id)
+{
+    if (!tx || tx->over_n == 0) return 0;
+    int blocked = 0;
+    for (int i = 0; i < MAX_PORTS; i++) {
+        tx_ring_t* r = tx->slot[i];
+        if (!r || !r->over || r->id != port_id) continue;
+        if (r->sc) continue;   // 配了慢 client 策略:由策略处理,不拖住 server
+        // 已断开的连接:fd 已关,不会再有 EPOLLOUT,残留在这里清掉,不让它卡住 server
+        if (!port_from_handle(r->h)) {
+            ring_reset(tx, r, 0);
+            continue;
+        }
+        blocked = 1;
+    }
+    return blocked;
+}
+
+// 可写:按段组 iovec 写出去,直到写空或 EAGAIN
+static void ring_flush(port_tx_t* tx, tx_ring_t* r)
+{
+    uint32_t before = r->len;
+    while (r->len > 0) {
+        struct iovec iov[64];
+        int n = 0;
+        for (; n < 64 && n < r->seg_n; n++) {
+            const tx_seg_t* s = seg_at(r, n);
+            iov[n].iov_base = s->p;
+            iov[n].iov_len  = s->len;
+        }
+        ssize_t w = tx_writev(r->fd, r->stream_sock, iov, n, 0);
+        if (w < 0) {
+            if (would_block(errno)) break;
+            // 对端关闭等:残留丢弃,断开由 reactor 读侧清理。
+            // 配了断线缓存的 tcp_client 留着整条消息,重连后发
+            CNT_ADD(r->id, errors, 1);
+            queued_add(r->id, -(long)(before - r->len));
+            if (r->offline_cap > 0) {
+                LOG_WARN("[port_tx] fd=%d: flush failed, errno=%d, keep %u bytes for reconnect\n",
+                         r->fd, errno, r->len);
+                ring_park(tx, r, 1);
+                return;
+            }
+            LOG_WARN("[port_tx] fd=%d: flush failed, errno=%d, drop %u bytes\n",
+                     r->fd, errno, r->len);
+            ring_reset(tx, r, 1);
+            return;
+        }
+        CNT_ADD(r->id, flushes, 1);
+        ring_consume(r, (uint32_t)w);
+    }
+    queued_add(r->id, -(long)(before - r->len));
+    slow_check(tx, r);
+    ep_update(tx, r);
+}
+
+int port_tx_poll(port_tx_t* tx)
+{
+    // 热路径:没有排队 / 停泊的端口就不做系统调用
+    if (!tx || (tx->armed_n == 0 && tx->parked_n == 0)) return 0;
+    struct epoll_event evs[64];
+    int n = tx->armed_n ? epoll_wait(tx->epfd, evs, 64, 0) : 0;
+    int resumed = 0;
+    for (int k = 0; k < n; k++) {
+        uint32_t i = evs[k].data.u32;
+        tx_ring_t* r = (i < MAX_PORTS) ? tx->slot[i] : NULL;
+        if (!r) continue;
+        if (!port_from_handle(r->h)) {   // 连接已断开:残留丢弃
+            ring_reset(tx, r, 0);
+            continue;
+        }
+        if (evs[k].events & (EPOLLERR | EPOLLHUP)) {
+            // 零拷贝完成通知;读不到通知且 socket 报错,说明是连接本身出错,在途缓冲不再等
+            if (zc_reap(r) == 0) {
+                int err = 0;
+                socklen_t el = sizeof(err);
+                if (getsockopt(r->fd, SOL_SOCKET, SO_ERROR, &err, &el) < 0 || err != 0 ||
+                    (evs[k].events & EPOLLHUP))
+                    zc_release_all(r);
+            }
+        }
+        if (r->parked) continue;   // 断线了,等重连
+        if (r->len > 0) {
+            int was_over = r->over;
+            ring_flush(tx, r);
+            ring_watermark(tx, r);
+            if (was_over && !r->over) resumed++;
+        } else {
+            ep_update(tx, r);
+        }
+    }
+    // 在等旧 fd EPOLLOUT 的 tcp_client 断了:旧 fd 已关,不会再有事件。
+    // 已重连就直接改到新 fd;还没连上则按 offline_cap 停泊或丢弃
+    for (int i = 0; tx->dialer_n > 0 && tx->armed_n > 0 && i < MAX_PORTS; i++) {
+        tx_ring_t* r = tx->slot[i];
+        if (!r || !r->dialer || !r->armed) continue;
+        const port_def_t* p = port_from_handle(r->h);
+        if (!p) {
+            ring_reset(tx, r, 0);
+            continue;
+        }
+        if (r->epoch == atomic_load_explicit(&p->base.link_epoch, memory_order_acquire) &&
+            port_link_up(p))
+            continue;
+        if (port_link_up(p)) {
+            int was_over = r->over;
+            ring_relink(tx, r, p);
+            if (r->len > 0) ring_flush(tx, r);
+            ring_watermark(tx, r);
+            if (was_over && !r->over) resumed++;
+        } else if (r->offline_cap > 0) {
+            ring_park(tx, r, 0);
+        } else {
+            int was_over = r->over;
+            ring_reset(tx, r, 0);
+            if (was_over) resumed++;
+        }
+    }
+    // 停泊的环:tcp_client 重连上了就改到新 fd 接着写
+    for (int i = 0; tx->parked_n > 0 && i < MAX_PORTS; i++) {
+        tx_ring_t* r = tx->slot[i];
+        if (!r || !r->parked) continue;
+        const port_def_t* p = port_from_handle(r->h);
+        if (!p) {
+            ring_reset(tx, r, 0);
+            continue;
+        }
+        if (!port_link_up(p)) continue;
+        int was_over = r->over;
+        ring_relink(tx, r, p);
+        if (r->len > 0) ring_flush(tx, r);
+        ring_watermark(tx, r);
+        if (was_over && !r->over) resumed++;
+    }
+    // 完全卡住的 client 没有 EPOLLOUT,也可能没有新消息,到期检查放在这里
+    for (int i = 0; tx->lag_n > 0 && i < MAX_PORTS; i++) {
+        tx_ring_t* r = tx->slot[i];
+        if (!r || !r->lag_since) continue;
+        if (!port_from_handle(r->h))
+            ring_reset(tx, r, 0);
+        else
+            slow_check(tx, r);
+    }
+    return resumed;
+}
+
+int port_tx_timeout_ms(port_tx_t* tx)
+{
+    int relink = tx && (tx->parked_n > 0 || (tx->dialer_n > 0 && tx->armed_n > 0));
+    if (!tx || (tx->lag_n == 0 && !relink)) return -1;
+    uint64_t now = now_ns();
+    int64_t best = relink ? PORT_TX_RELINK_MS : -1;
+    for (int i = 0; i < MAX_PORTS; i++) {
+        const tx_ring_t* r = tx->slot[i];
+        if (!r || !r->lag_since || r->degraded || r->evicted) continue;
+        uint64_t due = r->lag_since + (uint64_t)r->sc->grace_ms * 1000000ull;
+        int64_t ms = due > now ? (int64_t)((due - now + 999999) / 1000000) : 1;
+        if (best < 0 || ms < best) best = ms;
+    }
+    return (int)best;
+}
+
+int port_tx_get_stats(int port_id, port_tx_stats_t* out)
+{
+    tx_counter_t* c = cnt_of(port_id);
+    if (!c || !out) return -1;
+    out->queued_bytes   = atomic_load_explicit(&c->queued_bytes, memory_order_relaxed);
+    out->queued_max     = atomic_load_explicit(&c->queued_max, memory_order_relaxed);
+    out->short_writes   = atomic_load_explicit(&c->short_writes, memory_order_relaxed);
+    out->flushes        = atomic_load_explicit(&c->flushes, memory_order_relaxed);
+    out->overflow_drops = atomic_load_explicit(&c->overflow_drops, memory_order_relaxed);
+    out->overflow_bytes = atomic_load_explicit(&c->overflow_bytes, memory_order_relaxed);
+    out->errors         = atomic_load_explicit(&c->errors, memory_order_relaxed);
+    out->lag_drops      = atomic_load_explicit(&c->lag_drops, memory_order_relaxed);
+    out->lag_bytes      = atomic_load_explicit(&c->lag_bytes, memory_order_relaxed);
+    out->evictions      = atomic_load_explicit(&c->evictions, memory_order_relaxed);
+    out->downgrades     = atomic_load_explicit(&c->downgrades, memory_order_relaxed);
+    out->ref_msgs       = atomic_load_explicit(&c->ref_msgs, memory_order_relaxed);
+    out->zc_sends       = atomic_load_explicit(&c->zc_sends, memory_order_relaxed);
+    out->zc_copied      = atomic_load_explicit(&c->zc_copied, memory_order_relaxed);
+    out->offline_msgs   = atomic_load_explicit(&c->offline_msgs, memory_order_relaxed);
+    out->offline_drops  = atomic_load_explicit(&c->offline_drops, memory_order_relaxed);
+    return 0;
+}
+
+int port_tx_refs_held(void)
+{
+    return atomic_load_explicit(&g_refs_held, memory_order_relaxed);
+}
+
+int port_tx_clients(int server_id, port_tx_client_t* out, int max)
+{
+    uint64_t now = now_ns();
+    int n = 0;
+    for (int i = 0; i < MAX_PORTS && n < max; i++) {
+        tx_client_t* c = &g_client[i];
+        port_handle_t h = atomic_load_explicit(&c->h, memory_order_relaxed);
+        if (h == PORT_HANDLE_INVALID || !port_from_handle(h)) continue;
+        if (atomic_load_explicit(&c->id, memory_order_relaxed) != server_id) continue;
+        uint64_t since = atomic_load_explicit(&c->lag_since, memory_order_relaxed);
+        out[n].fd     = atomic_load_explicit(&c->fd, memory_order_relaxed);
+        out[n].queued = atomic_load_explicit(&c->queued, memory_order_relaxed);
+        out[n].lag_ms = (since && now > since) ? (unsigned long)((now - since) / 1000000) : 0;
+        n++;
+    }
+    return n;
+}
+
+void port_tx_log_stats(void)
+{
+    for (int id = 0; id < g_config.port_count && id < MAX_PORTS; id++) {
+        port_tx_stats_t s;
+        port_tx_get_stats(id, &s);
+        if (s.short_writes == 0 && s.overflow_drops == 0 && s.errors == 0 && s.zc_sends == 0 &&
+            s.offline_msgs == 0 && s.offline_drops == 0)
+            continue;
+        LOG_DEBUG("[port_tx] port=%s queued=%lu queued_max=%lu short_writes=%lu "
+                  "flushes=%lu overflow_drops=%lu overflow_bytes=%lu errors=%lu "
+                  "lag_drops=%lu lag_bytes=%lu evictions=%lu downgrades=%lu "
+                  "ref_msgs=%lu zc_sends=%lu zc_copied=%lu "
+                  "offline_msgs=%lu offline_drops=%lu\n",
+                  g_config.ports[id].base.name, s.queued_bytes, s.queued_max,
+                  s.short_writes, s.flushes, s.overflow_drops, s.overflow_bytes, s.errors,
+                  s.lag_drops, s.lag_bytes, s.evictions, s.downgrades,
+                  s.ref_msgs, s.zc_sends, s.zc_copied, s.offline_msgs, s.offline_drops);
+
+        port_tx_client_t cl[MAX_PORTS];
+        int n = port_tx_clients(id, cl, MAX_PORTS);
+        for (int k = 0; k < n; k++) {
+            if (cl[k].queued == 0) continue;
+            LOG_DEBUG("[port_tx]   client fd=%d queued=%lu lag_ms=%lu\n",
+                      cl[k].fd, cl[k].queued, cl[k].lag_ms);
+        }
+    }
+}
@@ -4,11 +4,13 @@
 //   - 纯函数,无并发 state,不 malloc,不依赖 socket / fd
 //   - LE 主机序直拷(见 protocol.h 字节序声明)
 //   - decode 零拷贝:payload_out 指向 in_buf 内部
+//   - resync 用 scan_pair 向量化找 magic 的两个字节(byte_scan.h)
 //
 // 测试: tests/unit/test_proto_codec.c (test-as-doc)
 
 #include <string.h>
 #include "protocol.h"
+#include "byte_scan.h"
 
 int proto_encode(const proto_frame_hdr_t* hdr,
                  const void* payload,
@@ -68,3 +70,24 @@ int proto_decode(const uint8_t* in_buf, size_t in_len,
     *payload_out = in_buf + PROTO_HDR_SIZE;
     return (int)total;
 }
+
+size_t proto_resync(const uint8_t* in_buf, size_t in_len)
+{
+    // magic 按 LE 落在字节流里:低字节在前
+    const uint8_t m0 = (uint8_t)(PROTO_MAGIC & 0xFF);
+    const uint8_t m1 = (uint8_t)(PROTO_MAGIC >> 8);
+
+    size_t off = 1;
+    while (off < in_len) {
+        const uint8_t* c = scan_pair(in_buf + off, in_len - off, m0, m1);
+        if (!c) break;
+        size_t pos = (size_t)(c - in_buf);
+        // version 字节还没到就先当候选;到了但不对,是 payload 里碰巧出现的 magic
+        if (pos + 2 >= in_len || in_buf[pos + 2] == PROTO_VERSION)
+            return pos;
+        off = pos + 1;
+    }
+    if (in_len > 1 && in_buf[in_len - 1] == m0)
+        return in_len - 1;
+    return in_len;
+}
@@ -1,17 +1,31 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE   // splice / pipe2
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <fcntl.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <time.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <sys/uio.h>
+#include <poll.h>
 
 #include "reactor.h"
 #include "event_queue.h"
+#include "dispatch_pool.h"
+#include "buf_pool.h"
+#include "route_table.h"
 #include "event.h"
 #include "port_map.h"
 // #include "ipc_server.h"
@@ -19,19 +33,322 @@
 #include "plugin_loader.h"
 #include "log.h"
 #include "run_state.h"
+#include "uring.h"
+#include "frame.h"
 
-static int epfd = -1;
 static int reactor_fds[MAX_REACT_FDS];
 
-// 初始化 reactor
-void reactor_init(void)
+// ============================================
+// 多 reactor:每个 reactor 一个 epoll + 一个线程,端口按 base.reactor 分片。
+// 端口只在自己的 reactor 上读,所以它的路由总是写目的端口的同一条 lane(q[id]),
+// 每条 lane 仍是单生产者。g_reactors[] 在 reactor_init 建好后不再增删。
+// ============================================
+typedef struct {
+    int          id;
+    int          epfd;
+    int          resume_efd;
+    pthread_t    th;
+    int          started;
+
+    // backpressure:目的 lane 过高水位时停读源端口(EPOLLIN 摘掉),
+    // 低水位时 dispatcher worker 写 resume eventfd,reactor 重新挂上 EPOLLIN。
+    // paused 只在本 reactor 线程访问。
+    port_def_t*  paused[MAX_PORTS];
+    int          paused_n;
+
+    // 边沿触发下读预算用完仍有数据的端口(不会再有新边沿),下一轮接着读。
+    // 只在本 reactor 线程访问。
+    port_def_t*  more[MAX_PORTS];
+    int          more_n;
+
+    // idle 分帧有累积帧、等静默到期的端口(见 frame_*),和按其中最近到期挂的 timerfd
+    // (idle_armed 是已挂的绝对到期时刻,0 = 没挂)。只在本 reactor 线程访问
+    port_def_t*  idle[MAX_PORTS];
+    int          idle_n;
+    int          idle_tfd;
+    uint64_t     idle_armed;
+
+    // udp 大数据报(buffers.max_message > BUF_SIZE - 1):数据报先收进 BUF_SIZE 的池缓冲,
+    // 超出的部分落进这里的第 k 段(每段 udp_spill_seg 字节),再拼进放得下的池缓冲。
+    // 首次用到时分配。只在本 reactor 线程访问
+    uint8_t*     udp_spill;
+    int          udp_spill_seg;
+
+    // io_uring 后端(g_uring 时):环、provided buffer ring 与 buffer id → 池缓冲。
+    // arm 是待挂读 / accept 的端口(reactor_watch 填,本线程取),用 reactor_lock 保护。
+    uring_t      ring;
+    uring_pbuf_t pbuf;
+    buf_t*       bid_buf[REACTOR_URING_BUFS];
+    int          bid_missing;            // 池耗尽没补上的槽数
+    port_def_t*  arm[MAX_PORTS * 2];
+    int          arm_n;
+    struct __kernel_timespec retry_ts;
+
+    // tcp_client 连接 / 重连(见 dial_*):本 reactor 上没连上的个数,
+    // io_uring 后端挂着的重连定时器到期时刻(0 = 没挂)。只在本 reactor 线程访问
+    int          dial_n;
+    unsigned     dial_seed;
+    uint64_t     dial_due;
+    struct __kernel_timespec dial_ts;
+
+    // 循环统计:本线程写,stats 任意线程读
+    atomic_int   ports;
+    atomic_ulong wakeups;
+    atomic_ulong events;
+    atomic_uint  max_events;
+    atomic_ulong busy_ns;
+} reactor_t;
+
+static reactor_t  g_reactors[REACTOR_MAX_THREADS];
+static int        g_reactor_count = 0;
+static int        g_edge = 1;              // 数据端口 EPOLLET;listener 始终水平触发
+static int        g_uring = 0;             // 1 = io_uring 后端(reactor_init 探测通过)
+static port_def_t resume_marker;           // epoll data.ptr 哨兵,区分 resume eventfd
+static port_def_t dial_marker;             // io_uring 重连定时器的 user_data 哨兵
+static port_def_t idle_marker;             // idle 分帧 timerfd 的 epoll data.ptr / user_data 哨兵
+
+// io_uring 后端的 user_data = 指针 | 低 2 位标签(见下方 io_uring 后端)
+#define URING_TAG_READ   0u
+#define URING_TAG_ACCEPT 1u
+#define URING_TAG_POLL   2u
+#define URING_TAG_IGNORE 3u      // cancel / 重试定时器,CQE 只需收割
+#define URING_TAG_MASK   3u
+#define URING_BGID       0
+
+static uint64_t uring_ud(void* p, unsigned tag)
 {
-    epfd = epoll_create(64);
-    if (epfd < 0) {
-        LOG_WARN("[reactor] epoll_create failed\n");
-        return;
+    return (uint64_t)(uintptr_t)p | tag;
+}
+
+// 每端口(按 g_config.ports 下标,accept 出的 client 计入其 server)的读计数。
+// 同一 server 的 client 可能在不同 reactor 上,所以用原子加。
+typedef struct {
+    atomic_ulong wakeups;   // 就绪后进入读循环的次数
+    atomic_ulong reads;     // 读系统调用次数(含以 EAGAIN 结束的那次)
+    atomic_ulong bytes;
+    atomic_ulong msgs;      // 切出的消息数(每条 <= buffers.max_message 字节;分帧端口 = 帧数)
+    atomic_ulong spliced;       // splice 直通写到目的的字节
+    atomic_ulong splice_drops;  // splice 直通时目的已断开 / 写出错丢弃的字节
+    atomic_ulong connects;      // tcp_client 连上的次数
+    atomic_ulong reconnects;    // 其中断开 / 失败之后重新连上的次数
+    atomic_ulong connect_fails; // connect 失败 / 超时次数
+    atomic_ulong connect_us_last;
+    atomic_ulong connect_us_max;
+    atomic_ulong connect_us_sum;
+    atomic_ulong dgram_drops;   // udp:超过 buffers.max_message 被截断而丢弃的数据报
+    atomic_ulong frame_drops;   // 分帧:超长 / 编码错误 / 池耗尽丢弃的帧
+    atomic_ulong gap_frames;    // idle 分帧:静默到期出的帧(下面延迟的样本数)
+    atomic_ulong gap_late_us_last;  // 到期 → 出帧的延迟
+    atomic_ulong gap_late_us_max;
+    atomic_ulong gap_late_us_sum;
+    atomic_ulong short_gaps;    // 见 frame_rx_t
+    atomic_ulong early_splits;
+} rx_counter_t;
+
+static rx_counter_t g_rx[MAX_PORTS];
+
+static reactor_t* reactor_of(const port_def_t* port)
+{
+    int k = port->base.reactor;
+    if (k < 0 || k >= g_reactor_count) k = 0;
+    return &g_reactors[k];
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int uring_setup(reactor_t* rc);
+
+// 初始化 reactor:建 threads 个 epoll,并把配置端口分到各 reactor
+// ("reactor": N 显式指定,否则按端口序号轮转)。须在 load_config 之后调用。
+void reactor_init(int threads)
+{
+    g_edge = g_config.reactor_edge;
+    g_uring = 0;
+    if (g_config.reactor_backend == REACTOR_BACKEND_URING) {
+        if (uring_probe()) {
+            g_uring = 1;
+        } else {
+            LOG_WARN("[reactor] io_uring unavailable, falling back to epoll\n");
+            g_config.reactor_backend = REACTOR_BACKEND_EPOLL;   // router_core 跟着走同步发送
+        }
+    }
+    memset(g_rx, 0, sizeof(g_rx));
+    if (threads < 1) threads = 1;
+    if (threads > REACTOR_MAX_THREADS) threads = REACTOR_MAX_THREADS;
+
+    g_reactor_count = 0;
+    for (int k = 0; k < threads; k++) {
+        reactor_t* rc = &g_reactors[k];
+        memset(rc, 0, sizeof(*rc));
+        rc->id = k;
+        rc->dial_seed = (unsigned)now_ns() ^ (unsigned)(k * 2654435761u);
+        rc->epfd = epoll_create(64);
+        if (rc->epfd < 0) {
+            LOG_WARN("[reactor] %d: epoll_create failed\n", k);
+            break;
+        }
+
+        rc->resume_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (rc->resume_efd >= 0) {
+            struct epoll_event ev = {.events = EPOLLIN, .data.ptr = &resume_marker};
+            epoll_ctl(rc->epfd, EPOLL_CTL_ADD, rc->resume_efd, &ev);
+        } else {
+            LOG_WARN("[reactor] %d: resume eventfd failed, backpressure routes fall back to drop\n", k);
+        }
+        rc->idle_tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (rc->idle_tfd >= 0) {
+            struct epoll_event ev = {.events = EPOLLIN, .data.ptr = &idle_marker};
+            epoll_ctl(rc->epfd, EPOLL_CTL_ADD, rc->idle_tfd, &ev);
+        } else {
+            LOG_WARN("[reactor] %d: timerfd failed, idle framing falls back to ms timeouts\n", k);
+        }
+        if (g_uring && uring_setup(rc) < 0) {
+            // 探测通过但这个 reactor 建环失败(内存 / 限额):整体回退,不混用后端
+            LOG_WARN("[reactor] %d: io_uring setup failed, falling back to epoll\n", k);
+            for (int j = 0; j <= k; j++) {
+                uring_pbuf_exit(&g_reactors[j].ring, &g_reactors[j].pbuf);
+                uring_exit(&g_reactors[j].ring);
+            }
+            g_uring = 0;
+            g_config.reactor_backend = REACTOR_BACKEND_EPOLL;
+        }
+        g_reactor_count++;
+    }
+    if (g_reactor_count == 0) return;
+
+    int rr = 0;
+    for (int i = 0; i < g_config.port_count; i++) {
+        port_def_t* p = &g_config.ports[i];
+        if (p->base.reactor >= g_reactor_count) {
+            LOG_WARN("[reactor] %s: reactor %d >= threads %d, using %d\n", p->base.name,
+                     p->base.reactor, g_reactor_count, p->base.reactor % g_reactor_count);
+            p->base.reactor %= g_reactor_count;
+        } else if (p->base.reactor < 0) {
+            p->base.reactor = rr++ % g_reactor_count;
+        }
+    }
+    if (g_uring && g_config.max_message > MAX_DATA - 1) {
+        // provided buffer 固定 BUF_SIZE 档(uring_refill):不分帧的字节流源一条 CQE
+        // 最多 MAX_DATA-1 字节,长记录会被切开。分帧端口跨 CQE 拼回,udp 走 recvmmsg
+        for (int r = 0; r < g_config.route_count; r++) {
+            port_def_t* p = config_find_port(g_config.routes[r].src);
+            if (!p || p->base.type == PORT_UDP || p->base.frame.mode != FRAME_NONE) continue;
+            int seen = 0;   // 同一个源只提示一次
+            for (int q = 0; q < r && !seen; q++)
+                seen = strcmp(g_config.routes[q].src, g_config.routes[r].src) == 0;
+            if (seen) continue;
+            LOG_WARN("[reactor] %s: io_uring reads unframed streams in %d-byte pieces, "
+                     "use a frame block or the epoll backend for %d-byte messages\n",
+                     p->base.name, MAX_DATA - 1, g_config.max_message);
+        }
+    }
+    if (g_uring)
+        LOG_INFO("[reactor] init ok, %d thread(s), io_uring backend\n", g_reactor_count);
+    else
+        LOG_INFO("[reactor] init ok, %d thread(s), epoll %s-triggered reads\n",
+                 g_reactor_count, g_edge ? "edge" : "level");
+}
+
+static int is_listener(const port_def_t* port)
+{
+    return port->base.type == PORT_TCP_SERVER || port->base.type == PORT_IPC_SERVER;
+}
+
+// 挂 epoll 用的事件掩码。listener 一次就绪只 accept 一个,保持水平触发。
+static uint32_t rx_events(const port_def_t* port)
+{
+    return EPOLLIN | ((g_edge && !is_listener(port)) ? EPOLLET : 0);
+}
+
+// 把 backpressure 路由在本 reactor 的目的 lane 接到本 reactor 的 resume eventfd
+// (reactor 线程启动时一次)。lane k 只有 reactor k 写,所以只有它需要被通知。
+static void bp_init(reactor_t* rc)
+{
+    for (int id = 0; id < g_config.port_count; id++) {
+        const route_src_t* rs = route_table_for_src(id);
+        for (int j = 0; rs && j < rs->n; j++) {
+            if (rs->e[j].policy == ROUTE_POLICY_BACKPRESSURE && rs->e[j].q[rc->id])
+                queue_set_resume_fd(rs->e[j].q[rc->id], rc->resume_efd);
+        }
+    }
+}
+
+// 源端口的任一 backpressure 目的 lane 在高水位以上 → 1
+static int bp_blocked(reactor_t* rc, const route_src_t* rs)
+{
+    if (rc->resume_efd < 0) return 0;
+    for (int j = 0; j < rs->n; j++) {
+        if (rs->e[j].policy == ROUTE_POLICY_BACKPRESSURE &&
+            queue_over_high_watermark(rs->e[j].q[rc->id]))
+            return 1;
+    }
+    return 0;
+}
+
+static int bp_is_paused(reactor_t* rc, const port_def_t* port)
+{
+    for (int k = 0; k < rc->paused_n; k++) {
+        if (rc->paused[k] == port) return 1;
+    }
+    return 0;
+}
+
+static void uring_cancel_read(reactor_t* rc, port_def_t* port);
+static void uring_arm(reactor_t* rc, port_def_t* port);
+
+static void bp_pause(reactor_t* rc, port_def_t* port)
+{
+    if (g_uring) {
+        // 在途的 multishot 读取消掉;取消完成前已读到的数据照常 fan-out
+        if (port->base.rx_armed) uring_cancel_read(rc, port);
+    } else {
+        // events = 0:不再报 EPOLLIN,EPOLLHUP / EPOLLERR 仍会报,断开照常清理
+        struct epoll_event ev = {.events = 0, .data.ptr = port};
+        epoll_ctl(rc->epfd, EPOLL_CTL_MOD, port->base.fd, &ev);
+    }
+    if (bp_is_paused(rc, port)) return;
+    if (rc->paused_n < MAX_PORTS) rc->paused[rc->paused_n++] = port;
+    LOG_INFO("[reactor] backpressure: pause %s fd=%d\n", port->base.name, port->base.fd);
+}
+
+static void bp_forget(reactor_t* rc, port_def_t* port)
+{
+    for (int k = 0; k < rc->paused_n; k++) {
+        if (rc->paused[k] == port) {
+            rc->paused[k] = rc->paused[--rc->paused_n];
+            return;
+        }
+    }
+}
+
+// resume eventfd 可读:重检所有暂停的源端口,目的 lane 都降下来的恢复读
+static void bp_resume(reactor_t* rc)
+{
+    uint64_t v;
+    (void)!read(rc->resume_efd, &v, sizeof(v));
+
+    for (int k = 0; k < rc->paused_n; ) {
+        port_def_t* port = rc->paused[k];
+        if (bp_blocked(rc, route_table_for_src(port->base.id))) {
+            k++;
+            continue;
+        }
+        if (g_uring) {
+            // 取消还没完成时不重挂,等它的最后一个 CQE(见 uring_on_read)
+            if (!port->base.rx_armed) uring_arm(rc, port);
+        } else {
+            // EPOLL_CTL_MOD 会重查就绪状态,边沿触发下暂停期间积压的数据也会报上来
+            struct epoll_event ev = {.events = rx_events(port), .data.ptr = port};
+            epoll_ctl(rc->epfd, EPOLL_CTL_MOD, port->base.fd, &ev);
+        }
+        LOG_INFO("[reactor] backpressure: resume %s fd=%d\n", port->base.name, port->base.fd);
+        rc->paused[k] = rc->paused[--rc->paused_n];
     }
-    LOG_INFO("[reactor] init ok\n");
 }
 
 // 根据 port 打开 fd 并注册
@@ -54,17 +371,1221 @@ void reactor_clear_all_ports(void)
     LOG_INFO("[reactor] all ports cleared\n");
 }
 
-void* reactor_thread(void* arg)
+static void more_add(reactor_t* rc, port_def_t* port)
+{
+    for (int k = 0; k < rc->more_n; k++) {
+        if (rc->more[k] == port) return;
+    }
+    if (rc->more_n < MAX_PORTS) rc->more[rc->more_n++] = port;
+}
+
+static void more_forget(reactor_t* rc, port_def_t* port)
+{
+    for (int k = 0; k < rc->more_n; k++) {
+        if (rc->more[k] == port) {
+            rc->more[k] = rc->more[--rc->more_n];
+            return;
+        }
+    }
+}
+
+static rx_counter_t* rx_of(const port_def_t* port)
+{
+    int id = port->base.id;
+    return (id >= 0 && id < MAX_PORTS) ? &g_rx[id] : NULL;
+}
+
+static void splice_forget(reactor_t* rc, port_def_t* port);
+static void frame_forget(reactor_t* rc, port_def_t* port);
+
+// ============================================
+// tcp_client 非阻塞连接与断线重连
+//
+// 配置里的 tcp_client(g_config.ports 元素)整个进程期间占着同一个句柄,连接来来去去:
+//   - connect 非阻塞发起(port_open_tcp_client),fd 先只等可写(epoll 挂 EPOLLOUT,
+//     io_uring 挂 POLL_ADD)。可写时 SO_ERROR 为 0 且 getpeername 成功才算连上,
+//     之后改挂读,fd 去掉 O_NONBLOCK(读写都按调用带 MSG_DONTWAIT,语义同以前)
+//   - 连接失败 / connect_timeout_ms 没完成 / 连上后读到 EOF 或出错:关 fd,句柄不注销,
+//     按 port_reconnect_delay_ms 抖动指数退避后重连,连上后退避清零
+//   - base.link / link_epoch 发布给 dispatch worker:断开期间发送引擎按 buffer_bytes
+//     缓存或丢弃,重连后把缓存按序发到新 fd(port_tx.h)
+// 到期检查:epoll 后端算进 epoll_wait 的超时,io_uring 后端挂 IORING_OP_TIMEOUT。
+// 状态只在端口所属的 reactor 线程读写(启动阶段的 reactor_add_port 在线程起来之前)。
+// ============================================
+typedef struct {
+    int      attempt;    // 连续失败次数,连上清零
+    int      ever_up;    // 连上过:之后每次连上计一次 reconnect
+    uint64_t start_ns;   // 本次 connect 发起时刻
+    uint64_t due_ns;     // CONNECTING:超时时刻;DOWN:下次重连时刻
+} dial_t;
+
+static dial_t g_dial[MAX_PORTS];   // 按 g_config.ports 下标
+
+static int is_dialer(const port_def_t* port)
+{
+    return port->base.type == PORT_TCP_CLIENT && port->base.id >= 0 &&
+           port->base.id < MAX_PORTS && port == &g_config.ports[port->base.id];
+}
+
+static int link_of(const port_def_t* port)
+{
+    return atomic_load_explicit(&port->base.link, memory_order_relaxed);
+}
+
+static void link_set(port_def_t* port, int st)
+{
+    atomic_store_explicit(&port->base.link, st, memory_order_release);
+}
+
+// 已发起 connect 的 fd 开始等完成
+static void dial_watch(reactor_t* rc, port_def_t* port)
+{
+    dial_t* d = &g_dial[port->base.id];
+    d->start_ns = now_ns();
+    d->due_ns   = d->start_ns + (uint64_t)port->cfg.tcp_client.connect_timeout_ms * 1000000ull;
+    link_set(port, PORT_LINK_CONNECTING);
+    if (g_uring) {
+        // SQ 只由 reactor 线程写:排进 arm,下一轮由 uring_arm 挂 POLL_ADD
+        reactor_lock();
+        if (rc->arm_n < (int)(sizeof(rc->arm) / sizeof(rc->arm[0])))
+            rc->arm[rc->arm_n++] = port;
+        reactor_unlock();
+        return;
+    }
+    struct epoll_event ev = {.events = EPOLLOUT, .data.ptr = port};
+    epoll_ctl(rc->epfd, EPOLL_CTL_ADD, port->base.fd, &ev);
+}
+
+// 摘掉并关闭当前 fd。先发布 DOWN,worker 不再往这个 fd 写
+static void dial_close(reactor_t* rc, port_def_t* port)
+{
+    int was = link_of(port);
+    link_set(port, PORT_LINK_DOWN);
+    if (port->base.fd < 0) return;
+    if (!g_uring) {
+        epoll_ctl(rc->epfd, EPOLL_CTL_DEL, port->base.fd, NULL);
+    } else if (was == PORT_LINK_CONNECTING) {
+        // 在途的 POLL_ADD 持有文件引用,close 不会让它结束
+        struct io_uring_sqe* sqe = uring_get_sqe(&rc->ring);
+        if (sqe) {
+            sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+            sqe->addr      = uring_ud(port, URING_TAG_POLL);
+            sqe->user_data = uring_ud(NULL, URING_TAG_IGNORE);
+        }
+    }
+    port_retire(NULL, port->base.fd);   // worker 可能还在写旧 fd,号码不能马上被重连复用
+    port->base.fd = -1;
+}
+
+// 排下一次重连,返回等待 ms
+static int dial_backoff(reactor_t* rc, port_def_t* port)
+{
+    dial_t* d = &g_dial[port->base.id];
+    int ms = port_reconnect_delay_ms(&port->cfg.tcp_client, d->attempt, (unsigned)rand_r(&rc->dial_seed));
+    if (d->attempt < 30) d->attempt++;
+    d->due_ns = now_ns() + (uint64_t)ms * 1000000ull;
+    return ms;
+}
+
+static void dial_fail(reactor_t* rc, port_def_t* port, int err)
+{
+    rx_counter_t* rx = rx_of(port);
+    if (rx) atomic_fetch_add_explicit(&rx->connect_fails, 1, memory_order_relaxed);
+    dial_close(rc, port);
+    int ms = dial_backoff(rc, port);
+    LOG_WARN("[reactor] %s: connect %s:%d failed (%s), retry in %d ms\n", port->base.name,
+             port->cfg.tcp_client.addr, port->cfg.tcp_client.port, strerror(err), ms);
+}
+
+// 发起一次连接(启动时 fd 已由 ports_open_all 打开)
+static void dial_start(reactor_t* rc, port_def_t* port)
+{
+    if (port->base.fd < 0) port->base.fd = port_open_tcp_client(port);
+    if (port->base.fd < 0) {
+        dial_fail(rc, port, errno);
+        return;
+    }
+    dial_watch(rc, port);
+}
+
+static void dial_up(reactor_t* rc, port_def_t* port)
+{
+    dial_t* d = &g_dial[port->base.id];
+    unsigned long us = (unsigned long)((now_ns() - d->start_ns) / 1000);
+    rx_counter_t* rx = rx_of(port);
+    if (rx) {
+        atomic_fetch_add_explicit(&rx->connects, 1, memory_order_relaxed);
+        if (d->ever_up) atomic_fetch_add_explicit(&rx->reconnects, 1, memory_order_relaxed);
+        atomic_store_explicit(&rx->connect_us_last, us, memory_order_relaxed);
+        atomic_fetch_add_explicit(&rx->connect_us_sum, us, memory_order_relaxed);
+        if (us > atomic_load_explicit(&rx->connect_us_max, memory_order_relaxed))
+            atomic_store_explicit(&rx->connect_us_max, us, memory_order_relaxed);
+    }
+    LOG_INFO("[reactor] %s: %sconnected to %s:%d fd=%d in %lu us\n", port->base.name,
+             d->ever_up ? "re" : "", port->cfg.tcp_client.addr, port->cfg.tcp_client.port,
+             port->base.fd, us);
+    d->ever_up = 1;
+    d->attempt = 0;
+    rc->dial_n--;
+
+    int fl = fcntl(port->base.fd, F_GETFL);
+    if (fl >= 0) fcntl(port->base.fd, F_SETFL, fl & ~O_NONBLOCK);
+    port->base.rx_segs = 0;
+    port->base.rx_cap  = 0;
+    // epoch 在 UP 之前发布:worker 看到 UP 时一定看到新 fd 和新 epoch
+    atomic_fetch_add_explicit(&port->base.link_epoch, 1, memory_order_relaxed);
+    link_set(port, PORT_LINK_UP);
+
+    if (g_uring) {
+        uring_arm(rc, port);
+        return;
+    }
+    // MOD 会重查就绪状态,连上之后立刻到的数据也会报上来
+    struct epoll_event ev = {.events = rx_events(port), .data.ptr = port};
+    epoll_ctl(rc->epfd, EPOLL_CTL_MOD, port->base.fd, &ev);
+}
+
+// 等连接的 fd 有事件(EPOLLOUT / ERR / HUP)
+static void dial_on_ready(reactor_t* rc, port_def_t* port, uint32_t events)
+{
+    if (link_of(port) != PORT_LINK_CONNECTING) return;   // 已超时放弃的过期完成
+    int err = 0;
+    socklen_t el = sizeof(err);
+    if (getsockopt(port->base.fd, SOL_SOCKET, SO_ERROR, &err, &el) < 0) err = errno;
+    if (err == 0) {
+        struct sockaddr_storage ss;
+        socklen_t sl = sizeof(ss);
+        if (getpeername(port->base.fd, (struct sockaddr*)&ss, &sl) < 0) {
+            if (!(events & (EPOLLERR | EPOLLHUP))) {   // 还在连
+                if (g_uring) uring_arm(rc, port);
+                return;
+            }
+            err = ENOTCONN;
+        }
+    }
+    if (err) {
+        dial_fail(rc, port, err);
+        return;
+    }
+    dial_up(rc, port);
+}
+
+// 连上的 tcp_client 断开:清掉读侧状态,句柄保留,退避后重连
+static void dial_lost(reactor_t* rc, port_def_t* port)
+{
+    LOG_WARN("[reactor] %s fd=%d: connection lost\n", port->base.name, port->base.fd);
+    splice_forget(rc, port);
+    frame_forget(rc, port);
+    bp_forget(rc, port);
+    more_forget(rc, port);
+    dial_close(rc, port);
+    rc->dial_n++;
+    int ms = dial_backoff(rc, port);
+    LOG_INFO("[reactor] %s: reconnect in %d ms\n", port->base.name, ms);
+}
+
+// 处理到期的连接超时 / 重连。返回距下一个到期还有多少 ms,-1 = 没有待办
+static int dial_tick(reactor_t* rc)
+{
+    if (rc->dial_n == 0) return -1;
+    uint64_t now = now_ns();
+    int64_t best = -1;
+    for (int id = 0; id < g_config.port_count && id < MAX_PORTS; id++) {
+        port_def_t* port = &g_config.ports[id];
+        if (port->base.type != PORT_TCP_CLIENT || reactor_of(port) != rc) continue;
+        int st = link_of(port);
+        if (st == PORT_LINK_UP) continue;
+        dial_t* d = &g_dial[id];
+        if (now >= d->due_ns) {
+            if (st == PORT_LINK_CONNECTING)
+                dial_fail(rc, port, ETIMEDOUT);
+            else
+                dial_start(rc, port);
+            now = now_ns();
+        }
+        int64_t ms = d->due_ns > now ? (int64_t)((d->due_ns - now + 999999) / 1000000) : 0;
+        if (best < 0 || ms < best) best = ms;
+    }
+    return (int)best;
+}
+
+// 启动时登记配置里的 tcp_client:fd 已在连(ports_open_all)就等完成,否则排重连
+static void dial_begin(reactor_t* rc, port_def_t* port)
+{
+    atomic_fetch_add_explicit(&rc->ports, 1, memory_order_relaxed);
+    rc->dial_n++;
+    if (port->base.fd >= 0) {
+        dial_watch(rc, port);
+    } else {
+        link_set(port, PORT_LINK_DOWN);
+        g_dial[port->base.id].due_ns = now_ns();
+    }
+}
+
+// 对端关闭 / 读错误:摘 epoll、关 fd、注销句柄(队列里指向它的消息随之失效),
+// 释放 accept 出来的客户端。配置里的 tcp_client 不注销,退避后重连(dial_lost)。
+static void port_close(reactor_t* rc, port_def_t* port)
+{
+    if (is_dialer(port)) {
+        dial_lost(rc, port);
+        return;
+    }
+    int fd = port->base.fd;
+    LOG_INFO("[reactor] fd=%d closed\n", fd);
+    epoll_ctl(rc->epfd, EPOLL_CTL_DEL, fd, NULL);
+    atomic_fetch_sub_explicit(&rc->ports, 1, memory_order_relaxed);
+
+    splice_forget(rc, port);
+    frame_forget(rc, port);
+    port_unregister(port->base.handle);
+    bp_forget(rc, port);
+    more_forget(rc, port);
+    // dispatch worker 可能刚从句柄解析出它、正在写:fd 和 accept 出的 client
+    // 交给 port_retire,等 worker 都离开当前一轮再关 / 释放
+    int owned = (port->base.type == PORT_TCP_CLIENT || port->base.type == PORT_IPC_CLIENT) &&
+                port->base.id >= 0 && port != &g_config.ports[port->base.id];
+    port_retire(owned ? port : NULL, fd);
+}
+
+// 一条消息(raw 的前 len 字节)按源端口的路由 fan-out 入队。消耗 reactor 对 raw 的引用。
+static void route_fanout(reactor_t* rc, port_def_t* port, const route_src_t* rs,
+                         buf_t* raw, int len)
+{
+    int rn = rs->n;
+    LOG_INFO("[reactor] recv from %s fd=%d len=%d\n",
+       port->base.name, port->base.fd, len);
+    LOG_INFO("[reactor] data: %d ,%s\n", len, raw->data);
+    LOG_INFO("find routes counte=%d\n",rn);
+
+    // raw 上 reactor 自己持有一个引用。无 handler 的路由 buf_ref 共享它;
+    // v1 handler 的路由要改写数据 → copy-on-write 拿私有副本,
+    // 只有最后一条路由且没有别人持有 raw 时才就地改写(把 reactor 的引用转交);
+    // v2 handler 从 raw 读、写进自己的输出缓冲,不需要副本。
+    int raw_ref_given = 0;
+    for (int j = 0; j < rn; j++) {
+        const route_entry_t* e = &rs->e[j];
+        const route_def_t* r = e->def;
+
+        // 每个目的端口每个 reactor 一条 lane,满只影响该目的端口
+        event_queue_t* q = e->q[rc->id];
+        // block:满时最多等 QUEUE_PUSH_TIMEOUT_MS;drop / backpressure:满即丢
+        // (backpressure 在高水位就停读,正常到不了满)
+        event_msg_t* slot = (e->policy == ROUTE_POLICY_BLOCK) ? queue_reserve(q)
+                                                             : queue_try_reserve(q);
+        if (!slot) continue;   // 已计 drop,槽位不 commit
+
+        plugin_handler_t handler = e->handler;
+        buf_t* out = raw;
+        int data_len = len;
+        if (e->handler_v2) {
+            // v2:raw 只读,输出直接写进新池缓冲(入队的就是它),raw 的引用不动
+            int limit = g_config.max_message > MAX_DATA ? g_config.max_message : MAX_DATA;
+            out = plugin_call_v2(e->handler_v2, r->handler, raw->data, len, limit, &data_len);
+            if (!out) continue;
+        } else if (handler) {
+            // handler 可以把消息改长到 MAX_DATA(v1 契约),副本至少给这么大
+            int room = len > MAX_DATA ? len : MAX_DATA;
+            if (j < rn - 1 || buf_refcnt(raw) > 1) {
+                out = buf_alloc(room);
+                if (!out) {
+                    LOG_WARN("[reactor] route %s -> %s: buf pool exhausted, drop\n",
+                             r->src, r->dst);
+                    continue;
+                }
+                memcpy(out->data, raw->data, len);
+            }
+            data_len = handler(out->data, len);
+
+            // 契约 5 (PROJECT_CONTEXT v2 / design-intent.md §4):
+            // handler 就地写缓冲,保证可写 max(len, MAX_DATA) 字节(池缓冲最小一档就是
+            // MAX_DATA,大消息的缓冲至少 len)。返回超过它会越界,返回 <0 不是约定的
+            // 有效长度。这里夹住,而不是 trust。
+            if (data_len < 0) {
+                LOG_WARN("[reactor] plugin %s returned %d, drop\n",
+                         r->handler, data_len);
+                if (out != raw) buf_unref(out);
+                continue;
+            }
+            if (data_len > room) {
+                LOG_WARN("[reactor] plugin %s returned %d > %d, truncated\n",
+                         r->handler, data_len, room);
+                data_len = room;
+            }
+            if (out == raw) raw_ref_given = 1;
+        } else {
+            buf_ref(raw);
+        }
+
+        slot->dst  = g_config.ports[e->dst_id].base.handle;   // 发送时校验 generation
+        slot->buf  = out;
+        slot->data = out->data;
+        slot->len  = data_len;
+        queue_commit(q);
+
+        LOG_INFO("Route: %s -> %s, push message to queue\n", r->src, r->dst);
+    }
+    if (!raw_ref_given) buf_unref(raw);
+}
+
+// 非阻塞读:socket 用 MSG_DONTWAIT(不改 fd 的阻塞属性,worker 的发送语义不变),
+// tty / usb 在 open 时已是 O_NONBLOCK。
+static ssize_t rx_readv(const port_def_t* port, struct iovec* iov, int cnt)
+{
+    switch (port->base.type) {
+    case PORT_TCP_CLIENT:
+    case PORT_IPC_CLIENT: {
+        struct msghdr mh;
+        memset(&mh, 0, sizeof(mh));
+        mh.msg_iov    = iov;
+        mh.msg_iovlen = (size_t)cnt;
+        return recvmsg(port->base.fd, &mh, MSG_DONTWAIT);
+    }
+    default:
+        return readv(port->base.fd, iov, cnt);
+    }
+}
+
+// ============================================
+// 收方向分帧(frame.h):配置了 frame 的字节流端口,读到的每段字节先过增量分帧,
+// 每个完整帧路由一次。两个后端共用(rx_deliver)。
+//   - 半帧跨读留在 base.frame_rx:首次读时分配,断开(port_close / dial_lost)时释放,
+//     重连后从空状态开始,旧连接的半帧不会拼到新连接上
+//   - 整帧正好是读缓冲的开头、且这段输入已用完:读缓冲原样交给路由,不拷贝;
+//     其余帧各拷进一个池缓冲
+//   - idle / modbus_rtu 模式:有累积帧的端口进 rc->idle;每次读后把本 reactor 的 timerfd
+//     按绝对时刻挂到这些端口里最近的静默到期(us 级,不受 epoll_wait 的 ms 超时和
+//     timer slack 影响;两个后端都把 timerfd 当普通可读 fd 等),到期由 idle_tick 出帧并
+//     记下到期 → 出帧的延迟;下一次读发现已过期也先出帧。timerfd 建不起来时退回把
+//     到期算进 epoll_wait 超时 / io_uring 定时器(ms 粒度)
+//   - 池耗尽丢了一段输入:当前半帧作废,下一个帧边界重新同步(frame_rx_gap)
+// ============================================
+static frame_rx_t* frame_rx_get(port_def_t* port, const port_frame_t* fc)
 {
-    struct epoll_event evs[16];
-    printf("[reactor] thread started\n");
+    if (!fc) return NULL;
+    if (!port->base.frame_rx) {
+        port->base.frame_rx = calloc(1, sizeof(frame_rx_t));
+        if (!port->base.frame_rx)
+            LOG_WARN("[reactor] %s: no memory for frame state, forwarded as read\n",
+                     port->base.name);
+    }
+    return port->base.frame_rx;
+}
+
+static void idle_add(reactor_t* rc, port_def_t* port)
+{
+    for (int k = 0; k < rc->idle_n; k++) {
+        if (rc->idle[k] == port) return;
+    }
+    if (rc->idle_n < MAX_PORTS) rc->idle[rc->idle_n++] = port;   // 满了就等下一次读时判过期
+}
+
+static void idle_forget(reactor_t* rc, port_def_t* port)
+{
+    for (int k = 0; k < rc->idle_n; k++) {
+        if (rc->idle[k] == port) {
+            rc->idle[k] = rc->idle[--rc->idle_n];
+            return;
+        }
+    }
+}
+
+static void idle_arm(reactor_t* rc, uint64_t due);
+
+// 读后重挂:timerfd 对准 rc->idle 里最近的静默到期
+static void idle_rearm(reactor_t* rc)
+{
+    uint64_t next = 0;
+    for (int k = 0; k < rc->idle_n; k++) {
+        const port_frame_t* fc = frame_conf_of(rc->idle[k]);
+        frame_rx_t* fr = rc->idle[k]->base.frame_rx;
+        uint64_t due = (fc && fr) ? frame_idle_due(fr, fc) : 0;
+        if (due && (next == 0 || due < next)) next = due;
+    }
+    idle_arm(rc, next);
+}
+
+// 一帧拷进新的池缓冲后 fan-out,返回 1 = 已路由
+static int frame_route(reactor_t* rc, port_def_t* port, const route_src_t* rs,
+                       const uint8_t* f, int len)
+{
+    buf_t* b = buf_alloc(len + 1);
+    if (!b) {
+        rx_counter_t* rx = rx_of(port);
+        if (rx) atomic_fetch_add_explicit(&rx->frame_drops, 1, memory_order_relaxed);
+        LOG_WARN("[reactor] buf pool exhausted, drop %d-byte frame from %s\n", len, port->base.name);
+        return 0;
+    }
+    memcpy(b->data, f, (size_t)len);
+    b->data[len] = '\0';
+    route_fanout(rc, port, rs, b, len);
+    return 1;
+}
+
+// idle:取走到期的累积帧并路由。now 非 0 时记下到期 → 出帧的延迟(断开时出帧不算)
+static int idle_flush(reactor_t* rc, port_def_t* port, frame_rx_t* fr, const port_frame_t* fc,
+                      uint64_t now)
+{
+    uint64_t due = frame_idle_due(fr, fc);
+    const uint8_t* f;
+    int len = frame_take(fr, fc, &f);
+    rx_counter_t* rx = rx_of(port);
+    if (rx && now && due && len > 0) {
+        unsigned long us = (unsigned long)((now - due) / 1000);
+        atomic_fetch_add_explicit(&rx->gap_frames, 1, memory_order_relaxed);
+        atomic_store_explicit(&rx->gap_late_us_last, us, memory_order_relaxed);
+        atomic_fetch_add_explicit(&rx->gap_late_us_sum, us, memory_order_relaxed);
+        if (us > atomic_load_explicit(&rx->gap_late_us_max, memory_order_relaxed))
+            atomic_store_explicit(&rx->gap_late_us_max, us, memory_order_relaxed);
+    }
+    const route_src_t* rs = route_table_for_src(port->base.id);
+    if (len <= 0 || !rs || rs->n == 0) return 0;
+    int routed = frame_route(rc, port, rs, f, len);
+    if (rx && routed) atomic_fetch_add_explicit(&rx->msgs, 1, memory_order_relaxed);
+    return routed;
+}
+
+// 把 timerfd 挂到 due(绝对时刻,0 = 摘掉);和已挂的一样就不动
+static void idle_arm(reactor_t* rc, uint64_t due)
+{
+    if (due == rc->idle_armed) return;
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec  = (time_t)(due / 1000000000ull);
+    its.it_value.tv_nsec = (long)(due % 1000000000ull);
+    if (timerfd_settime(rc->idle_tfd, TFD_TIMER_ABSTIME, &its, NULL) == 0)
+        rc->idle_armed = due;
+}
+
+// timerfd 到期:清掉计数,下一轮 idle_tick 出帧并重挂
+static void idle_on_timer(reactor_t* rc)
+{
+    uint64_t v;
+    (void)!read(rc->idle_tfd, &v, sizeof(v));
+    rc->idle_armed = 0;
+}
+
+// 出到期的 idle 帧,timerfd 重挂到剩下的最近到期。
+// 返回值只在没有 timerfd 时有意义:距下一个到期还有多少 ms,-1 = 没有待办
+static int idle_tick(reactor_t* rc)
+{
+    if (rc->idle_n == 0) {
+        if (rc->idle_tfd >= 0) idle_arm(rc, 0);
+        return -1;
+    }
+    uint64_t now = now_ns();
+    uint64_t next = 0;
+    for (int k = 0; k < rc->idle_n; ) {
+        port_def_t* port = rc->idle[k];
+        const port_frame_t* fc = frame_conf_of(port);
+        frame_rx_t* fr = port->base.frame_rx;
+        uint64_t due = (fc && fr) ? frame_idle_due(fr, fc) : 0;
+        if (due == 0 || now >= due) {
+            if (due) idle_flush(rc, port, fr, fc, now);
+            rc->idle[k] = rc->idle[--rc->idle_n];
+            continue;
+        }
+        if (next == 0 || due < next) next = due;
+        k++;
+    }
+    if (rc->idle_tfd >= 0) {
+        idle_arm(rc, next);
+        return -1;
+    }
+    return next ? (int)((next - now + 999999) / 1000000) : -1;
+}
+
+// 端口断开:idle 的累积帧已经完整(之后只会是静默),照常出;其余模式的半帧丢弃
+static void frame_forget(reactor_t* rc, port_def_t* port)
+{
+    frame_rx_t* fr = port->base.frame_rx;
+    if (!fr) return;
+    const port_frame_t* fc = frame_conf_of(port);
+    if (fc && frame_gap_ns(fc)) idle_flush(rc, port, fr, fc, 0);
+    idle_forget(rc, port);
+    port->base.frame_rx = NULL;
+    frame_rx_free(fr);
+    free(fr);
+}
+
+// 读到的一段(raw 的前 len 字节)交给路由:不分帧就是一条消息,分帧则每个完整帧一条。
+// 消耗 reactor 对 raw 的引用,返回路由出去的消息数。
+static int rx_deliver(reactor_t* rc, port_def_t* port, const route_src_t* rs, buf_t* raw, int len)
+{
+    const port_frame_t* fc = frame_conf_of(port);
+    frame_rx_t* fr = frame_rx_get(port, fc);
+    if (!fr) {
+        raw->data[len] = '\0';
+        route_fanout(rc, port, rs, raw, len);
+        return 1;
+    }
+
+    if (frame_gap_ns(fc)) {
+        uint64_t now = now_ns();
+        uint64_t due = frame_idle_due(fr, fc);
+        if (due && now >= due) idle_flush(rc, port, fr, fc, now);   // 静默已过,先出旧帧(自己计数)
+        unsigned long drops = fr->drops, shorts = fr->short_gaps, early = fr->early_splits;
+        frame_idle_feed(fr, fc, raw->data, len, now);
+        buf_unref(raw);
+        rx_counter_t* rx = rx_of(port);
+        if (rx && fr->drops != drops)
+            atomic_fetch_add_explicit(&rx->frame_drops, fr->drops - drops, memory_order_relaxed);
+        if (rx && fr->short_gaps != shorts)
+            atomic_fetch_add_explicit(&rx->short_gaps, fr->short_gaps - shorts, memory_order_relaxed);
+        if (rx && fr->early_splits != early)
+            atomic_fetch_add_explicit(&rx->early_splits, fr->early_splits - early, memory_order_relaxed);
+        if (frame_idle_due(fr, fc)) {
+            idle_add(rc, port);
+            if (rc->idle_tfd >= 0) idle_rearm(rc);
+        }
+        return 0;
+    }
+
+    unsigned long drops = fr->drops;
+    const uint8_t* in = raw->data;
+    const uint8_t* f;
+    int left = len, fl, msgs = 0, shared = 0;
+    while ((fl = frame_next(fr, fc, &in, &left, &f)) > 0) {
+        if (f == raw->data && left == 0) {
+            // 帧后面只剩已消耗的分隔符:'\0' 写在那里不影响任何人
+            raw->data[fl] = '\0';
+            route_fanout(rc, port, rs, raw, fl);
+            shared = 1;
+            msgs++;
+        } else {
+            msgs += frame_route(rc, port, rs, f, fl);
+        }
+    }
+    if (!shared) buf_unref(raw);
+    rx_counter_t* rx = rx_of(port);
+    if (rx && fr->drops != drops)
+        atomic_fetch_add_explicit(&rx->frame_drops, fr->drops - drops, memory_order_relaxed);
+    return msgs;
+}
+
+// 读到了但没存下(池耗尽):分帧端口的半帧作废
+static void rx_lost(port_def_t* port)
+{
+    const port_frame_t* fc = frame_conf_of(port);
+    frame_rx_t* fr = frame_rx_get(port, fc);
+    if (!fr) return;
+    frame_rx_gap(fr, fc);
+    rx_counter_t* rx = rx_of(port);
+    if (rx) atomic_fetch_add_explicit(&rx->frame_drops, 1, memory_order_relaxed);
+}
+
+// 两个可能的到期取近的,-1 = 没有
+static int timeout_min(int a, int b)
+{
+    if (a < 0) return b;
+    if (b < 0) return a;
+    return a < b ? a : b;
+}
+
+// ============================================
+// splice 直通(route_table.h):源 fd → 管道 → 目的 fd,字节不进用户态、不进队列
+//
+// 每个源端口一份状态,按 g_port_table 槽位索引并记下句柄(槽位换了连接就重建),
+// 只由源端口所在的 reactor 线程访问。
+//   - 每轮从源 splice 进管道,再从管道 splice 到目的;每次就绪最多 REACTOR_READ_BUDGET 轮
+//   - 目的写不动(EAGAIN):源端口的 EPOLLIN 摘掉(数据留在内核 / 设备里节流发送方),
+//     目的 fd 的一个 dup 挂 EPOLLOUT 到本 reactor 的 epoll(dup 是独立的注册项,
+//     和目的端口自己的读注册不冲突);可写时冲完管道、关 dup、恢复源端口
+//   - 目的已断开(句柄过期)/ 写出错:管道里的字节丢弃计数,同普通路径上过期句柄的消息
+//   - 源或目的不支持 splice(EINVAL),或等目的期间源 HUP:管道里的存货读回池缓冲
+//     交给普通路径(route_fanout 入队,由 dispatch worker 发),之后该连接一直走普通路径
+//   - 目的 socket 设成 O_NONBLOCK:splice 写 socket 是否阻塞只看文件标志。
+//     直通的目的只被这一条路由写(route_table 保证),不影响别的发送路径
+//   - 源 socket 同样设成 O_NONBLOCK:tcp 的 splice 读也只看文件标志(SPLICE_F_NONBLOCK
+//     只管管道一侧),阻塞的 tcp_client 源读空后会把 reactor 卡在 splice 里。
+//     socket 上的其他读写都按调用带 MSG_DONTWAIT / 走发送引擎,不受影响
+// io_uring 后端不走这里(读由内核直接投递到池缓冲),直通路由照常走队列。
+// ============================================
+#define REACTOR_SPLICE_PIPE  (256 * 1024)   // 直通管道容量(F_SETPIPE_SZ,失败用缺省)
+
+typedef struct {
+    port_handle_t h;         // 源端口句柄;PORT_HANDLE_INVALID = 空
+    int           state;     // 1 = 可用,-1 = 不支持(走普通路径)
+    int           pipe_rd;
+    int           pipe_wr;
+    int           pending;   // 管道里还没写到目的的字节
+    int           cap;       // 管道容量,一次从源 splice 的上限
+    port_handle_t dst_h;     // 上次写的目的连接(换了连接要重设 O_NONBLOCK)
+    unsigned      dst_epoch; // 目的是 tcp_client 时:第几次连接(重连后句柄不变,fd 变)
+    int           dst_fd;
+    int           out_fd;    // 等目的可写时挂在 epoll 上的 dup,-1 = 没在等
+    port_def_t*   src;
+} splice_t;
+
+static splice_t g_splice[MAX_PORTS];
+
+// epoll data.ptr 落在 g_splice 里 = 某个直通在等目的可写
+static splice_t* splice_of_ptr(void* p)
+{
+    if (p < (void*)g_splice || p >= (void*)(g_splice + MAX_PORTS)) return NULL;
+    return p;
+}
+
+// 源端口的直通状态,第一次用时建管道;不可用返回 NULL(走普通路径)
+static splice_t* splice_get(port_def_t* port)
+{
+    int i = port_handle_slot(port->base.handle);
+    if (i < 0) return NULL;
+    splice_t* sp = &g_splice[i];
+    if (sp->h != port->base.handle) {
+        int fds[2];
+        memset(sp, 0, sizeof(*sp));
+        sp->h      = port->base.handle;
+        sp->src    = port;
+        sp->out_fd = -1;
+        sp->dst_fd = -1;
+        if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+            LOG_WARN("[reactor] %s: splice pipe failed, errno=%d, copy path\n",
+                     port->base.name, errno);
+            sp->state = -1;
+        } else {
+            sp->pipe_rd = fds[0];
+            sp->pipe_wr = fds[1];
+            sp->state   = 1;
+            fcntl(fds[1], F_SETPIPE_SZ, REACTOR_SPLICE_PIPE);
+            sp->cap = fcntl(fds[1], F_GETPIPE_SZ);
+            if (sp->cap <= 0) sp->cap = 64 * 1024;
+            if (port->base.type == PORT_TCP_CLIENT || port->base.type == PORT_IPC_CLIENT)
+                fcntl(port->base.fd, F_SETFL, fcntl(port->base.fd, F_GETFL) | O_NONBLOCK);
+        }
+    }
+    return sp->state > 0 ? sp : NULL;
+}
+
+static void splice_unwait(reactor_t* rc, splice_t* sp)
+{
+    if (sp->out_fd < 0) return;
+    // dup 和目的 fd 指向同一个打开文件,只 close 不会从 epoll 摘掉,先 DEL
+    epoll_ctl(rc->epfd, EPOLL_CTL_DEL, sp->out_fd, NULL);
+    close(sp->out_fd);
+    sp->out_fd = -1;
+}
+
+static void splice_forget(reactor_t* rc, port_def_t* port)
+{
+    int i = port_handle_slot(port->base.handle);
+    if (i < 0 || g_splice[i].h != port->base.handle) return;
+    splice_t* sp = &g_splice[i];
+    splice_unwait(rc, sp);
+    if (sp->state > 0) {
+        close(sp->pipe_rd);
+        close(sp->pipe_wr);
+    }
+    memset(sp, 0, sizeof(*sp));
+}
+
+// 源端口暂停 / 恢复读(同 bp_pause:events = 0 时 HUP / ERR 仍会报)
+static void splice_pause(reactor_t* rc, port_def_t* port)
+{
+    struct epoll_event ev = {.events = 0, .data.ptr = port};
+    epoll_ctl(rc->epfd, EPOLL_CTL_MOD, port->base.fd, &ev);
+}
+
+static void splice_resume(reactor_t* rc, port_def_t* port)
+{
+    // EPOLL_CTL_MOD 会重查就绪状态,边沿触发下暂停期间积压的数据也会报上来
+    struct epoll_event ev = {.events = rx_events(port), .data.ptr = port};
+    epoll_ctl(rc->epfd, EPOLL_CTL_MOD, port->base.fd, &ev);
+}
+
+// 管道里的存货丢掉,返回字节数
+static int splice_discard(splice_t* sp)
+{
+    uint8_t scratch[4096];
+    int dropped = 0;
+    ssize_t n;
+    while ((n = read(sp->pipe_rd, scratch, sizeof(scratch))) > 0) dropped += (int)n;
+    sp->pending = 0;
+    rx_counter_t* rx = rx_of(sp->src);
+    if (rx) atomic_fetch_add_explicit(&rx->splice_drops, (unsigned long)dropped, memory_order_relaxed);
+    return dropped;
+}
+
+// 管道里的存货读回池缓冲,走普通路径(入队)
+static void splice_spill(reactor_t* rc, splice_t* sp, const route_src_t* rs)
+{
+    const int seg_cap = MAX_DATA - 1;
+    while (sp->pending > 0) {
+        buf_t* raw = buf_alloc(MAX_DATA);
+        if (!raw) {
+            LOG_WARN("[reactor] %s: buf pool exhausted, drop %d spliced bytes\n",
+                     sp->src->base.name, splice_discard(sp));
+            return;
+        }
+        ssize_t n = read(sp->pipe_rd, raw->data, (size_t)seg_cap);
+        if (n <= 0) {
+            buf_unref(raw);
+            sp->pending = 0;
+            return;
+        }
+        sp->pending -= (int)n;
+        raw->data[n] = '\0';
+        route_fanout(rc, sp->src, rs, raw, (int)n);
+    }
+}
+
+// 把管道冲到目的。返回 0 = 冲空(或目的不在了,存货已丢),1 = 目的写不动,
+// -1 = 目的不支持 splice
+static int splice_flush(splice_t* sp, int dst_id)
+{
+    port_def_t* dst = port_from_handle(g_config.ports[dst_id].base.handle);
+    if (!dst || dst->base.fd < 0 || !port_link_up(dst)) {
+        if (sp->pending > 0)
+            LOG_WARN("[reactor] %s -> %s: dst not connected, drop %d bytes\n",
+                     sp->src->base.name, g_config.ports[dst_id].base.name, splice_discard(sp));
+        return 0;
+    }
+    unsigned epoch = atomic_load_explicit(&dst->base.link_epoch, memory_order_acquire);
+    if (dst->base.handle != sp->dst_h || epoch != sp->dst_epoch) {
+        if (dst->base.type == PORT_TCP_CLIENT || dst->base.type == PORT_IPC_CLIENT)
+            fcntl(dst->base.fd, F_SETFL, fcntl(dst->base.fd, F_GETFL) | O_NONBLOCK);
+        sp->dst_h     = dst->base.handle;
+        sp->dst_epoch = epoch;
+        sp->dst_fd    = dst->base.fd;
+    }
+    rx_counter_t* rx = rx_of(sp->src);
+    while (sp->pending > 0) {
+        ssize_t n = splice(sp->pipe_rd, NULL, sp->dst_fd, NULL, (size_t)sp->pending,
+                           SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n > 0) {
+            sp->pending -= (int)n;
+            if (rx) atomic_fetch_add_explicit(&rx->spliced, (unsigned long)n, memory_order_relaxed);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 1;
+        if (n < 0 && errno == EINVAL) return -1;
+        // EPIPE / ECONNRESET 等:目的坏了,由它自己的 reactor 读到断开后清理
+        LOG_WARN("[reactor] %s -> %s: splice write failed, errno=%d, drop %d bytes\n",
+                 sp->src->base.name, dst->base.name, errno, splice_discard(sp));
+        return 0;
+    }
+    return 0;
+}
+
+// 目的写不动:挂 dup 等 EPOLLOUT,源端口停读
+static int splice_wait(reactor_t* rc, splice_t* sp)
+{
+    if (sp->out_fd < 0) {
+        sp->out_fd = fcntl(sp->dst_fd, F_DUPFD_CLOEXEC, 0);
+        if (sp->out_fd < 0) return -1;
+        struct epoll_event ev = {.events = EPOLLOUT, .data.ptr = sp};
+        if (epoll_ctl(rc->epfd, EPOLL_CTL_ADD, sp->out_fd, &ev) < 0) {
+            close(sp->out_fd);
+            sp->out_fd = -1;
+            return -1;
+        }
+    }
+    splice_pause(rc, sp->src);
+    return 0;
+}
+
+// 退回普通路径:存货入队,该连接之后不再直通
+static int splice_fallback(reactor_t* rc, splice_t* sp, const route_src_t* rs, int err)
+{
+    if (err)
+        LOG_WARN("[reactor] %s: splice unavailable (errno=%d), copy path\n",
+                 sp->src->base.name, err);
+    splice_unwait(rc, sp);
+    sp->state = -1;
+    splice_spill(rc, sp, rs);
+    splice_resume(rc, sp->src);
+    return -1;
+}
+
+// 目的可写了:冲管道,冲空就恢复源端口
+static void splice_on_writable(reactor_t* rc, splice_t* sp)
+{
+    if (sp->state <= 0 || !port_from_handle(sp->h)) {
+        splice_unwait(rc, sp);
+        return;
+    }
+    const route_src_t* rs = route_table_for_src(sp->src->base.id);
+    int r = splice_flush(sp, rs->e[0].dst_id);
+    if (r == 1) return;   // 还写不动,接着等
+    if (r < 0) {
+        splice_fallback(rc, sp, rs, EINVAL);
+        return;
+    }
+    splice_unwait(rc, sp);
+    splice_resume(rc, sp->src);
+}
+
+// 直通路由的源端口就绪。返回同 port_drain;-1 = 不能直通,调用方走普通路径
+static int splice_drain(reactor_t* rc, port_def_t* port, const route_src_t* rs, uint32_t events)
+{
+    splice_t* sp = splice_get(port);
+    if (!sp) return -1;
+    if (sp->out_fd >= 0) {
+        // 停读期间只会报 HUP / ERR:存货交给普通路径,由它读完剩下的并走断开清理
+        if (!(events & (EPOLLHUP | EPOLLERR))) return 0;
+        return splice_fallback(rc, sp, rs, 0);
+    }
+
+    rx_counter_t* rx = rx_of(port);
+    for (int round = 0; round < REACTOR_READ_BUDGET; round++) {
+        // 管道此时是空的(上一轮冲空了),一次最多读满它。
+        // 不能按短读判断源已空:socket 一个 skb 占一个管道槽位,槽位用完也会短读,
+        // 边沿触发下必须读到 EAGAIN
+        ssize_t n = splice(port->base.fd, NULL, sp->pipe_wr, NULL, (size_t)sp->cap,
+                           SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (rx) atomic_fetch_add_explicit(&rx->reads, 1, memory_order_relaxed);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 0;
+            if (errno == EINVAL) return splice_fallback(rc, sp, rs, errno);
+        }
+        if (n <= 0) {
+            port_close(rc, port);   // 对端关闭 / 读错误,同普通路径
+            return 0;
+        }
+        sp->pending += (int)n;
+        if (rx) atomic_fetch_add_explicit(&rx->bytes, (unsigned long)n, memory_order_relaxed);
+
+        int r = splice_flush(sp, rs->e[0].dst_id);
+        if (r < 0) return splice_fallback(rc, sp, rs, EINVAL);
+        if (r == 1) {
+            if (splice_wait(rc, sp) < 0) return splice_fallback(rc, sp, rs, errno);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// ============================================
+// 一条消息最多占的缓冲字节(含 '\0'):buffers.max_message + 1,池的最大一档放不下时取后者
+static int rx_max_size(void)
+{
+    int n = g_config.max_message + 1;
+    return n < buf_max_size() ? n : buf_max_size();
+}
+
+// udp spill 区:每个数据报超出 BUF_SIZE - 1 的部分最多多少字节;没配大消息 /
+// 内存不足返回 0(数据报上限就是 BUF_SIZE - 1)
+static int udp_spill_get(reactor_t* rc)
+{
+    int seg = rx_max_size() - BUF_SIZE;
+    if (seg <= 0) return 0;
+    if (rc->udp_spill && rc->udp_spill_seg == seg) return seg;
+    free(rc->udp_spill);
+    rc->udp_spill = malloc((size_t)seg * REACTOR_RX_SEGS_MAX);
+    rc->udp_spill_seg = rc->udp_spill ? seg : 0;
+    if (!rc->udp_spill)
+        LOG_WARN("[reactor] no memory for udp spill, datagrams limited to %d bytes\n", BUF_SIZE - 1);
+    return rc->udp_spill_seg;
+}
+
+// UDP 读:recvmmsg 一次收一批数据报,每个数据报读进一个池缓冲、就是一条消息
+// (边界原样带到目的:udp 目的一条消息发一个数据报,port_send_udp)。
+//   - 批大小同字节流端口的 rx_segs 自适应:收满翻倍,只用到一小部分减半
+//   - 小数据报直接收进 BUF_SIZE 档,零拷贝;配了大消息时每个数据报再挂一段 spill,
+//     超过 BUF_SIZE - 1 的数据报拼进放得下的一档(只有大数据报多一次拷贝)
+//   - 超过 buffers.max_message 的数据报被内核截断(MSG_TRUNC):丢弃计数,不转发半截
+//   - 空数据报跳过;读错误(如 ICMP 不可达)只告警 —— UDP 没有"对端关闭",端口不关
+//   - learn_peer:批里最后一个数据报的发送方成为回发对端(port_udp_learn)
+// 两个后端共用:io_uring 下 UDP 端口挂 POLL_ADD,就绪后也走这里。
+// ============================================
+static int udp_drain(reactor_t* rc, port_def_t* port, const route_src_t* rs, uint32_t events)
+{
+    int rn = rs ? rs->n : 0;
+    rx_counter_t* rx = rx_of(port);
+    const int seg_cap = BUF_SIZE - 1;
+    const int spill = udp_spill_get(rc);
+    if (port->base.rx_segs < 1) port->base.rx_segs = 1;
+    if (port->base.rx_segs > REACTOR_RX_SEGS_MAX) port->base.rx_segs = REACTOR_RX_SEGS_MAX;
+
+    for (int round = 0; round < REACTOR_READ_BUDGET; round++) {
+        if (rn > 0 && !(events & (EPOLLHUP | EPOLLERR)) && bp_blocked(rc, rs)) {
+            bp_pause(rc, port);
+            return 0;
+        }
+
+        buf_t*             bufs[REACTOR_RX_SEGS_MAX];
+        struct iovec       iov[REACTOR_RX_SEGS_MAX][2];
+        struct mmsghdr     mm[REACTOR_RX_SEGS_MAX];
+        struct sockaddr_in from[REACTOR_RX_SEGS_MAX];
+        uint8_t            scratch[MAX_DATA];
+        int nb = 0;
+        for (; rn > 0 && nb < port->base.rx_segs; nb++) {
+            bufs[nb] = buf_alloc(BUF_SIZE);
+            if (!bufs[nb]) break;
+        }
+        // 没有路由 / 池耗尽:一批都收进 scratch 丢弃,socket 仍要读空
+        int cnt = nb > 0 ? nb : port->base.rx_segs;
+        for (int k = 0; k < cnt; k++) {
+            iov[k][0].iov_base = nb > 0 ? bufs[k]->data : scratch;
+            iov[k][0].iov_len  = (size_t)seg_cap;
+            iov[k][1].iov_base = spill ? rc->udp_spill + (size_t)k * (size_t)spill : NULL;
+            iov[k][1].iov_len  = (size_t)spill;
+            memset(&mm[k], 0, sizeof(mm[k]));
+            mm[k].msg_hdr.msg_name    = &from[k];
+            mm[k].msg_hdr.msg_namelen = sizeof(from[k]);
+            mm[k].msg_hdr.msg_iov     = iov[k];
+            mm[k].msg_hdr.msg_iovlen  = spill ? 2 : 1;
+        }
+
+        int got = recvmmsg(port->base.fd, mm, (unsigned)cnt, MSG_DONTWAIT, NULL);
+        if (rx) atomic_fetch_add_explicit(&rx->reads, 1, memory_order_relaxed);
+        if (got <= 0) {
+            for (int k = 0; k < nb; k++) buf_unref(bufs[k]);
+            if (got < 0 && errno == EINTR) continue;
+            if (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                LOG_WARN("[reactor] %s fd=%d: recvmmsg failed, errno=%d\n",
+                         port->base.name, port->base.fd, errno);
+            return 0;
+        }
+
+        int used = 0;
+        unsigned long bytes = 0;
+        for (int k = 0; k < got; k++) {
+            int len = (int)mm[k].msg_len;
+            bytes += (unsigned long)len;
+            if (mm[k].msg_hdr.msg_flags & MSG_TRUNC) {
+                if (rx) atomic_fetch_add_explicit(&rx->dgram_drops, 1, memory_order_relaxed);
+                LOG_WARN("[reactor] %s: datagram larger than %d bytes, drop\n",
+                         port->base.name, seg_cap + spill);
+                continue;
+            }
+            if (nb == 0 || len == 0) continue;
+            buf_t* raw = bufs[k];
+            if (len > seg_cap) {
+                // 大数据报:小缓冲 + spill 段拼进放得下的一档,小缓冲留给下面统一归还
+                raw = buf_alloc(len + 1);
+                if (!raw) {
+                    LOG_WARN("[reactor] buf pool exhausted, drop %d-byte datagram from %s\n",
+                             len, port->base.name);
+                    continue;
+                }
+                memcpy(raw->data, bufs[k]->data, (size_t)seg_cap);
+                memcpy(raw->data + seg_cap, iov[k][1].iov_base, (size_t)(len - seg_cap));
+            } else {
+                bufs[k] = NULL;
+            }
+            raw->data[len] = '\0';
+            route_fanout(rc, port, rs, raw, len);
+            used++;
+        }
+        if (rn > 0 && nb == 0)
+            LOG_WARN("[reactor] buf pool exhausted, drop %d datagrams from %s\n",
+                     got, port->base.name);
+        for (int k = 0; k < nb; k++)
+            if (bufs[k]) buf_unref(bufs[k]);
+        port_udp_learn(port, &from[got - 1]);
+        if (rx) {
+            atomic_fetch_add_explicit(&rx->bytes, bytes, memory_order_relaxed);
+            atomic_fetch_add_explicit(&rx->msgs, (unsigned long)used, memory_order_relaxed);
+        }
+
+        int full = (got == cnt);
+        if (full && port->base.rx_segs < REACTOR_RX_SEGS_MAX)
+            port->base.rx_segs *= 2;
+        else if (got * 4 <= port->base.rx_segs && port->base.rx_segs > 1)
+            port->base.rx_segs /= 2;
+        if (port->base.rx_segs > REACTOR_RX_SEGS_MAX) port->base.rx_segs = REACTOR_RX_SEGS_MAX;
+        if (!full) return 0;
+    }
+    return 1;
+}
+
+// TCP_QUICKACK 不持久:内核判定不再是交互流量就退回延迟 ACK。配了 quickack 的 TCP
+// 端口(accept 出的 client 看 server 的配置)每次收到数据重设一次;设置时还有待发的
+// ACK 会立即发出。只对配了的端口多一次系统调用。
+static void rx_quickack(const port_def_t* port)
+{
+    int id = port->base.id;
+    if (port->base.type != PORT_TCP_CLIENT || id < 0 || id >= g_config.port_count ||
+        !g_config.ports[id].base.sock.quickack)
+        return;
+    int one = 1;
+    setsockopt(port->base.fd, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+}
+
+// 就绪端口读到空:每次 readv 进 rx_segs 个 rx_cap 字节的池缓冲(每个切一条消息),
+// 读满就加大(配了大消息时先加段容量,再把段数翻倍,上限 REACTOR_RX_SEGS_MAX),
+// 只用到一小部分就减小 —— 突发时一次系统调用搬十几 KB,涓流时不多占缓冲。短读说明内核缓冲已空,不再多读一次等 EAGAIN
+// (之后到的数据会产生新的边沿)。
+//
+// 先查路由再读:有路由就读进池缓冲,fan-out 的各路由共享它(引用计数);
+// 没有路由 / 池耗尽则读进栈上 scratch 丢弃,fd 仍需排空。
+//
+// 返回 1 = 读了 REACTOR_READ_BUDGET 次仍是满读(边沿触发下须自己再来),
+//      0 = 已读空 / 已暂停 / 已关闭。
+static int port_drain(reactor_t* rc, port_def_t* port, uint32_t events)
+{
+    // 路由表在启动时编译好,按源端口下标 O(1) 取,热路径无字符串比较
+    const route_src_t* rs = route_table_for_src(port->base.id);
+    int rn = rs ? rs->n : 0;
+    rx_counter_t* rx = rx_of(port);
+    if (rx) atomic_fetch_add_explicit(&rx->wakeups, 1, memory_order_relaxed);
+    rx_quickack(port);
+
+    if (rn == 1 && rs->e[0].splice) {
+        int r = splice_drain(rc, port, rs, events);
+        if (r >= 0) return r;
+    }
+
+    if (port->base.type == PORT_UDP)
+        return udp_drain(rc, port, rs, events);
+
+    const int max_segs = REACTOR_RX_SEGS_MAX;
+    if (port->base.rx_segs < 1) port->base.rx_segs = 1;
+    if (port->base.rx_segs > max_segs) port->base.rx_segs = max_segs;
+
+    for (int round = 0; round < REACTOR_READ_BUDGET; round++) {
+        // backpressure:目的 lane 过高水位就先不读,数据留在内核缓冲里节流发送方。
+        // 只有 HUP/ERR(暂停期间唯一会报的事件)时照常 read,走断开清理。
+        if (rn > 0 && !(events & (EPOLLHUP | EPOLLERR)) && bp_blocked(rc, rs)) {
+            bp_pause(rc, port);
+            return 0;
+        }
+
+        // 每段留一个位置给 '\0';段容量 rx_cap 见下方自适应
+        int seg_size = port->base.rx_cap > BUF_SIZE ? port->base.rx_cap : BUF_SIZE;
+        buf_t*       bufs[REACTOR_RX_SEGS_MAX];
+        struct iovec iov[REACTOR_RX_SEGS_MAX];
+        uint8_t      scratch[MAX_DATA];
+        int nb = 0;
+        for (; rn > 0 && nb < port->base.rx_segs; nb++) {
+            bufs[nb] = buf_alloc(seg_size);
+            if (!bufs[nb] && nb == 0 && seg_size > BUF_SIZE) {
+                // 大档暂时用光(队列 / 发送环里压着大消息):退回 BUF_SIZE 段,字节照收
+                seg_size = BUF_SIZE;
+                port->base.rx_cap = 0;
+                bufs[nb] = buf_alloc(seg_size);
+            }
+            if (!bufs[nb]) break;
+            iov[nb].iov_base = bufs[nb]->data;
+            iov[nb].iov_len  = (size_t)(seg_size - 1);
+        }
+        int seg_cap = seg_size - 1;
+        int cnt = nb;
+        if (nb == 0) {
+            seg_cap = MAX_DATA - 1;
+            iov[0].iov_base = scratch;
+            iov[0].iov_len  = (size_t)seg_cap;
+            cnt = 1;
+        }
+
+        ssize_t len = rx_readv(port, iov, cnt);
+        if (rx) atomic_fetch_add_explicit(&rx->reads, 1, memory_order_relaxed);
+        if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            for (int k = 0; k < nb; k++) buf_unref(bufs[k]);
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        if (len <= 0) {
+            // 客户端断开连接
+            for (int k = 0; k < nb; k++) buf_unref(bufs[k]);
+            port_close(rc, port);
+            return 0;
+        }
+        if (rx) atomic_fetch_add_explicit(&rx->bytes, (unsigned long)len, memory_order_relaxed);
+
+        int used = 0, msgs = 0;
+        if (rn > 0 && nb == 0) {
+            LOG_WARN("[reactor] buf pool exhausted, drop %d bytes from %s\n",
+                     (int)len, port->base.name);
+            rx_lost(port);
+        } else if (nb > 0) {
+            for (int off = 0; off < len; ) {
+                int seg = (int)len - off < seg_cap ? (int)len - off : seg_cap;
+                msgs += rx_deliver(rc, port, rs, bufs[used++], seg);
+                off += seg;
+            }
+            if (rx) atomic_fetch_add_explicit(&rx->msgs, (unsigned long)msgs, memory_order_relaxed);
+        }
+        for (int k = used; k < nb; k++) buf_unref(bufs[k]);
+
+        // 读满时先把段容量 ×4(直到池的最大一档:一次读装进一段,长记录不在 1 KiB 处
+        // 被切开),容量到顶再把段数翻倍;只用到一小部分时段数先减半,只剩一段且这段
+        // 只用了不到 1/4 再缩容量 —— 涓流 / 小消息回到 BUF_SIZE 档。
+        // 没配大消息(最大一档就是 BUF_SIZE)时只有段数在变。
+        int full = (len == (ssize_t)cnt * seg_cap);
+        if (nb > 0) {
+            const int max_size = rx_max_size();
+            if (full && seg_size < max_size)
+                port->base.rx_cap = seg_size * 4 < max_size ? seg_size * 4 : max_size;
+            else if (full && port->base.rx_segs < max_segs)
+                port->base.rx_segs *= 2;
+            else if (used * 4 <= port->base.rx_segs && port->base.rx_segs > 1)
+                port->base.rx_segs /= 2;
+            else if (!full && used == 1 && seg_size > BUF_SIZE && len * 4 <= seg_cap)
+                port->base.rx_cap = seg_size / 4 > BUF_SIZE ? seg_size / 4 : BUF_SIZE;
+            if (port->base.rx_segs > max_segs) port->base.rx_segs = max_segs;
+        }
+        if (!full) return 0;
+    }
+    return 1;
+}
+
+// accept 出的连接建成 client 端口:继承 server 的名字 / 路由(base.id),
+// 留在接受它的 reactor 上
+static void on_accepted(reactor_t* rc, port_def_t* server, int client_fd)
+{
+    // 建立新的 port_def_t 结构体用于 client_fd
+    port_def_t* client = calloc(1, sizeof(port_def_t));
+    if (!client) {
+        close(client_fd);
+        return;
+    }
+    // base.name 是 char[32];源/目同尺寸,但 strncpy + 显式 NUL
+    // 防止未来源不再保证 NUL 终结(防御性,统一风格)
+    strncpy(client->base.name, server->base.name, sizeof(client->base.name) - 1);
+    client->base.name[sizeof(client->base.name) - 1] = '\0';
+    client->base.fd      = client_fd;
+    client->base.type    = (server->base.type == PORT_IPC_SERVER) ? PORT_IPC_CLIENT
+                                                                  : PORT_TCP_CLIENT;
+    client->base.id      = server->base.id;   // 按 server 的路由表转发
+    client->base.reactor = rc->id;
+    if (server->base.type == PORT_TCP_SERVER)
+        port_apply_sockopts(server, client_fd);   // quickack 等不随 listener 继承
+    reactor_add_port(client);
+    LOG_INFO("[reactor] new %s client fd=%d\n", client->base.name, client_fd);
+}
+
+static void epoll_loop(reactor_t* rc)
+{
+    struct epoll_event evs[REACTOR_MAX_EVENTS];
 
     while (run_state_is_running()) {
-        int n = epoll_wait(epfd, evs, 16, -1);
-        if (n <= 0) continue;
+        // 有读预算用完的端口时不睡,处理完新事件接着读它们;
+        // 有 tcp_client 在连 / 等重连时睡到最近的到期;idle 分帧的静默到期由 timerfd 唤醒
+        int tick_ms = timeout_min(dial_tick(rc), idle_tick(rc));
+        int n = epoll_wait(rc->epfd, evs, REACTOR_MAX_EVENTS, rc->more_n ? 0 : tick_ms);
+        if (n < 0 || (n == 0 && rc->more_n == 0)) continue;
+
+        uint64_t t0 = now_ns();
+        atomic_fetch_add_explicit(&rc->wakeups, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&rc->events, (unsigned long)n, memory_order_relaxed);
+        if ((unsigned)n > atomic_load_explicit(&rc->max_events, memory_order_relaxed))
+            atomic_store_explicit(&rc->max_events, (unsigned)n, memory_order_relaxed);
 
         for (int i = 0; i < n; i++) {
             port_def_t* port = evs[i].data.ptr;
+            if (port == &resume_marker) {
+                bp_resume(rc);
+                continue;
+            }
+            if (port == &idle_marker) {
+                idle_on_timer(rc);
+                continue;
+            }
+            splice_t* sp = splice_of_ptr(evs[i].data.ptr);
+            if (sp) {
+                splice_on_writable(rc, sp);
+                continue;
+            }
+            if (link_of(port) != PORT_LINK_UP) {
+                // tcp_client 在连:EPOLLOUT / ERR / HUP 判定结果。
+                // 等重连的端口 fd 已关,同一批里残留的旧事件忽略
+                if (link_of(port) == PORT_LINK_CONNECTING)
+                    dial_on_ready(rc, port, evs[i].events);
+                continue;
+            }
             int fd = port->base.fd;
 
             // ============================================
@@ -83,125 +1604,503 @@ void* reactor_thread(void* arg)
                  inet_ntoa(client_addr.sin_addr),
                  ntohs(client_addr.sin_port),
                  client_fd);
-
-                // 建立新的 port_def_t 结构体用于 client_fd
-                port_def_t* client_port = calloc(1, sizeof(port_def_t));
-                // base.name 是 char[32];源/目同尺寸,但 strncpy + 显式 NUL
-                // 防止未来源不再保证 NUL 终结(防御性,统一风格)
-                strncpy(client_port->base.name, port->base.name, sizeof(client_port->base.name) - 1);
-                client_port->base.name[sizeof(client_port->base.name) - 1] = '\0';
-                client_port->base.fd = client_fd;
-                client_port->base.type = PORT_TCP_CLIENT;
-                reactor_add_port(client_port);
-                LOG_INFO("set up client with server\n");
-
+                on_accepted(rc, port, client_fd);
                 continue;  // 不要再往下执行 read()
             }
 
             if (port->base.type == PORT_IPC_SERVER) {
-
                 int client_fd = accept(fd, NULL, NULL);
                 if (client_fd < 0) {
                     perror("[reactor] ipc accept");
                     continue;
                 }
-
-                port_def_t* client = calloc(1, sizeof(port_def_t));
-
-                // 继承 server 的逻辑名字（一般是 "HOST"）
-                // strncpy 防御性:base.name 是 char[32],源/目同尺寸
-                strncpy(client->base.name, port->base.name, sizeof(client->base.name) - 1);
-                client->base.name[sizeof(client->base.name) - 1] = '\0';
-
-                client->base.fd   = client_fd;
-                client->base.type = PORT_IPC_CLIENT;   // ✅ 正确
-                reactor_add_port(client);
-                LOG_INFO("[ipc] new %s client fd=%d\n",
-                client->base.name, client_fd);
+                on_accepted(rc, port, client_fd);
                 continue;   // 不再往下 read()
-                }
+            }
 
             // ============================================
-            // ② 普通客户端或设备端口：读取数据
+            // ② 普通客户端或设备端口：读到空
             // ============================================
-                uint8_t buf[1024];
-                int len = read(fd, buf, sizeof(buf) - 1);  // 留一个位置给 '\0'
-                if(len>0){
-                    buf[len]='\0';
+            more_forget(rc, port);   // 本次就绪接着读,不在下面重复
+            if (port_drain(rc, port, evs[i].events) && g_edge)
+                more_add(rc, port);
+        }
+
+        // 上一轮读预算用完的端口:边沿触发不会再报,这里接着读
+        if (rc->more_n > 0) {
+            port_def_t* again[MAX_PORTS];
+            int m = rc->more_n;
+            memcpy(again, rc->more, sizeof(again[0]) * (size_t)m);
+            rc->more_n = 0;
+            for (int k = 0; k < m; k++) {
+                if (port_drain(rc, again[k], 0))
+                    more_add(rc, again[k]);
+            }
+        }
+        atomic_fetch_add_explicit(&rc->busy_ns, now_ns() - t0, memory_order_relaxed);
+    }
+}
+
+// ============================================
+// io_uring 后端
+//
+// 与 epoll 后端共用路由 fan-out / backpressure / 关闭路径,区别只在"怎么拿到数据":
+//   - listener:multishot accept,一个 SQE 持续产出新连接
+//   - socket 类端口:multishot recv + provided buffer ring,内核直接把数据读进
+//     池缓冲(bid_buf[bid]),CQE 到手即是一条消息,零拷贝交给 route_fanout
+//   - tty / usb:单次 read + buffer select,每个 CQE 后重挂
+//   - udp:单次 POLL_ADD,可读后同 epoll 后端 recvmmsg 读空(udp_drain),再重挂
+//   - resume eventfd:单次 POLL_ADD,每次触发后重挂
+// 一次 io_uring_enter 同时提交所有重挂 / 补缓冲并收割完成,空闲时睡在里面。
+//
+// 生命周期:端口只在"读请求已终止(CQE 不带 F_MORE)"时关闭 / 释放,
+// 所以释放时内核里不再有引用它的请求。
+// ============================================
+static int is_socket_port(const port_def_t* port)
+{
+    return port->base.type == PORT_TCP_CLIENT || port->base.type == PORT_IPC_CLIENT ||
+           port->base.type == PORT_UDP;
+}
+
+// 空槽补上池缓冲并发布给内核。池耗尽的槽留空,下一轮再补。
+static void uring_refill(reactor_t* rc)
+{
+    if (rc->bid_missing == 0) return;
+    int added = 0;
+    for (int bid = 0; bid < REACTOR_URING_BUFS; bid++) {
+        if (rc->bid_buf[bid]) continue;
+        buf_t* b = buf_alloc(MAX_DATA);
+        if (!b) break;
+        rc->bid_buf[bid] = b;
+        uring_pbuf_add(&rc->pbuf, b->data, MAX_DATA - 1, (uint16_t)bid);   // 留一个位置给 '\0'
+        rc->bid_missing--;
+        added++;
+    }
+    if (added) uring_pbuf_commit(&rc->pbuf);
+}
+
+static int uring_setup(reactor_t* rc)
+{
+    if (uring_init(&rc->ring, REACTOR_URING_ENTRIES) < 0) return -1;
+    if (uring_pbuf_init(&rc->ring, &rc->pbuf, REACTOR_URING_BUFS, URING_BGID) < 0) {
+        uring_exit(&rc->ring);
+        return -1;
+    }
+    rc->retry_ts.tv_sec  = 0;
+    rc->retry_ts.tv_nsec = 1000 * 1000;
+    return 0;
+}
+
+// 有 backpressure 路由的源端口:multishot 在取消生效前还会继续产出 CQE,可能冲过
+// 高水位到队列满而丢数据。这类端口用单次 recv,每条完成后重查水位再挂。
+static int bp_source(const port_def_t* port)
+{
+    const route_src_t* rs = route_table_for_src(port->base.id);
+    for (int j = 0; rs && j < rs->n; j++) {
+        if (rs->e[j].policy == ROUTE_POLICY_BACKPRESSURE) return 1;
+    }
+    return 0;
+}
+
+static void uring_arm(reactor_t* rc, port_def_t* port)
+{
+    int st = link_of(port);
+    if (st == PORT_LINK_DOWN) return;   // tcp_client 等重连,fd 已关
+    struct io_uring_sqe* sqe = uring_get_sqe(&rc->ring);
+    if (!sqe) {
+        more_add(rc, port);   // SQ 满,下一轮再挂
+        return;
+    }
+    sqe->fd = port->base.fd;
+    if (st == PORT_LINK_CONNECTING) {   // tcp_client 等连接完成
+        sqe->opcode        = IORING_OP_POLL_ADD;
+        sqe->poll32_events = POLLOUT;
+        sqe->user_data     = uring_ud(port, URING_TAG_POLL);
+        return;
+    }
+    if (port->base.type == PORT_UDP) {
+        // 等可读再 recvmmsg(udp_drain):要发送方地址、要一次收一批,multishot recv 都给不了。
+        // 用 READ 标签,backpressure 的取消 / 重挂与其他读请求一致
+        sqe->opcode        = IORING_OP_POLL_ADD;
+        sqe->poll32_events = POLLIN;
+        sqe->user_data     = uring_ud(port, URING_TAG_READ);
+    } else if (is_listener(port)) {
+        sqe->opcode    = IORING_OP_ACCEPT;
+        sqe->ioprio    = IORING_ACCEPT_MULTISHOT;
+        sqe->user_data = uring_ud(port, URING_TAG_ACCEPT);
+    } else {
+        sqe->opcode    = is_socket_port(port) ? IORING_OP_RECV : IORING_OP_READ;
+        sqe->ioprio    = (is_socket_port(port) && !bp_source(port)) ? IORING_RECV_MULTISHOT : 0;
+        if (!is_socket_port(port))
+            sqe->off   = (uint64_t)-1;   // 当前位置(tty 不可 seek);recv 的 off 须为 0
+        sqe->flags     = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = URING_BGID;
+        sqe->user_data = uring_ud(port, URING_TAG_READ);
+    }
+    port->base.rx_armed = 1;
+}
+
+static void uring_cancel_read(reactor_t* rc, port_def_t* port)
+{
+    struct io_uring_sqe* sqe = uring_get_sqe(&rc->ring);
+    if (!sqe) return;   // 取消不了就让它继续读,try_reserve 兜底
+    sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+    sqe->addr      = uring_ud(port, URING_TAG_READ);
+    sqe->user_data = uring_ud(NULL, URING_TAG_IGNORE);
+}
+
+static void uring_arm_resume(reactor_t* rc)
+{
+    if (rc->resume_efd < 0) return;
+    struct io_uring_sqe* sqe = uring_get_sqe(&rc->ring);
+    if (!sqe) return;
+    sqe->opcode        = IORING_OP_POLL_ADD;
+    sqe->fd            = rc->resume_efd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data     = uring_ud(&resume_marker, URING_TAG_POLL);
+}
+
+static void uring_arm_idle(reactor_t* rc)
+{
+    if (rc->idle_tfd < 0) return;
+    struct io_uring_sqe* sqe = uring_get_sqe(&rc->ring);
+    if (!sqe) return;
+    sqe->opcode        = IORING_OP_POLL_ADD;
+    sqe->fd            = rc->idle_tfd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data     = uring_ud(&idle_marker, URING_TAG_POLL);
+}
+
+static void uring_on_accept(reactor_t* rc, port_def_t* server, const struct io_uring_cqe* cqe)
+{
+    if (cqe->res >= 0)
+        on_accepted(rc, server, cqe->res);
+    else
+        LOG_WARN("[reactor] %s: accept failed, errno=%d\n", server->base.name, -cqe->res);
+    if (!(cqe->flags & IORING_CQE_F_MORE))
+        uring_arm(rc, server);
+}
+
+// udp 的 POLL_ADD 完成:读空后重挂。backpressure 暂停中不挂,由 bp_resume 挂;
+// 取消完成前已经恢复的(bp_resume 见 rx_armed 没挂)在这里挂
+static void uring_on_udp(reactor_t* rc, port_def_t* port, const struct io_uring_cqe* cqe)
+{
+    port->base.rx_armed = 0;
+    if (cqe->res == -ECANCELED) {
+        if (!bp_is_paused(rc, port)) uring_arm(rc, port);
+        return;
+    }
+    rx_counter_t* rx = rx_of(port);
+    if (rx) atomic_fetch_add_explicit(&rx->wakeups, 1, memory_order_relaxed);
+    const route_src_t* rs = route_table_for_src(port->base.id);
+    udp_drain(rc, port, rs, cqe->res < 0 ? EPOLLERR : (uint32_t)cqe->res);
+    if (!bp_is_paused(rc, port)) uring_arm(rc, port);   // 读预算用完也一样:POLL 水平触发
+}
+
+static void uring_on_read(reactor_t* rc, port_def_t* port, const struct io_uring_cqe* cqe)
+{
+    if (port->base.type == PORT_UDP) {
+        uring_on_udp(rc, port, cqe);
+        return;
+    }
+    int more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+    if (!more) port->base.rx_armed = 0;
+
+    const route_src_t* rs = route_table_for_src(port->base.id);
+    int rn = rs ? rs->n : 0;
+    rx_counter_t* rx = rx_of(port);
+    if (rx) {
+        atomic_fetch_add_explicit(&rx->wakeups, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&rx->reads, 1, memory_order_relaxed);
+    }
+
+    if (cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER)) {
+        rx_quickack(port);
+        int bid = (int)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        buf_t* raw = (bid < REACTOR_URING_BUFS) ? rc->bid_buf[bid] : NULL;
+        if (raw) {
+            rc->bid_buf[bid] = NULL;
+            rc->bid_missing++;
+            int len = cqe->res;
+            int msgs = 0;
+            if (rn > 0)
+                msgs = rx_deliver(rc, port, rs, raw, len);   // 消耗 raw 的引用
+            else
+                buf_unref(raw);
+            if (rx) {
+                atomic_fetch_add_explicit(&rx->bytes, (unsigned long)len, memory_order_relaxed);
+                atomic_fetch_add_explicit(&rx->msgs, (unsigned long)msgs, memory_order_relaxed);
+            }
+        }
+    } else if (cqe->res == 0 || (cqe->res < 0 && cqe->res != -ENOBUFS &&
+                                 cqe->res != -ECANCELED && cqe->res != -EAGAIN &&
+                                 cqe->res != -EINTR)) {
+        // 对端关闭 / 读错误。multishot 在 EOF / 错误时一定终止,这里 rx_armed 已是 0
+        if (cqe->res < 0)
+            LOG_WARN("[reactor] %s fd=%d: read failed, errno=%d\n",
+                     port->base.name, port->base.fd, -cqe->res);
+        if (!more) port_close(rc, port);
+        return;
+    }
+
+    if (more) {
+        // backpressure:过高水位就取消在途读,剩下的 CQE 仍照常 fan-out
+        if (rn > 0 && bp_blocked(rc, rs) && !bp_is_paused(rc, port))
+            bp_pause(rc, port);
+        return;
+    }
+
+    // 请求终止(单次 read 完成 / 取消 / 缓冲耗尽):除非暂停中,重挂
+    if (bp_is_paused(rc, port)) return;
+    if (rn > 0 && bp_blocked(rc, rs)) {
+        bp_pause(rc, port);
+        return;
+    }
+    if (cqe->res == -ENOBUFS)
+        more_add(rc, port);   // 缓冲补上后再挂
+    else
+        uring_arm(rc, port);
+}
+
+static void uring_loop(reactor_t* rc)
+{
+    uring_t* u = &rc->ring;
+    rc->bid_missing = REACTOR_URING_BUFS;
+    uring_refill(rc);
+    uring_arm_resume(rc);
+    uring_arm_idle(rc);
+
+    while (run_state_is_running()) {
+        // tcp_client 连接超时 / 重连到期(可能往 arm 里加端口)、idle 分帧静默到期
+        // (timerfd 另有 POLL_ADD,这里只在没有 timerfd 时计入);有待办就挂一个定时器。已挂的定时器比新的到期晚才再挂一个,多出来的那个到期只是空转一轮
+        int dial_ms = timeout_min(dial_tick(rc), idle_tick(rc));
+        if (dial_ms >= 0) {
+            uint64_t due = now_ns() + (uint64_t)dial_ms * 1000000ull;
+            if (rc->dial_due == 0 || due + 1000000ull < rc->dial_due) {
+                struct io_uring_sqe* sqe = uring_get_sqe(u);
+                if (sqe) {
+                    rc->dial_ts.tv_sec  = dial_ms / 1000;
+                    rc->dial_ts.tv_nsec = (long long)(dial_ms % 1000) * 1000000;
+                    sqe->opcode    = IORING_OP_TIMEOUT;
+                    sqe->addr      = (uint64_t)(uintptr_t)&rc->dial_ts;
+                    sqe->len       = 1;
+                    sqe->user_data = uring_ud(&dial_marker, URING_TAG_IGNORE);
+                    rc->dial_due   = due;
                 }
+            }
+        }
 
-                if (len <= 0) {
-                // 客户端断开连接
-                    LOG_INFO("[reactor] fd=%d closed\n", fd);
-                    epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
-                    close(fd);
-                    
-                    // 从 g_port_table 中移除并释放动态分配的客户端
-                    for (int k = 0; k < MAX_PORTS; k++) {
-                        if (g_port_table[k].used && g_port_table[k].fd == fd) {
-                            g_port_table[k].used = 0;
-                            g_port_table[k].fd = -1;
-                            // 只有动态分配的客户端需要 free
-                            if (port->base.type == PORT_TCP_CLIENT || 
-                                port->base.type == PORT_IPC_CLIENT) {
-                                free(g_port_table[k].port);
-                            }
-                            g_port_table[k].port = NULL;
-                            break;
-                        }
-                    }
-                    continue;
+        // 新注册的端口(启动时 main 线程 / accept / tcp_client 发起连接)挂请求
+        reactor_lock();
+        port_def_t* arm[MAX_PORTS * 2];
+        int an = rc->arm_n;
+        memcpy(arm, rc->arm, sizeof(arm[0]) * (size_t)an);
+        rc->arm_n = 0;
+        reactor_unlock();
+        for (int k = 0; k < an; k++)
+            uring_arm(rc, arm[k]);
+
+        // 缓冲耗尽 / SQ 满而没挂上的端口:补缓冲后重挂,仍缺缓冲就 1ms 后再试
+        uring_refill(rc);
+        if (rc->more_n > 0) {
+            if (rc->bid_missing < REACTOR_URING_BUFS) {
+                port_def_t* again[MAX_PORTS];
+                int m = rc->more_n;
+                memcpy(again, rc->more, sizeof(again[0]) * (size_t)m);
+                rc->more_n = 0;
+                for (int k = 0; k < m; k++)
+                    uring_arm(rc, again[k]);
+            } else {
+                struct io_uring_sqe* sqe = uring_get_sqe(u);
+                if (sqe) {
+                    sqe->opcode    = IORING_OP_TIMEOUT;
+                    sqe->addr      = (uint64_t)(uintptr_t)&rc->retry_ts;
+                    sqe->len       = 1;
+                    sqe->user_data = uring_ud(NULL, URING_TAG_IGNORE);
                 }
+            }
+        }
 
-                LOG_INFO("[reactor] recv from %s fd=%d len=%d\n",
-                   port->base.name, fd, len);
-                LOG_INFO("[reactor] data: %d ,%s\n", len, buf);
-
-            // === 路由转发逻辑 ===
-                route_def_t* routes[16];
-                LOG_INFO("port name=%s\n",port->base.name);
-                int rn = config_find_routes_by_src(port->base.name, routes, 16);
-                LOG_INFO("find routes counte=%d\n",rn);
-                for (int j = 0; j < rn; j++) {
-                    route_def_t* r = routes[j];
-                    plugin_handler_t handler = plugin_get_handler(r->handler);
-                    int data_len = len;
-                    if (handler) {
-                        data_len = handler(buf, len);
-
-                        // 契约 5 (PROJECT_CONTEXT v2 / design-intent.md §4):
-                        // handler 就地写 buf,栈缓冲固定 1024 字节,
-                        // event_msg_t.data 也是 MAX_DATA。返回 >MAX_DATA 会越界,
-                        // 返回 <0 不是约定的有效长度。这里夹住,而不是 trust。
-                        if (data_len < 0) {
-                            LOG_WARN("[reactor] plugin %s returned %d, drop\n",
-                                     r->handler, data_len);
-                            continue;
-                        }
-                        if (data_len > MAX_DATA) {
-                            LOG_WARN("[reactor] plugin %s returned %d > MAX_DATA=%d, truncated\n",
-                                     r->handler, data_len, MAX_DATA);
-                            data_len = MAX_DATA;
-                        }
-                    }
-
-                    event_msg_t msg;
-
-                //r->dst type
-
-
-                    memcpy(msg.dst, r->dst, sizeof(msg.dst));
-                    msg.len = data_len;
-                    memcpy(msg.data, buf, data_len);
-                    queue_push(&msg);
-
-                    LOG_INFO("Route: %s -> %s, push message to queue\n", r->src, r->dst);
+        // 一次系统调用:提交本轮所有 SQE,并等至少一个完成
+        if (uring_submit(u, 1) < 0) continue;
+
+        uint64_t t0 = now_ns();
+        unsigned n = 0;
+        struct io_uring_cqe* cqe;
+        while ((cqe = uring_peek_cqe(u)) != NULL) {
+            struct io_uring_cqe c = *cqe;
+            uring_cqe_seen(u);
+            n++;
+
+            unsigned tag = (unsigned)(c.user_data & URING_TAG_MASK);
+            port_def_t* port = (port_def_t*)(uintptr_t)(c.user_data & ~(uint64_t)URING_TAG_MASK);
+            switch (tag) {
+            case URING_TAG_READ:   uring_on_read(rc, port, &c); break;
+            case URING_TAG_ACCEPT: uring_on_accept(rc, port, &c); break;
+            case URING_TAG_POLL:
+                if (port == &resume_marker) {
+                    bp_resume(rc);
+                    uring_arm_resume(rc);
+                } else if (port == &idle_marker) {
+                    idle_on_timer(rc);
+                    uring_arm_idle(rc);
+                } else if (c.res != -ECANCELED) {
+                    dial_on_ready(rc, port, c.res < 0 ? EPOLLERR : (uint32_t)c.res);
                 }
+                break;
+            default:
+                if (port == &dial_marker) rc->dial_due = 0;
+                break;
+            }
         }
+        if (n == 0) continue;
+
+        atomic_fetch_add_explicit(&rc->wakeups, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&rc->events, (unsigned long)n, memory_order_relaxed);
+        if (n > atomic_load_explicit(&rc->max_events, memory_order_relaxed))
+            atomic_store_explicit(&rc->max_events, n, memory_order_relaxed);
+        atomic_fetch_add_explicit(&rc->busy_ns, now_ns() - t0, memory_order_relaxed);
     }
+}
+
+void* reactor_thread(void* arg)
+{
+    reactor_t* rc = arg ? arg : &g_reactors[0];
+    printf("[reactor] thread %d started\n", rc->id);
+    bp_init(rc);
+
+    if (g_uring)
+        uring_loop(rc);
+    else
+        epoll_loop(rc);
     return NULL;
 }
 
+int reactor_start(void)
+{
+    int started = 0;
+    for (int k = 0; k < g_reactor_count; k++) {
+        if (pthread_create(&g_reactors[k].th, NULL, reactor_thread, &g_reactors[k]) != 0) {
+            LOG_ERROR("[reactor] thread %d create failed\n", k);
+            continue;
+        }
+        g_reactors[k].started = 1;
+        started++;
+    }
+    return started;
+}
+
+void reactor_join(void)
+{
+    for (int k = 0; k < g_reactor_count; k++) {
+        if (!g_reactors[k].started) continue;
+        pthread_join(g_reactors[k].th, NULL);
+        g_reactors[k].started = 0;
+    }
+}
+
+int reactor_count(void)
+{
+    return g_reactor_count;
+}
+
+int reactor_get_stats(reactor_stats_t* out, int max)
+{
+    int n = 0;
+    for (int k = 0; k < g_reactor_count && n < max; k++, n++) {
+        reactor_t* rc = &g_reactors[k];
+        out[n].id         = rc->id;
+        out[n].ports      = atomic_load_explicit(&rc->ports, memory_order_relaxed);
+        out[n].wakeups    = atomic_load_explicit(&rc->wakeups, memory_order_relaxed);
+        out[n].events     = atomic_load_explicit(&rc->events, memory_order_relaxed);
+        out[n].max_events = atomic_load_explicit(&rc->max_events, memory_order_relaxed);
+        out[n].busy_ns    = atomic_load_explicit(&rc->busy_ns, memory_order_relaxed);
+    }
+    return n;
+}
+
+int reactor_get_port_stats(reactor_port_stats_t* out, int max)
+{
+    int n = 0;
+    for (int id = 0; id < g_config.port_count && id < MAX_PORTS && n < max; id++) {
+        unsigned long wakeups  = atomic_load_explicit(&g_rx[id].wakeups, memory_order_relaxed);
+        unsigned long connects = atomic_load_explicit(&g_rx[id].connects, memory_order_relaxed);
+        unsigned long fails    = atomic_load_explicit(&g_rx[id].connect_fails, memory_order_relaxed);
+        if (wakeups == 0 && connects == 0 && fails == 0) continue;
+        memcpy(out[n].name, g_config.ports[id].base.name, sizeof(out[n].name));
+        out[n].wakeups = wakeups;
+        out[n].reads   = atomic_load_explicit(&g_rx[id].reads, memory_order_relaxed);
+        out[n].bytes   = atomic_load_explicit(&g_rx[id].bytes, memory_order_relaxed);
+        out[n].msgs    = atomic_load_explicit(&g_rx[id].msgs, memory_order_relaxed);
+        out[n].spliced = atomic_load_explicit(&g_rx[id].spliced, memory_order_relaxed);
+        out[n].splice_drops = atomic_load_explicit(&g_rx[id].splice_drops, memory_order_relaxed);
+        out[n].dgram_drops  = atomic_load_explicit(&g_rx[id].dgram_drops, memory_order_relaxed);
+        out[n].frame_drops  = atomic_load_explicit(&g_rx[id].frame_drops, memory_order_relaxed);
+        unsigned long gaps  = atomic_load_explicit(&g_rx[id].gap_frames, memory_order_relaxed);
+        out[n].gap_frames       = gaps;
+        out[n].gap_late_us_last = atomic_load_explicit(&g_rx[id].gap_late_us_last, memory_order_relaxed);
+        out[n].gap_late_us_max  = atomic_load_explicit(&g_rx[id].gap_late_us_max, memory_order_relaxed);
+        out[n].gap_late_us_avg  = gaps ? atomic_load_explicit(&g_rx[id].gap_late_us_sum,
+                                                              memory_order_relaxed) / gaps : 0;
+        out[n].short_gaps   = atomic_load_explicit(&g_rx[id].short_gaps, memory_order_relaxed);
+        out[n].early_splits = atomic_load_explicit(&g_rx[id].early_splits, memory_order_relaxed);
+        out[n].connects        = connects;
+        out[n].reconnects      = atomic_load_explicit(&g_rx[id].reconnects, memory_order_relaxed);
+        out[n].connect_fails   = fails;
+        out[n].connect_us_last = atomic_load_explicit(&g_rx[id].connect_us_last, memory_order_relaxed);
+        out[n].connect_us_max  = atomic_load_explicit(&g_rx[id].connect_us_max, memory_order_relaxed);
+        out[n].connect_us_avg  = connects ? atomic_load_explicit(&g_rx[id].connect_us_sum,
+                                                                 memory_order_relaxed) / connects : 0;
+        n++;
+    }
+    return n;
+}
+
+void reactor_log_stats(void)
+{
+    // busy% 按两次调用之间的增量算,只由主线程周期调用
+    static uint64_t prev_busy[REACTOR_MAX_THREADS];
+    static uint64_t prev_t = 0;
+
+    reactor_stats_t st[REACTOR_MAX_THREADS];
+    int n = reactor_get_stats(st, REACTOR_MAX_THREADS);
+    uint64_t t = now_ns();
+    uint64_t dt = prev_t ? t - prev_t : 0;
+    for (int i = 0; i < n; i++) {
+        double busy = dt ? 100.0 * (double)(st[i].busy_ns - prev_busy[i]) / (double)dt : 0.0;
+        LOG_DEBUG("[reactor] id=%d ports=%d wakeups=%lu events=%lu avg_events=%.1f "
+                  "max_events=%u busy=%.1f%%\n",
+                  st[i].id, st[i].ports, st[i].wakeups, st[i].events,
+                  st[i].wakeups ? (double)st[i].events / st[i].wakeups : 0.0,
+                  st[i].max_events, busy);
+        prev_busy[i] = st[i].busy_ns;
+    }
+    prev_t = t;
+
+    reactor_port_stats_t ps[MAX_PORTS];
+    n = reactor_get_port_stats(ps, MAX_PORTS);
+    for (int i = 0; i < n; i++) {
+        LOG_DEBUG("[reactor] port=%s wakeups=%lu reads=%lu reads_per_wakeup=%.1f "
+                  "bytes=%lu bytes_per_read=%.0f msgs=%lu msgs_per_read=%.1f spliced=%lu "
+                  "splice_drops=%lu dgram_drops=%lu frame_drops=%lu\n",
+                  ps[i].name, ps[i].wakeups, ps[i].reads,
+                  ps[i].wakeups ? (double)ps[i].reads / ps[i].wakeups : 0.0, ps[i].bytes,
+                  ps[i].reads ? (double)ps[i].bytes / ps[i].reads : 0.0, ps[i].msgs,
+                  ps[i].reads ? (double)ps[i].msgs / ps[i].reads : 0.0,
+                  ps[i].spliced, ps[i].splice_drops, ps[i].dgram_drops, ps[i].frame_drops);
+        if (ps[i].connects || ps[i].connect_fails)
+            LOG_DEBUG("[reactor] port=%s connects=%lu reconnects=%lu connect_fails=%lu "
+                      "connect_us last=%lu avg=%lu max=%lu\n",
+                      ps[i].name, ps[i].connects, ps[i].reconnects, ps[i].connect_fails,
+                      ps[i].connect_us_last, ps[i].connect_us_avg, ps[i].connect_us_max);
+        if (ps[i].gap_frames || ps[i].short_gaps || ps[i].early_splits)
+            LOG_DEBUG("[reactor] port=%s gap_frames=%lu gap_late_us last=%lu avg=%lu max=%lu "
+                      "short_gaps=%lu early_splits=%lu\n",
+                      ps[i].name, ps[i].gap_frames, ps[i].gap_late_us_last, ps[i].gap_late_us_avg,
+                      ps[i].gap_late_us_max, ps[i].short_gaps, ps[i].early_splits);
+    }
+}
+
 static pthread_mutex_t reactor_mutex=PTHREAD_MUTEX_INITIALIZER;
 void reactor_lock(){
     pthread_mutex_lock(&reactor_mutex);
@@ -215,7 +2114,7 @@ void reactor_clear_fds(){
     reactor_lock();
     for(int i=0;i<MAX_REACT_FDS;i++){
         if(reactor_fds[i]>0){
-            epoll_ctl(epfd, EPOLL_CTL_DEL,reactor_fds[i], NULL);
+            epoll_ctl(g_reactors[0].epfd, EPOLL_CTL_DEL,reactor_fds[i], NULL);
             reactor_fds[i]=-1;
         }
     }
@@ -231,40 +2130,80 @@ void reactor_add_fd(int fd){
     ev.events = EPOLLIN;
     ev.data.fd = fd;
 
-    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+    epoll_ctl(g_reactors[0].epfd, EPOLL_CTL_ADD, fd, &ev);
     reactor_fds[fd]=fd;
     reactor_unlock();
     LOG_INFO("[reactor] add fd=%d\n", fd);
 }
 
 
+static void reactor_watch(reactor_t* rc, port_def_t* port)
+{
+    reactor_lock();
+    if (g_uring) {
+        // 请求由 reactor 线程自己挂(SQ 单生产者);启动前加的端口在第一轮挂上
+        if (rc->arm_n < (int)(sizeof(rc->arm) / sizeof(rc->arm[0])))
+            rc->arm[rc->arm_n++] = port;
+        atomic_fetch_add_explicit(&rc->ports, 1, memory_order_relaxed);
+        reactor_unlock();
+        LOG_INFO("[reactor] %d: add %s fd=%d\n", rc->id, port->base.name, port->base.fd);
+        return;
+    }
+    struct epoll_event ev;
+    ev.events = rx_events(port);
+   //ev.data.fd = fd;
+    ev.data.ptr=port;
+
+    epoll_ctl(rc->epfd, EPOLL_CTL_ADD, port->base.fd, &ev);
+    atomic_fetch_add_explicit(&rc->ports, 1, memory_order_relaxed);
+    reactor_unlock();
+    LOG_INFO("[reactor] %d: add %s fd=%d\n", rc->id, port->base.name, port->base.fd);
+}
+
+// 多 reactor 时给 tcp_server 在其余每个 reactor 上各开一个 SO_REUSEPORT listener,
+// 新连接由内核分摊,accept 出的 client 留在接受它的 reactor 上。
+// 分片 listener 不占端口句柄(不会是目的端口),常驻到进程退出。
+static void reactor_add_listener_shards(port_def_t* server)
+{
+    for (int k = 0; k < g_reactor_count; k++) {
+        if (k == server->base.reactor) continue;
+        int fd = port_open_tcp_listener(server);
+        if (fd < 0) {
+            LOG_WARN("[reactor] %s: listener for reactor %d failed, accepts stay on %d\n",
+                     server->base.name, k, server->base.reactor);
+            continue;
+        }
+        port_def_t* shard = malloc(sizeof(port_def_t));
+        if (!shard) {
+            close(fd);
+            continue;
+        }
+        *shard = *server;
+        shard->base.fd = fd;
+        shard->base.reactor = k;
+        shard->base.handle = PORT_HANDLE_INVALID;
+        reactor_watch(&g_reactors[k], shard);
+    }
+}
+
 void reactor_add_port(port_def_t* port){
 
    if(!port) return;
 
    int fd=port->base.fd;
-   if(fd<0) return;
+   if(fd<0 && !is_dialer(port)) return;   // tcp_client 没建成 socket 也登记,之后重连
+   if (g_reactor_count == 0) return;
 
-   for(int i=0;i<MAX_PORTS;i++){
-        if(!g_port_table[i].used){
-            g_port_table[i].used=1;
-            g_port_table[i].fd=port->base.fd;
-            g_port_table[i].port=port;
-            break;
-        }
-    }
+   port_register(port);
     LOG_INFO("add reactor table");
 
-    reactor_lock();
-    struct epoll_event ev;
-    ev.events = EPOLLIN;
-   //ev.data.fd = fd;
-    ev.data.ptr=port;
+    if (is_dialer(port)) {
+        dial_begin(reactor_of(port), port);   // 连上之后才挂读
+        return;
+    }
+    reactor_watch(reactor_of(port), port);
 
-    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
-   // reactor_fds[fd]=fd;
-    // reactor_table[fd].fd=fd;
-    // reactor_table[fd].handler=h;
-    reactor_unlock();
-    LOG_INFO("[reactor] add fd=%d\n", fd);
-}
\ No newline at end of file
+    if (port->base.type == PORT_TCP_SERVER && g_reactor_count > 1 &&
+        port->base.id >= 0 && port == &g_config.ports[port->base.id])
+        reactor_add_listener_shards(port);
+}
@@ -0,0 +1,117 @@
+// route_table.c — 编译后的路由表
+//
+// 详见 route_table.h 文件头。
+//
+// 并发:build 在单线程启动阶段写 g_table,之后 reactor 只读。
+//
+// 测试:tests/unit/test_route_table.c
+
+#include <stdio.h>
+#include <string.h>
+#include "route_table.h"
+#include "dispatch_pool.h"
+#include "frame.h"
+#include "log.h"
+
+static route_src_t g_table[MAX_PORTS];
+
+static int port_index(const char* name)
+{
+    for (int i = 0; i < g_config.port_count; i++) {
+        if (strcmp(g_config.ports[i].base.name, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+// 单连接字节流端口:一个 fd,写的字节原样到达对端
+static int is_stream_port(const port_def_t* p)
+{
+    return p->base.type == PORT_TTY || p->base.type == PORT_USB ||
+           p->base.type == PORT_TCP_CLIENT || p->base.type == PORT_IPC_CLIENT;
+}
+
+// 所有路由编好后再判 splice:要看源的路由数和目的被几条路由写。
+// 配了断线缓存的 tcp_client 目的不直通:缓存在发送引擎里(port_tx.h);
+// 分帧的源不直通:帧要在 reactor 里切(frame.h)
+static void mark_splice(void)
+{
+    int writers[MAX_PORTS] = {0};
+    for (int src = 0; src < MAX_PORTS; src++)
+        for (int j = 0; j < g_table[src].n; j++)
+            writers[g_table[src].e[j].dst_id]++;
+
+    for (int src = 0; src < g_config.port_count && src < MAX_PORTS; src++) {
+        route_src_t* s = &g_table[src];
+        if (s->n != 1) continue;
+        route_entry_t* e = &s->e[0];
+        const port_def_t* sp = &g_config.ports[src];
+        const port_def_t* dp = &g_config.ports[e->dst_id];
+        e->splice = e->def->splice && e->def->handler[0] == '\0' &&
+                    e->policy != ROUTE_POLICY_DROP && e->dst_id != src &&
+                    writers[e->dst_id] == 1 && is_stream_port(sp) && is_stream_port(dp) &&
+                    !frame_conf_of(sp) &&
+                    dp->base.coalesce.max_delay_us == 0 &&
+                    !(dp->base.type == PORT_TCP_CLIENT && dp->cfg.tcp_client.buffer_bytes > 0);
+        if (e->splice)
+            LOG_INFO("[route] %s -> %s: splice fast path\n", e->def->src, e->def->dst);
+    }
+}
+
+int route_table_build(void)
+{
+    int total = 0;
+    memset(g_table, 0, sizeof(g_table));
+
+    for (int i = 0; i < g_config.route_count; i++) {
+        const route_def_t* r = &g_config.routes[i];
+
+        int src = port_index(r->src);
+        if (src < 0) {
+            LOG_WARN("[route] %s -> %s: src port not configured, skipped\n", r->src, r->dst);
+            continue;
+        }
+        int dst = port_index(r->dst);
+        if (dst < 0 || !dispatch_queue_by_name(r->dst)) {
+            LOG_WARN("[route] %s -> %s: no dst port/queue, skipped\n", r->src, r->dst);
+            continue;
+        }
+
+        route_src_t* s = &g_table[src];
+        if (s->n >= ROUTE_MAX_PER_SRC) {
+            LOG_WARN("[route] %s: more than %d routes, %s dropped\n",
+                     r->src, ROUTE_MAX_PER_SRC, r->dst);
+            continue;
+        }
+
+        plugin_handler_t h = NULL;
+        plugin_handler_v2_t h2 = NULL;
+        if (r->handler[0] != '\0') {
+            h = plugin_get_handler(r->handler);
+            h2 = plugin_get_handler_v2(r->handler);
+            if (!h && !h2)
+                LOG_WARN("[route] %s -> %s: handler %s not registered, pass through\n",
+                         r->src, r->dst, r->handler);
+        }
+
+        route_entry_t* e = &s->e[s->n++];
+        e->def     = r;
+        e->dst_id  = dst;
+        for (int k = 0; k < dispatch_pool_lanes(); k++)
+            e->q[k] = dispatch_lane(r->dst, k);
+        e->handler = h;
+        e->handler_v2 = h2;
+        e->policy  = r->policy;
+        total++;
+        LOG_INFO("[route] %s(%d) -> %s(%d) handler=%s policy=%s\n",
+                 r->src, src, r->dst, dst, (h || h2) ? r->handler : "-", route_policy_name(r->policy));
+    }
+    mark_splice();
+    return total;
+}
+
+const route_src_t* route_table_for_src(int port_id)
+{
+    if (port_id < 0 || port_id >= MAX_PORTS) return NULL;
+    return &g_table[port_id];
+}
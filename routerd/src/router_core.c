@@ -1,28 +1,329 @@
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
 #include "router_core.h"
 #include "router_link.h"
 #include "port_map.h"
 // #include "forward.h"
-// #include "config_store.h"
+#include "config_store.h"
 #include "port_manager.h"
+#include "port_tx.h"
+#include "uring.h"
 #include "log.h"
 void router_core_handle(event_msg_t* msg)
 {
     if (!msg) return;
 
-    LOG_INFO("[router] enter routers and get port");
-    port_def_t* dst = port_find(msg->dst);
+    // 句柄 → 端口是数组下标 + generation 校验,不做字符串查找。
+    // 入队后目的连接已断开(句柄过期)的消息直接丢弃,不会写到复用同一 fd 的新连接。
+    // tcp_server / ipc_server 作为 dst 时由 port_send 广播给它 accept 出的 client。
+    port_def_t* dst = port_from_handle(msg->dst);
     if (!dst) {
-        LOG_ERROR("[router] ERROR: dst port '%s' not found\n", msg->dst);
+        LOG_WARN("[router] dst handle 0x%x stale or invalid, drop %d bytes\n", msg->dst, msg->len);
         return;
     }
-    LOG_INFO("[router] find port success,dst name=%s,fd=%d\n",dst->base.name,dst->base.fd);
+    LOG_INFO("[router] dst name=%s,fd=%d\n",dst->base.name,dst->base.fd);
 
-    LOG_INFO("[router] write data to %s\n", msg->dst);
-    LOG_INFO("[router] write data to %s\n", msg->data);
-    int w = port_send(dst, msg->data, msg->len);
+    LOG_INFO("[router] write data to %.*s\n", msg->len, msg->data);
+    // 带上池缓冲:要排队(含广播给多个 client)时引用它而不拷贝
+    struct iovec one = {.iov_base = msg->data, .iov_len = (size_t)msg->len};
+    int w = port_send_batch_bufs(dst, &one, &msg->buf, 1);
     if (w < 0) {
-        LOG_ERROR("[router] ERROR: send failed on %s\n", msg->dst);
+        LOG_ERROR("[router] ERROR: send failed on %s\n", dst->base.name);
     }
 }
+
+// ============================================
+// io_uring 发送("reactor": {"backend": "io_uring"} 时)
+//
+// 每个 dispatch worker 一个环(线程局部,首次用时建,建不了就一直走 port_tx 直写)。
+// 一批消息按 dst 分组后每组一个写 SQE(server 目的按 client 展开):socket 用
+// SENDMSG(MSG_DONTWAIT | MSG_NOSIGNAL),tty / usb 用 WRITEV(RWF_NOWAIT),都不阻塞。
+// 只有一个写时直接走 port_tx(环的收益在于一次系统调用发多个 fd);
+// 同 fd 的 SQE 排在一起并用 IOSQE_IO_LINK 串起来,内核按序执行;
+// 整批一次 io_uring_enter 提交并等全部完成。短写 / EAGAIN / 链断(-ECANCELED)
+// 的剩余部分按原顺序交给该端口的输出环(port_tx_queue),可写时由 worker 冲刷。
+// 已有排队字节的端口不进环,直接 port_tx_write 排在后面,保证同一 fd 字节不乱序。
+// ============================================
+typedef struct {
+    port_def_t*         port;
+    const struct iovec* iov;
+    struct buf* const*  bufs;
+    int                 cnt;
+    size_t              len;
+    struct msghdr       mh;
+} tx_op_t;
+
+static __thread uring_t tx_ring;
+static __thread int     tx_ring_state;   // 0 = 未建,1 = 可用,-1 = 不可用
+
+static uring_t* tx_ring_get(void)
+{
+    if (tx_ring_state == 0) {
+        int r = uring_init(&tx_ring, ROUTER_URING_OPS);
+        tx_ring_state = (r == 0) ? 1 : -1;
+        if (r < 0)
+            LOG_WARN("[router] io_uring tx ring unavailable (errno=%d), using writev\n", -r);
+    }
+    return tx_ring_state > 0 ? &tx_ring : NULL;
+}
+
+static int is_socket(const port_def_t* p)
+{
+    return p->base.type == PORT_TCP_CLIENT || p->base.type == PORT_IPC_CLIENT;
+}
+
+static void tx_flush(uring_t* u, port_tx_t* tx, tx_op_t* ops, int n)
+{
+    if (n == 0) return;
+    if (n == 1) {
+        // 单个写:一次 writev 就够,走环反而多一轮提交 / 收割
+        if (port_tx_write(tx, ops[0].port, ops[0].iov, ops[0].bufs, ops[0].cnt) < 0)
+            LOG_WARN("[router] write to %s fd=%d failed, errno=%d\n",
+                     ops[0].port->base.name, ops[0].port->base.fd, errno);
+        return;
+    }
+
+    // 同 fd 的 op 挪到一起(稳定插入排序,保留各 fd 内的先后),再串成 link
+    for (int i = 1; i < n; i++) {
+        tx_op_t t = ops[i];
+        int j = i;
+        while (j > 0 && ops[j - 1].port->base.fd > t.port->base.fd) {
+            ops[j] = ops[j - 1];
+            j--;
+        }
+        ops[j] = t;
+    }
+
+    int res[ROUTER_URING_OPS];
+    for (int i = 0; i < n; i++) {
+        struct io_uring_sqe* sqe = uring_get_sqe(u);   // n <= 环大小,不会取不到
+        int fd = ops[i].port->base.fd;
+        sqe->fd = fd;
+        if (is_socket(ops[i].port)) {
+            memset(&ops[i].mh, 0, sizeof(ops[i].mh));
+            ops[i].mh.msg_iov    = (struct iovec*)ops[i].iov;
+            ops[i].mh.msg_iovlen = (size_t)ops[i].cnt;
+            sqe->opcode    = IORING_OP_SENDMSG;
+            sqe->addr      = (uint64_t)(uintptr_t)&ops[i].mh;
+            sqe->msg_flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+        } else {
+            sqe->opcode   = IORING_OP_WRITEV;
+            sqe->addr     = (uint64_t)(uintptr_t)ops[i].iov;
+            sqe->len      = (unsigned)ops[i].cnt;
+            sqe->off      = (uint64_t)-1;
+            sqe->rw_flags = RWF_NOWAIT;
+        }
+        sqe->user_data = (uint64_t)i;
+        if (i + 1 < n && ops[i + 1].port->base.fd == fd) sqe->flags = IOSQE_IO_LINK;
+        res[i] = -ECANCELED;
+    }
+
+    int got = 0;
+    int r = uring_submit(u, (unsigned)n);
+    while (got < n) {
+        if (r < 0 && r != -EINTR) break;
+        struct io_uring_cqe* cqe;
+        while ((cqe = uring_peek_cqe(u)) != NULL) {
+            if (cqe->user_data < (uint64_t)n) res[cqe->user_data] = cqe->res;
+            uring_cqe_seen(u);
+            got++;
+        }
+        if (got < n) r = uring_submit(u, (unsigned)(n - got));
+    }
+    if (got < n) {
+        // 等不到完成就不能复用 iov / 环:放弃这个环,之后走 port_tx 直写
+        LOG_ERROR("[router] io_uring wait failed (errno=%d), disabling tx ring\n", -r);
+        tx_ring_state = -1;
+        return;
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (res[i] >= 0 && (size_t)res[i] == ops[i].len) continue;
+        if (res[i] >= 0 || res[i] == -EAGAIN || res[i] == -ECANCELED) {
+            port_tx_queue(tx, ops[i].port, ops[i].iov, ops[i].bufs, ops[i].cnt,
+                          res[i] > 0 ? (size_t)res[i] : 0);
+            continue;
+        }
+        LOG_WARN("[router] write to %s fd=%d failed, errno=%d\n",
+                 ops[i].port->base.name, ops[i].port->base.fd, -res[i]);
+    }
+}
+
+static void router_core_handle_batch_uring(uring_t* u, port_tx_t* tx, event_msg_t* msgs, int n)
+{
+    struct iovec iov[ROUTER_URING_OPS];   // 每条消息一段,n <= dispatch 批大小
+    struct buf*  bufs[ROUTER_URING_OPS];  // 每段所在的池缓冲,排队时引用
+    tx_op_t      ops[ROUTER_URING_OPS];
+    int          nops = 0;
+    int          used = 0;
+
+    for (int i = 0; i < n; ) {
+        if (used == ROUTER_URING_OPS) {   // iov 用完:先把前面的发掉
+            tx_flush(u, tx, ops, nops);
+            nops = used = 0;
+        }
+        int j = i;
+        while (j < n && j - i < ROUTER_IOV_MAX && used + (j - i) < ROUTER_URING_OPS &&
+               msgs[j].dst == msgs[i].dst) {
+            iov[used + j - i].iov_base = msgs[j].data;
+            iov[used + j - i].iov_len  = (size_t)msgs[j].len;
+            bufs[used + j - i]         = msgs[j].buf;
+            j++;
+        }
+        int cnt = j - i;
+        size_t len = 0;
+        for (int k = 0; k < cnt; k++) len += iov[used + k].iov_len;
+
+        port_def_t* dst = port_from_handle(msgs[i].dst);
+        if (!dst) {
+            LOG_WARN("[router] dst handle 0x%x stale or invalid, drop %d msgs\n", msgs[i].dst, cnt);
+            i = j;
+            continue;
+        }
+
+        // 目的句柄:server 目的展开成各 client 的句柄快照,用前逐个重新解析
+        port_handle_t targets[MAX_PORTS];
+        int nt = 0;
+        switch (dst->base.type) {
+        case PORT_TTY:
+        case PORT_USB:
+        case PORT_TCP_CLIENT:
+        case PORT_IPC_CLIENT:
+            targets[nt++] = msgs[i].dst;
+            break;
+        case PORT_TCP_SERVER:
+        case PORT_IPC_SERVER:
+            nt = port_server_clients(dst, targets, MAX_PORTS);
+            break;
+        default:
+            // UDP 等无连接目的不走环,保持原语义
+            port_send_batch_bufs(dst, &iov[used], &bufs[used], cnt);
+            break;
+        }
+
+        LOG_INFO("[router] uring batch %d msgs to %s (%d fd)\n", cnt, dst->base.name, nt);
+        for (int t = 0; t < nt; t++) {
+            port_def_t* tp = port_from_handle(targets[t]);
+            if (!tp) continue;   // client 已断开
+            if (!port_tx_idle(tx, tp)) {
+                // 前面还有排队字节:直接排在后面,不进环
+                port_tx_write(tx, tp, &iov[used], &bufs[used], cnt);
+                continue;
+            }
+            if (nops == ROUTER_URING_OPS || tx_ring_state < 0) {
+                tx_flush(u, tx, ops, nops);
+                nops = 0;
+                if (tx_ring_state < 0) {   // 环失效:剩下的走 port_tx 直写
+                    for (int g = t; g < nt; g++) {
+                        port_def_t* gp = port_from_handle(targets[g]);
+                        if (gp) port_tx_write(tx, gp, &iov[used], &bufs[used], cnt);
+                    }
+                    router_core_handle_batch(msgs + j, n - j);
+                    return;
+                }
+            }
+            ops[nops].port = tp;
+            ops[nops].iov  = &iov[used];
+            ops[nops].bufs = &bufs[used];
+            ops[nops].cnt  = cnt;
+            ops[nops].len  = len;
+            nops++;
+        }
+        used += cnt;
+        i = j;
+    }
+    tx_flush(u, tx, ops, nops);
+}
+
+// 一批消息(同一条目的队列出来的,通常同一个 dst)按连续同 dst 分组,
+// 每组一次 port_send_batch(writev)。小包负载下系统调用数从 n 降到组数。
+void router_core_handle_batch(event_msg_t* msgs, int n)
+{
+    struct iovec iov[ROUTER_IOV_MAX];
+    struct buf*  bufs[ROUTER_IOV_MAX];
+
+    port_tx_t* tx = port_tx_current();
+    if (tx && g_config.reactor_backend == REACTOR_BACKEND_URING && tx_ring_state >= 0) {
+        uring_t* u = tx_ring_get();
+        if (u) {
+            router_core_handle_batch_uring(u, tx, msgs, n);
+            return;
+        }
+    }
+
+    for (int i = 0; i < n; ) {
+        int j = i;
+        while (j < n && j - i < ROUTER_IOV_MAX && msgs[j].dst == msgs[i].dst) {
+            iov[j - i].iov_base = msgs[j].data;
+            iov[j - i].iov_len  = (size_t)msgs[j].len;
+            bufs[j - i]         = msgs[j].buf;
+            j++;
+        }
+
+        port_def_t* dst = port_from_handle(msgs[i].dst);
+        if (!dst) {
+            LOG_WARN("[router] dst handle 0x%x stale or invalid, drop %d msgs\n", msgs[i].dst, j - i);
+        } else if (j - i == 1) {
+            router_core_handle(&msgs[i]);
+        } else {
+            LOG_INFO("[router] batch %d msgs to %s fd=%d\n", j - i, dst->base.name, dst->base.fd);
+            if (port_send_batch_bufs(dst, iov, bufs, j - i) < 0)
+                LOG_ERROR("[router] ERROR: batch send failed on %s\n", dst->base.name);
+        }
+        i = j;
+    }
+}
+
+// ============================================
+// dispatch worker 的发送挂钩:每 worker 一个 port_tx 引擎
+// ============================================
+static int tx_thread_init(void)
+{
+    port_reader_register();   // 每轮发送期间解析出的端口不被 reactor 回收(port_retire)
+    port_tx_t* tx = port_tx_create();
+    if (!tx) {
+        LOG_WARN("[router] tx engine create failed, worker sends synchronously\n");
+        return -1;
+    }
+    port_tx_bind(tx);
+    return port_tx_fd(tx);
+}
+
+static int tx_poll(void)
+{
+    port_tx_t* tx = port_tx_current();
+    port_tx_poll(tx);
+    return port_tx_timeout_ms(tx);
+}
+
+static int tx_blocked(int port_id)
+{
+    port_tx_t* tx = port_tx_current();
+    if (!tx || port_id < 0 || port_id >= g_config.port_count) return 0;
+    return port_tx_blocked(tx, port_id);
+}
+
+static void tx_thread_exit(void)
+{
+    port_tx_destroy(port_tx_current());
+    if (tx_ring_state > 0) uring_exit(&tx_ring);
+    tx_ring_state = 0;
+    port_reader_unregister();
+}
+
+const dispatch_tx_hooks_t* router_core_tx_hooks(void)
+{
+    static const dispatch_tx_hooks_t hooks = {
+        .thread_init = tx_thread_init,
+        .poll        = tx_poll,
+        .blocked     = tx_blocked,
+        .round_begin = port_read_begin,
+        .round_end   = port_read_end,
+        .thread_exit = tx_thread_exit,
+    };
+    return &hooks;
+}
@@ -0,0 +1,50 @@
+// tty_baud.c — termios2 任意波特率与 ASYNC_LOW_LATENCY
+//
+// 详见 tty_baud.h 文件头。这里刻意不包含 <termios.h>。
+//
+// 测试:tests/unit/test_tty_baud.c
+
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <asm/termbits.h>
+#include <linux/serial.h>
+#include "tty_baud.h"
+
+int tty_set_baud(int fd, int baud)
+{
+    if (baud <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct termios2 t;
+    if (ioctl(fd, TCGETS2, &t) < 0) return -1;
+    // 输出速率在 CBAUD,输入速率在 CIBAUD(= CBAUD << IBSHIFT);两个都改成 BOTHER
+    t.c_cflag &= ~(CBAUD | (CBAUD << IBSHIFT));
+    t.c_cflag |= BOTHER | (BOTHER << IBSHIFT);
+    t.c_ispeed = (speed_t)baud;
+    t.c_ospeed = (speed_t)baud;
+    if (ioctl(fd, TCSETS2, &t) < 0) return -1;
+    return tty_get_baud(fd);   // 驱动按分频器能做到的值改写 c_ospeed
+}
+
+int tty_get_baud(int fd)
+{
+    struct termios2 t;
+    if (ioctl(fd, TCGETS2, &t) < 0) return -1;
+    return (int)t.c_ospeed;
+}
+
+int tty_baud_error_ppm(int requested, int actual)
+{
+    if (requested <= 0) return 0;
+    return (int)(((long long)actual - requested) * 1000000 / requested);
+}
+
+int tty_set_low_latency(int fd, int on)
+{
+    struct serial_struct ss;
+    if (ioctl(fd, TIOCGSERIAL, &ss) < 0) return -1;
+    if (on) ss.flags |= ASYNC_LOW_LATENCY;
+    else    ss.flags &= ~ASYNC_LOW_LATENCY;
+    return ioctl(fd, TIOCSSERIAL, &ss);
+}
@@ -0,0 +1,143 @@
+// bench_byte_scan.c — 字节查找吞吐:逐字节循环 vs byte_scan 向量实现
+//
+// 目的:量化分帧 / 重同步热路径上"找边界字节"的开销(GB/s,单核)。
+//   byte  找单个字节(cobs 的 0x00、slip 丢弃中的 END)     对照 逐字节 / glibc memchr
+//   pair  找两字节魔数(PROTO_MAGIC 7C EB 重同步)          对照 逐字节
+//   set   找 2 种字节之一(slip 的 END / ESC)              对照 逐字节
+//   seq   找多字节分隔符("\r\n" / 4 字节)                对照 逐字节 / glibc memmem
+//
+// 数据是不含目标字节的随机字节,目标只放在末尾:每次都要扫完整段,即最坏情况
+// (也是大多数读缓冲里的常态——一帧只有一个边界)。长度取 64(短帧)、1024
+// (MAX_DATA,一次读)、65536(PROTO_MAX_PAYLOAD,ipc 收缓冲)。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -O2 -Wall -Wextra -D_GNU_SOURCE -I routerd/include routerd/src/byte_scan.c tests/bench/bench_byte_scan.c -o /tmp/bench_byte_scan
+//   /tmp/bench_byte_scan [总字节数 MiB,默认 2048]
+//
+// 输出:每种 长度 × 实现一行,GB/s;hits 是命中偏移之和,同一组内应一致。
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "byte_scan.h"
+
+// ---- 逐字节对照(noinline:不让编译器把它和调用点一起特化掉)----
+__attribute__((noinline))
+static const uint8_t* loop_byte(const uint8_t* p, size_t n, uint8_t b)
+{
+    for (size_t i = 0; i < n; i++) if (p[i] == b) return p + i;
+    return NULL;
+}
+
+__attribute__((noinline))
+static const uint8_t* loop_pair(const uint8_t* p, size_t n, uint8_t b0, uint8_t b1)
+{
+    for (size_t i = 0; i + 1 < n; i++) if (p[i] == b0 && p[i + 1] == b1) return p + i;
+    return NULL;
+}
+
+__attribute__((noinline))
+static const uint8_t* loop_set2(const uint8_t* p, size_t n, uint8_t a, uint8_t b)
+{
+    for (size_t i = 0; i < n; i++) if (p[i] == a || p[i] == b) return p + i;
+    return NULL;
+}
+
+__attribute__((noinline))
+static const uint8_t* loop_seq(const uint8_t* p, size_t n, const uint8_t* d, size_t m)
+{
+    for (size_t i = 0; i + m <= n; i++) if (p[i] == d[0] && memcmp(p + i, d, m) == 0) return p + i;
+    return NULL;
+}
+
+static const uint8_t k_set[2]  = { 0xC0, 0xDB };
+static const uint8_t k_crlf[2] = { '\r', '\n' };
+static const uint8_t k_d4[4]   = { 0xAA, 0x55, 0xAA, 0x55 };
+
+enum { K_LOOP_BYTE, K_MEMCHR, K_SCAN_BYTE,
+       K_LOOP_PAIR, K_SCAN_PAIR,
+       K_LOOP_SET, K_SCAN_SET,
+       K_LOOP_CRLF, K_MEMMEM_CRLF, K_SCAN_CRLF,
+       K_LOOP_D4, K_MEMMEM_D4, K_SCAN_D4, K_COUNT };
+
+static const char* k_name[K_COUNT] = {
+    "byte  loop", "byte  memchr", "byte  scan",
+    "pair  loop", "pair  scan",
+    "set   loop", "set   scan",
+    "crlf  loop", "crlf  memmem", "crlf  scan",
+    "seq4  loop", "seq4  memmem", "seq4  scan",
+};
+
+static const uint8_t* call(int k, const uint8_t* p, size_t n)
+{
+    switch (k) {
+    case K_LOOP_BYTE:   return loop_byte(p, n, 0xC0);
+    case K_MEMCHR:      return memchr(p, 0xC0, n);
+    case K_SCAN_BYTE:   return scan_byte(p, n, 0xC0);
+    case K_LOOP_PAIR:   return loop_pair(p, n, 0x7C, 0xEB);
+    case K_SCAN_PAIR:   return scan_pair(p, n, 0x7C, 0xEB);
+    case K_LOOP_SET:    return loop_set2(p, n, 0xC0, 0xDB);
+    case K_SCAN_SET:    return scan_set(p, n, k_set, 2);
+    case K_LOOP_CRLF:   return loop_seq(p, n, k_crlf, 2);
+    case K_MEMMEM_CRLF: return memmem(p, n, k_crlf, 2);
+    case K_SCAN_CRLF:   return scan_seq(p, n, k_crlf, 2);
+    case K_LOOP_D4:     return loop_seq(p, n, k_d4, 4);
+    case K_MEMMEM_D4:   return memmem(p, n, k_d4, 4);
+    case K_SCAN_D4:     return scan_seq(p, n, k_d4, 4);
+    }
+    return NULL;
+}
+
+// 随机内容,但不含任何目标字节;末尾放上各种目标(pair / seq 的命中都在最后几个字节)
+static void fill(uint8_t* p, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        uint8_t b;
+        do b = (uint8_t)rand();
+        while (b == 0xC0 || b == 0xDB || b == 0x7C || b == '\r' || b == 0xAA);
+        p[i] = b;
+    }
+    memcpy(p + n - 4, k_d4, 4);   // seq4 命中
+    p[n - 6] = '\r';              // crlf 命中
+    p[n - 5] = '\n';
+    p[n - 8] = 0x7C;              // pair 命中
+    p[n - 7] = 0xEB;
+    p[n - 9] = 0xC0;              // byte / set 命中(最靠前的目标,其他组不会提前命中)
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t total = (size_t)((argc > 1) ? atol(argv[1]) : 2048) << 20;
+    static const size_t lens[] = { 64, 1024, 65536 };
+
+    printf("impl=%s  total=%zu MiB per row\n", scan_impl(), total >> 20);
+    for (size_t li = 0; li < sizeof(lens) / sizeof(lens[0]); li++) {
+        size_t n = lens[li];
+        uint8_t* buf = malloc(n);
+        fill(buf, n);
+        long reps = (long)(total / n);
+        printf("\nlen=%zu\n", n);
+        for (int k = 0; k < K_COUNT; k++) {
+            volatile size_t hits = 0;
+            double t0 = now_s();
+            for (long r = 0; r < reps; r++) {
+                const uint8_t* h = call(k, buf, n);
+                hits += h ? (size_t)(h - buf) : 0;
+            }
+            double dt = now_s() - t0;
+            printf("  %-13s %8.2f GB/s  hits=%zu\n", k_name[k],
+                   (double)reps * n / dt / 1e9, (size_t)hits / (size_t)reps);
+        }
+        free(buf);
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+// bench_event_queue.c — event_queue SPSC 环 vs 旧 mutex/condvar 队列的微基准
+//
+// 目的:量化 reactor → dispatcher 这一跳的每消息开销。
+//   legacy: 旧实现逐行复刻(mutex + 两个 condvar,每次 push/pop 都加锁 + signal)
+//   spsc  : routerd/src/event_queue.c 现行实现(原子 head/tail + eventfd 边沿唤醒)
+//
+// 两种负载:
+//   stream: 生产者连续灌 N 条(模拟 UART 突发),消费者尽快取
+//   burst : 生产者每 BURST 条 sleep 一下(模拟多个 UART 交错的突发 + 空闲),
+//           消费者经常睡眠,考察 empty→non-empty 唤醒路径
+//
+// 消息体就是真实的 event_msg_t(消息头,数据在 buf_pool),两边都按值拷贝,比较的是同步开销。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -O2 -Wall -Wextra -D_GNU_SOURCE -I routerd/include routerd/src/event_queue.c routerd/src/log.c tests/bench/bench_event_queue.c -lpthread -o /tmp/bench_event_queue
+//   /tmp/bench_event_queue [N]
+//
+// 输出:每种实现 × 负载一行,ns/msg 与 Mmsg/s。结果仅作相对比较,
+//   绝对值受核数 / 大小核调度影响很大(RK3588 上建议 taskset 绑 A76 两核)。
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "event_queue.h"
+#include "log.h"
+
+#define BURST 64
+
+// ---------------- legacy:旧 mutex/condvar 实现(无 timeout 分支,稳态不触发) ----------------
+#define LQSIZE 128
+static event_msg_t      l_queue[LQSIZE];
+static int              l_head = 0, l_tail = 0;
+static pthread_mutex_t  l_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   l_not_empty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t   l_not_full  = PTHREAD_COND_INITIALIZER;
+
+static int legacy_push(event_msg_t* msg)
+{
+    pthread_mutex_lock(&l_lock);
+    while (((l_tail + 1) % LQSIZE) == l_head)
+        pthread_cond_wait(&l_not_full, &l_lock);
+    l_queue[l_tail] = *msg;
+    l_tail = (l_tail + 1) % LQSIZE;
+    pthread_cond_signal(&l_not_empty);
+    pthread_mutex_unlock(&l_lock);
+    return 0;
+}
+
+static void legacy_pop(event_msg_t* msg)
+{
+    pthread_mutex_lock(&l_lock);
+    while (l_head == l_tail)
+        pthread_cond_wait(&l_not_empty, &l_lock);
+    *msg = l_queue[l_head];
+    l_head = (l_head + 1) % LQSIZE;
+    pthread_cond_signal(&l_not_full);
+    pthread_mutex_unlock(&l_lock);
+}
+
+static event_queue_t* g_q;
+
+// spsc 的 push 在满时会 timeout drop;bench 里生产者遇到 -1 就重试,
+// 保证两边传递的消息数相同(drop 次数单独打印)。
+static int spsc_push(event_msg_t* msg)
+{
+    while (queue_push(g_q, msg) != 0) {}
+    return 0;
+}
+
+static void spsc_pop(event_msg_t* msg)
+{
+    queue_pop(g_q, msg);
+}
+
+// ---------------- 驱动 ----------------
+typedef struct {
+    const char* name;
+    int  (*push)(event_msg_t*);
+    void (*pop)(event_msg_t*);
+} impl_t;
+
+typedef struct {
+    const impl_t* impl;
+    long n;
+    int  bursty;
+} run_arg_t;
+
+static void* producer(void* p)
+{
+    run_arg_t* a = p;
+    event_msg_t msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.dst = 1;
+    for (long i = 0; i < a->n; i++) {
+        msg.len = (int)i;   // 用 len 携带序号
+        a->impl->push(&msg);
+        if (a->bursty && (i % BURST) == BURST - 1)
+            usleep(50);
+    }
+    return NULL;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run(const impl_t* impl, long n, int bursty)
+{
+    run_arg_t a = {.impl = impl, .n = n, .bursty = bursty};
+    event_msg_t got;
+    long bad = 0;
+
+    double t0 = now_s();
+    pthread_t th;
+    pthread_create(&th, NULL, producer, &a);
+    for (long i = 0; i < n; i++) {
+        impl->pop(&got);
+        if (got.len != (int)i) bad++;
+    }
+    pthread_join(th, NULL);
+    double dt = now_s() - t0;
+
+    printf("%-7s %-6s n=%-8ld %8.1f ns/msg %7.3f Mmsg/s  order_err=%ld\n",
+           impl->name, bursty ? "burst" : "stream", n,
+           dt * 1e9 / n, n / dt / 1e6, bad);
+}
+
+int main(int argc, char* argv[])
+{
+    long n = (argc > 1) ? atol(argv[1]) : 1000000;
+    log_init(0, LOG_LEVEL_WARN);
+    g_q = queue_create("BENCH", NULL);
+
+    static const impl_t legacy = {"legacy", legacy_push, legacy_pop};
+    static const impl_t spsc   = {"spsc",   spsc_push,   spsc_pop};
+
+    printf("sizeof(event_msg_t)=%zu\n", sizeof(event_msg_t));
+    run(&legacy, n, 0);
+    run(&spsc,   n, 0);
+    run(&legacy, n / 10, 1);
+    run(&spsc,   n / 10, 1);
+    printf("spsc timeout drops (retried): %lu\n", queue_get_drop_count(g_q));
+    queue_destroy(g_q);
+    return 0;
+}
@@ -0,0 +1,230 @@
+// bench_reactor_backend.c — reactor 后端对比:epoll vs io_uring
+//
+// 目的:同一条路由 SRC → DST(无 handler,block 策略),分别用两种后端跑完整数据面
+//   (reactor 读 → 队列 → dispatch worker 写),量化后端切换带来的差异;
+//   再加一行 epoll + splice 直通(route_table.h,不经队列和 worker)作对照。
+//   源端口两种:
+//     pty        : SRC 是 pty 从端(raw + O_NONBLOCK),模拟串口
+//     socketpair : SRC 是 AF_UNIX 流 socket,模拟 TCP / IPC client
+//   DST 始终是 socketpair 一端。socketpair 端口登记为 ipc_client:配置里的 tcp_client
+//   归 reactor 的拨号逻辑管(连接超时 / 重连),会把现成的 socketpair 当成没连上关掉。每个 (后端 × 源) 组合 fork 一个子进程跑,
+//   互不影响(reactor / 队列 / 缓冲池都是进程级单例)。
+//
+// 两项指标:
+//   pingpong : 写 64 字节进 SRC 对端,等 DST 对端收到再写下一条 → 单消息往返延迟
+//   stream   : 连续写 STREAM_BYTES(每次 512 字节),DST 对端收完计时 → 吞吐
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -O2 -Wall -Wextra -D_GNU_SOURCE -I routerd/include -I routerd/3rdparty/cjson routerd/src/reactor.c routerd/src/uring.c routerd/src/router_core.c routerd/src/port_map.c routerd/src/port_manager.c routerd/src/tty_baud.c routerd/src/port_tx.c routerd/src/config_store.c routerd/src/plugin_loader.c routerd/src/route_table.c routerd/src/frame.c routerd/src/byte_scan.c routerd/src/dispatch_pool.c routerd/src/event_queue.c routerd/src/buf_pool.c routerd/src/run_state.c routerd/src/log.c routerd/3rdparty/cjson/cJSON.c tests/bench/bench_reactor_backend.c -lpthread -lm -ldl -o /tmp/bench_reactor_backend
+//   /tmp/bench_reactor_backend [N]
+//
+// 输出:每个组合一行。io_uring 不可用(内核旧 / 被禁)时该后端一行标 "fallback epoll"。
+// splice 行末的 spliced 是直通搬运的字节占比(源 / 目的不支持 splice 时退回拷贝路径)。
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "config_store.h"
+#include "reactor.h"
+#include "route_table.h"
+#include "dispatch_pool.h"
+#include "buf_pool.h"
+#include "router_core.h"
+#include "log.h"
+
+#define MSG_LEN       64
+#define STREAM_CHUNK  512
+#define STREAM_BYTES  (16 * 1024 * 1024)
+
+static int g_out = STDOUT_FILENO;   // 结果行;子进程的 stdout 指向 /dev/null
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 阻塞读满 len 字节
+static int read_full(int fd, uint8_t* p, int len)
+{
+    int got = 0;
+    while (got < len) {
+        ssize_t r = read(fd, p + got, (size_t)(len - got));
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return -1;
+        got += (int)r;
+    }
+    return got;
+}
+
+static int write_full(int fd, const uint8_t* p, int len)
+{
+    int put = 0;
+    while (put < len) {
+        ssize_t w = write(fd, p + put, (size_t)(len - put));
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0) return -1;
+        put += (int)w;
+    }
+    return put;
+}
+
+// 建源端:返回给 SRC 端口的 fd,*peer 是测试侧写入的一端
+static int open_source(int use_pty, int* peer)
+{
+    if (use_pty) {
+        int m = posix_openpt(O_RDWR | O_NOCTTY);
+        if (m < 0 || grantpt(m) < 0 || unlockpt(m) < 0) return -1;
+        int s = open(ptsname(m), O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (s < 0) return -1;
+        struct termios t;
+        tcgetattr(s, &t);
+        cfmakeraw(&t);
+        tcsetattr(s, TCSANOW, &t);
+        *peer = m;
+        return s;
+    }
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) return -1;
+    *peer = sv[1];
+    return sv[0];
+}
+
+static void add_port(int id, const char* name, port_type_t type, int fd)
+{
+    port_def_t* p = &g_config.ports[id];
+    snprintf(p->base.name, sizeof(p->base.name), "%s", name);
+    p->base.type    = type;
+    p->base.fd      = fd;
+    p->base.id      = id;
+    p->base.reactor = 0;
+}
+
+// 子进程:搭一条 SRC → DST 数据面,跑两项指标,打印一行
+static int run_case(reactor_backend_t backend, int use_pty, int splice, long n)
+{
+    log_init(0, LOG_LEVEL_NONE);
+
+    int src_peer, dst_fds[2];
+    int src = open_source(use_pty, &src_peer);
+    if (src < 0 || socketpair(AF_UNIX, SOCK_STREAM, 0, dst_fds) < 0) {
+        perror("setup");
+        return 1;
+    }
+
+    memset(&g_config, 0, sizeof(g_config));
+    add_port(0, "SRC", use_pty ? PORT_TTY : PORT_IPC_CLIENT, src);
+    add_port(1, "DST", PORT_IPC_CLIENT, dst_fds[0]);
+    g_config.port_count = 2;
+    route_def_t* r = &g_config.routes[0];
+    snprintf(r->src, sizeof(r->src), "SRC");
+    snprintf(r->dst, sizeof(r->dst), "DST");
+    r->policy = ROUTE_POLICY_BLOCK;
+    r->splice = splice;
+    g_config.route_count     = 1;
+    g_config.reactor_threads = 1;
+    g_config.reactor_edge    = 1;
+    g_config.reactor_backend = backend;
+
+    // 启动顺序同 ez_router.c main
+    reactor_init(1);   // io_uring 不可用时改写 g_config.reactor_backend
+    reactor_add_port(&g_config.ports[0]);
+    reactor_add_port(&g_config.ports[1]);
+    buf_pool_init(BUF_POOL_DEFAULT_COUNT);
+    dispatch_pool_init(1, router_core_handle_batch);
+    dispatch_pool_set_tx_hooks(router_core_tx_hooks());
+    route_table_build();
+    reactor_start();
+    dispatch_pool_start();
+
+    uint8_t msg[MSG_LEN], back[STREAM_CHUNK];
+    memset(msg, 'x', sizeof(msg));
+
+    // pingpong
+    double t0 = now_s();
+    for (long i = 0; i < n; i++) {
+        if (write_full(src_peer, msg, MSG_LEN) < 0 || read_full(dst_fds[1], back, MSG_LEN) < 0) {
+            perror("pingpong");
+            return 1;
+        }
+    }
+    double pp_ns = (now_s() - t0) * 1e9 / (double)n;
+
+    // stream:写在 fork 出的进程里做,本进程只收
+    t0 = now_s();
+    pid_t w = fork();
+    if (w == 0) {
+        uint8_t chunk[STREAM_CHUNK];
+        memset(chunk, 'y', sizeof(chunk));
+        for (long put = 0; put < STREAM_BYTES; put += STREAM_CHUNK)
+            write_full(src_peer, chunk, STREAM_CHUNK);
+        _exit(0);
+    }
+    long got = 0;
+    while (got < STREAM_BYTES) {
+        ssize_t k = read(dst_fds[1], back, sizeof(back));
+        if (k <= 0) break;
+        got += k;
+    }
+    double st_s = now_s() - t0;
+    waitpid(w, NULL, 0);
+
+    int fell_back = (backend == REACTOR_BACKEND_URING &&
+                     g_config.reactor_backend != REACTOR_BACKEND_URING);
+    reactor_port_stats_t ps[2];
+    unsigned long spliced = 0, rx_bytes = 0;
+    for (int k = reactor_get_port_stats(ps, 2) - 1; k >= 0; k--) {
+        spliced  += ps[k].spliced;
+        rx_bytes += ps[k].bytes;
+    }
+    char note[48] = "";
+    if (fell_back)
+        snprintf(note, sizeof(note), "  (fallback epoll)");
+    else if (splice)
+        snprintf(note, sizeof(note), "  (spliced %.0f%%)",
+                 rx_bytes ? 100.0 * (double)spliced / (double)rx_bytes : 0.0);
+    dprintf(g_out, "%-9s%s %-10s  pingpong %8.0f ns/msg   stream %7.1f MB/s%s\n",
+           splice ? "splice" : reactor_backend_name(backend), fell_back ? "*" : " ",
+           use_pty ? "pty" : "socketpair", pp_ns,
+           (double)got / st_s / 1e6, note);
+    // 数据面线程不做收尾,直接退出子进程
+    _exit(got == STREAM_BYTES ? 0 : 1);
+}
+
+int main(int argc, char* argv[])
+{
+    long n = (argc > 1) ? atol(argv[1]) : 20000;
+    int fail = 0;
+
+    printf("SRC -> DST, %d-byte pingpong x %ld, stream %d MB in %d-byte writes\n",
+           MSG_LEN, n, STREAM_BYTES >> 20, STREAM_CHUNK);
+    for (int use_pty = 1; use_pty >= 0; use_pty--) {
+        // 第三轮:epoll + splice 直通
+        for (int b = REACTOR_BACKEND_EPOLL; b <= REACTOR_BACKEND_URING + 1; b++) {
+            int splice = (b > REACTOR_BACKEND_URING);
+            reactor_backend_t backend = splice ? REACTOR_BACKEND_EPOLL : (reactor_backend_t)b;
+            fflush(stdout);
+            pid_t pid = fork();
+            if (pid == 0) {
+                // 子进程里 reactor / worker 的启动日志不混进结果
+                int devnull = open("/dev/null", O_WRONLY);
+                g_out = dup(STDOUT_FILENO);
+                dup2(devnull, STDOUT_FILENO);
+                return run_case(backend, use_pty, splice, n);
+            }
+            int st = 0;
+            waitpid(pid, &st, 0);
+            if (!WIFEXITED(st) || WEXITSTATUS(st) != 0) fail = 1;
+        }
+    }
+    return fail;
+}
@@ -4,7 +4,7 @@
 //   socket → REGISTER → 读 ACK → HEARTBEAT → 关闭。
 // 用法(target 上):
 //   ./out/ez_router -log &  (启 daemon)
-//   gcc -Wall -D_GNU_SOURCE -I routerd/include routerd/src/proto_codec.c tests/unit/smoke_ipc_client.c -o /tmp/smoke
+//   gcc -Wall -D_GNU_SOURCE -I routerd/include routerd/src/proto_codec.c routerd/src/byte_scan.c tests/unit/smoke_ipc_client.c -o /tmp/smoke
 //   /tmp/smoke
 // 退出码 0 = ACK 收到且 ok=true,非 0 = 失败。
 
@@ -12,7 +12,7 @@
 //   仅靠 supervisor_check_heartbeats 周期检查 → 不需要 ez_router 主动 spawn。
 //
 // 编译运行(target 上,单行命令):
-//   gcc -Wall -D_GNU_SOURCE -I routerd/include routerd/src/proto_codec.c tests/unit/smoke_supervised_child.c -o /tmp/smoke_supervised_child
+//   gcc -Wall -D_GNU_SOURCE -I routerd/include routerd/src/proto_codec.c routerd/src/byte_scan.c tests/unit/smoke_supervised_child.c -o /tmp/smoke_supervised_child
 //   setsid /tmp/smoke_supervised_child < /dev/null > /tmp/scsl.log 2>&1 &
 //
 // 约束:本程序故意不 fork 自 ez_router supervisor 表 — 这里测的是
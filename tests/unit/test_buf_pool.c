@@ -0,0 +1,168 @@
+// test_buf_pool.c — 引用计数数据缓冲池的 test-as-doc
+//
+// 固化契约(buf_pool.h):
+//   - buf_alloc 返回 refcnt == 1 的缓冲,size > BUF_SIZE 或池空返回 NULL
+//   - buf_ref / buf_unref 成对,最后一个 unref 归还池,缓冲可被复用
+//   - fan-out 共享:N 个持有者各 unref 一次后才归还,归还前内容不变
+//   - 多线程并发 unref 不丢不重(in_use 最终归零,池可全部再分配)
+//   - 统计:in_use / peak_in_use / alloc_fail
+//   - 分档:buf_pool_init_sized 按 BUF_SIZE ×4 加档到放得下 max_size,取放得下的最小一档,
+//     该档空了借更大的档(upsized);大档个数按字节预算,归还回到自己的档
+//
+// §6.5 TEST AS DOC 形态。Unity 单测脚手架(open-questions U1)就绪后迁移。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -Wall -Wextra -D_GNU_SOURCE -I routerd/include routerd/src/buf_pool.c routerd/src/log.c tests/unit/test_buf_pool.c -lpthread -o /tmp/test_buf_pool
+//   /tmp/test_buf_pool
+//
+// 退出码:0 = 全部 PASS,非 0 = FAIL
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include "buf_pool.h"
+#include "log.h"
+
+static int g_failed = 0;
+static int g_passed = 0;
+
+#define EXPECT(cond, label) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL %s (line %d)\n", label, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+#define EXPECT_EQ_INT(actual, expected, label) do { \
+    long _a = (long)(actual), _e = (long)(expected); \
+    if (_a != _e) { fprintf(stderr, "FAIL %s: got %ld, want %ld (line %d)\n", \
+            label, _a, _e, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+#define POOL_N     8
+#define N_THREADS  4
+#define N_ROUNDS   20000
+
+static buf_t* g_shared[N_THREADS];
+
+// 每个线程反复:拿走一个共享引用并 unref,模拟多个 dispatch worker 同时发完
+static void* unref_worker(void* arg)
+{
+    long id = (long)arg;
+    for (int i = 0; i < N_ROUNDS; i++) {
+        buf_t* b = buf_alloc(16);
+        if (!b) continue;
+        buf_ref(b);            // 另一个"目的端口"的引用
+        g_shared[id] = b;
+        buf_unref(b);
+        buf_unref(g_shared[id]);
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    log_init(0, LOG_LEVEL_WARN);
+    buf_pool_stats_t st;
+
+    EXPECT_EQ_INT(buf_pool_init(POOL_N), 0, "setup: buf_pool_init");
+
+    // ---- Case 1: alloc 得到 refcnt == 1,容量 BUF_SIZE ----
+    buf_t* a = buf_alloc(MAX_DATA);
+    EXPECT(a != NULL, "case1: alloc MAX_DATA ok");
+    EXPECT_EQ_INT(buf_refcnt(a), 1, "case1: refcnt == 1");
+    EXPECT_EQ_INT(a->cap, BUF_SIZE, "case1: cap == BUF_SIZE");
+
+    // ---- Case 2: 超过 BUF_SIZE 返回 NULL 并计 alloc_fail ----
+    EXPECT(buf_alloc(BUF_SIZE + 1) == NULL, "case2: oversize alloc returns NULL");
+    buf_pool_get_stats(&st);
+    EXPECT_EQ_INT(st.alloc_fail, 1, "case2: alloc_fail == 1");
+
+    // ---- Case 3: fan-out 共享,最后一个 unref 才归还 ----
+    memcpy(a->data, "SHARED", 6);
+    buf_ref(a);
+    buf_ref(a);
+    EXPECT_EQ_INT(buf_refcnt(a), 3, "case3: 3 holders");
+    buf_unref(a);
+    buf_unref(a);
+    EXPECT_EQ_INT(memcmp(a->data, "SHARED", 6), 0, "case3: content intact while held");
+    buf_pool_get_stats(&st);
+    EXPECT_EQ_INT(st.in_use, 1, "case3: still in use with 1 holder");
+    buf_unref(a);
+    buf_pool_get_stats(&st);
+    EXPECT_EQ_INT(st.in_use, 0, "case3: returned after last unref");
+
+    // ---- Case 4: 池耗尽返回 NULL,归还后可再分配 ----
+    buf_t* all[POOL_N];
+    int got = 0;
+    for (int i = 0; i < POOL_N; i++) {
+        all[i] = buf_alloc(1);
+        if (all[i]) got++;
+    }
+    EXPECT_EQ_INT(got, POOL_N, "case4: all buffers allocated");
+    EXPECT(buf_alloc(1) == NULL, "case4: exhausted pool returns NULL");
+    buf_pool_get_stats(&st);
+    EXPECT_EQ_INT(st.peak_in_use, POOL_N, "case4: peak_in_use == pool size");
+    buf_unref(all[3]);
+    buf_t* again = buf_alloc(1);
+    EXPECT(again == all[3], "case4: freed buffer is reused");
+    for (int i = 0; i < POOL_N; i++) buf_unref(all[i]);
+
+    // ---- Case 5: 多线程并发 unref,不丢不重 ----
+    pthread_t th[N_THREADS];
+    for (long i = 0; i < N_THREADS; i++)
+        pthread_create(&th[i], NULL, unref_worker, (void*)i);
+    for (int i = 0; i < N_THREADS; i++)
+        pthread_join(th[i], NULL);
+    buf_pool_get_stats(&st);
+    EXPECT_EQ_INT(st.in_use, 0, "case5: in_use back to 0");
+    got = 0;
+    for (int i = 0; i < POOL_N; i++) {
+        all[i] = buf_alloc(1);
+        if (all[i]) got++;
+    }
+    EXPECT_EQ_INT(got, POOL_N, "case5: whole pool allocatable again");
+    for (int i = 0; i < POOL_N; i++) buf_unref(all[i]);
+
+    // ---- Case 6: 分档 ----
+    EXPECT_EQ_INT(buf_pool_init_sized(POOL_N, 40001, 128 * 1024), 0, "case6: init with size classes");
+    buf_pool_get_stats(&st);
+    EXPECT(st.classes == 4 && st.cls[0].cap == BUF_SIZE && st.cls[1].cap == 4 * BUF_SIZE &&
+           st.cls[2].cap == 16 * BUF_SIZE && st.cls[3].cap == 40064,
+           "case6: BUF_SIZE x4 classes, last one trimmed to max_size (64-byte aligned)");
+    EXPECT(st.cls[1].total == 32 && st.cls[2].total == 8 && st.cls[3].total == BUF_CLASS_MIN_COUNT,
+           "case6: large class counts follow the byte budget, at least BUF_CLASS_MIN_COUNT");
+    EXPECT_EQ_INT(buf_max_size(), 40064, "case6: buf_max_size is the largest class");
+    buf_t* s1 = buf_alloc(100);
+    buf_t* s2 = buf_alloc(3000);
+    buf_t* s3 = buf_alloc(40001);
+    EXPECT(s1 && s1->cap == BUF_SIZE && s2 && s2->cap == 4 * BUF_SIZE && s3 && s3->cap == 40064,
+           "case6: smallest class that fits");
+    memset(s3->data, 0xA5, 40001);   // 整个容量可写(ASan / valgrind 下也不越界)
+    EXPECT(buf_alloc(40065) == NULL, "case6: larger than the largest class returns NULL");
+    buf_t* mid[8];
+    for (int i = 0; i < 8; i++) mid[i] = buf_alloc(5000);
+    buf_t* up = buf_alloc(5000);
+    buf_pool_get_stats(&st);
+    EXPECT(up && up->cap == 40064 && st.upsized == 1 && st.cls[2].in_use == 8 && st.cls[3].in_use == 2,
+           "case6: empty class borrows from the next larger one");
+    buf_unref(up);
+    buf_pool_get_stats(&st);
+    EXPECT(st.cls[3].in_use == 1 && st.cls[2].in_use == 8, "case6: unref returns to its own class");
+    for (int i = 0; i < 8; i++) buf_unref(mid[i]);
+    buf_unref(s1);
+    buf_unref(s2);
+    buf_unref(s3);
+    buf_pool_get_stats(&st);
+    EXPECT(st.in_use == 0 && st.peak_in_use == 12 && st.cls[2].peak_in_use == 8,
+           "case6: per-class and total counters balance");
+
+    EXPECT_EQ_INT(buf_pool_init_sized(POOL_N, BUF_SIZE, 0), 0, "case6: max_size BUF_SIZE");
+    buf_pool_get_stats(&st);
+    EXPECT(st.classes == 1 && buf_max_size() == BUF_SIZE && st.total == POOL_N,
+           "case6: no large classes unless asked for");
+
+    buf_pool_destroy();
+    printf("\n%d passed, %d failed\n", g_passed, g_failed);
+    return g_failed ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+// test_byte_scan.c — 向量化字节查找(byte_scan.h)的 test-as-doc
+//
+// 固化契约:
+//   - scan_byte / scan_pair / scan_set / scan_seq 与逐字节参考实现结果完全相同:
+//     长度 0..300、起点 0..63 的所有组合,命中在块内任意位置 / 块边界 / 重叠尾块 / 没有命中
+//   - scan_pair 只差最后一个字节时不算命中(另一半还没收到)
+//   - 不读 [p, p + n) 以外的字节:输入紧贴一个 PROT_NONE 页,越界即 SIGSEGV
+//
+// §6.5 TEST AS DOC 形态。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -Wall -Wextra -I routerd/include routerd/src/byte_scan.c tests/unit/test_byte_scan.c -o /tmp/test_byte_scan
+//   /tmp/test_byte_scan
+// 在 AVX2 机器上长输入走 AVX2;加 -DBYTE_SCAN_NO_AVX2 再编一次覆盖 SSE2 的长输入路径。
+//
+// 退出码:0 = 全部 PASS,非 0 = FAIL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "byte_scan.h"
+
+static int g_failed = 0;
+static int g_passed = 0;
+
+#define EXPECT(cond, label) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL %s (line %d)\n", label, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+// ---- 逐字节参考实现 ----
+static const uint8_t* ref_byte(const uint8_t* p, size_t n, uint8_t b)
+{
+    for (size_t i = 0; i < n; i++) if (p[i] == b) return p + i;
+    return NULL;
+}
+
+static const uint8_t* ref_pair(const uint8_t* p, size_t n, uint8_t b0, uint8_t b1)
+{
+    for (size_t i = 0; i + 1 < n; i++) if (p[i] == b0 && p[i + 1] == b1) return p + i;
+    return NULL;
+}
+
+static const uint8_t* ref_set(const uint8_t* p, size_t n, const uint8_t* set, int k)
+{
+    for (size_t i = 0; i < n; i++)
+        for (int j = 0; j < k; j++) if (p[i] == set[j]) return p + i;
+    return NULL;
+}
+
+static const uint8_t* ref_seq(const uint8_t* p, size_t n, const uint8_t* d, size_t m)
+{
+    for (size_t i = 0; i + m <= n; i++) if (memcmp(p + i, d, m) == 0) return p + i;
+    return NULL;
+}
+
+// 输入区:最后一个字节紧贴 PROT_NONE 页
+#define MAX_LEN   300
+#define MAX_ALIGN 64
+static uint8_t* g_end;   // 可读区的末尾(下一页不可读)
+
+static uint8_t* guarded(size_t n)
+{
+    return g_end - n;
+}
+
+static void setup_guard(void)
+{
+    long pg = sysconf(_SC_PAGESIZE);
+    size_t span = ((MAX_LEN + MAX_ALIGN) / (size_t)pg + 1) * (size_t)pg;
+    uint8_t* m = mmap(NULL, span + (size_t)pg, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED) { perror("mmap"); exit(2); }
+    mprotect(m + span, (size_t)pg, PROT_NONE);
+    g_end = m + span;
+}
+
+// 随机填充,字母表小(命中概率高)或大(多半不命中)
+static void fill(uint8_t* p, size_t n, int alphabet)
+{
+    for (size_t i = 0; i < n; i++) p[i] = (uint8_t)(rand() % alphabet);
+}
+
+// 所有长度 × 起点:输入放在 guarded 区末尾,起点偏移改变相对 16 / 32 字节块的对齐
+static void test_equivalence(void)
+{
+    int bad_byte = 0, bad_pair = 0, bad_set = 0, bad_seq = 0;
+    for (int alpha = 4; alpha <= 256; alpha *= 4) {
+        for (size_t n = 0; n <= MAX_LEN; n++) {
+            for (size_t a = 0; a < MAX_ALIGN; a += (n < 80 ? 1 : 7)) {
+                uint8_t* p = guarded(n + a) + a;   // 末尾仍贴着保护页
+                fill(guarded(n + a), n + a, alpha);
+                uint8_t b = (uint8_t)(rand() % alpha), b1 = (uint8_t)(rand() % alpha);
+                uint8_t set[3] = { b, b1, (uint8_t)(rand() % alpha) };
+                uint8_t d[4] = { b, b1, (uint8_t)(rand() % alpha), (uint8_t)(rand() % alpha) };
+                size_t m = 1 + (size_t)(rand() % 4);
+
+                if (scan_byte(p, n, b) != ref_byte(p, n, b)) bad_byte++;
+                if (scan_pair(p, n, b, b1) != ref_pair(p, n, b, b1)) bad_pair++;
+                if (scan_set(p, n, set, 3) != ref_set(p, n, set, 3)) bad_set++;
+                if (scan_seq(p, n, d, m) != ref_seq(p, n, d, m)) bad_seq++;
+            }
+        }
+    }
+    EXPECT(bad_byte == 0, "scan_byte_matches_reference");
+    EXPECT(bad_pair == 0, "scan_pair_matches_reference");
+    EXPECT(bad_set == 0, "scan_set_matches_reference");
+    EXPECT(bad_seq == 0, "scan_seq_matches_reference");
+}
+
+// 唯一命中放在每个位置上(块内 / 块边界 / 重叠尾块),其余字节不命中
+static void test_single_hit_every_position(void)
+{
+    int bad = 0;
+    for (size_t n = 1; n <= 130; n++) {
+        uint8_t* p = guarded(n);
+        for (size_t at = 0; at < n; at++) {
+            memset(p, 0x11, n);
+            p[at] = 0xC0;
+            if (scan_byte(p, n, 0xC0) != p + at) bad++;
+            static const uint8_t set[2] = { 0xC0, 0xDB };
+            if (scan_set(p, n, set, 2) != p + at) bad++;
+            if (at + 1 < n) {
+                p[at + 1] = 0xEB;
+                if (scan_pair(p, n, 0xC0, 0xEB) != p + at) bad++;
+            }
+        }
+    }
+    EXPECT(bad == 0, "single_hit_found_at_every_position");
+}
+
+static void test_pair_half_at_end(void)
+{
+    for (size_t n = 1; n <= 70; n++) {
+        uint8_t* p = guarded(n);
+        memset(p, 0, n);
+        p[n - 1] = 0x7C;
+        if (scan_pair(p, n, 0x7C, 0xEB) != NULL) {
+            EXPECT(0, "pair_half_at_end_is_not_a_hit");
+            return;
+        }
+    }
+    EXPECT(1, "pair_half_at_end_is_not_a_hit");
+}
+
+static void test_edge_args(void)
+{
+    uint8_t buf[32] = {0};
+    static const uint8_t set[SCAN_SET_MAX + 1] = {0};
+    EXPECT(scan_byte(buf, 0, 0) == NULL, "empty_input_no_hit");
+    EXPECT(scan_seq(buf, 32, buf, 0) == buf, "empty_needle_matches_at_start");
+    EXPECT(scan_seq(buf, 3, buf, 4) == NULL, "needle_longer_than_input");
+    EXPECT(scan_set(buf, 32, set, 0) == NULL, "set_k0_rejected");
+    EXPECT(scan_set(buf, 32, set, SCAN_SET_MAX + 1) == NULL, "set_k_too_big_rejected");
+    EXPECT(scan_set(buf, 32, set, SCAN_SET_MAX) == buf, "set_k_max_ok");
+    printf("impl: %s\n", scan_impl());
+}
+
+int main(void)
+{
+    srand(12345);
+    setup_guard();
+    test_equivalence();
+    test_single_hit_every_position();
+    test_pair_half_at_end();
+    test_edge_args();
+
+    printf("\n%d passed, %d failed\n", g_passed, g_failed);
+    return g_failed ? 1 : 0;
+}
@@ -0,0 +1,299 @@
+// test_dispatch_pool.c — 按目的端口分队列 + worker 池的 test-as-doc
+//
+// 固化契约(dispatch_pool.h):
+//   - 每个被路由引用的 dst 一条队列,未配置的 dst 不建队列
+//   - 同一目的端口严格按入队顺序处理
+//   - 慢目的端口(回调阻塞)不拖慢落在其他 worker 上的目的端口(无队头阻塞)
+//   - 每目的端口独立 sent / drops / depth / batches 计数;积压时批量出队
+//   - workers 夹到 [1, 目的端口数]
+//   - 配了 coalesce 的目的端口:小消息攒成一批,max_delay_us 到期发;
+//     攒够 max_bytes 立即发,不等到期
+//   - 多 reactor:每目的端口每 reactor 一条 lane,同一个 worker 全部取走,计数按 lane 求和
+//
+// 用注入回调替代 router_core_handle:回调只记录 (dst 句柄, seq, 时间戳),
+// "SLOW" 目的端口的回调每条 sleep 20ms 模拟 9600 波特 UART。
+//
+// §6.5 TEST AS DOC 形态。Unity 单测脚手架(open-questions U1)就绪后迁移。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -Wall -Wextra -D_GNU_SOURCE -I routerd/include -I routerd/3rdparty/cjson routerd/src/dispatch_pool.c routerd/src/event_queue.c routerd/src/buf_pool.c routerd/src/config_store.c routerd/src/run_state.c routerd/src/log.c routerd/3rdparty/cjson/cJSON.c tests/unit/test_dispatch_pool.c -lpthread -o /tmp/test_dispatch_pool
+//   /tmp/test_dispatch_pool
+//
+// 退出码:0 = 全部 PASS,非 0 = FAIL
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdatomic.h>
+#include "dispatch_pool.h"
+#include "config_store.h"
+#include "log.h"
+
+static int g_failed = 0;
+static int g_passed = 0;
+
+#define EXPECT(cond, label) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL %s (line %d)\n", label, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+#define EXPECT_EQ_INT(actual, expected, label) do { \
+    long _a = (long)(actual), _e = (long)(expected); \
+    if (_a != _e) { fprintf(stderr, "FAIL %s: got %ld, want %ld (line %d)\n", \
+            label, _a, _e, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+#define N_MSGS 10
+
+// 桩回调不解析端口,句柄值只用来区分两个目的端口
+#define DST_SLOW 1u
+#define DST_FAST 2u
+
+static long now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+// 每个 dst 的处理记录;每个 dst 只有一个 worker 写,无需锁
+typedef struct {
+    atomic_int count;
+    int        order_err;
+    long       last_ms;
+} record_t;
+
+static record_t g_fast, g_slow;
+
+static void stub_handle(event_msg_t* msgs, int n)
+{
+    for (int i = 0; i < n; i++) {
+        event_msg_t* msg = &msgs[i];
+        record_t* r = (msg->dst == DST_SLOW) ? &g_slow : &g_fast;
+        if (r == &g_slow) usleep(20 * 1000);
+        if (msg->len != atomic_load(&r->count)) r->order_err++;
+        r->last_ms = now_ms();
+        atomic_fetch_add(&r->count, 1);
+    }
+}
+
+// 合并用例:记录每批的条数和到达时间
+static atomic_int g_co_batches;
+static atomic_int g_co_msgs;
+static int        g_co_first_n;
+static long       g_co_first_ms;
+
+static void coalesce_handle(event_msg_t* msgs, int n)
+{
+    (void)msgs;
+    if (atomic_fetch_add(&g_co_batches, 1) == 0) {
+        g_co_first_n  = n;
+        g_co_first_ms = now_ms();
+    }
+    atomic_fetch_add(&g_co_msgs, n);
+}
+
+static void add_port(const char* name)
+{
+    port_def_t* p = &g_config.ports[g_config.port_count++];
+    strcpy(p->base.name, name);
+    p->base.type = PORT_TTY;
+    p->base.fd = -1;
+}
+
+static void add_route(const char* src, const char* dst)
+{
+    route_def_t* r = &g_config.routes[g_config.route_count++];
+    strcpy(r->src, src);
+    strcpy(r->dst, dst);
+}
+
+static void push_n(const char* dst, int n)
+{
+    event_queue_t* q = dispatch_queue_by_name(dst);
+    for (int i = 0; i < n; i++) {
+        event_msg_t* slot = queue_reserve(q);
+        slot->dst  = (strcmp(dst, "SLOW") == 0) ? DST_SLOW : DST_FAST;
+        slot->buf  = NULL;    // 外部内存,worker 不归还
+        slot->data = NULL;
+        slot->len  = i;       // 用 len 携带序号
+        queue_commit(q);
+    }
+}
+
+static void push_len(const char* dst, int n, int len)
+{
+    event_queue_t* q = dispatch_queue_by_name(dst);
+    for (int i = 0; i < n; i++) {
+        event_msg_t* slot = queue_reserve(q);
+        slot->dst  = DST_FAST;
+        slot->buf  = NULL;
+        slot->data = NULL;
+        slot->len  = len;
+        queue_commit(q);
+    }
+}
+
+static int wait_atomic(atomic_int* v, int want, int timeout_ms)
+{
+    long deadline = now_ms() + timeout_ms;
+    while (atomic_load(v) < want && now_ms() < deadline)
+        usleep(500);
+    return atomic_load(v);
+}
+
+static int wait_count(record_t* r, int want, int timeout_ms)
+{
+    long deadline = now_ms() + timeout_ms;
+    while (atomic_load(&r->count) < want && now_ms() < deadline)
+        usleep(1000);
+    return atomic_load(&r->count);
+}
+
+int main(void)
+{
+    log_init(0, LOG_LEVEL_WARN);
+
+    memset(&g_config, 0, sizeof(g_config));
+    add_port("SRC");
+    add_port("SLOW");
+    add_port("FAST");
+    add_route("SRC", "SLOW");
+    add_route("SRC", "FAST");
+    add_route("SRC", "SLOW");      // 重复 dst 只建一条队列
+    add_route("SRC", "MISSING");   // 未配置端口不建队列
+
+    // ---- Case 1: 队列按 dst 去重,未配置 dst 跳过 ----
+    EXPECT_EQ_INT(dispatch_pool_init(8, stub_handle), 2, "case1: 2 dst queues");
+    EXPECT(dispatch_queue_by_name("SLOW") != NULL, "case1: SLOW has queue");
+    EXPECT(dispatch_queue_by_name("FAST") != NULL, "case1: FAST has queue");
+    EXPECT(dispatch_queue_by_name("MISSING") == NULL, "case1: MISSING has no queue");
+    EXPECT(dispatch_queue_by_name("SRC") == NULL, "case1: non-dst port has no queue");
+
+    // ---- Case 2: workers 夹到目的端口数,两个 dst 落在不同 worker ----
+    EXPECT_EQ_INT(dispatch_pool_start(), 2, "case2: workers clamped to dst count");
+    dispatch_dst_stats_t st[4];
+    int n = dispatch_pool_get_stats(st, 4);
+    EXPECT_EQ_INT(n, 2, "case2: stats has 2 entries");
+    EXPECT(st[0].worker != st[1].worker, "case2: SLOW/FAST on different workers");
+
+    // ---- Case 3: SLOW 积压 10 条(~200ms)时,FAST 的 10 条不被拖住 ----
+    long t0 = now_ms();
+    push_n("SLOW", N_MSGS);
+    push_n("FAST", N_MSGS);
+    EXPECT_EQ_INT(wait_count(&g_fast, N_MSGS, 1000), N_MSGS, "case3: FAST all handled");
+    long fast_ms = g_fast.last_ms - t0;
+    if (fast_ms > 60) {
+        fprintf(stderr, "FAIL case3: FAST finished after %ld ms, head-of-line blocked by SLOW\n", fast_ms);
+        g_failed++;
+    } else {
+        printf("PASS case3: FAST finished in %ld ms while SLOW backlog drains\n", fast_ms);
+        g_passed++;
+    }
+    EXPECT_EQ_INT(wait_count(&g_slow, N_MSGS, 2000), N_MSGS, "case3: SLOW all handled");
+
+    // ---- Case 4: 每目的端口保序 ----
+    EXPECT_EQ_INT(g_fast.order_err, 0, "case4: FAST in order");
+    EXPECT_EQ_INT(g_slow.order_err, 0, "case4: SLOW in order");
+
+    // ---- Case 5: 每目的端口独立计数 ----
+    n = dispatch_pool_get_stats(st, 4);
+    for (int i = 0; i < n; i++) {
+        EXPECT_EQ_INT(st[i].sent, N_MSGS, "case5: per-dst sent == 10");
+        EXPECT_EQ_INT(st[i].depth, 0, "case5: per-dst depth drained");
+        EXPECT_EQ_INT(st[i].drops, 0, "case5: per-dst drops == 0");
+        EXPECT(st[i].batches >= 1 && st[i].batches <= N_MSGS, "case5: batches counted");
+        EXPECT(st[i].batch_max >= 1 && st[i].batch_max <= DISPATCH_QUANTUM, "case5: batch_max in [1, QUANTUM]");
+    }
+
+    // SLOW 的回调每条 20ms,积压的 10 条里后面的消息会被一批取走
+    EXPECT(st[0].batch_max > 1, "case5: SLOW backlog drained in batches");
+
+    dispatch_pool_stop();
+
+    // ---- Case 6: workers=0 取缺省,单 dst 时夹到 1 ----
+    memset(&g_config, 0, sizeof(g_config));
+    add_port("A");
+    add_port("B");
+    add_route("A", "B");
+    EXPECT_EQ_INT(dispatch_pool_init(0, stub_handle), 1, "case6: 1 dst queue");
+    EXPECT_EQ_INT(dispatch_pool_start(), 1, "case6: default workers clamped to 1");
+    dispatch_pool_stop();
+
+    // ---- Case 7: 合并端口,5 条小消息在 max_delay_us(50ms)到期时作为一批发出 ----
+    memset(&g_config, 0, sizeof(g_config));
+    add_port("A");
+    add_port("NET");
+    add_route("A", "NET");
+    g_config.ports[1].base.coalesce.max_bytes    = 1000;
+    g_config.ports[1].base.coalesce.max_delay_us = 50 * 1000;
+    EXPECT_EQ_INT(dispatch_pool_init(1, coalesce_handle), 1, "case7: 1 dst queue");
+    dispatch_pool_start();
+
+    t0 = now_ms();
+    push_len("NET", 5, 10);
+    EXPECT_EQ_INT(wait_atomic(&g_co_msgs, 5, 1000), 5, "case7: all 5 delivered");
+    EXPECT_EQ_INT(atomic_load(&g_co_batches), 1, "case7: delivered as one batch");
+    EXPECT_EQ_INT(g_co_first_n, 5, "case7: batch holds 5 msgs");
+    long co_ms = g_co_first_ms - t0;
+    if (co_ms < 40 || co_ms > 500) {
+        fprintf(stderr, "FAIL case7: flushed after %ld ms, want ~50 ms\n", co_ms);
+        g_failed++;
+    } else {
+        printf("PASS case7: flushed by timer after %ld ms\n", co_ms);
+        g_passed++;
+    }
+    n = dispatch_pool_get_stats(st, 4);
+    EXPECT_EQ_INT(st[0].timer_flushes, 1, "case7: counted as timer flush");
+
+    // ---- Case 8: 攒够 max_bytes 立即发,不等 max_delay_us ----
+    atomic_store(&g_co_batches, 0);
+    atomic_store(&g_co_msgs, 0);
+    t0 = now_ms();
+    push_len("NET", 4, 300);       // 1200 >= 1000
+    EXPECT_EQ_INT(wait_atomic(&g_co_msgs, 4, 1000), 4, "case8: all 4 delivered");
+    co_ms = g_co_first_ms - t0;
+    if (co_ms >= 40) {
+        fprintf(stderr, "FAIL case8: size-triggered flush took %ld ms\n", co_ms);
+        g_failed++;
+    } else {
+        printf("PASS case8: max_bytes reached, flushed in %ld ms\n", co_ms);
+        g_passed++;
+    }
+    n = dispatch_pool_get_stats(st, 4);
+    EXPECT_EQ_INT(st[0].timer_flushes, 1, "case8: no extra timer flush");
+    dispatch_pool_stop();
+
+    // ---- Case 9: 2 个 reactor,两条 lane 各自入队,worker 都取走 ----
+    memset(&g_config, 0, sizeof(g_config));
+    g_config.reactor_threads = 2;
+    add_port("A");
+    add_port("FAST");
+    add_route("A", "FAST");
+    memset(&g_fast, 0, sizeof(g_fast));
+    EXPECT_EQ_INT(dispatch_pool_init(1, stub_handle), 1, "case9: 1 dst");
+    EXPECT_EQ_INT(dispatch_pool_lanes(), 2, "case9: 2 lanes");
+    event_queue_t* l0 = dispatch_lane("FAST", 0);
+    event_queue_t* l1 = dispatch_lane("FAST", 1);
+    EXPECT(l0 && l1 && l0 != l1, "case9: distinct lanes");
+    dispatch_pool_start();
+    push_n("FAST", N_MSGS);                  // lane 0,序号 0..9
+    for (int i = 0; i < N_MSGS; i++) {       // lane 1,接着 10..19(等 lane 0 取完再发,保证序号连续)
+        if (i == 0) wait_count(&g_fast, N_MSGS, 1000);
+        event_msg_t* slot = queue_reserve(l1);
+        slot->dst = DST_FAST; slot->buf = NULL; slot->data = NULL; slot->len = N_MSGS + i;
+        queue_commit(l1);
+    }
+    EXPECT_EQ_INT(wait_count(&g_fast, 2 * N_MSGS, 1000), 2 * N_MSGS, "case9: both lanes drained");
+    EXPECT_EQ_INT(g_fast.order_err, 0, "case9: per-lane order kept");
+    n = dispatch_pool_get_stats(st, 4);
+    EXPECT_EQ_INT(st[0].sent, 2 * N_MSGS, "case9: sent summed over lanes");
+    dispatch_pool_stop();
+
+    printf("\n%d passed, %d failed\n", g_passed, g_failed);
+    return g_failed ? 1 : 0;
+}
@@ -15,7 +15,7 @@
 // §6.5 TEST AS DOC 形态。Unity 单测脚手架(open-questions U1)就绪后迁移。
 //
 // 编译运行(从仓库根目录):
-//   gcc -Wall -Wextra -I routerd/include -I routerd/3rdparty/cjson routerd/src/registry.c routerd/src/proto_dispatcher.c routerd/src/proto_codec.c routerd/src/log.c routerd/3rdparty/cjson/cJSON.c tests/unit/test_dispatcher.c -lpthread -o /tmp/test_dispatcher
+//   gcc -Wall -Wextra -I routerd/include -I routerd/3rdparty/cjson routerd/src/registry.c routerd/src/proto_dispatcher.c routerd/src/proto_codec.c routerd/src/byte_scan.c routerd/src/log.c routerd/3rdparty/cjson/cJSON.c tests/unit/test_dispatcher.c -lpthread -o /tmp/test_dispatcher
 //   /tmp/test_dispatcher
 //
 // 退出码:0 = 全部 PASS,非 0 = FAIL
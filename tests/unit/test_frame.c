@@ -0,0 +1,501 @@
+// test_frame.c — 收方向增量分帧(frame.h)的 test-as-doc
+//
+// 固化契约:
+//   - 同一段字节流无论怎么切成若干次读(整段 / 逐字节 / 随机切),切出的帧完全相同
+//   - delimiter:缺省去掉分隔符,keep_delimiter 保留;分隔符跨读也认得;空帧跳过
+//   - length:offset / width / endian / adjust 决定帧长;超长帧整帧跳过后接着同步;
+//     长度字段不合理时逐字节滑动找头
+//   - slip / cobs:输出解码后的内容;编码错误 / 超长的帧丢弃,下一个 END / 0x00 后恢复
+//   - idle:frame_next 只累积,frame_take 出帧,frame_idle_due = 最后一个字节 + idle_us
+//   - modbus_rtu:静默 = 3.5 字符时间(起始 + 数据 + 校验 + 停止位 / baudrate),> 19200 baud
+//     固定 1750us;gap_chars / idle_us 可覆盖;frame_idle_feed 统计帧内短间隙(> t1.5)和
+//     出帧后不到一个静默又来字节(拆早了)
+//   - 没有半帧、整帧在本次输入里的 delimiter / length 帧直接指向输入(零拷贝)
+//   - frame_rx_gap:丢了一段输入后半帧作废,不会拼出跨缺口的假帧
+//   - frame 配置块的解析 / save_config 往返;use_frame 缺省跟随 frame 块
+//   - 大帧:max_len 可到 "buffers".max_message(缺省跟随它),拼帧缓冲按需增长,
+//     几十 KB 的记录跨多次读拼回整帧
+//
+// §6.5 TEST AS DOC 形态。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -Wall -Wextra -D_GNU_SOURCE -I routerd/include -I routerd/3rdparty/cjson routerd/src/frame.c routerd/src/byte_scan.c routerd/src/config_store.c routerd/src/log.c routerd/3rdparty/cjson/cJSON.c tests/unit/test_frame.c -o /tmp/test_frame
+//   /tmp/test_frame
+//
+// 退出码:0 = 全部 PASS,非 0 = FAIL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "frame.h"
+#include "log.h"
+
+static int g_failed = 0;
+static int g_passed = 0;
+
+#define EXPECT(cond, label) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL %s (line %d)\n", label, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+// 切出的帧依次拼成 "长度:内容|" 便于整体比较
+static char   g_out[65536];
+static size_t g_out_n;
+static int    g_frames;
+
+static void collect(const uint8_t* f, int len)
+{
+    g_out_n += (size_t)snprintf(g_out + g_out_n, sizeof(g_out) - g_out_n, "%d:", len);
+    for (int k = 0; k < len && g_out_n + 4 < sizeof(g_out); k++) {
+        if (f[k] >= 0x20 && f[k] < 0x7f) g_out[g_out_n++] = (char)f[k];
+        else g_out_n += (size_t)snprintf(g_out + g_out_n, sizeof(g_out) - g_out_n, "\\%02x", f[k]);
+    }
+    g_out[g_out_n++] = '|';
+    g_out[g_out_n] = '\0';
+    g_frames++;
+}
+
+// 把 data 按 chunk 字节一次(chunk <= 0 = 随机 1..17)喂给新的 frame_rx,返回拼好的结果
+static const char* run(const port_frame_t* c, const uint8_t* data, int len, int chunk)
+{
+    static frame_rx_t fr;
+    frame_rx_free(&fr);   // 上一次的拼帧缓冲,顺带清零
+    g_out_n = 0;
+    g_out[0] = '\0';
+    g_frames = 0;
+    for (int off = 0; off < len; ) {
+        int n = chunk > 0 ? chunk : 1 + rand() % 17;
+        if (n > len - off) n = len - off;
+        const uint8_t* in = data + off;
+        int left = n;
+        const uint8_t* f;
+        int fl;
+        while ((fl = frame_next(&fr, c, &in, &left, &f)) > 0) collect(f, fl);
+        off += n;
+    }
+    if (frame_gap_ns(c)) {
+        const uint8_t* f;
+        int fl = frame_take(&fr, c, &f);
+        if (fl > 0) collect(f, fl);
+    }
+    return g_out;
+}
+
+// 整段 / 逐字节 / 随机切 200 次,结果都等于 want
+static int same_any_split(const port_frame_t* c, const void* data, int len, const char* want)
+{
+    if (strcmp(run(c, data, len, len), want) != 0) {
+        fprintf(stderr, "  whole: got %s\n  want  %s\n", g_out, want);
+        return 0;
+    }
+    if (strcmp(run(c, data, len, 1), want) != 0) {
+        fprintf(stderr, "  bytewise: got %s\n", g_out);
+        return 0;
+    }
+    for (int i = 0; i < 200; i++) {
+        if (strcmp(run(c, data, len, 0), want) != 0) {
+            fprintf(stderr, "  random: got %s\n", g_out);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static port_frame_t conf(frame_mode_t m)
+{
+    port_frame_t c;
+    memset(&c, 0, sizeof(c));
+    c.mode = m;
+    return c;
+}
+
+// COBS 编码(测试用参考实现)
+static int cobs_encode(const uint8_t* in, int n, uint8_t* out)
+{
+    int w = 1, code_at = 0;
+    uint8_t code = 1;
+    for (int r = 0; r < n; r++) {
+        if (in[r] == 0) {
+            out[code_at] = code;
+            code = 1;
+            code_at = w++;
+        } else {
+            out[w++] = in[r];
+            if (++code == 0xFF) {
+                out[code_at] = code;
+                code = 1;
+                code_at = w++;
+            }
+        }
+    }
+    out[code_at] = code;
+    return w;
+}
+
+int main(void)
+{
+    srand(1);
+
+    // ---- Case 1: delimiter ----
+    port_frame_t d = conf(FRAME_DELIMITER);
+    memcpy(d.delim, "\r\n", 2);
+    d.delim_len = 2;
+    const char* lines = "$GPGGA,1*4F\r\n\r\n$GPRMC,2*11\r\nOK\r\npartial";
+    EXPECT(same_any_split(&d, lines, (int)strlen(lines), "11:$GPGGA,1*4F|11:$GPRMC,2*11|2:OK|"),
+           "case1: CRLF lines, delimiter stripped, empty line skipped, any split");
+    d.keep_delim = 1;
+    EXPECT(same_any_split(&d, "A\r\nBC\r\n", 7, "3:A\\0d\\0a|4:BC\\0d\\0a|"),
+           "case1: keep_delimiter keeps CRLF");
+    d.keep_delim = 0;
+    d.max_len = 8;
+    const char* longl = "0123456789abcdef\r\nshort\r\n12345678\r\n123456789\r\nend\r\n";
+    EXPECT(same_any_split(&d, longl, (int)strlen(longl), "5:short|8:12345678|3:end|"),
+           "case1: frames over max_len dropped, next line resyncs");
+    {
+        frame_rx_t fr = {0};
+        const uint8_t* in = (const uint8_t*)longl;
+        int left = (int)strlen(longl);
+        const uint8_t* f;
+        while (frame_next(&fr, &d, &in, &left, &f) > 0) {}
+        EXPECT(fr.drops == 2 && fr.frames == 3, "case1: drops and frames counted");
+        frame_rx_free(&fr);
+    }
+    d.max_len = 0;
+
+    // 单字节分隔符,数字 0 也行
+    port_frame_t z = conf(FRAME_DELIMITER);
+    z.delim_len = 1;
+    EXPECT(same_any_split(&z, "ab\0c\0\0d", 7, "2:ab|1:c|"), "case1: NUL delimiter");
+
+    // ---- Case 2: 零拷贝 ----
+    {
+        frame_rx_t fr = {0};
+        const uint8_t msg[] = "hello\r\n";
+        const uint8_t* in = msg;
+        int left = 7;
+        const uint8_t* f = NULL;
+        int fl = frame_next(&fr, &d, &in, &left, &f);
+        EXPECT(fl == 5 && f == msg && left == 0, "case2: whole frame in one read points into the input");
+        in = (const uint8_t*)"hel";
+        left = 3;
+        frame_next(&fr, &d, &in, &left, &f);
+        in = (const uint8_t*)"lo\r\n";
+        left = 4;
+        fl = frame_next(&fr, &d, &in, &left, &f);
+        EXPECT(fl == 5 && f == fr.buf && memcmp(f, "hello", 5) == 0, "case2: split frame assembled in frame_rx");
+        frame_rx_free(&fr);
+    }
+
+    // ---- Case 3: length ----
+    // Modbus TCP(MBAP):长度在偏移 4、2 字节大端,计单元号 + PDU,帧长 = 6 + len
+    port_frame_t mb = conf(FRAME_LENGTH);
+    mb.len_offset = 4;
+    mb.len_width  = 2;
+    mb.len_big    = 1;
+    const uint8_t mbap[] = {0, 1, 0, 0, 0, 6, 1, 3, 0, 0, 0, 2,
+                            0, 2, 0, 0, 0, 3, 1, 0x83, 2};
+    EXPECT(same_any_split(&mb, mbap, sizeof(mbap),
+                          "12:\\00\\01\\00\\00\\00\\06\\01\\03\\00\\00\\00\\02|"
+                          "9:\\00\\02\\00\\00\\00\\03\\01\\83\\02|"),
+           "case3: MBAP frames, big-endian length at offset 4");
+
+    // ez_router 自己的帧头:payload_len 在偏移 8、4 字节小端
+    port_frame_t pr = conf(FRAME_LENGTH);
+    pr.len_offset = 8;
+    pr.len_width  = 4;
+    uint8_t p2[28];
+    memset(p2, 0, sizeof(p2));
+    p2[0]  = 0x7C; p2[1]  = 0xEB; p2[8]  = 3; memcpy(p2 + 12, "abc", 3);
+    p2[15] = 0x7C; p2[16] = 0xEB; p2[23] = 1; p2[27] = 'z';
+    char* pw = strdup(run(&pr, p2, 28, 28));
+    EXPECT(g_frames == 2 && same_any_split(&pr, p2, 28, pw),
+           "case3: proto header layout (little-endian at offset 8), any split");
+    free(pw);
+    {
+        frame_rx_t fr = {0};
+        const uint8_t* in = p2;
+        int left = 28;
+        const uint8_t* f;
+        int a = frame_next(&fr, &pr, &in, &left, &f);
+        int b = frame_next(&fr, &pr, &in, &left, &f);
+        EXPECT(a == 15 && b == 13 && f[12] == 'z' && left == 0, "case3: proto frames 15 + 13 bytes");
+        frame_rx_free(&fr);
+    }
+
+    // 长度字段就是整帧长:adjust = -(offset + width)
+    port_frame_t whole = conf(FRAME_LENGTH);
+    whole.len_width  = 1;
+    whole.len_adjust = -1;
+    EXPECT(same_any_split(&whole, "\x03""ab\x02""c\x01", 6, "3:\\03ab|2:\\02c|1:\\01|"),
+           "case3: adjust for a length that counts the whole frame");
+
+    // 超长帧跳过;长度 0(比头短)滑字节
+    port_frame_t sm = conf(FRAME_LENGTH);
+    sm.len_width = 1;
+    sm.max_len   = 4;
+    EXPECT(same_any_split(&sm, "\x09""123456789\x02""ab\x01""c", 15, "3:\\02ab|2:\\01c|"),
+           "case3: oversize frame skipped by its declared length");
+    port_frame_t neg = whole;
+    EXPECT(same_any_split(&neg, "\x00\x00\x02""a\x01", 5, "2:\\02a|1:\\01|"),
+           "case3: impossible length slides one byte to resync");
+
+    // ---- Case 4: slip ----
+    port_frame_t sl = conf(FRAME_SLIP);
+    const uint8_t slip[] = {0xC0, 'a', 0xDB, 0xDC, 'b', 0xDB, 0xDD, 0xC0, 0xC0,
+                            'x', 0xDB, 'q', 'y', 0xC0,          // 非法转义 → 丢
+                            'o', 'k', 0xC0};
+    EXPECT(same_any_split(&sl, slip, sizeof(slip), "4:a\\c0b\\db|2:ok|"),
+           "case4: SLIP decoded, bad escape dropped, recovers at next END");
+
+    // ---- Case 5: cobs ----
+    port_frame_t cb = conf(FRAME_COBS);
+    uint8_t raw1[] = {0x11, 0x00, 0x00, 0x22, 0x00};
+    uint8_t raw2[300];
+    for (int k = 0; k < 300; k++) raw2[k] = (uint8_t)(1 + k % 250);
+    uint8_t enc[700];
+    int en = cobs_encode(raw1, sizeof(raw1), enc);
+    enc[en++] = 0;
+    int e2 = cobs_encode(raw2, sizeof(raw2), enc + en);
+    en += e2;
+    enc[en++] = 0;
+    enc[en++] = 0x05;   // 码字节越界 → 丢
+    enc[en++] = 'x';
+    enc[en++] = 0;
+    en += cobs_encode((const uint8_t*)"end", 3, enc + en);
+    enc[en++] = 0;
+    char want[2048];
+    int wn = snprintf(want, sizeof(want), "5:\\11\\00\\00\"\\00|300:");
+    for (int k = 0; k < 300; k++) {
+        uint8_t b = raw2[k];
+        if (b >= 0x20 && b < 0x7f) want[wn++] = (char)b;
+        else wn += snprintf(want + wn, sizeof(want) - (size_t)wn, "\\%02x", b);
+    }
+    snprintf(want + wn, sizeof(want) - (size_t)wn, "|3:end|");
+    EXPECT(same_any_split(&cb, enc, en, want), "case5: COBS decoded incl. 254-byte blocks, bad frame dropped");
+
+    // ---- Case 6: idle ----
+    port_frame_t id = conf(FRAME_IDLE);
+    id.idle_us = 1750;
+    {
+        frame_rx_t fr = {0};
+        const uint8_t* in = (const uint8_t*)"\x01\x03\x00\x00";
+        int left = 4;
+        const uint8_t* f;
+        EXPECT(frame_next(&fr, &id, &in, &left, &f) == 0 && left == 0 && fr.n == 4,
+               "case6: idle accumulates, never emits from frame_next");
+        fr.last_ns = 1000000;
+        EXPECT(frame_idle_due(&fr, &id) == 1000000 + 1750000, "case6: due = last byte + idle_us");
+        EXPECT(frame_take(&fr, &id, &f) == 4 && frame_idle_due(&fr, &id) == 0,
+               "case6: frame_take emits, nothing pending afterwards");
+        id.max_len = 3;
+        in = (const uint8_t*)"abcd";
+        left = 4;
+        frame_next(&fr, &id, &in, &left, &f);
+        EXPECT(frame_take(&fr, &id, &f) == 0 && fr.drops == 1, "case6: over max_len dropped at the gap");
+        frame_rx_free(&fr);
+    }
+
+    // ---- Case 7: 缺口 ----
+    {
+        frame_rx_t fr = {0};
+        const uint8_t* in = (const uint8_t*)"hea";
+        int left = 3;
+        const uint8_t* f;
+        frame_next(&fr, &d, &in, &left, &f);
+        frame_rx_gap(&fr, &d);
+        in = (const uint8_t*)"der\r\nnext\r\n";
+        left = 11;
+        int fl = frame_next(&fr, &d, &in, &left, &f);
+        EXPECT(fl == 4 && memcmp(f, "next", 4) == 0 && fr.drops == 1,
+               "case7: half frame before a gap discarded up to the next delimiter");
+        frame_rx_free(&fr);
+    }
+
+    // ---- Case 8: 配置 ----
+    char path[] = "/tmp/test_frame_XXXXXX";
+    int cf = mkstemp(path);
+    dprintf(cf,
+            "{\"ports\":["
+            "{\"name\":\"GPS\",\"type\":\"tty\",\"tty\":{\"path\":\"/dev/null\"},"
+            " \"frame\":{\"mode\":\"delimiter\",\"delimiter\":\"\\r\\n\",\"max_len\":256}},"
+            "{\"name\":\"MB\",\"type\":\"tcp_server\",\"tcp_server\":{\"bind\":\"0.0.0.0\",\"port\":502},"
+            " \"frame\":{\"mode\":\"length\",\"offset\":4,\"width\":2}},"
+            "{\"name\":\"HDLC\",\"type\":\"tty\",\"tty\":{\"path\":\"/dev/null\"},\"use_frame\":false,"
+            " \"frame\":{\"mode\":\"delimiter\",\"delimiter\":[126,0]}},"
+            "{\"name\":\"RTU\",\"type\":\"tty\",\"tty\":{\"path\":\"/dev/null\"},"
+            " \"frame\":{\"mode\":\"idle\"}},"
+            "{\"name\":\"BAD\",\"type\":\"tty\",\"tty\":{\"path\":\"/dev/null\"},"
+            " \"frame\":{\"mode\":\"length\",\"width\":3}},"
+            "{\"name\":\"RAW\",\"type\":\"tty\",\"tty\":{\"path\":\"/dev/null\"}}],"
+            "\"plugins\":[],\"routes\":[]}");
+    close(cf);
+    EXPECT(load_config(path) == 0 && g_config.port_count == 6, "case8: config loads");
+    port_def_t* P = g_config.ports;
+    EXPECT(P[0].base.use_frame && P[0].base.frame.mode == FRAME_DELIMITER &&
+           P[0].base.frame.delim_len == 2 && P[0].base.frame.max_len == 256,
+           "case8: frame block enables framing");
+    EXPECT(P[1].base.frame.mode == FRAME_LENGTH && P[1].base.frame.len_big == 1,
+           "case8: length defaults to big-endian");
+    EXPECT(!P[2].base.use_frame && frame_conf_of(&P[2]) == NULL && P[2].base.frame.delim_len == 2,
+           "case8: use_frame false keeps the block but disables it");
+    EXPECT(P[3].base.frame.idle_us == FRAME_DEFAULT_IDLE_US, "case8: idle_us default");
+    EXPECT(P[4].base.frame.mode == FRAME_NONE && frame_conf_of(&P[4]) == NULL,
+           "case8: invalid width → not framed");
+    EXPECT(frame_conf_of(&P[5]) == NULL && P[5].base.frame.max_len == 0, "case8: no block → not framed");
+
+    // accept 出的 client 用 server 的配置
+    port_def_t client;
+    memset(&client, 0, sizeof(client));
+    client.base.type = PORT_TCP_CLIENT;
+    client.base.id   = 1;
+    EXPECT(frame_conf_of(&client) == &P[1].base.frame, "case8: accepted client uses the server's frame");
+
+    EXPECT(save_config(path) == 0 && load_config(path) == 0, "case8: save + reload");
+    EXPECT(P[0].base.frame.mode == FRAME_DELIMITER && memcmp(P[0].base.frame.delim, "\r\n", 2) == 0 &&
+           P[0].base.frame.max_len == 256 && P[1].base.frame.len_offset == 4 &&
+           !P[2].base.use_frame && P[2].base.frame.delim[0] == 126 && P[2].base.frame.delim[1] == 0 &&
+           P[3].base.frame.mode == FRAME_IDLE && P[5].base.frame.mode == FRAME_NONE,
+           "case8: frame blocks round-trip");
+    unlink(path);
+
+    // ---- Case 9: modbus_rtu 的静默按线路参数算 ----
+    strcpy(path, "/tmp/test_frame_XXXXXX");
+    cf = mkstemp(path);
+    dprintf(cf,
+            "{\"ports\":["
+            "{\"name\":\"B9600\",\"type\":\"tty\",\"tty\":{\"path\":\"/dev/null\",\"baudrate\":9600},"
+            " \"frame\":{\"mode\":\"modbus_rtu\"}},"
+            "{\"name\":\"B19200E\",\"type\":\"tty\",\"tty\":{\"path\":\"/dev/null\",\"baudrate\":19200,\"parity\":2},"
+            " \"frame\":{\"mode\":\"modbus_rtu\"}},"
+            "{\"name\":\"FAST\",\"type\":\"tty\",\"tty\":{\"path\":\"/dev/null\",\"baudrate\":115200},"
+            " \"frame\":{\"mode\":\"modbus_rtu\"}},"
+            "{\"name\":\"CHARS\",\"type\":\"tty\",\"tty\":{\"path\":\"/dev/null\",\"baudrate\":115200},"
+            " \"frame\":{\"mode\":\"modbus_rtu\",\"gap_chars\":4}},"
+            "{\"name\":\"FIXED\",\"type\":\"tty\",\"tty\":{\"path\":\"/dev/null\",\"baudrate\":9600},"
+            " \"frame\":{\"mode\":\"modbus_rtu\",\"idle_us\":5000}},"
+            "{\"name\":\"GW\",\"type\":\"tcp_server\",\"tcp_server\":{\"bind\":\"0.0.0.0\",\"port\":502},"
+            " \"frame\":{\"mode\":\"modbus_rtu\"}}],"
+            "\"plugins\":[],\"routes\":[]}");
+    close(cf);
+    EXPECT(load_config(path) == 0 && g_config.port_count == 6, "case9: config loads");
+    // 9600 8N1:10 位 / 字符 = 1041.7us,t3.5 = 3646us,t1.5 = 1563us
+    EXPECT(P[0].base.frame.mode == FRAME_MODBUS && P[0].base.frame.gap_us == 3646 &&
+           P[0].base.frame.short_us == 1563 && frame_gap_ns(&P[0].base.frame) == 3646000,
+           "case9: 9600 8N1 gap = 3.5 chars");
+    // 19200 8E1:11 位 / 字符 = 572.9us,t3.5 = 2005us
+    EXPECT(P[1].base.frame.gap_us == 2005 && P[1].base.frame.short_us == 859,
+           "case9: parity bit counted in the char time");
+    EXPECT(P[2].base.frame.gap_us == FRAME_MODBUS_FAST_US && P[2].base.frame.short_us == FRAME_MODBUS_FAST_T15,
+           "case9: > 19200 baud uses the fixed 1750/750us");
+    EXPECT(P[3].base.frame.gap_us == 347, "case9: explicit gap_chars follows the line even when fast");
+    EXPECT(P[4].base.frame.gap_us == 5000, "case9: explicit idle_us wins");
+    EXPECT(P[5].base.frame.gap_us == FRAME_MODBUS_FAST_US, "case9: non-tty port defaults to 1750us");
+    EXPECT(save_config(path) == 0 && load_config(path) == 0 &&
+           P[0].base.frame.mode == FRAME_MODBUS && P[0].base.frame.gap_us == 3646 &&
+           P[3].base.frame.gap_chars == 4 && P[4].base.frame.idle_us == 5000,
+           "case9: modbus_rtu round-trips without baking in the computed gap");
+    unlink(path);
+
+    // ---- Case 10: 帧边界计数 ----
+    {
+        port_frame_t mb = conf(FRAME_MODBUS);
+        mb.gap_us   = 3646;
+        mb.short_us = 1563;
+        frame_rx_t fr = {0};
+        const uint8_t* f;
+        uint64_t t = 1000000000ull;
+        frame_idle_feed(&fr, &mb, (const uint8_t*)"\x01\x03", 2, t);
+        frame_idle_feed(&fr, &mb, (const uint8_t*)"\x00\x00", 2, t + 1000000);   // 1ms:正常
+        EXPECT(fr.short_gaps == 0 && fr.n == 4 && frame_idle_due(&fr, &mb) == t + 1000000 + 3646000,
+               "case10: bytes within t1.5 join the frame; due = last read + t3.5");
+        frame_idle_feed(&fr, &mb, (const uint8_t*)"\x00\x0a", 2, t + 3000000);   // 2ms:> t1.5
+        EXPECT(fr.short_gaps == 1 && fr.n == 6, "case10: gap over t1.5 inside a frame counted");
+        EXPECT(frame_take(&fr, &mb, &f) == 6, "case10: frame emitted at the gap");
+        // 出帧之后 1ms 又来了字节:静默其实没到,刚才拆早了
+        frame_idle_feed(&fr, &mb, (const uint8_t*)"\xc5\xcd", 2, t + 4000000);
+        EXPECT(fr.early_splits == 1, "case10: bytes within t3.5 after a split counted");
+        frame_take(&fr, &mb, &f);
+        frame_idle_feed(&fr, &mb, (const uint8_t*)"\x01", 1, t + 20000000);
+        EXPECT(fr.early_splits == 1 && fr.short_gaps == 1, "case10: a real gap counts nothing");
+
+        port_frame_t dl = conf(FRAME_DELIMITER);
+        EXPECT(frame_gap_ns(&dl) == 0, "case10: frame_gap_ns is 0 for non-gap modes");
+        frame_rx_free(&fr);
+    }
+
+    // ---- Case 11: 大帧 ----
+    {
+        port_frame_t big = conf(FRAME_LENGTH);
+        big.len_width = 4;
+        big.len_big   = 1;
+        big.max_len   = 40000;
+        static uint8_t rec[2][4 + 30000];
+        for (int r = 0; r < 2; r++) {
+            rec[r][0] = 0; rec[r][1] = 0; rec[r][2] = 30000 >> 8; rec[r][3] = 30000 & 0xff;
+            for (int k = 0; k < 30000; k++) rec[r][4 + k] = (uint8_t)(k * 7 + r);
+        }
+        frame_rx_t fr = {0};
+        int ok = 0, whole = 0;
+        for (int r = 0; r < 2; r++) {
+            for (int off = 0; off < (int)sizeof(rec[r]); off += 777) {
+                const uint8_t* in = rec[r] + off;
+                int left = (int)sizeof(rec[r]) - off < 777 ? (int)sizeof(rec[r]) - off : 777;
+                const uint8_t* f;
+                int fl;
+                while ((fl = frame_next(&fr, &big, &in, &left, &f)) > 0) {
+                    whole++;
+                    ok += fl == (int)sizeof(rec[r]) && memcmp(f, rec[r], sizeof(rec[r])) == 0;
+                }
+            }
+        }
+        EXPECT(whole == 2 && ok == 2 && fr.drops == 0 && fr.cap >= FRAME_BUF_BYTES(40000),
+               "case11: 30 KB records reassembled intact across 777-byte reads");
+        frame_rx_free(&fr);
+
+        big.max_len = 0;   // 缺省 MAX_DATA-1:同样的记录超长丢弃,之后照常同步
+        const uint8_t* in = rec[0];
+        int left = (int)sizeof(rec[0]);
+        const uint8_t* f;
+        EXPECT(frame_next(&fr, &big, &in, &left, &f) == 0 && fr.drops == 1 &&
+               fr.cap == FRAME_BUF_BYTES(MAX_DATA - 1),
+               "case11: default max_len keeps the 1 KiB buffer and drops the record");
+        frame_rx_free(&fr);
+
+        strcpy(path, "/tmp/test_frame_XXXXXX");
+        cf = mkstemp(path);
+        dprintf(cf,
+                "{\"buffers\":{\"max_message\":40000},\"ports\":["
+                "{\"name\":\"CAM\",\"type\":\"tcp_server\",\"tcp_server\":{\"bind\":\"0.0.0.0\",\"port\":9000},"
+                " \"frame\":{\"mode\":\"length\",\"width\":4}},"
+                "{\"name\":\"BIG\",\"type\":\"tty\",\"tty\":{\"path\":\"/dev/null\"},"
+                " \"frame\":{\"mode\":\"delimiter\",\"delimiter\":\"\\n\",\"max_len\":100000}},"
+                "{\"name\":\"SMALL\",\"type\":\"tty\",\"tty\":{\"path\":\"/dev/null\"},"
+                " \"frame\":{\"mode\":\"slip\",\"max_len\":512}}],"
+                "\"plugins\":[],\"routes\":[]}");
+        close(cf);
+        EXPECT(load_config(path) == 0 && g_config.max_message == 40000 &&
+               P[0].base.frame.max_len == 40000 && P[1].base.frame.max_len == 40000 &&
+               P[2].base.frame.max_len == 512,
+               "case11: max_len defaults to and is clamped by buffers.max_message");
+        unlink(path);
+
+        strcpy(path, "/tmp/test_frame_XXXXXX");
+        cf = mkstemp(path);
+        dprintf(cf, "{\"buffers\":{\"max_message\":1048576},\"ports\":[],\"plugins\":[],\"routes\":[]}");
+        close(cf);
+        EXPECT(load_config(path) == 0 && g_config.max_message == MAX_MESSAGE,
+               "case11: buffers.max_message clamped to MAX_MESSAGE");
+        unlink(path);
+        strcpy(path, "/tmp/test_frame_XXXXXX");
+        cf = mkstemp(path);
+        dprintf(cf, "{\"ports\":[],\"plugins\":[],\"routes\":[]}");
+        close(cf);
+        EXPECT(load_config(path) == 0 && g_config.max_message == MAX_DATA - 1,
+               "case11: max_message defaults to MAX_DATA-1");
+        unlink(path);
+    }
+
+    printf("\n%d passed, %d failed\n", g_passed, g_failed);
+    return g_failed ? 1 : 0;
+}
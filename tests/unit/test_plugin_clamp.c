@@ -1,9 +1,9 @@
 // test_plugin_clamp.c — RPD 阶段 0 任务 0.1 的 test-as-doc
 //
 // 固化契约(PROJECT_CONTEXT.MD 条目 5 / design-intent.md §4):
-//   plugin handler 返回长度必须被 reactor 夹到 [0, MAX_DATA]。
+//   plugin handler 返回长度必须被 reactor 夹到 [0, max(输入长度, MAX_DATA)]。
 //   <0   → 丢弃本路由(continue)
-//   >MAX → 截断为 MAX_DATA
+//   >MAX → 截断为 max(输入长度, MAX_DATA)(大消息的缓冲至少放得下输入)
 //   合法 → 透传
 //
 // 这个文件是 §6.5 TEST AS DOC 形态:用最小复现样例固化逻辑切面,
@@ -25,13 +25,14 @@
 //
 // 返回值约定:
 //   0  → drop(对应 reactor 的 `continue`,不入队)
-//   >0 → 入队的有效长度(已被夹到 [1, MAX_DATA])
+//   >0 → 入队的有效长度(已被夹到 [1, max(in_len, MAX_DATA)])
 //
 // 这是 reactor.c clamp 块的等价模型,任何对生产代码的修改都应该
 // 同步更新这里,否则该测试会变成"测了模型但没测代码"。
-static int clamp_handler_return(int handler_ret) {
+static int clamp_handler_return(int handler_ret, int in_len) {
+    int room = in_len > MAX_DATA ? in_len : MAX_DATA;
     if (handler_ret < 0) return 0;          // drop
-    if (handler_ret > MAX_DATA) return MAX_DATA;
+    if (handler_ret > room) return room;
     return handler_ret;
 }
 
@@ -50,15 +51,21 @@ static int g_failed = 0;
 
 int main(void) {
     // 边界 / 越界 / 合法
-    EXPECT_EQ(clamp_handler_return(-1),            0,         "negative -> drop");
-    EXPECT_EQ(clamp_handler_return(-9999),         0,         "very_negative -> drop");
-    EXPECT_EQ(clamp_handler_return(0),             0,         "zero -> drop_or_empty");
-    EXPECT_EQ(clamp_handler_return(1),             1,         "one -> passthrough");
-    EXPECT_EQ(clamp_handler_return(512),           512,       "midrange -> passthrough");
-    EXPECT_EQ(clamp_handler_return(MAX_DATA),      MAX_DATA,  "exact_max -> passthrough");
-    EXPECT_EQ(clamp_handler_return(MAX_DATA + 1),  MAX_DATA,  "max_plus_one -> truncated");
-    EXPECT_EQ(clamp_handler_return(99999),         MAX_DATA,  "huge -> truncated");
-    EXPECT_EQ(clamp_handler_return(0x7fffffff),    MAX_DATA,  "INT_MAX -> truncated");
+    EXPECT_EQ(clamp_handler_return(-1, 16),            0,         "negative -> drop");
+    EXPECT_EQ(clamp_handler_return(-9999, 16),         0,         "very_negative -> drop");
+    EXPECT_EQ(clamp_handler_return(0, 16),             0,         "zero -> drop_or_empty");
+    EXPECT_EQ(clamp_handler_return(1, 16),             1,         "one -> passthrough");
+    EXPECT_EQ(clamp_handler_return(512, 16),           512,       "midrange -> passthrough");
+    EXPECT_EQ(clamp_handler_return(MAX_DATA, 16),      MAX_DATA,  "exact_max -> passthrough");
+    EXPECT_EQ(clamp_handler_return(MAX_DATA + 1, 16),  MAX_DATA,  "max_plus_one -> truncated");
+    EXPECT_EQ(clamp_handler_return(99999, 16),         MAX_DATA,  "huge -> truncated");
+    EXPECT_EQ(clamp_handler_return(0x7fffffff, 16),    MAX_DATA,  "INT_MAX -> truncated");
+
+    // 大消息(buffers.max_message > MAX_DATA):上限是输入长度
+    EXPECT_EQ(clamp_handler_return(30000, 30000),  30000,     "large_in -> passthrough");
+    EXPECT_EQ(clamp_handler_return(20000, 30000),  20000,     "large_shrunk -> passthrough");
+    EXPECT_EQ(clamp_handler_return(30001, 30000),  30000,     "large_grown -> truncated to input");
+    EXPECT_EQ(clamp_handler_return(MAX_DATA, 2000), MAX_DATA, "large_to_small -> passthrough");
 
     if (g_failed) {
         fprintf(stderr, "\n%d FAILED\n", g_failed);
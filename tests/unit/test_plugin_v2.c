@@ -0,0 +1,173 @@
+// test_plugin_v2.c — 插件 handler v2 ABI 的 test-as-doc
+//
+// 固化契约(plugin_loader.h):
+//   - v1 / v2 登记在同一张表,按全名查;查到的是另一种 ABI 时返回 NULL
+//   - plugin_call_v2:输入只读,输出写进新分配的池缓冲,out_cap >= max(in_len, MAX_DATA)
+//     (不超过 max_len)
+//   - 返回 > out_cap = "需要这么多字节":换至少这么大的缓冲重调一次
+//   - 要的超过 max_len / 第二次还不够 / 返回 < 0 / 池耗尽 → NULL(丢弃),输出缓冲已归还
+//
+// §6.5 TEST AS DOC 形态。Unity 单测脚手架(open-questions U1)就绪后迁移。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -Wall -Wextra -D_GNU_SOURCE -I routerd/include routerd/src/plugin_loader.c routerd/src/buf_pool.c routerd/src/log.c tests/unit/test_plugin_v2.c -lpthread -ldl -o /tmp/test_plugin_v2
+//   /tmp/test_plugin_v2
+//
+// 退出码:0 = 全部 PASS,非 0 = FAIL
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "plugin_loader.h"
+#include "buf_pool.h"
+#include "event.h"
+#include "log.h"
+
+static int g_failed = 0;
+static int g_passed = 0;
+
+#define EXPECT(cond, label) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL %s (line %d)\n", label, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+#define EXPECT_EQ_INT(actual, expected, label) do { \
+    long _a = (long)(actual), _e = (long)(expected); \
+    if (_a != _e) { fprintf(stderr, "FAIL %s: got %ld, want %ld (line %d)\n", \
+            label, _a, _e, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+static int g_calls;
+static int g_last_cap;
+
+static int h_v1(uint8_t* data, int len) { (void)data; return len; }
+
+// 原样拷贝
+static int h_copy(const uint8_t* in, int len, uint8_t* out, int cap)
+{
+    g_calls++; g_last_cap = cap;
+    if (len > cap) return len;
+    memcpy(out, in, len);
+    return len;
+}
+
+// hex 编码:输出是输入的两倍,典型的"变长"变换
+static int h_hex(const uint8_t* in, int len, uint8_t* out, int cap)
+{
+    static const char digits[] = "0123456789abcdef";
+    g_calls++; g_last_cap = cap;
+    if (len * 2 > cap) return len * 2;
+    for (int i = 0; i < len; i++) {
+        out[2 * i]     = digits[in[i] >> 4];
+        out[2 * i + 1] = digits[in[i] & 0xf];
+    }
+    return len * 2;
+}
+
+// 永远嫌不够
+static int h_greedy(const uint8_t* in, int len, uint8_t* out, int cap)
+{
+    (void)in; (void)len; (void)out;
+    g_calls++;
+    return cap + 1;
+}
+
+static int h_reject(const uint8_t* in, int len, uint8_t* out, int cap)
+{
+    (void)in; (void)len; (void)out; (void)cap;
+    g_calls++;
+    return -1;
+}
+
+static int pool_in_use(void)
+{
+    buf_pool_stats_t st;
+    buf_pool_get_stats(&st);
+    return st.in_use;
+}
+
+int main(void)
+{
+    log_init(0, LOG_LEVEL_ERROR);
+    static uint8_t in[4096];
+    for (int i = 0; i < (int)sizeof(in); i++) in[i] = (uint8_t)(i * 7);
+
+    // ---- Case 1: 同一张表,按 ABI 分别查 ----
+    plugin_register_handler("t", "v1", h_v1);
+    plugin_register_handler_v2("t", "copy", h_copy);
+    EXPECT(plugin_get_handler("t.v1") == h_v1, "case1: v1 lookup");
+    EXPECT(plugin_get_handler_v2("t.copy") == h_copy, "case1: v2 lookup");
+    EXPECT(plugin_get_handler("t.copy") == NULL, "case1: v2 entry is not a v1 handler");
+    EXPECT(plugin_get_handler_v2("t.v1") == NULL, "case1: v1 entry is not a v2 handler");
+    EXPECT(plugin_get_handler_v2("t.none") == NULL, "case1: unknown name -> NULL");
+
+    // 档位:1024 / 4096 / 8192
+    EXPECT_EQ_INT(buf_pool_init_sized(16, 8192, 64 * 1024), 0, "init pool with size classes");
+    const int limit = 8192;
+    int out_len = -1;
+
+    // ---- Case 2: 放得下,一次调用,输出在新缓冲里,输入不变 ----
+    g_calls = 0;
+    buf_t* out = plugin_call_v2(h_copy, "t.copy", in, 100, limit, &out_len);
+    EXPECT(out != NULL, "case2: output buffer returned");
+    EXPECT_EQ_INT(out_len, 100, "case2: output length");
+    EXPECT_EQ_INT(g_calls, 1, "case2: handler called once");
+    EXPECT(g_last_cap >= MAX_DATA, "case2: out_cap >= MAX_DATA");
+    EXPECT(out && out->data != in && memcmp(out->data, in, 100) == 0, "case2: bytes copied out");
+    EXPECT_EQ_INT(buf_refcnt(out), 1, "case2: caller holds one reference");
+    buf_unref(out);
+
+    // ---- Case 3: 大输入,第一次就给够 ----
+    g_calls = 0;
+    out = plugin_call_v2(h_copy, "t.copy", in, 3000, limit, &out_len);
+    EXPECT(out != NULL && out_len == 3000 && g_calls == 1 && g_last_cap >= 3000,
+           "case3: out_cap >= in_len on the first call");
+    if (out) buf_unref(out);
+
+    // ---- Case 4: "需要 N 字节" → 换大缓冲重调一次 ----
+    g_calls = 0;
+    out = plugin_call_v2(h_hex, "t.hex", in, 1000, limit, &out_len);
+    EXPECT(out != NULL, "case4: retried with a larger buffer");
+    EXPECT_EQ_INT(g_calls, 2, "case4: handler called twice");
+    EXPECT_EQ_INT(out_len, 2000, "case4: expanded output length");
+    EXPECT(out && out->cap >= 2000 && g_last_cap >= 2000, "case4: second out_cap covers the request");
+    EXPECT(out && memcmp(out->data, "00070e15", 8) == 0, "case4: output content");
+    if (out) buf_unref(out);
+
+    // ---- Case 5: 要的超过上限 → 丢弃,不重试 ----
+    g_calls = 0;
+    out = plugin_call_v2(h_hex, "t.hex", in, 4096, 8000, &out_len);
+    EXPECT(out == NULL, "case5: need > max_len dropped");
+    EXPECT_EQ_INT(g_calls, 1, "case5: no retry past the limit");
+
+    // ---- Case 6: 第二次还不够 → 丢弃 ----
+    g_calls = 0;
+    out = plugin_call_v2(h_greedy, "t.greedy", in, 10, limit, &out_len);
+    EXPECT(out == NULL && g_calls == 2, "case6: retried once then dropped");
+
+    // ---- Case 7: 返回 < 0 → 丢弃 ----
+    g_calls = 0;
+    out = plugin_call_v2(h_reject, "t.reject", in, 10, limit, &out_len);
+    EXPECT(out == NULL && g_calls == 1, "case7: negative return dropped");
+
+    // ---- Case 8: out_cap 不超过 max_len ----
+    out = plugin_call_v2(h_copy, "t.copy", in, 10, 512, &out_len);
+    EXPECT(out != NULL && g_last_cap == 512, "case8: out_cap clamped to max_len");
+    if (out) buf_unref(out);
+
+    EXPECT_EQ_INT(pool_in_use(), 0, "dropped calls returned their buffers");
+    buf_pool_destroy();
+
+    // ---- Case 9: 池耗尽 → 丢弃,handler 不被调用 ----
+    EXPECT_EQ_INT(buf_pool_init(1), 0, "case9: one-buffer pool");
+    buf_t* hold = buf_alloc(BUF_SIZE);
+    g_calls = 0;
+    out = plugin_call_v2(h_copy, "t.copy", in, 10, MAX_DATA, &out_len);
+    EXPECT(out == NULL && g_calls == 0, "case9: pool exhausted -> dropped");
+    buf_unref(hold);
+    buf_pool_destroy();
+
+    printf("\n%d passed, %d failed\n", g_passed, g_failed);
+    return g_failed ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+// test_port_handle.c — 端口句柄 + generation 的 test-as-doc
+//
+// 固化契约(port_manager.h):
+//   - port_register 分配非 0 句柄,写入 p->base.handle
+//   - port_from_handle 对有效句柄 O(1) 返回端口
+//   - port_unregister 之后旧句柄失效(NULL),即使槽位被新连接复用、
+//     新连接拿到同一个 fd —— 队列里指向旧连接的消息不会发到新连接
+//   - 重复 unregister / 过期句柄 unregister 不影响现任持有者
+//   - 表满返回 PORT_HANDLE_INVALID
+//
+// §6.5 TEST AS DOC 形态。Unity 单测脚手架(open-questions U1)就绪后迁移。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -Wall -Wextra -D_GNU_SOURCE -I routerd/include -I routerd/3rdparty/cjson routerd/src/port_manager.c routerd/src/tty_baud.c routerd/src/port_tx.c routerd/src/buf_pool.c routerd/src/config_store.c routerd/src/log.c routerd/3rdparty/cjson/cJSON.c tests/unit/test_port_handle.c -o /tmp/test_port_handle
+//   /tmp/test_port_handle
+//
+// 退出码:0 = 全部 PASS,非 0 = FAIL
+
+#include <stdio.h>
+#include <string.h>
+#include "port_manager.h"
+#include "log.h"
+
+static int g_failed = 0;
+static int g_passed = 0;
+
+#define EXPECT(cond, label) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL %s (line %d)\n", label, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+static port_def_t make_port(const char* name, port_type_t type, int fd)
+{
+    port_def_t p;
+    memset(&p, 0, sizeof(p));
+    strcpy(p.base.name, name);
+    p.base.type = type;
+    p.base.fd = fd;
+    return p;
+}
+
+int main(void)
+{
+    log_init(0, LOG_LEVEL_ERROR);
+
+    // ---- Case 1: 注册得到非 0 句柄,按句柄取回同一端口 ----
+    port_def_t uart = make_port("UART1", PORT_TTY, 10);
+    port_handle_t hu = port_register(&uart);
+    EXPECT(hu != PORT_HANDLE_INVALID, "case1: handle is valid");
+    EXPECT(uart.base.handle == hu, "case1: handle stored in port");
+    EXPECT(port_from_handle(hu) == &uart, "case1: lookup returns port");
+
+    // ---- Case 2: client 断开后旧句柄失效 ----
+    port_def_t cli1 = make_port("NET", PORT_TCP_CLIENT, 11);
+    port_handle_t h1 = port_register(&cli1);
+    EXPECT(port_from_handle(h1) == &cli1, "case2: client handle resolves");
+    port_unregister(h1);
+    EXPECT(port_from_handle(h1) == NULL, "case2: unregistered handle is stale");
+
+    // ---- Case 3: 槽位 + fd 被新连接复用,旧句柄仍然失效 ----
+    port_def_t cli2 = make_port("NET", PORT_TCP_CLIENT, 11);   // 内核复用了同一个 fd
+    port_handle_t h2 = port_register(&cli2);
+    EXPECT((h2 & 0xFFFFu) == (h1 & 0xFFFFu), "case3: same table slot reused");
+    EXPECT(h2 != h1, "case3: generation differs");
+    EXPECT(port_from_handle(h1) == NULL, "case3: old handle does not hit new client");
+    EXPECT(port_from_handle(h2) == &cli2, "case3: new handle resolves");
+
+    // ---- Case 4: 过期句柄 unregister 不影响现任持有者 ----
+    port_unregister(h1);
+    EXPECT(port_from_handle(h2) == &cli2, "case4: stale unregister is no-op");
+
+    // ---- Case 5: 非法句柄 ----
+    EXPECT(port_from_handle(PORT_HANDLE_INVALID) == NULL, "case5: handle 0 invalid");
+    EXPECT(port_from_handle(0xFFFFu) == NULL, "case5: out of range index");
+
+    // ---- Case 6: 表满 ----
+    static port_def_t many[MAX_PORTS];
+    int ok = 0;
+    port_handle_t last = 1;
+    for (int i = 0; i < MAX_PORTS; i++) {
+        many[i] = make_port("X", PORT_TCP_CLIENT, 100 + i);
+        last = port_register(&many[i]);
+        if (last != PORT_HANDLE_INVALID) ok++;
+    }
+    EXPECT(ok == MAX_PORTS - 2, "case6: fills remaining slots");
+    EXPECT(last == PORT_HANDLE_INVALID, "case6: full table returns invalid");
+
+    printf("\n%d passed, %d failed\n", g_passed, g_failed);
+    return g_failed ? 1 : 0;
+}
@@ -0,0 +1,182 @@
+// test_port_retire.c — 断开端口延迟回收(port_retire)的 test-as-doc
+//
+// 固化契约(port_manager.h):
+//   - 没有读侧停在一轮里:port_retire 立即关 fd / 释放 client
+//   - 读侧在一轮里(port_read_begin 之后):挂起,fd 保持打开、client 内存不释放;
+//     最后一个读侧 port_read_end 时回收
+//   - 广播按句柄快照逐个重新解析:快照之后注销的 client 不再被写
+//   - 并发:worker 持续广播、reactor 持续建立 / 断开 client,写不会落到
+//     复用了同号 fd 的新连接上
+//
+// §6.5 TEST AS DOC 形态。Unity 单测脚手架(open-questions U1)就绪后迁移。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -Wall -Wextra -D_GNU_SOURCE -I routerd/include -I routerd/3rdparty/cjson routerd/src/port_manager.c routerd/src/tty_baud.c routerd/src/port_tx.c routerd/src/buf_pool.c routerd/src/config_store.c routerd/src/log.c routerd/3rdparty/cjson/cJSON.c tests/unit/test_port_retire.c -lpthread -o /tmp/test_port_retire
+//   /tmp/test_port_retire
+//
+// 退出码:0 = 全部 PASS,非 0 = FAIL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include "port_manager.h"
+#include "log.h"
+
+static int g_failed = 0;
+static int g_passed = 0;
+
+#define EXPECT(cond, label) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL %s (line %d)\n", label, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+#define CHURN 2000
+
+static port_def_t g_server;
+
+static int fd_open(int fd) { return fcntl(fd, F_GETFD) >= 0; }
+
+// 读完 fd 上现有的字节(非阻塞),返回字节数
+static long drain(int fd)
+{
+    char buf[4096];
+    long total = 0;
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) total += n;
+    return total;
+}
+
+// accept 出的 client 的形状:malloc,type / id 跟 server
+static port_def_t* new_client(int fd)
+{
+    port_def_t* c = calloc(1, sizeof(*c));
+    strcpy(c->base.name, g_server.base.name);
+    c->base.type = PORT_TCP_CLIENT;
+    c->base.id   = g_server.base.id;
+    c->base.fd   = fd;
+    port_register(c);
+    return c;
+}
+
+static atomic_int g_stop;
+static atomic_long g_rounds;
+
+static void* broadcaster(void* arg)
+{
+    (void)arg;
+    port_reader_register();
+    while (!atomic_load(&g_stop)) {
+        port_read_begin();
+        port_send(&g_server, (const uint8_t*)"x", 1);
+        port_read_end();
+        atomic_fetch_add(&g_rounds, 1);
+    }
+    port_reader_unregister();
+    return NULL;
+}
+
+int main(void)
+{
+    log_init(0, LOG_LEVEL_ERROR);
+    signal(SIGPIPE, SIG_IGN);   // 对端先关的 client 写 EPIPE
+
+    strcpy(g_server.base.name, "SRV");
+    g_server.base.type = PORT_TCP_SERVER;
+    g_server.base.id   = 0;
+    g_server.base.fd   = 100;   // 只作非负占位,广播不写 server 自己的 fd
+
+    // ---- Case 1: 没有读侧在一轮里 → 立即回收 ----
+    int sv[2];
+    socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv);
+    port_def_t* c = new_client(sv[0]);
+    port_unregister(c->base.handle);
+    port_retire(c, sv[0]);
+    EXPECT(port_retired_pending() == 0, "case1: nothing pending");
+    EXPECT(!fd_open(sv[0]), "case1: fd closed at once");
+    close(sv[1]);
+
+    // ---- Case 2: 广播途中注销一个 client ----
+    // 本线程兼任读侧(worker)和 reactor:读侧在一轮里时注销 + 挂起 a
+    port_reader_register();
+    int a[2], b[2];
+    socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, a);
+    socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, b);
+    port_def_t* ca = new_client(a[0]);
+    port_def_t* cb = new_client(b[0]);
+
+    port_read_begin();
+    port_handle_t snap[MAX_PORTS];
+    int ns = port_server_clients(&g_server, snap, MAX_PORTS);
+    EXPECT(ns == 2, "case2: snapshot has both clients");
+
+    port_unregister(ca->base.handle);   // reactor:a 断开
+    port_retire(ca, a[0]);
+    EXPECT(port_retired_pending() == 1, "case2: retire deferred while a round is open");
+    EXPECT(fd_open(a[0]), "case2: fd stays open during the round");
+    EXPECT(port_from_handle(snap[0]) == NULL || port_from_handle(snap[1]) == NULL,
+           "case2: one snapshot handle is now stale");
+
+    EXPECT(port_send(&g_server, (const uint8_t*)"hi", 2) == 2, "case2: broadcast succeeds");
+    EXPECT(drain(a[1]) == 0, "case2: unregistered client not written");
+    EXPECT(drain(b[1]) == 2, "case2: remaining client written");
+
+    port_read_end();
+    EXPECT(port_retired_pending() == 0, "case2: reclaimed when the round ends");
+    EXPECT(!fd_open(a[0]), "case2: fd closed after the round");
+    port_reader_unregister();
+
+    port_unregister(cb->base.handle);
+    port_retire(cb, b[0]);
+    close(a[1]);
+    close(b[1]);
+
+    // ---- Case 3: 并发广播 + client 反复建立 / 断开 ----
+    // 旧 client 的 fd 号一关就可能分给新 socketpair 的任一端;如果 worker 还在按旧
+    // 指针写旧号码,字节会从某个 client 端(cli[0])读出来 —— 正常情况下 cli[0] 永远读不到
+    pthread_t th;
+    pthread_create(&th, NULL, broadcaster, NULL);
+    long misdirected = 0, delivered = 0;
+    port_def_t* live[4] = {0};
+    int peer[4] = {-1, -1, -1, -1};
+    for (int i = 0; i < CHURN; i++) {
+        int k = i % 4;
+        if (live[k]) {
+            misdirected += drain(live[k]->base.fd);
+            delivered += drain(peer[k]);
+            int fd = live[k]->base.fd;
+            port_unregister(live[k]->base.handle);
+            close(peer[k]);
+            port_retire(live[k], fd);
+        }
+        int p[2];
+        socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, p);
+        live[k] = new_client(p[0]);
+        peer[k] = p[1];
+        if (i % 64 == 0) usleep(100);
+    }
+    atomic_store(&g_stop, 1);
+    pthread_join(th, NULL);
+    for (int k = 0; k < 4; k++) {
+        misdirected += drain(live[k]->base.fd);
+        delivered += drain(peer[k]);
+        int fd = live[k]->base.fd;
+        port_unregister(live[k]->base.handle);
+        close(peer[k]);
+        port_retire(live[k], fd);
+    }
+    printf("case3: rounds=%ld delivered=%ld misdirected=%ld\n",
+           atomic_load(&g_rounds), delivered, misdirected);
+    EXPECT(delivered > 0, "case3: broadcasts reached live clients");
+    EXPECT(misdirected == 0, "case3: no write landed on a reused fd");
+    EXPECT(port_retired_pending() == 0, "case3: everything reclaimed once readers are gone");
+
+    printf("\n%d passed, %d failed\n", g_passed, g_failed);
+    return g_failed ? 1 : 0;
+}
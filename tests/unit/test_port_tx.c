@@ -0,0 +1,475 @@
+// test_port_tx.c — 非阻塞发送引擎(输出环 + EPOLLOUT 冲刷)的 test-as-doc
+//
+// 固化契约(port_tx.h):
+//   - 环空且内核缓冲有空间:直接写出,不排队
+//   - 短写 / EAGAIN:剩余部分进输出环,调用方看到的是"已接收"的字节数,不阻塞
+//   - 环满:整条消息丢弃并计数,接收端看到的永远是完整消息(不撕裂),顺序不变
+//   - 高 / 低水位滞回:超过 PORT_TX_HWM 起 blocked,降到 PORT_TX_LWM 以下才解除
+//   - server 端口:accept 出的 client 任一积压,server 即 blocked
+//   - 可写时 port_tx_poll 冲刷;写空后 idle
+//   - 端口断开(句柄过期):残留字节丢弃,同槽位的新连接从空环开始
+//   - 非 socket 端口(tty / usb)走 writev,语义相同
+//   - 慢 client(server 配 slow_client):drop_oldest 丢最旧、latest 只留最新、
+//     disconnect 到期断开;都只丢整条消息,不拖住 server;积压和落后时长可查
+//   - 池缓冲消息排队只持引用:广播给两个 client 时两个环共享一个缓冲,都写完才归还
+//   - zerocopy_min:TCP 上不小于阈值的直写带 MSG_ZEROCOPY,缓冲持有到完成通知
+//   - tcp_client 断线(base.link 不是 UP):buffer_bytes 以内整条缓存、超出整条丢;
+//     重连(link_epoch 变)后 poll 把缓存按序写到新 fd;旧连接上写了一半的那条作废;
+//     重连间隔(port_reconnect_delay_ms)指数退避、封顶、抖动
+//
+// §6.5 TEST AS DOC 形态。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -Wall -Wextra -D_GNU_SOURCE -I routerd/include -I routerd/3rdparty/cjson routerd/src/port_tx.c routerd/src/port_manager.c routerd/src/tty_baud.c routerd/src/buf_pool.c routerd/src/config_store.c routerd/src/log.c routerd/3rdparty/cjson/cJSON.c tests/unit/test_port_tx.c -lpthread -o /tmp/test_port_tx
+//   /tmp/test_port_tx
+//
+// 退出码:0 = 全部 PASS,非 0 = FAIL
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "port_tx.h"
+#include "port_manager.h"
+#include "buf_pool.h"
+#include "log.h"
+
+static int g_failed = 0;
+static int g_passed = 0;
+
+#define EXPECT(cond, label) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL %s (line %d)\n", label, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+#define MSG 1000
+
+static port_def_t make_port(const char* name, port_type_t type, int fd, int id)
+{
+    port_def_t p;
+    memset(&p, 0, sizeof(p));
+    strcpy(p.base.name, name);
+    p.base.type = type;
+    p.base.fd = fd;
+    p.base.id = id;
+    return p;
+}
+
+// 消息 = 4 字节序号 + 填充(填充字节 = 序号低 8 位),接收端据此检查完整性
+static void fill_msg(uint8_t* m, unsigned seq)
+{
+    memcpy(m, &seq, sizeof(seq));
+    memset(m + sizeof(seq), (int)(seq & 0xFF), MSG - sizeof(seq));
+}
+
+static int tx_write1(port_tx_t* tx, port_def_t* p, const uint8_t* m, int len)
+{
+    struct iovec iov = {.iov_base = (void*)m, .iov_len = (size_t)len};
+    return port_tx_write(tx, p, &iov, NULL, 1);
+}
+
+// 收到的字节流是否由完整消息组成、序号递增(允许有空缺);*last = 最后一条的序号
+static int stream_ok(const uint8_t* buf, size_t got, unsigned* last)
+{
+    *last = 0;
+    if (got % MSG) return 0;
+    for (size_t off = 0; off < got; off += MSG) {
+        unsigned s;
+        memcpy(&s, buf + off, sizeof(s));
+        if (s <= *last) return 0;
+        *last = s;
+        for (int k = sizeof(s); k < MSG; k++)
+            if (buf[off + k] != (uint8_t)(s & 0xFF)) return 0;
+    }
+    return 1;
+}
+
+// accept 出的 client:base.id 指向配了 slow_client 的 server
+static port_def_t slow_client_setup(int* peer, int server_id, slow_client_policy_t policy,
+                                    int budget, int grace_ms)
+{
+    port_def_t* srv = &g_config.ports[server_id];
+    srv->base.type = PORT_TCP_SERVER;
+    srv->base.id   = server_id;
+    srv->base.slow_client.policy       = policy;
+    srv->base.slow_client.budget_bytes = budget;
+    srv->base.slow_client.grace_ms     = grace_ms;
+
+    int sv[2], small = 4096;
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    setsockopt(sv[1], SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+    fcntl(sv[1], F_SETFL, O_NONBLOCK);
+    *peer = sv[1];
+    port_def_t cli = make_port("SRV", PORT_TCP_CLIENT, sv[0], server_id);
+    return cli;
+}
+
+// 非阻塞读空 fd,追加到 buf,返回新长度
+static size_t drain_fd(int fd, uint8_t* buf, size_t have, size_t cap)
+{
+    for (;;) {
+        ssize_t r = read(fd, buf + have, cap - have);
+        if (r <= 0) return have;
+        have += (size_t)r;
+    }
+}
+
+int main(void)
+{
+    log_init(0, LOG_LEVEL_ERROR);
+    static uint8_t rx[4 * 1024 * 1024];
+    uint8_t m[MSG];
+    g_config.port_count = 9;
+    buf_pool_init(64);   // 引擎按池大小定引用上限,先建池
+
+    port_tx_t* tx = port_tx_create();
+    EXPECT(tx != NULL && port_tx_fd(tx) >= 0, "setup: engine created");
+
+    int sv[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    int small = 4096;
+    setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    setsockopt(sv[1], SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+    fcntl(sv[1], F_SETFL, O_NONBLOCK);
+    port_def_t net = make_port("NET", PORT_TCP_CLIENT, sv[0], 0);
+    port_register(&net);
+
+    // ---- Case 1: 有空间时直接写出,不排队 ----
+    fill_msg(m, 0);
+    EXPECT(tx_write1(tx, &net, m, 100) == 100, "case1: write accepted");
+    EXPECT(port_tx_idle(tx, &net), "case1: nothing queued");
+    port_tx_stats_t st;
+    port_tx_get_stats(0, &st);
+    EXPECT(st.short_writes == 0 && st.queued_bytes == 0, "case1: no short write");
+    size_t got = drain_fd(sv[1], rx, 0, sizeof(rx));
+    EXPECT(got == 100, "case1: peer received");
+
+    // ---- Case 2: 对端不读,一直写:短写进环,环满整条丢,写调用从不阻塞 ----
+    unsigned seq = 1, accepted_msgs = 0;
+    int saw_blocked_at = -1;
+    for (; seq <= 400; seq++) {
+        fill_msg(m, seq);
+        int w = tx_write1(tx, &net, m, MSG);
+        if (w == MSG) accepted_msgs++;
+        if (saw_blocked_at < 0 && port_tx_blocked(tx, 0))
+            saw_blocked_at = (int)seq;
+    }
+    port_tx_get_stats(0, &st);
+    EXPECT(st.short_writes >= 1, "case2: short write / EAGAIN observed");
+    EXPECT(!port_tx_idle(tx, &net), "case2: bytes queued");
+    EXPECT(st.queued_bytes <= PORT_TX_RING_BYTES, "case2: ring bounded");
+    EXPECT(st.overflow_drops == 400 - accepted_msgs, "case2: every rejected message counted");
+    EXPECT(st.overflow_drops > 0, "case2: ring overflowed");
+    EXPECT(saw_blocked_at > 0, "case2: blocked once over high watermark");
+
+    // ---- Case 3: 读走一部分,高低水位之间仍 blocked(滞回)----
+    got = 0;
+    while (st.queued_bytes > (PORT_TX_HWM + PORT_TX_LWM) / 2) {
+        got = drain_fd(sv[1], rx, got, sizeof(rx));
+        port_tx_poll(tx);
+        port_tx_get_stats(0, &st);
+    }
+    EXPECT(port_tx_blocked(tx, 0), "case3: still blocked between LWM and HWM");
+
+    // ---- Case 4: 全部冲刷:blocked 解除,接收端是完整、有序的消息 ----
+    for (int spin = 0; spin < 100000 && !port_tx_idle(tx, &net); spin++) {
+        got = drain_fd(sv[1], rx, got, sizeof(rx));
+        port_tx_poll(tx);
+    }
+    got = drain_fd(sv[1], rx, got, sizeof(rx));
+    EXPECT(port_tx_idle(tx, &net), "case4: ring drained");
+    EXPECT(!port_tx_blocked(tx, 0), "case4: unblocked below LWM");
+    EXPECT(got == (size_t)accepted_msgs * MSG, "case4: all accepted bytes delivered");
+    unsigned last;
+    EXPECT(stream_ok(rx, got, &last), "case4: no torn message, order preserved");
+    port_tx_get_stats(0, &st);
+    EXPECT(st.queued_bytes == 0 && st.flushes > 0, "case4: flushed via poll");
+
+    // ---- Case 5: 端口断开,残留丢弃;同槽位新连接从空环开始 ----
+    for (seq = 1000; seq < 1100; seq++) {
+        fill_msg(m, seq);
+        tx_write1(tx, &net, m, MSG);
+    }
+    EXPECT(!port_tx_idle(tx, &net), "case5: bytes queued before disconnect");
+    port_handle_t old = net.base.handle;
+    close(sv[0]);
+    port_unregister(old);
+    port_tx_poll(tx);   // 已关闭的 fd 不再报 EPOLLOUT,残留由 blocked 检查或槽位复用清掉
+    EXPECT(!port_tx_blocked(tx, 0), "case5: disconnected backlog does not block the port");
+    int sv2[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sv2);
+    port_def_t net2 = make_port("NET", PORT_TCP_CLIENT, sv2[0], 0);
+    port_register(&net2);
+    EXPECT(port_handle_slot(net2.base.handle) == port_handle_slot(old), "case5: slot reused");
+    EXPECT(port_tx_idle(tx, &net2), "case5: new connection starts empty");
+    fill_msg(m, 7);
+    EXPECT(tx_write1(tx, &net2, m, MSG) == MSG, "case5: new connection writable");
+    port_tx_get_stats(0, &st);
+    EXPECT(st.queued_bytes == 0, "case5: stale bytes no longer counted as queued");
+
+    // ---- Case 6: 非 socket 端口(pipe 模拟 O_NONBLOCK tty)----
+    int pf[2];
+    pipe(pf);
+    fcntl(pf[0], F_SETFL, O_NONBLOCK);
+    fcntl(pf[1], F_SETFL, O_NONBLOCK);
+    port_def_t uart = make_port("UART", PORT_TTY, pf[1], 1);
+    port_register(&uart);
+    int total = 0;
+    for (seq = 1; seq <= 200; seq++) {
+        fill_msg(m, seq);
+        total += tx_write1(tx, &uart, m, MSG);
+    }
+    EXPECT(!port_tx_idle(tx, &uart), "case6: tty backlog queued");
+    got = 0;
+    for (int spin = 0; spin < 100000 && !port_tx_idle(tx, &uart); spin++) {
+        got = drain_fd(pf[0], rx, got, sizeof(rx));
+        port_tx_poll(tx);
+    }
+    got = drain_fd(pf[0], rx, got, sizeof(rx));
+    EXPECT(got == (size_t)total, "case6: tty bytes delivered");
+
+    // ---- Case 7: server 按 client 汇总(accept 出的 client 的 base.id 是 server 的)----
+    int sv3[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sv3);
+    setsockopt(sv3[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    port_def_t cli = make_port("SRV", PORT_TCP_CLIENT, sv3[0], 2);
+    port_register(&cli);
+    for (seq = 1; seq <= 100; seq++) {
+        fill_msg(m, seq);
+        tx_write1(tx, &cli, m, MSG);
+    }
+    EXPECT(port_tx_blocked(tx, 2), "case7: slow client blocks its server");
+    EXPECT(!port_tx_blocked(tx, 0), "case7: other ports unaffected");
+    close(sv3[0]);
+    port_unregister(cli.base.handle);
+    EXPECT(!port_tx_blocked(tx, 2), "case7: client gone, server resumes");
+
+    // ---- Case 8: drop_oldest:积压压回 budget,最新的保留,server 不被拖住 ----
+    int peer;
+    port_def_t c8 = slow_client_setup(&peer, 3, SLOW_CLIENT_DROP_OLDEST, 8 * 1024, 0);
+    port_register(&c8);
+    for (seq = 1; seq <= 100; seq++) {
+        fill_msg(m, seq);
+        tx_write1(tx, &c8, m, MSG);
+    }
+    port_tx_get_stats(3, &st);
+    EXPECT(st.queued_bytes <= 8 * 1024 + MSG, "case8: backlog trimmed to budget");
+    EXPECT(st.lag_drops > 0 && st.downgrades == 1, "case8: oldest messages dropped");
+    EXPECT(!port_tx_blocked(tx, 3), "case8: server not blocked by slow client");
+    got = 0;
+    for (int spin = 0; spin < 100000 && !port_tx_idle(tx, &c8); spin++) {
+        got = drain_fd(peer, rx, got, sizeof(rx));
+        port_tx_poll(tx);
+    }
+    got = drain_fd(peer, rx, got, sizeof(rx));
+    unsigned last8;
+    EXPECT(stream_ok(rx, got, &last8), "case8: only whole messages, in order");
+    EXPECT(last8 == 100, "case8: newest message delivered");
+    EXPECT(got / MSG + st.lag_drops == 100, "case8: every message delivered or counted");
+
+    // ---- Case 9: latest:只留最新一条,追上后恢复 ----
+    port_def_t c9 = slow_client_setup(&peer, 4, SLOW_CLIENT_LATEST, 8 * 1024, 0);
+    port_register(&c9);
+    for (seq = 1; seq <= 100; seq++) {
+        fill_msg(m, seq);
+        tx_write1(tx, &c9, m, MSG);
+    }
+    port_tx_get_stats(4, &st);
+    EXPECT(st.queued_bytes <= 2 * MSG, "case9: only in-flight + latest queued");
+    EXPECT(st.downgrades == 1, "case9: downgraded once");
+    got = 0;
+    for (int spin = 0; spin < 100000 && !port_tx_idle(tx, &c9); spin++) {
+        got = drain_fd(peer, rx, got, sizeof(rx));
+        port_tx_poll(tx);
+    }
+    got = drain_fd(peer, rx, got, sizeof(rx));
+    unsigned last9;
+    EXPECT(stream_ok(rx, got, &last9) && last9 == 100, "case9: whole messages, latest delivered");
+    unsigned long drops9 = st.lag_drops;
+    fill_msg(m, 101);
+    tx_write1(tx, &c9, m, MSG);
+    port_tx_get_stats(4, &st);
+    EXPECT(st.lag_drops == drops9, "case9: caught up, back to normal");
+
+    // ---- Case 10: disconnect:超 budget 未满 grace 只计落后时长,到期断开 ----
+    port_def_t c10 = slow_client_setup(&peer, 5, SLOW_CLIENT_DISCONNECT, 8 * 1024, 50);
+    port_register(&c10);
+    for (seq = 1; seq <= 50; seq++) {
+        fill_msg(m, seq);
+        tx_write1(tx, &c10, m, MSG);
+    }
+    port_tx_client_t cl[4];
+    int ncl = port_tx_clients(5, cl, 4);
+    EXPECT(ncl == 1 && cl[0].queued > 8 * 1024, "case10: client backlog visible");
+    port_tx_get_stats(5, &st);
+    EXPECT(st.evictions == 0, "case10: not evicted within grace");
+    usleep(80 * 1000);
+    port_tx_poll(tx);   // 对端完全不读:到期检查靠 poll
+    ncl = port_tx_clients(5, cl, 4);
+    port_tx_get_stats(5, &st);
+    EXPECT(st.evictions == 1, "case10: evicted after grace");
+    EXPECT(!port_tx_blocked(tx, 5), "case10: server not blocked");
+    got = drain_fd(peer, rx, 0, sizeof(rx));
+    EXPECT(read(peer, rx, 1) == 0, "case10: peer sees EOF");
+    fill_msg(m, 51);
+    EXPECT(tx_write1(tx, &c10, m, MSG) == MSG, "case10: writes after eviction silently dropped");
+
+    // ---- Case 11: 广播共享缓冲:两个慢 client 的环引用同一个池缓冲,都写完才归还 ----
+    static uint8_t rx2[256 * 1024];
+    int pa[2], pb[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, pa);
+    socketpair(AF_UNIX, SOCK_STREAM, 0, pb);
+    int fds11[] = {pa[0], pa[1], pb[0], pb[1]};
+    for (int k = 0; k < 4; k++)
+        setsockopt(fds11[k], SOL_SOCKET, (k & 1) ? SO_RCVBUF : SO_SNDBUF, &small, sizeof(small));
+    fcntl(pa[1], F_SETFL, O_NONBLOCK);
+    fcntl(pb[1], F_SETFL, O_NONBLOCK);
+    port_def_t ca = make_port("BC", PORT_TCP_CLIENT, pa[0], 6);
+    port_def_t cb = make_port("BC", PORT_TCP_CLIENT, pb[0], 6);
+    port_register(&ca);
+    port_register(&cb);
+    for (seq = 1; seq <= 20; seq++) {   // 先塞满内核缓冲,后面的消息必须排队
+        fill_msg(m, seq);
+        tx_write1(tx, &ca, m, MSG);
+        tx_write1(tx, &cb, m, MSG);
+    }
+    buf_t* b = buf_alloc(MSG);
+    fill_msg(b->data, 21);
+    struct iovec iov11 = {.iov_base = b->data, .iov_len = MSG};
+    struct buf* bl[1] = {b};
+    port_tx_write(tx, &ca, &iov11, bl, 1);
+    port_tx_write(tx, &cb, &iov11, bl, 1);
+    EXPECT(buf_refcnt(b) == 3, "case11: both rings reference the buffer");
+    port_tx_get_stats(6, &st);
+    EXPECT(st.ref_msgs == 2, "case11: queued by reference, not copied");
+    buf_unref(b);   // 调用方(dispatch worker)照常释放自己那份
+    got = 0;
+    size_t got2 = 0;
+    for (int spin = 0; spin < 100000 && !(port_tx_idle(tx, &ca) && port_tx_idle(tx, &cb)); spin++) {
+        got  = drain_fd(pa[1], rx, got, sizeof(rx));
+        got2 = drain_fd(pb[1], rx2, got2, sizeof(rx2));
+        port_tx_poll(tx);
+    }
+    got  = drain_fd(pa[1], rx, got, sizeof(rx));
+    got2 = drain_fd(pb[1], rx2, got2, sizeof(rx2));
+    unsigned la, lb;
+    EXPECT(stream_ok(rx, got, &la) && la == 21 && got == 21 * MSG, "case11: client A got every message");
+    EXPECT(stream_ok(rx2, got2, &lb) && lb == 21 && got2 == 21 * MSG, "case11: client B got every message");
+    buf_pool_stats_t ps;
+    buf_pool_get_stats(&ps);
+    EXPECT(ps.in_use == 0 && port_tx_refs_held() == 0, "case11: buffer returned after the last client");
+
+    // ---- Case 12: zerocopy_min:TCP loopback 上大消息带 MSG_ZEROCOPY,完成后归还 ----
+    int ls = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in sa = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    socklen_t sl = sizeof(sa);
+    bind(ls, (struct sockaddr*)&sa, sizeof(sa));
+    listen(ls, 1);
+    getsockname(ls, (struct sockaddr*)&sa, &sl);
+    int cfd = socket(AF_INET, SOCK_STREAM, 0);
+    connect(cfd, (struct sockaddr*)&sa, sizeof(sa));
+    int afd = accept(ls, NULL, NULL);
+    g_config.ports[7].base.zerocopy_min = 512;
+    port_def_t zc = make_port("ZC", PORT_TCP_CLIENT, cfd, 7);
+    port_register(&zc);
+
+    fill_msg(m, 1);
+    tx_write1(tx, &zc, m, 100);   // 小于阈值:普通发送
+    b = buf_alloc(MSG);
+    fill_msg(b->data, 2);
+    iov11.iov_base = b->data;
+    bl[0] = b;
+    EXPECT(port_tx_write(tx, &zc, &iov11, bl, 1) == MSG, "case12: large write accepted");
+    port_tx_get_stats(7, &st);
+    if (st.zc_sends == 0) {
+        printf("SKIP case12: SO_ZEROCOPY unavailable on this kernel\n");
+        buf_unref(b);
+    } else {
+        EXPECT(st.zc_sends == 1, "case12: only the message above the threshold used zerocopy");
+        EXPECT(buf_refcnt(b) == 2, "case12: buffer pinned until the kernel completes");
+        buf_unref(b);
+        size_t want = 100 + MSG;
+        got = 0;
+        while (got < want) {
+            ssize_t k = read(afd, rx + got, want - got);
+            if (k <= 0) break;
+            got += (size_t)k;
+        }
+        EXPECT(got == want && memcmp(rx + 100, iov11.iov_base, MSG) == 0, "case12: bytes delivered");
+        for (int spin = 0; spin < 1000 && port_tx_refs_held() > 0; spin++) {
+            port_tx_poll(tx);
+            usleep(1000);
+        }
+        port_tx_get_stats(7, &st);
+        buf_pool_get_stats(&ps);
+        EXPECT(port_tx_refs_held() == 0 && ps.in_use == 0, "case12: completion releases the buffer");
+        printf("      (zc_copied=%lu: loopback reports the kernel copied)\n", st.zc_copied);
+    }
+    close(afd);
+    close(ls);
+
+    // ---- Case 13: tcp_client 断线缓存与重连 ----
+    port_tcp_client_conf_t rc = {.reconnect_min_ms = 100, .reconnect_max_ms = 1000};
+    int d0 = port_reconnect_delay_ms(&rc, 0, 12345), d9 = port_reconnect_delay_ms(&rc, 9, 777);
+    EXPECT(d0 >= 50 && d0 <= 100 && d9 >= 500 && d9 <= 1000,
+           "case13: backoff doubles from min, capped at max, jittered into [d/2, d]");
+    port_def_t* dial = &g_config.ports[8];
+    *dial = make_port("DIAL", PORT_TCP_CLIENT, -1, 8);
+    dial->cfg.tcp_client.buffer_bytes = 5 * MSG;
+    port_register(dial);
+    atomic_store(&dial->base.link, PORT_LINK_DOWN);
+    for (unsigned k = 1; k <= 8; k++) {
+        fill_msg(m, k);
+        if (tx_write1(tx, dial, m, MSG) != MSG) break;
+    }
+    port_tx_get_stats(8, &st);
+    EXPECT(st.offline_msgs == 5 && st.offline_drops == 3, "case13: buffer_bytes bounds the backlog while down");
+    EXPECT(!port_tx_idle(tx, dial), "case13: down port is not idle (uring path must not write it)");
+    int t13 = port_tx_timeout_ms(tx);
+    EXPECT(t13 > 0 && t13 <= PORT_TX_RELINK_MS, "case13: worker wakes up to look for the reconnect");
+
+    int sr[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sr);
+    dial->base.fd = sr[0];
+    atomic_fetch_add(&dial->base.link_epoch, 1);
+    atomic_store(&dial->base.link, PORT_LINK_UP);
+    port_tx_poll(tx);
+    fcntl(sr[1], F_SETFL, O_NONBLOCK);
+    got = drain_fd(sr[1], rx, 0, sizeof(rx));
+    unsigned l13;
+    EXPECT(stream_ok(rx, got, &l13) && got == 5 * MSG && l13 == 5, "case13: backlog replayed in order on the new fd");
+
+    // 连着时积压,写了一半断线:新连接只收到完整消息
+    setsockopt(sr[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    for (unsigned k = 10; k < 60; k++) {
+        fill_msg(m, k);
+        tx_write1(tx, dial, m, MSG);
+    }
+    got = drain_fd(sr[1], rx, 0, 1500);   // 对端读走一条半,环头停在某条消息中间
+    port_tx_poll(tx);
+    atomic_store(&dial->base.link, PORT_LINK_DOWN);
+    close(sr[0]);
+    close(sr[1]);
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sr);
+    fcntl(sr[1], F_SETFL, O_NONBLOCK);
+    dial->base.fd = sr[0];
+    atomic_fetch_add(&dial->base.link_epoch, 1);
+    atomic_store(&dial->base.link, PORT_LINK_UP);
+    got = 0;
+    for (int spin = 0; spin < 200; spin++) {
+        port_tx_poll(tx);
+        got = drain_fd(sr[1], rx, got, sizeof(rx));
+    }
+    EXPECT(got > 0 && stream_ok(rx, got, &l13) && l13 == 59, "case13: torn head dropped, rest whole after reconnect");
+    close(sr[0]);
+    close(sr[1]);
+
+    port_tx_destroy(tx);
+    printf("\n%d passed, %d failed\n", g_passed, g_failed);
+    return g_failed ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+// test_port_udp.c — udp 端口(对端、学习、sendmmsg 保边界)的 test-as-doc
+//
+// 固化契约(port_manager.h / config_store.h 的 port_udp_conf_t):
+//   - 配置:没配 peer 时 learn_peer 缺省开,配了 peer 时缺省关;multicast 块可选
+//   - 没有对端(没配、也没学到)时发送返回 0,不报错
+//   - 配了 peer:一批 cnt 条消息 = cnt 个数据报,长度 / 内容 / 顺序与消息一一对应
+//   - learn_peer:port_udp_learn 之后发往学到的地址;关着时学习不生效
+//   - 打开时非阻塞(worker 发送不会因为 socket 阻塞)
+//
+// §6.5 TEST AS DOC 形态。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -Wall -Wextra -D_GNU_SOURCE -I routerd/include -I routerd/3rdparty/cjson routerd/src/port_manager.c routerd/src/tty_baud.c routerd/src/port_tx.c routerd/src/buf_pool.c routerd/src/config_store.c routerd/src/log.c routerd/3rdparty/cjson/cJSON.c tests/unit/test_port_udp.c -lpthread -o /tmp/test_port_udp
+//   /tmp/test_port_udp
+//
+// 退出码:0 = 全部 PASS,非 0 = FAIL
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "port_manager.h"
+#include "log.h"
+
+static int g_failed = 0;
+static int g_passed = 0;
+
+#define EXPECT(cond, label) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL %s (line %d)\n", label, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+// 本机 127.0.0.1 上的接收 socket,返回 fd,*port = 内核分的端口
+static int udp_sink(int* port)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    struct sockaddr_in a = {.sin_family = AF_INET};
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, (struct sockaddr*)&a, sizeof(a));
+    socklen_t l = sizeof(a);
+    getsockname(fd, (struct sockaddr*)&a, &l);
+    *port = ntohs(a.sin_port);
+    return fd;
+}
+
+int main(void)
+{
+    int sink_port, sink = udp_sink(&sink_port);
+    int other_port, other = udp_sink(&other_port);
+
+    // ---- Case 1: 配置解析 ----
+    char path[] = "/tmp/test_port_udp_XXXXXX";
+    int cf = mkstemp(path);
+    dprintf(cf,
+            "{\"ports\":["
+            "{\"name\":\"PEER\",\"type\":\"udp\",\"udp\":{\"bind\":\"127.0.0.1\",\"port\":0,"
+            "\"peer\":\"127.0.0.1\",\"peer_port\":%d}},"
+            "{\"name\":\"LEARN\",\"type\":\"udp\",\"udp\":{\"bind\":\"127.0.0.1\",\"port\":0}},"
+            "{\"name\":\"MC\",\"type\":\"udp\",\"udp\":{\"bind\":\"0.0.0.0\",\"port\":0,"
+            "\"peer\":\"239.1.2.3\",\"peer_port\":%d,"
+            "\"multicast\":{\"group\":\"239.1.2.3\",\"ttl\":4,\"loop\":true}}}],"
+            "\"plugins\":[],\"routes\":[]}",
+            sink_port, sink_port);
+    close(cf);
+    EXPECT(load_config(path) == 0 && g_config.port_count == 3, "case1: config loads");
+    unlink(path);
+    port_def_t* peer  = &g_config.ports[0];
+    port_def_t* learn = &g_config.ports[1];
+    port_def_t* mc    = &g_config.ports[2];
+    EXPECT(!peer->cfg.udp.learn_peer && learn->cfg.udp.learn_peer,
+           "case1: learn_peer defaults on only without a configured peer");
+    EXPECT(strcmp(mc->cfg.udp.mcast_group, "239.1.2.3") == 0 && mc->cfg.udp.mcast_ttl == 4 &&
+           mc->cfg.udp.mcast_loop == 1, "case1: multicast block parsed");
+
+    // ---- Case 2: 配了 peer,一批消息 = 一批数据报 ----
+    EXPECT(port_open_single(peer) >= 0, "case2: udp port opens");
+    EXPECT(fcntl(peer->base.fd, F_GETFL) & O_NONBLOCK, "case2: socket is non-blocking");
+    char m[5][64];
+    struct iovec iov[5];
+    for (int i = 0; i < 5; i++) {
+        memset(m[i], 'a' + i, sizeof(m[i]));
+        iov[i].iov_base = m[i];
+        iov[i].iov_len  = (size_t)(10 * i + 1);
+    }
+    EXPECT(port_send_batch(peer, iov, 5) == 1 + 11 + 21 + 31 + 41, "case2: batch accepted");
+    int whole = 1;
+    for (int i = 0; i < 5; i++) {
+        char rx[256];
+        ssize_t r = recv(sink, rx, sizeof(rx), 0);
+        if (r != (ssize_t)iov[i].iov_len || memcmp(rx, m[i], (size_t)r) != 0) whole = 0;
+    }
+    EXPECT(whole, "case2: one datagram per message, boundaries and order kept");
+    char one[] = "single";
+    EXPECT(port_send(peer, (const uint8_t*)one, 6) == 6, "case2: port_send sends a datagram");
+    char rx[64];
+    EXPECT(recv(sink, rx, sizeof(rx), 0) == 6, "case2: single datagram received");
+
+    // ---- Case 3: 学习对端 ----
+    EXPECT(port_open_single(learn) >= 0, "case3: udp port opens");
+    struct sockaddr_in cur;
+    EXPECT(!port_udp_peer(learn, &cur), "case3: no peer before anything is received");
+    EXPECT(port_send(learn, (const uint8_t*)one, 6) == 0, "case3: nothing to send to yet, returns 0");
+    struct sockaddr_in from = {.sin_family = AF_INET, .sin_port = htons(other_port)};
+    from.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    port_udp_learn(learn, &from);
+    EXPECT(port_udp_peer(learn, &cur) && cur.sin_port == htons(other_port) &&
+           cur.sin_addr.s_addr == htonl(INADDR_LOOPBACK), "case3: learned the sender");
+    EXPECT(port_send(learn, (const uint8_t*)one, 6) == 6 && recv(other, rx, sizeof(rx), 0) == 6,
+           "case3: replies go to the learned peer");
+
+    // learn_peer 关着的端口不被改写
+    from.sin_port = htons(1);
+    port_udp_learn(peer, &from);
+    EXPECT(port_udp_peer(peer, &cur) && cur.sin_port == htons(sink_port),
+           "case3: learning ignored when learn_peer is off");
+
+    port_close_single(peer);
+    port_close_single(learn);
+    close(sink);
+    close(other);
+    printf("\n%d passed, %d failed\n", g_passed, g_failed);
+    return g_failed ? 1 : 0;
+}
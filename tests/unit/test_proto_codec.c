@@ -6,12 +6,13 @@
 //   - PROTO_MAX_PAYLOAD = 65536(64 KiB)
 //   - decode 零拷贝(payload_out 指向 in_buf 内部)
 //   - INCOMPLETE 与 BAD_MAGIC / BAD_VERSION 严格区分(caller 行为不同)
+//   - BAD_MAGIC 后 proto_resync 跳到下一个 magic + version 候选
 //
 // 这是 §6.5 TEST AS DOC 形态,等 Unity 单测脚手架就绪(open-questions U1)
 // 后迁移过去。
 //
 // 编译运行(从仓库根目录),命令在一行:
-//   gcc -Wall -Wextra -I routerd/include routerd/src/proto_codec.c tests/unit/test_proto_codec.c -o /tmp/test_proto_codec
+//   gcc -Wall -Wextra -I routerd/include routerd/src/proto_codec.c routerd/src/byte_scan.c tests/unit/test_proto_codec.c -o /tmp/test_proto_codec
 //   /tmp/test_proto_codec
 //
 // 退出码:0 = 全部 PASS,非 0 = FAIL
@@ -261,6 +262,47 @@ static void test_roundtrip_matrix(void)
     EXPECT(ok, "roundtrip_matrix_cmd_x_seq");
 }
 
+// 垃圾 + 合法帧:resync 丢掉垃圾后 decode 成功
+static void test_resync_garbage_then_frame(void)
+{
+    uint8_t buf[256];
+    memset(buf, 0x55, 37);
+    buf[5] = 0x7C; buf[6] = 0xEB; buf[7] = 0x09;   // magic 对但 version 不对:payload 里碰巧的
+    buf[20] = 0x7C;                                 // 半个 magic
+    const uint8_t pl[3] = {1, 2, 3};
+    size_t n = craft_frame(buf + 37, PROTO_MAGIC, PROTO_VERSION, PROTO_DATA, 7, 3, pl);
+
+    proto_frame_hdr_t out;
+    const uint8_t* p = NULL;
+    EXPECT_EQ_INT(proto_decode(buf, 37 + n, &out, &p), PROTO_ERR_BAD_MAGIC, "resync_precondition_bad_magic");
+    size_t skip = proto_resync(buf, 37 + n);
+    EXPECT_EQ_INT(skip, 37, "resync_skips_to_real_header");
+    EXPECT_EQ_INT(proto_decode(buf + skip, 37 + n - skip, &out, &p), (int)n, "resync_then_decode_ok");
+    EXPECT_EQ_INT(out.seq, 7, "resync_then_decode_seq");
+}
+
+// 没有候选:全部丢弃;末字节是 magic 前半时保留它等下一次 recv
+static void test_resync_no_candidate(void)
+{
+    uint8_t buf[64];
+    memset(buf, 0xAA, sizeof(buf));
+    EXPECT_EQ_INT(proto_resync(buf, sizeof(buf)), sizeof(buf), "resync_drop_all");
+    buf[63] = 0x7C;
+    EXPECT_EQ_INT(proto_resync(buf, sizeof(buf)), 63, "resync_keep_half_magic");
+    // 头部恰好是 magic(decode 已判它坏):不会返回 0 原地打转
+    buf[0] = 0x7C; buf[1] = 0xEB; buf[2] = PROTO_VERSION;
+    EXPECT(proto_resync(buf, sizeof(buf)) > 0, "resync_always_progresses");
+}
+
+// version 字节还没收到的候选先保留
+static void test_resync_candidate_at_tail(void)
+{
+    uint8_t buf[40];
+    memset(buf, 0, sizeof(buf));
+    buf[38] = 0x7C; buf[39] = 0xEB;
+    EXPECT_EQ_INT(proto_resync(buf, sizeof(buf)), 38, "resync_tail_candidate");
+}
+
 int main(void)
 {
     test_roundtrip_empty();
@@ -275,6 +317,9 @@ int main(void)
     test_incomplete_payload();
     test_encode_buf_too_small();
     test_roundtrip_matrix();
+    test_resync_garbage_then_frame();
+    test_resync_no_candidate();
+    test_resync_candidate_at_tail();
 
     printf("\n%d passed, %d failed\n", g_passed, g_failed);
     return g_failed ? 1 : 0;
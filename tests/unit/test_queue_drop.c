@@ -6,6 +6,10 @@
 //   reactor 线程不可被任何 send 路径阻塞。
 //   queue_push 在队列满时最多 timed_wait QUEUE_PUSH_TIMEOUT_MS,
 //   超时返回 -1 + WARN + drop_count++,reactor 永不卡死。
+//   零拷贝接口 queue_reserve 满时遵守同一规则(返回 NULL);
+//   queue_try_reserve 满即返回 NULL 不等待;高水位置 throttled,低水位 write resume eventfd;
+//   水位同时按条数和字节算(大消息按字节先到);
+//   reserve/commit ↔ peek/release 往返不拷贝,peek 拿到的就是 commit 的槽位。
 //
 /* 编译运行(在 target 上):
      cd /opt/ez_router_test
@@ -22,10 +26,11 @@
 #include <string.h>
 #include <pthread.h>
 #include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 #include "event_queue.h"
 #include "log.h"
 
-#define QSIZE 128  // 必须与 event_queue.c 内一致
 
 static int g_failed = 0;
 #define EXPECT_EQ(actual, expected, label) do { \
@@ -43,25 +48,28 @@ static long elapsed_ms(struct timespec a, struct timespec b)
 
 int main(void) {
     log_init(0, LOG_LEVEL_WARN);  // 抑制 INFO/DEBUG 噪音
-    queue_init();
+    event_queue_t* q = queue_create("TEST_DST", NULL);
+    EXPECT_EQ(q != NULL, 1, "setup: queue_create");
 
     event_msg_t msg;
     memset(&msg, 0, sizeof(msg));
-    strcpy(msg.dst, "TEST_DST");
+    msg.dst = 1;
+    uint8_t payload[4] = {'A', 'B', 'C', 'D'};   // 消息只携带数据指针,数据由调用方持有
     msg.len = 4;
-    memcpy(msg.data, "ABCD", 4);
+    msg.data = payload;
 
     // ---- Case 1: 单次正常 push/pop,返回 0 ----
-    EXPECT_EQ(queue_push(&msg), 0, "case1: normal push returns 0");
+    EXPECT_EQ(queue_push(q, &msg), 0, "case1: normal push returns 0");
     event_msg_t got;
-    queue_pop(&got);
+    queue_pop(q, &got);
     EXPECT_EQ(got.len, 4, "case1: pop len matches");
     EXPECT_EQ(memcmp(got.data, "ABCD", 4), 0, "case1: pop payload matches");
 
     // ---- Case 2: 灌满队列(QSIZE-1 = 127 条)前都成功 ----
-    queue_init();
+    queue_destroy(q);
+    q = queue_create("TEST_DST", NULL);
     for (int i = 0; i < QSIZE - 1; i++) {
-        if (queue_push(&msg) != 0) {
+        if (queue_push(q, &msg) != 0) {
             fprintf(stderr, "FAIL case2: push %d unexpectedly failed\n", i);
             g_failed++;
             break;
@@ -70,10 +78,10 @@ int main(void) {
     printf("PASS case2: filled %d entries without timeout\n", QSIZE - 1);
 
     // ---- Case 3: 队列满后第 128 次 push 应在 ~100ms 内 timeout drop ----
-    unsigned long drops_before = queue_get_drop_count();
+    unsigned long drops_before = queue_get_drop_count(q);
     struct timespec t0, t1;
     clock_gettime(CLOCK_MONOTONIC, &t0);
-    int rc = queue_push(&msg);
+    int rc = queue_push(q, &msg);
     clock_gettime(CLOCK_MONOTONIC, &t1);
     long ms = elapsed_ms(t0, t1);
     EXPECT_EQ(rc, -1, "case3: full-queue push returns -1");
@@ -83,19 +91,19 @@ int main(void) {
     } else {
         printf("PASS case3: timeout in %ld ms (in [80,250])\n", ms);
     }
-    EXPECT_EQ(queue_get_drop_count() - drops_before, 1, "case3: drop_count incremented by 1");
+    EXPECT_EQ(queue_get_drop_count(q) - drops_before, 1, "case3: drop_count incremented by 1");
 
     // ---- Case 4: 多次满 push 累计 drop_count ----
-    drops_before = queue_get_drop_count();
+    drops_before = queue_get_drop_count(q);
     for (int i = 0; i < 3; i++) {
-        EXPECT_EQ(queue_push(&msg), -1, "case4: full push returns -1");
+        EXPECT_EQ(queue_push(q, &msg), -1, "case4: full push returns -1");
     }
-    EXPECT_EQ(queue_get_drop_count() - drops_before, 3, "case4: drop_count incremented by 3");
+    EXPECT_EQ(queue_get_drop_count(q) - drops_before, 3, "case4: drop_count incremented by 3");
 
     // ---- Case 5: pop 释放后 push 立即 ok(不 timeout) ----
-    queue_pop(&got);
+    queue_pop(q, &got);
     clock_gettime(CLOCK_MONOTONIC, &t0);
-    rc = queue_push(&msg);
+    rc = queue_push(q, &msg);
     clock_gettime(CLOCK_MONOTONIC, &t1);
     ms = elapsed_ms(t0, t1);
     EXPECT_EQ(rc, 0, "case5: post-pop push returns 0");
@@ -106,6 +114,117 @@ int main(void) {
         printf("PASS case5: push completed in %ld ms\n", ms);
     }
 
+    // ---- Case 6: reserve/commit → peek/release 零拷贝往返,槽位指针一致 ----
+    queue_destroy(q);
+    q = queue_create("TEST_DST", NULL);
+    event_msg_t* w = queue_reserve(q);
+    EXPECT_EQ(w != NULL, 1, "case6: reserve on empty queue returns slot");
+    w->dst = 2;
+    uint8_t zc[4] = {'W', 'X', 'Y', 'Z'};
+    w->buf = NULL;
+    w->data = zc;
+    w->len = 4;
+    queue_commit(q);
+    event_msg_t* r = queue_peek(q);
+    EXPECT_EQ(r == w, 1, "case6: peek returns the committed slot (no copy)");
+    EXPECT_EQ(memcmp(r->data, "WXYZ", 4), 0, "case6: peek payload matches");
+    queue_release(q);
+
+    // ---- Case 7: reserve 不 commit = 放弃,下次 reserve 拿到同一槽位,消费者看不到 ----
+    event_msg_t* a = queue_reserve(q);
+    event_msg_t* b = queue_reserve(q);
+    EXPECT_EQ(a == b, 1, "case7: uncommitted reserve is reused");
+    EXPECT_EQ(queue_push(q, &msg), 0, "case7: push after abandoned reserve ok");
+    queue_pop(q, &got);
+    EXPECT_EQ(got.len, 4, "case7: pop sees only the pushed message");
+
+    // ---- Case 8: 满队列 reserve 与 push 同规则:~100ms 超时返回 NULL + drop_count++ ----
+    queue_destroy(q);
+    q = queue_create("TEST_DST", NULL);
+    for (int i = 0; i < QSIZE - 1; i++) queue_push(q, &msg);
+    drops_before = queue_get_drop_count(q);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    w = queue_reserve(q);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ms = elapsed_ms(t0, t1);
+    EXPECT_EQ(w == NULL, 1, "case8: full-queue reserve returns NULL");
+    if (ms < 80 || ms > 250) {
+        fprintf(stderr, "FAIL case8: timeout took %ld ms, expected ~100ms (80-250 tolerance)\n", ms);
+        g_failed++;
+    } else {
+        printf("PASS case8: timeout in %ld ms (in [80,250])\n", ms);
+    }
+    EXPECT_EQ(queue_get_drop_count(q) - drops_before, 1, "case8: drop_count incremented by 1");
+
+    // ---- Case 9: try_reserve("drop" 策略)满即返回 NULL,不等待 ----
+    drops_before = queue_get_drop_count(q);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    w = queue_try_reserve(q);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    ms = elapsed_ms(t0, t1);
+    EXPECT_EQ(w == NULL, 1, "case9: full-queue try_reserve returns NULL");
+    EXPECT_EQ(ms < 5, 1, "case9: try_reserve does not wait");
+    EXPECT_EQ(queue_get_drop_count(q) - drops_before, 1, "case9: drop_count incremented by 1");
+
+    // ---- Case 10: 高水位置 throttled,消费到低水位时 write resume eventfd 一次 ----
+    queue_destroy(q);
+    q = queue_create("TEST_DST", NULL);
+    int resume = eventfd(0, EFD_NONBLOCK);
+    queue_set_resume_fd(q, resume);
+    for (int i = 0; i < QUEUE_HIGH_WATERMARK - 1; i++) queue_push(q, &msg);
+    EXPECT_EQ(queue_over_high_watermark(q), 0, "case10: below high watermark");
+    queue_push(q, &msg);
+    EXPECT_EQ(queue_over_high_watermark(q), 1, "case10: at high watermark -> throttle");
+    EXPECT_EQ(queue_try_reserve(q) != NULL, 1, "case10: still room above high watermark");
+    uint64_t ev;
+    while (queue_depth(q) > QUEUE_LOW_WATERMARK + 1) queue_pop(q, &got);
+    EXPECT_EQ(read(resume, &ev, sizeof(ev)) < 0, 1, "case10: no resume above low watermark");
+    queue_pop(q, &got);
+    EXPECT_EQ(read(resume, &ev, sizeof(ev)) == sizeof(ev), 1, "case10: resume signalled at low watermark");
+    queue_pop(q, &got);
+    EXPECT_EQ(read(resume, &ev, sizeof(ev)) < 0, 1, "case10: resume signalled only once");
+    close(resume);
+
+    // ---- Case 11: pop_batch 一次取走多条,保序,不超过 max,空时返回 0 ----
+    queue_destroy(q);
+    q = queue_create("TEST_DST", NULL);
+    for (int i = 0; i < 5; i++) {
+        msg.len = i;
+        queue_push(q, &msg);
+    }
+    event_msg_t batch[4];
+    int n = queue_pop_batch(q, batch, 4);
+    EXPECT_EQ(n, 4, "case11: batch capped at max");
+    EXPECT_EQ(batch[0].len == 0 && batch[3].len == 3, 1, "case11: batch in order");
+    EXPECT_EQ(queue_depth(q), 1, "case11: remaining depth 1");
+    EXPECT_EQ(queue_pop_batch(q, batch, 4), 1, "case11: partial batch");
+    EXPECT_EQ(batch[0].len, 4, "case11: last message");
+    EXPECT_EQ(queue_pop_batch(q, batch, 4), 0, "case11: empty queue returns 0");
+    EXPECT_EQ(queue_get_pop_count(q), 5, "case11: pop_count counts batched messages");
+
+    // ---- Case 12: 字节水位:几条大消息就停读,条数和字节都降到低水位才恢复 ----
+    queue_destroy(q);
+    q = queue_create("TEST_DST", NULL);
+    resume = eventfd(0, EFD_NONBLOCK);
+    queue_set_resume_fd(q, resume);
+    msg.len = 32 * 1024;
+    int big = QUEUE_HIGH_WATERMARK_BYTES / msg.len;
+    for (int i = 0; i < big - 1; i++) queue_push(q, &msg);
+    EXPECT_EQ(queue_bytes(q), (unsigned long)(big - 1) * msg.len, "case12: queued bytes tracked");
+    EXPECT_EQ(queue_over_high_watermark(q), 0, "case12: below byte high watermark");
+    queue_push(q, &msg);
+    EXPECT_EQ(queue_over_high_watermark(q), 1, "case12: byte high watermark -> throttle");
+    int low = QUEUE_LOW_WATERMARK_BYTES / msg.len;
+    while ((int)queue_depth(q) > low + 1) queue_pop(q, &got);
+    EXPECT_EQ(read(resume, &ev, sizeof(ev)) < 0, 1, "case12: no resume above byte low watermark");
+    queue_pop_batch(q, batch, 1);
+    EXPECT_EQ(read(resume, &ev, sizeof(ev)) == sizeof(ev), 1, "case12: resume at byte low watermark");
+    while (queue_pop_batch(q, batch, 4) > 0) {}
+    EXPECT_EQ(queue_bytes(q), 0, "case12: drained queue has no bytes");
+    close(resume);
+
+    queue_destroy(q);
+
     if (g_failed) {
         fprintf(stderr, "\n%d FAILED\n", g_failed);
         return 1;
@@ -0,0 +1,77 @@
+// test_reconnect_delay.c — tcp_client 重连退避(port_reconnect_delay_ms)的 test-as-doc
+//
+// 固化契约(port_manager.h):
+//   - 第 attempt 次重连的基准 d = reconnect_min_ms << attempt,封顶 reconnect_max_ms
+//   - 实际等待在 [d/2, d] 内按 rnd 抖动,两端都取得到
+//   - attempt 很大时不溢出,一直停在 reconnect_max_ms
+//   - reconnect_min_ms <= 0 用 TCP_CLIENT_RECONNECT_MIN_MS;
+//     reconnect_max_ms 小于 min(含 0)时按 min 封顶
+//
+// §6.5 TEST AS DOC 形态。Unity 单测脚手架(open-questions U1)就绪后迁移。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -Wall -Wextra -D_GNU_SOURCE -I routerd/include -I routerd/3rdparty/cjson routerd/src/port_manager.c routerd/src/tty_baud.c routerd/src/port_tx.c routerd/src/buf_pool.c routerd/src/config_store.c routerd/src/log.c routerd/3rdparty/cjson/cJSON.c tests/unit/test_reconnect_delay.c -lpthread -o /tmp/test_reconnect_delay
+//   /tmp/test_reconnect_delay
+//
+// 退出码:0 = 全部 PASS,非 0 = FAIL
+
+#include <stdio.h>
+#include "config_store.h"
+#include "port_manager.h"
+#include "log.h"
+
+static int g_failed = 0;
+static int g_passed = 0;
+
+#define EXPECT(cond, label) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL %s (line %d)\n", label, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+// 扫一遍 rnd,返回所有结果都落在 [lo, hi] 内且两端都出现过
+static int spans(const port_tcp_client_conf_t* c, int attempt, int lo, int hi)
+{
+    int seen_lo = 0, seen_hi = 0;
+    for (unsigned rnd = 0; rnd < 100000; rnd += 7) {
+        int ms = port_reconnect_delay_ms(c, attempt, rnd);
+        if (ms < lo || ms > hi) {
+            fprintf(stderr, "  attempt %d rnd %u: %d ms not in [%d, %d]\n", attempt, rnd, ms, lo, hi);
+            return 0;
+        }
+        seen_lo |= ms == lo;
+        seen_hi |= ms == hi;
+    }
+    return seen_lo && seen_hi;
+}
+
+int main(void)
+{
+    log_init(0, LOG_LEVEL_ERROR);
+    port_tcp_client_conf_t c = {.reconnect_min_ms = 100, .reconnect_max_ms = 1000};
+
+    // ---- Case 1: 抖动范围 [d/2, d] ----
+    EXPECT(spans(&c, 0, 50, 100), "attempt 0: [50, 100]");
+    EXPECT(port_reconnect_delay_ms(&c, 0, 0) == 50, "rnd 0 gives d/2");
+    EXPECT(port_reconnect_delay_ms(&c, 0, 50) == 100, "rnd d/2 gives d");
+
+    // ---- Case 2: 每次翻倍,封顶 reconnect_max_ms ----
+    EXPECT(spans(&c, 1, 100, 200), "attempt 1: [100, 200]");
+    EXPECT(spans(&c, 3, 400, 800), "attempt 3: [400, 800]");
+    EXPECT(spans(&c, 4, 500, 1000), "attempt 4: 1600 capped to 1000");
+    EXPECT(spans(&c, 30, 500, 1000), "attempt 30: still capped, no overflow");
+    c.reconnect_max_ms = 300;
+    EXPECT(spans(&c, 2, 150, 300), "cap need not be a power-of-two multiple of min");
+
+    // ---- Case 3: 缺省值 ----
+    port_tcp_client_conf_t z = {0};
+    int dmin = TCP_CLIENT_RECONNECT_MIN_MS;
+    EXPECT(spans(&z, 0, dmin - dmin / 2, dmin), "min 0: TCP_CLIENT_RECONNECT_MIN_MS");
+    EXPECT(spans(&z, 5, dmin - dmin / 2, dmin), "max 0: capped at min");
+    port_tcp_client_conf_t inv = {.reconnect_min_ms = 400, .reconnect_max_ms = 100};
+    EXPECT(spans(&inv, 3, 200, 400), "max below min: capped at min");
+    port_tcp_client_conf_t one = {.reconnect_min_ms = 1, .reconnect_max_ms = 1};
+    EXPECT(port_reconnect_delay_ms(&one, 0, 12345) == 1, "d = 1: no jitter");
+
+    printf("\n%d passed, %d failed\n", g_passed, g_failed);
+    return g_failed ? 1 : 0;
+}
@@ -0,0 +1,184 @@
+// test_route_table.c — 编译后路由表的 test-as-doc
+//
+// 固化契约(route_table.h):
+//   - 按源端口下标索引,保持 g_config.routes 中的出现顺序
+//   - 表项预解析目的端口下标 / 目的队列 / handler 函数指针
+//   - handler 未注册 → 表项保留,handler = NULL(透传)
+//   - v2 handler 填 handler_v2,handler 留 NULL;v1 反之
+//   - dst 未配置 → 表项不建;无路由的源端口 n = 0;越界 id 返回 NULL
+//   - 超过 ROUTE_MAX_PER_SRC 的路由被丢弃
+//   - 多 reactor:表项按 reactor 各带一条目的 lane,彼此不同
+//   - splice 直通只标给:无 handler、源只有一条路由、两端都是单连接字节流端口、
+//     目的只被这一条路由写、策略不是 drop、配置没关的路由
+//
+// §6.5 TEST AS DOC 形态。Unity 单测脚手架(open-questions U1)就绪后迁移。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -Wall -Wextra -D_GNU_SOURCE -I routerd/include -I routerd/3rdparty/cjson routerd/src/route_table.c routerd/src/frame.c routerd/src/byte_scan.c routerd/src/dispatch_pool.c routerd/src/event_queue.c routerd/src/buf_pool.c routerd/src/plugin_loader.c routerd/src/config_store.c routerd/src/run_state.c routerd/src/log.c routerd/3rdparty/cjson/cJSON.c tests/unit/test_route_table.c -lpthread -ldl -o /tmp/test_route_table
+//   /tmp/test_route_table
+//
+// 退出码:0 = 全部 PASS,非 0 = FAIL
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "route_table.h"
+#include "dispatch_pool.h"
+#include "plugin_loader.h"
+#include "log.h"
+
+static int g_failed = 0;
+static int g_passed = 0;
+
+#define EXPECT(cond, label) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL %s (line %d)\n", label, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+#define EXPECT_EQ_INT(actual, expected, label) do { \
+    long _a = (long)(actual), _e = (long)(expected); \
+    if (_a != _e) { fprintf(stderr, "FAIL %s: got %ld, want %ld (line %d)\n", \
+            label, _a, _e, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+static int h_upper(uint8_t* data, int len) { (void)data; return len; }
+static int h_wrap(const uint8_t* in, int len, uint8_t* out, int cap)
+{ (void)in; (void)out; (void)cap; return len; }
+
+static void stub_handle(event_msg_t* msgs, int n) { (void)msgs; (void)n; }
+
+static void add_port(const char* name)
+{
+    port_def_t* p = &g_config.ports[g_config.port_count];
+    strcpy(p->base.name, name);
+    p->base.type = PORT_TTY;
+    p->base.fd = -1;
+    p->base.id = g_config.port_count++;
+}
+
+static void add_route(const char* src, const char* dst, const char* handler)
+{
+    route_def_t* r = &g_config.routes[g_config.route_count++];
+    strcpy(r->src, src);
+    strcpy(r->dst, dst);
+    strcpy(r->handler, handler);
+}
+
+int main(void)
+{
+    log_init(0, LOG_LEVEL_ERROR);
+
+    memset(&g_config, 0, sizeof(g_config));
+    add_port("UART1");   // id 0
+    add_port("UART2");   // id 1
+    add_port("NET");     // id 2
+    add_port("IDLE");    // id 3
+    add_route("UART1", "NET",   "filter.upper");
+    add_route("UART1", "UART2", "");
+    add_route("UART1", "NOPE",  "");               // dst 未配置
+    g_config.routes[1].policy = ROUTE_POLICY_BACKPRESSURE;
+    add_route("NET",   "UART1", "filter.missing"); // handler 未注册
+    add_route("UART2", "NET",   "filter.wrap");    // v2 handler
+    plugin_register_handler("filter", "upper", h_upper);
+    plugin_register_handler_v2("filter", "wrap", h_wrap);
+
+    dispatch_pool_init(1, stub_handle);
+
+    // ---- Case 1: 表项总数(未配置 dst 不计) ----
+    EXPECT_EQ_INT(route_table_build(), 4, "case1: 4 compiled entries");
+
+    // ---- Case 2: 按源端口下标取,顺序与配置一致,预解析 dst / 队列 / handler ----
+    const route_src_t* s = route_table_for_src(0);
+    EXPECT(s != NULL, "case2: UART1 has table");
+    EXPECT_EQ_INT(s->n, 2, "case2: UART1 has 2 routes");
+    EXPECT_EQ_INT(s->e[0].dst_id, 2, "case2: first dst = NET");
+    EXPECT(s->e[0].q[0] == dispatch_queue_by_name("NET"), "case2: first queue = NET queue");
+    EXPECT(s->e[0].handler == h_upper, "case2: handler resolved to function");
+    EXPECT(s->e[0].handler_v2 == NULL, "case2: v1 handler leaves handler_v2 NULL");
+    EXPECT_EQ_INT(s->e[1].dst_id, 1, "case2: second dst = UART2");
+    EXPECT(s->e[1].handler == NULL, "case2: no handler = pass through");
+    EXPECT_EQ_INT(s->e[0].policy, ROUTE_POLICY_BLOCK, "case2: default policy block");
+    EXPECT_EQ_INT(s->e[1].policy, ROUTE_POLICY_BACKPRESSURE, "case2: policy copied");
+
+    // ---- Case 3: 未注册 handler 透传 ----
+    s = route_table_for_src(2);
+    EXPECT_EQ_INT(s->n, 1, "case3: NET has 1 route");
+    EXPECT(s->e[0].handler == NULL && s->e[0].handler_v2 == NULL,
+           "case3: unregistered handler = pass through");
+
+    // ---- Case 3b: v2 handler 解析到 handler_v2 ----
+    s = route_table_for_src(1);
+    EXPECT_EQ_INT(s->n, 1, "case3b: UART2 has 1 route");
+    EXPECT(s->e[0].handler_v2 == h_wrap && s->e[0].handler == NULL,
+           "case3b: v2 handler resolved to handler_v2");
+
+    // ---- Case 4: 无路由 / 越界 ----
+    EXPECT_EQ_INT(route_table_for_src(3)->n, 0, "case4: IDLE has no routes");
+    EXPECT(route_table_for_src(-1) == NULL, "case4: negative id -> NULL");
+    EXPECT(route_table_for_src(MAX_PORTS) == NULL, "case4: id >= MAX_PORTS -> NULL");
+    dispatch_pool_stop();
+
+    // ---- Case 5: 超过 ROUTE_MAX_PER_SRC 丢弃 ----
+    memset(&g_config, 0, sizeof(g_config));
+    add_port("SRC");
+    add_port("DST");
+    for (int i = 0; i < ROUTE_MAX_PER_SRC + 4; i++)
+        add_route("SRC", "DST", "");
+    dispatch_pool_init(1, stub_handle);
+    EXPECT_EQ_INT(route_table_build(), ROUTE_MAX_PER_SRC, "case5: capped at ROUTE_MAX_PER_SRC");
+    EXPECT_EQ_INT(route_table_for_src(0)->n, ROUTE_MAX_PER_SRC, "case5: SRC n capped");
+    dispatch_pool_stop();
+
+    // ---- Case 6: 3 个 reactor → 每表项 3 条 lane,reactor k 用 q[k] ----
+    memset(&g_config, 0, sizeof(g_config));
+    g_config.reactor_threads = 3;
+    add_port("SRC");
+    add_port("DST");
+    add_route("SRC", "DST", "");
+    dispatch_pool_init(1, stub_handle);
+    EXPECT_EQ_INT(dispatch_pool_lanes(), 3, "case6: 3 lanes");
+    EXPECT_EQ_INT(route_table_build(), 1, "case6: 1 entry");
+    s = route_table_for_src(0);
+    for (int k = 0; k < 3; k++)
+        EXPECT(s->e[0].q[k] == dispatch_lane("DST", k), "case6: q[k] = lane k");
+    EXPECT(s->e[0].q[0] != s->e[0].q[1] && s->e[0].q[1] != s->e[0].q[2], "case6: lanes distinct");
+    EXPECT(s->e[0].q[3] == NULL, "case6: no lane past reactor count");
+    EXPECT(dispatch_lane("DST", 3) == NULL, "case6: lane out of range -> NULL");
+    dispatch_pool_stop();
+
+    // ---- Case 7: splice 直通资格 ----
+    memset(&g_config, 0, sizeof(g_config));
+    const char* names[] = {"U1", "N1", "U2", "N2", "U3", "U4", "N3", "U5", "SRV",
+                           "U6", "N6", "U7", "N7", "U8", "N8", "N9"};
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) add_port(names[i]);
+    g_config.ports[8].base.type = PORT_TCP_SERVER;   // SRV
+    g_config.ports[1].base.type = PORT_TCP_CLIENT;   // N1:tty → tcp 的串口网桥
+    add_route("U1", "N1",  "");
+    add_route("U2", "N2",  "filter.upper");   // 有 handler
+    add_route("U3", "N3",  "");               // N3 被两条路由写
+    add_route("U4", "N3",  "");
+    add_route("U5", "SRV", "");               // server 目的是广播
+    add_route("U6", "N6",  "");
+    add_route("U7", "N7",  "");
+    add_route("U8", "N8",  "");               // 源有两条路由
+    add_route("U8", "N9",  "");
+    for (int i = 0; i < g_config.route_count; i++) g_config.routes[i].splice = 1;
+    g_config.routes[5].policy = ROUTE_POLICY_DROP;
+    g_config.routes[6].splice = 0;            // "splice": false
+    dispatch_pool_init(1, stub_handle);
+    route_table_build();
+    EXPECT(route_table_for_src(0)->e[0].splice == 1, "case7: plain tty -> tcp_client spliced");
+    EXPECT(route_table_for_src(2)->e[0].splice == 0, "case7: handler route not spliced");
+    EXPECT(route_table_for_src(4)->e[0].splice == 0 && route_table_for_src(5)->e[0].splice == 0,
+           "case7: shared dst not spliced");
+    EXPECT(route_table_for_src(7)->e[0].splice == 0, "case7: server dst not spliced");
+    EXPECT(route_table_for_src(9)->e[0].splice == 0, "case7: drop policy not spliced");
+    EXPECT(route_table_for_src(11)->e[0].splice == 0, "case7: config opt-out honoured");
+    EXPECT(route_table_for_src(13)->e[0].splice == 0 && route_table_for_src(13)->e[1].splice == 0,
+           "case7: multi-route source not spliced");
+    dispatch_pool_stop();
+
+    printf("\n%d passed, %d failed\n", g_passed, g_failed);
+    return g_failed ? 1 : 0;
+}
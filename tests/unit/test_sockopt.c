@@ -0,0 +1,131 @@
+// test_sockopt.c — 端口 socket 选项("socket" 配置块)的 test-as-doc
+//
+// 固化契约(config_store.h 的 port_sockopt_t,port_manager.h 的 port_apply_sockopts):
+//   - 不写 socket 块:什么都不设,保持内核缺省
+//   - tcp_server:选项设在 listener 上;accept 出的 client 用 server 配置再设一遍
+//   - tcp_client:connect 前设好(缓冲大小影响握手时的窗口缩放)
+//   - udp:缓冲 / tos 生效,TCP 专有选项(nodelay / keepalive / user_timeout)忽略
+//   - "dscp": N 等价于 "tos": N << 2
+//   - save_config 写回同样的 socket 块
+//
+// §6.5 TEST AS DOC 形态。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -Wall -Wextra -D_GNU_SOURCE -I routerd/include -I routerd/3rdparty/cjson routerd/src/port_manager.c routerd/src/tty_baud.c routerd/src/port_tx.c routerd/src/buf_pool.c routerd/src/config_store.c routerd/src/log.c routerd/3rdparty/cjson/cJSON.c tests/unit/test_sockopt.c -lpthread -o /tmp/test_sockopt
+//   /tmp/test_sockopt
+//
+// 退出码:0 = 全部 PASS,非 0 = FAIL
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "port_manager.h"
+#include "log.h"
+
+static int g_failed = 0;
+static int g_passed = 0;
+
+#define EXPECT(cond, label) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL %s (line %d)\n", label, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+static int opt(int fd, int level, int name)
+{
+    int v = -1;
+    socklen_t l = sizeof(v);
+    getsockopt(fd, level, name, &v, &l);
+    return v;
+}
+
+static int write_config(char* path, const char* json)
+{
+    int fd = mkstemp(path);
+    if (fd < 0) return -1;
+    int ok = write(fd, json, strlen(json)) == (ssize_t)strlen(json);
+    close(fd);
+    return ok ? 0 : -1;
+}
+
+int main(void)
+{
+    char path[] = "/tmp/test_sockopt_XXXXXX";
+    write_config(path,
+        "{\"ports\":["
+        "{\"name\":\"CTRL\",\"type\":\"tcp_server\",\"tcp_server\":{\"bind\":\"127.0.0.1\",\"port\":19611,\"backlog\":4},"
+        " \"socket\":{\"nodelay\":true,\"quickack\":true,\"sndbuf\":16384,\"rcvbuf\":16384,"
+        "  \"user_timeout_ms\":2000,\"keepalive\":{\"idle_s\":5,\"interval_s\":2,\"count\":3},\"dscp\":46}},"
+        "{\"name\":\"BULK\",\"type\":\"tcp_client\",\"tcp_client\":{\"addr\":\"127.0.0.1\",\"port\":19611},"
+        " \"socket\":{\"sndbuf\":1048576,\"rcvbuf\":1048576}},"
+        "{\"name\":\"DG\",\"type\":\"udp\",\"udp\":{\"bind\":\"127.0.0.1\",\"port\":0},"
+        " \"socket\":{\"rcvbuf\":65536,\"nodelay\":true,\"tos\":16}},"
+        "{\"name\":\"PLAIN\",\"type\":\"udp\",\"udp\":{\"bind\":\"127.0.0.1\",\"port\":0}}],"
+        "\"plugins\":[],\"routes\":[]}");
+    EXPECT(load_config(path) == 0 && g_config.port_count == 4, "config loads");
+    port_def_t* ctrl  = &g_config.ports[0];
+    port_def_t* bulk  = &g_config.ports[1];
+    port_def_t* dg    = &g_config.ports[2];
+    port_def_t* plain = &g_config.ports[3];
+    EXPECT(ctrl->base.sock.tos == 46 << 2, "dscp 46 (EF) stored as tos 0xb8");
+
+    // ---- 不写 socket 块 ----
+    int pfd = port_open_single(plain);
+    int pdef = socket(AF_INET, SOCK_DGRAM, 0);
+    EXPECT(opt(pfd, SOL_SOCKET, SO_RCVBUF) == opt(pdef, SOL_SOCKET, SO_RCVBUF) &&
+           opt(pfd, IPPROTO_IP, IP_TOS) == 0, "no socket block: kernel defaults");
+    close(pdef);
+
+    // ---- tcp_server listener ----
+    int lfd = port_open_single(ctrl);
+    EXPECT(lfd >= 0, "tcp_server opens");
+    EXPECT(opt(lfd, IPPROTO_TCP, TCP_NODELAY) == 1, "listener: TCP_NODELAY");
+    EXPECT(opt(lfd, SOL_SOCKET, SO_RCVBUF) == 2 * 16384, "listener: SO_RCVBUF (kernel doubles)");
+    EXPECT(opt(lfd, SOL_SOCKET, SO_KEEPALIVE) == 1 && opt(lfd, IPPROTO_TCP, TCP_KEEPIDLE) == 5 &&
+           opt(lfd, IPPROTO_TCP, TCP_KEEPINTVL) == 2 && opt(lfd, IPPROTO_TCP, TCP_KEEPCNT) == 3,
+           "listener: keepalive idle / interval / count");
+    EXPECT(opt(lfd, IPPROTO_TCP, TCP_USER_TIMEOUT) == 2000, "listener: TCP_USER_TIMEOUT");
+    EXPECT(opt(lfd, IPPROTO_IP, IP_TOS) == 0xb8, "listener: IP_TOS from dscp");
+
+    // ---- tcp_client:connect 前已设 ----
+    int cfd = port_open_single(bulk);
+    int tdef = socket(AF_INET, SOCK_STREAM, 0);
+    EXPECT(cfd >= 0 && opt(cfd, SOL_SOCKET, SO_SNDBUF) > opt(tdef, SOL_SOCKET, SO_SNDBUF),
+           "tcp_client: SO_SNDBUF raised (kernel caps at wmem_max)");
+    close(tdef);
+    EXPECT(opt(cfd, IPPROTO_TCP, TCP_NODELAY) == 0, "tcp_client: options not configured stay off");
+
+    // ---- accept 出的 client 按 server 配置再设 ----
+    usleep(50 * 1000);
+    int afd = accept(lfd, NULL, NULL);
+    EXPECT(afd >= 0, "accepted");
+    EXPECT(port_apply_sockopts(ctrl, afd) == 0, "accepted client: all options applied");
+    EXPECT(opt(afd, IPPROTO_TCP, TCP_NODELAY) == 1 && opt(afd, IPPROTO_TCP, TCP_QUICKACK) == 1 &&
+           opt(afd, IPPROTO_IP, IP_TOS) == 0xb8, "accepted client: nodelay / quickack / tos");
+
+    // ---- udp ----
+    int ufd = port_open_single(dg);
+    EXPECT(ufd >= 0 && opt(ufd, SOL_SOCKET, SO_RCVBUF) == 2 * 65536 &&
+           opt(ufd, IPPROTO_IP, IP_TOS) == 16, "udp: rcvbuf and tos applied");
+    EXPECT(port_apply_sockopts(dg, ufd) == 0, "udp: TCP-only options skipped, no failures");
+
+    // ---- save_config 往返 ----
+    EXPECT(save_config(path) == 0 && load_config(path) == 0, "save + reload");
+    const port_sockopt_t* so = &g_config.ports[0].base.sock;
+    EXPECT(so->nodelay && so->quickack && so->sndbuf == 16384 && so->keepalive &&
+           so->keepidle_s == 5 && so->user_timeout_ms == 2000 && so->tos == 0xb8,
+           "socket block round-trips");
+    EXPECT(g_config.ports[3].base.sock.tos == 0 && !g_config.ports[3].base.sock.nodelay,
+           "unset block stays unset");
+    unlink(path);
+
+    close(afd);
+    close(cfd);
+    close(lfd);
+    close(ufd);
+    close(pfd);
+    printf("\n%d passed, %d failed\n", g_passed, g_failed);
+    return g_failed ? 1 : 0;
+}
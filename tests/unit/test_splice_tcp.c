@@ -0,0 +1,174 @@
+// test_splice_tcp.c — splice 直通的 tcp_client 源不阻塞 reactor 的 test-as-doc
+//
+// 固化契约(reactor.c splice 直通):
+//   - tcp 的 splice 读是否阻塞只看源 fd 的 O_NONBLOCK,SPLICE_F_NONBLOCK 只管管道一侧;
+//     直通的 tcp_client 源读到 EAGAIN 就返回,不会停在 splice 里
+//   - 源读空之后,同一 reactor 上的其他端口照常转发
+//   - 断线重连后(dial_up 会去掉 O_NONBLOCK)新连接照样直通、照样不阻塞
+//
+// 场景:一个 reactor 线程、两条直通路由
+//   NET(tcp_client,连本进程的 listener,按 port_open_single 打开) → D1(socketpair)
+//   AUX(ipc_client,socketpair) → D2(socketpair)
+// 先往 NET 的对端写一段,D1 收到后 NET 已读空;再往 AUX 写,D2 必须在超时内收到。
+// reactor 卡在 NET 的 splice 里时 D2 永远收不到,判 FAIL(数据面线程不收尾,直接退出)。
+// 之后关掉 NET 的对端,等它重连上来,同样的检查再做一遍。
+//
+// §6.5 TEST AS DOC 形态。Unity 单测脚手架(open-questions U1)就绪后迁移。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -Wall -Wextra -D_GNU_SOURCE -I routerd/include -I routerd/3rdparty/cjson routerd/src/reactor.c routerd/src/uring.c routerd/src/router_core.c routerd/src/port_map.c routerd/src/port_manager.c routerd/src/tty_baud.c routerd/src/port_tx.c routerd/src/config_store.c routerd/src/plugin_loader.c routerd/src/route_table.c routerd/src/frame.c routerd/src/byte_scan.c routerd/src/dispatch_pool.c routerd/src/event_queue.c routerd/src/buf_pool.c routerd/src/run_state.c routerd/src/log.c routerd/3rdparty/cjson/cJSON.c tests/unit/test_splice_tcp.c -lpthread -lm -ldl -o /tmp/test_splice_tcp
+//   /tmp/test_splice_tcp
+//
+// 退出码:0 = 全部 PASS,非 0 = FAIL
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "config_store.h"
+#include "port_manager.h"
+#include "reactor.h"
+#include "route_table.h"
+#include "dispatch_pool.h"
+#include "buf_pool.h"
+#include "router_core.h"
+#include "log.h"
+
+#define WAIT_MS 2000
+
+static int g_failed = 0;
+static int g_passed = 0;
+
+#define EXPECT(cond, label) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL %s (line %d)\n", label, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+// 等 fd 上读到 len 字节,超时返回已读到的
+static int read_within(int fd, char* buf, int len, int ms)
+{
+    int got = 0;
+    while (got < len) {
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        if (poll(&pfd, 1, ms) <= 0) break;
+        ssize_t n = read(fd, buf + got, (size_t)(len - got));
+        if (n <= 0) break;
+        got += (int)n;
+    }
+    return got;
+}
+
+static port_def_t* add_port(int id, const char* name, port_type_t type, int fd)
+{
+    port_def_t* p = &g_config.ports[id];
+    snprintf(p->base.name, sizeof(p->base.name), "%s", name);
+    p->base.type    = type;
+    p->base.fd      = fd;
+    p->base.id      = id;
+    p->base.reactor = 0;
+    return p;
+}
+
+static void add_route(int i, const char* src, const char* dst)
+{
+    route_def_t* r = &g_config.routes[i];
+    snprintf(r->src, sizeof(r->src), "%s", src);
+    snprintf(r->dst, sizeof(r->dst), "%s", dst);
+    r->policy = ROUTE_POLICY_BLOCK;
+    r->splice = 1;
+}
+
+int main(void)
+{
+    log_init(0, LOG_LEVEL_ERROR);
+
+    // NET 要连的 listener
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in la = {.sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+    socklen_t alen = sizeof(la);
+    if (lfd < 0 || bind(lfd, (struct sockaddr*)&la, sizeof(la)) < 0 || listen(lfd, 1) < 0 ||
+        getsockname(lfd, (struct sockaddr*)&la, &alen) < 0) {
+        perror("listener");
+        return 1;
+    }
+
+    int d1[2], aux[2], d2[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, d1) < 0 || socketpair(AF_UNIX, SOCK_STREAM, 0, aux) < 0 ||
+        socketpair(AF_UNIX, SOCK_STREAM, 0, d2) < 0) {
+        perror("socketpair");
+        return 1;
+    }
+
+    memset(&g_config, 0, sizeof(g_config));
+    port_def_t* net = add_port(0, "NET", PORT_TCP_CLIENT, -1);
+    snprintf(net->cfg.tcp_client.addr, sizeof(net->cfg.tcp_client.addr), "127.0.0.1");
+    net->cfg.tcp_client.port = ntohs(la.sin_port);
+    net->cfg.tcp_client.connect_timeout_ms = WAIT_MS;
+    net->cfg.tcp_client.reconnect_min_ms   = 10;
+    net->cfg.tcp_client.reconnect_max_ms   = 10;
+    EXPECT(port_open_single(net) >= 0, "NET socket opened like the daemon does");
+    add_port(1, "D1", PORT_IPC_CLIENT, d1[0]);
+    add_port(2, "AUX", PORT_IPC_CLIENT, aux[0]);
+    add_port(3, "D2", PORT_IPC_CLIENT, d2[0]);
+    g_config.port_count = 4;
+    add_route(0, "NET", "D1");
+    add_route(1, "AUX", "D2");
+    g_config.route_count     = 2;
+    g_config.reactor_threads = 1;
+    g_config.reactor_edge    = 1;
+    g_config.reactor_backend = REACTOR_BACKEND_EPOLL;
+
+    // 启动顺序同 ez_router.c main
+    reactor_init(1);
+    for (int i = 0; i < g_config.port_count; i++)
+        reactor_add_port(&g_config.ports[i]);
+    buf_pool_init(BUF_POOL_DEFAULT_COUNT);
+    dispatch_pool_init(1, router_core_handle_batch);
+    dispatch_pool_set_tx_hooks(router_core_tx_hooks());
+    route_table_build();
+    EXPECT(route_table_for_src(0)->e[0].splice, "NET -> D1 takes the splice fast path");
+    reactor_start();
+    dispatch_pool_start();
+
+    int peer = accept(lfd, NULL, NULL);
+    EXPECT(peer >= 0, "NET connected");
+
+    char buf[64];
+    EXPECT(write(peer, "hello", 5) == 5 && read_within(d1[1], buf, 5, WAIT_MS) == 5 &&
+           memcmp(buf, "hello", 5) == 0, "NET bytes reach D1");
+
+    // NET 此时已读空:reactor 要能回到 epoll_wait,处理 AUX
+    EXPECT(write(aux[1], "ping", 4) == 4 && read_within(d2[1], buf, 4, WAIT_MS) == 4 &&
+           memcmp(buf, "ping", 4) == 0, "reactor not stalled on the drained tcp source");
+
+    // 再来一轮,确认 NET 仍在直通路径上
+    EXPECT(write(peer, "again", 5) == 5 && read_within(d1[1], buf, 5, WAIT_MS) == 5,
+           "NET keeps forwarding after EAGAIN");
+
+    // 对端断开:NET 退避后重连,新连接重新建直通状态
+    close(peer);
+    peer = accept(lfd, NULL, NULL);
+    EXPECT(peer >= 0, "NET reconnected");
+    EXPECT(write(peer, "after", 5) == 5 && read_within(d1[1], buf, 5, WAIT_MS) == 5 &&
+           memcmp(buf, "after", 5) == 0, "reconnected NET bytes reach D1");
+    EXPECT(write(aux[1], "pong", 4) == 4 && read_within(d2[1], buf, 4, WAIT_MS) == 4 &&
+           memcmp(buf, "pong", 4) == 0, "reactor not stalled after the reconnect");
+
+    // 计数在 splice 返回之后才加,可能比 D1 收到晚一点
+    unsigned long spliced = 0;
+    for (int t = 0; t < WAIT_MS && spliced < 15; t++) {
+        reactor_port_stats_t ps[4];
+        for (int k = reactor_get_port_stats(ps, 4) - 1; k >= 0; k--)
+            if (strcmp(ps[k].name, "NET") == 0) spliced = ps[k].spliced;
+        if (spliced < 15) usleep(1000);
+    }
+    EXPECT(spliced == 15, "NET bytes moved by splice");
+
+    printf("\n%d passed, %d failed\n", g_passed, g_failed);
+    fflush(stdout);
+    // 数据面线程不做收尾(卡住时也 join 不回来),直接退出
+    _exit(g_failed ? 1 : 0);
+}
@@ -0,0 +1,100 @@
+// test_tty_baud.c — 串口任意波特率(termios2)与低延迟标志的 test-as-doc
+//
+// 固化契约(tty_baud.h,port_manager.c 的 port_open_tty):
+//   - tty_set_baud 接受任意正整数速率(460800 / 921600 / 3M / 250000 DMX / 非常规值),
+//     返回读回的实际速率;非法速率返回 -1
+//   - tty_baud_error_ppm:带符号 ppm,偏差超过 TTY_BAUD_WARN_PPM 时 port_open_tty 告警
+//   - 驱动不支持 ASYNC_LOW_LATENCY(pty、多数 USB 串口)时返回 -1,不影响端口
+//   - port_open_tty:非标准速率经 termios2 设准;baudrate 不写 = 115200;
+//     配了 low_latency 而驱动不支持时端口照常打开
+//
+// pty 驱动照单全收任何速率,所以"实际 = 请求";真实 UART 的分频偏差只能在硬件上看日志。
+//
+// §6.5 TEST AS DOC 形态。
+//
+// 编译运行(从仓库根目录,单行命令):
+//   gcc -Wall -Wextra -D_GNU_SOURCE -I routerd/include -I routerd/3rdparty/cjson routerd/src/port_manager.c routerd/src/tty_baud.c routerd/src/port_tx.c routerd/src/buf_pool.c routerd/src/config_store.c routerd/src/log.c routerd/3rdparty/cjson/cJSON.c tests/unit/test_tty_baud.c -lpthread -o /tmp/test_tty_baud
+//   /tmp/test_tty_baud
+//
+// 退出码:0 = 全部 PASS,非 0 = FAIL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "port_manager.h"
+#include "tty_baud.h"
+#include "log.h"
+
+static int g_failed = 0;
+static int g_passed = 0;
+
+#define EXPECT(cond, label) do { \
+    if (!(cond)) { fprintf(stderr, "FAIL %s (line %d)\n", label, __LINE__); g_failed++; } \
+    else { printf("PASS %s\n", label); g_passed++; } \
+} while (0)
+
+// pty 主端,*slave = 从端路径
+static int open_pty(char* slave, size_t n)
+{
+    int m = posix_openpt(O_RDWR | O_NOCTTY);
+    if (m < 0 || grantpt(m) < 0 || unlockpt(m) < 0) return -1;
+    snprintf(slave, n, "%s", ptsname(m));
+    return m;
+}
+
+int main(void)
+{
+    char slave[128];
+    int master = open_pty(slave, sizeof(slave));
+    EXPECT(master >= 0, "pty available");
+    int fd = open(slave, O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+    // ---- Case 1: 任意速率 ----
+    static const int rates[] = {9600, 115200, 250000, 460800, 921600, 1500000, 3000000, 1234567};
+    int all = 1;
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        if (tty_set_baud(fd, rates[i]) != rates[i] || tty_get_baud(fd) != rates[i]) {
+            fprintf(stderr, "  rate %d read back %d\n", rates[i], tty_get_baud(fd));
+            all = 0;
+        }
+    }
+    EXPECT(all, "case1: standard and non-standard rates set and read back");
+    EXPECT(tty_set_baud(fd, 0) < 0 && tty_set_baud(fd, -9600) < 0, "case1: non-positive rate rejected");
+    EXPECT(tty_set_baud(master + 1000, 9600) < 0, "case1: bad fd fails");
+
+    // ---- Case 2: 偏差 ----
+    EXPECT(tty_baud_error_ppm(250000, 250000) == 0, "case2: exact rate 0 ppm");
+    EXPECT(tty_baud_error_ppm(3000000, 2941176) == -19608, "case2: -1.96% below the warning line");
+    EXPECT(tty_baud_error_ppm(921600, 941176) > TTY_BAUD_WARN_PPM, "case2: +2.12% over the warning line");
+
+    // ---- Case 3: 低延迟 ----
+    EXPECT(tty_set_low_latency(fd, 1) < 0, "case3: pty has no serial_struct, reports failure");
+    close(fd);
+
+    // ---- Case 4: port_open_tty 走 termios2 ----
+    port_def_t p;
+    memset(&p, 0, sizeof(p));
+    strcpy(p.base.name, "DMX");
+    p.base.type = PORT_TTY;
+    snprintf(p.cfg.tty.path, sizeof(p.cfg.tty.path), "%s", slave);
+    p.cfg.tty.baudrate    = 250000;
+    p.cfg.tty.databits    = 8;
+    p.cfg.tty.stopbits    = 2;
+    p.cfg.tty.low_latency = 1;
+    int pfd = port_open_single(&p);
+    EXPECT(pfd >= 0, "case4: opens even though low_latency is unsupported");
+    EXPECT(tty_get_baud(pfd) == 250000, "case4: DMX 250000 applied exactly");
+    port_close_single(&p);
+
+    p.cfg.tty.baudrate    = 0;
+    p.cfg.tty.low_latency = 0;
+    pfd = port_open_single(&p);
+    EXPECT(pfd >= 0 && tty_get_baud(pfd) == TTY_DEFAULT_BAUD, "case4: unset baudrate = 115200");
+    port_close_single(&p);
+
+    close(master);
+    printf("\n%d passed, %d failed\n", g_passed, g_failed);
+    return g_failed ? 1 : 0;
+}